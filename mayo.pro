@@ -66,6 +66,7 @@ SOURCES += \
 
 win* {
     QT += winextras
+    LIBS += -lpsapi
     HEADERS += $$files(src/app/windows/*.h)
     SOURCES += $$files(src/app/windows/*.cpp)
 
@@ -112,7 +113,6 @@ LIBS += \
     -lTKLCAF \
     -lTKMath \
     -lTKMesh \
-    -lTKMeshVS \
     -lTKOpenGl \
     -lTKPrim \
     -lTKService \
@@ -12,8 +12,13 @@
 #include "../base/io_system.h"
 #include "../base/occt_enums.h"
 #include "../base/settings.h"
+#include "../base/tessellation_cache.h"
+#include "../base/thread_budget.h"
 #include "../graphics/graphics_entity_driver.h"
 
+#include <QtCore/QDir>
+#include <QtCore/QStandardPaths>
+
 namespace Mayo {
 
 static inline const Enumeration enumUnitSchemas = {
@@ -26,6 +31,11 @@ static inline const Enumeration enumLanguages = {
     { 1, AppModule::textId("fr"), {} }
 };
 
+static inline const Enumeration enumDeflectionTypes = {
+    { int(TessellationParameters::DeflectionMode::Absolute), AppModule::textId("Absolute"), {} },
+    { int(TessellationParameters::DeflectionMode::Relative), AppModule::textId("Relative"), {} }
+};
+
 AppModule::AppModule(Application* app)
     : QObject(app),
       PropertyGroup(app->settings()),
@@ -37,6 +47,10 @@ AppModule::AppModule(Application* app)
           app->settings()->addSection(this->groupId_system, textId("units"))),
       unitSystemDecimals(app->settings(), textId("decimalCount")),
       unitSystemSchema(app->settings(), textId("schema"), &enumUnitSchemas),
+      // -- Threads
+      sectionId_systemThreads(
+          app->settings()->addSection(this->groupId_system, textId("threads"))),
+      threadBudget(this, textId("threadBudget")),
       // Application
       groupId_application(app->settings()->addGroup(textId("application"))),
       language(this, textId("language"), &enumLanguages),
@@ -47,6 +61,10 @@ AppModule::AppModule(Application* app)
       // Graphics
       groupId_graphics(app->settings()->addGroup(textId("graphics"))),
       defaultShowOriginTrihedron(this, textId("defaultShowOriginTrihedron")),
+      graphicsStaticBatching(this, textId("staticBatchingOn")),
+      graphicsHlrExact(this, textId("hlrExactOn")),
+      graphicsInteractionLod(this, textId("interactionLodOn")),
+      graphicsFrameStatsOverlay(this, textId("frameStatsOverlayOn")),
       // -- Clip planes
       sectionId_graphicsClipPlanes(
           app->settings()->addSection(this->groupId_graphics, textId("clipPlanes"))),
@@ -59,7 +77,20 @@ AppModule::AppModule(Application* app)
       meshDefaultsEdgeColor(this, textId("edgeColor")),
       meshDefaultsMaterial(this, textId("material"), &OcctEnums::Graphic3d_NameOfMaterial()),
       meshDefaultsShowEdges(this, textId("showEgesOn")),
-      meshDefaultsShowNodes(this, textId("showNodesOn"))
+      meshDefaultsShowNodes(this, textId("showNodesOn")),
+      // Meshing
+      groupId_meshing(app->settings()->addGroup(textId("meshing"))),
+      meshingOnImport(this, textId("meshingOnImport")),
+      meshingDeflectionType(this, textId("deflectionType"), &enumDeflectionTypes),
+      meshingChordalDeflection(this, textId("chordalDeflection")),
+      meshingRelativeChordalDeflection(this, textId("relativeChordalDeflection")),
+      meshingAngularDeflection(this, textId("angularDeflection")),
+      meshingProgressive(this, textId("progressiveOn")),
+      // -- Cache
+      sectionId_meshingCache(
+          app->settings()->addSection(this->groupId_meshing, textId("cache"))),
+      meshingCacheOn(this, textId("cacheOn")),
+      meshingCacheMaxSize(this, textId("cacheMaxSize"))
 {
     auto settings = app->settings();
 
@@ -70,6 +101,15 @@ AppModule::AppModule(Application* app)
     this->unitSystemDecimals.setRange(1, 99);
     this->unitSystemDecimals.setSingleStep(1);
     this->unitSystemDecimals.setConstraintsEnabled(true);
+    // -- Threads
+    this->threadBudget.setDescription(
+                tr("Maximum count of worker threads used by the application, shared between "
+                   "concurrent tasks and OpenCascade parallel algorithms. "
+                   "Value 0 means the count of hardware threads"));
+    settings->addSetting(&this->threadBudget, this->sectionId_systemThreads);
+    this->threadBudget.setRange(0, 1024);
+    this->threadBudget.setSingleStep(1);
+    this->threadBudget.setConstraintsEnabled(true);
 
     // Application
     this->language.setDescription(
@@ -90,7 +130,25 @@ AppModule::AppModule(Application* app)
     this->defaultShowOriginTrihedron.setDescription(
                 tr("Show or hide by default the trihedron centered at world origin. "
                    "This doesn't affect 3D view of currently opened documents"));
+    this->graphicsStaticBatching.setDescription(
+                tr("Draw the shapes with a few large vertex buffers merged by color, reducing the "
+                   "count of draw calls for assemblies made of many small parts. "
+                   "Selected parts are drawn separately"));
     settings->addSetting(&this->defaultShowOriginTrihedron, this->groupId_graphics);
+    this->graphicsHlrExact.setDescription(
+                tr("Hidden lines are computed from the exact geometry instead of the meshes. "
+                   "Output is print quality but computation is much slower"));
+    settings->addSetting(&this->graphicsStaticBatching, this->groupId_graphics);
+    this->graphicsInteractionLod.setDescription(
+                tr("While the view is rotated, panned or zoomed, draw the shapes with decimated "
+                   "meshes or bounding boxes of the parts within a fixed triangle budget. "
+                   "Full detail is drawn back once the view manipulation ends"));
+    settings->addSetting(&this->graphicsHlrExact, this->groupId_graphics);
+    this->graphicsFrameStatsOverlay.setDescription(
+                tr("Show in the 3D view the frame rate, the count of draw calls and the count of "
+                   "triangles drawn"));
+    settings->addSetting(&this->graphicsInteractionLod, this->groupId_graphics);
+    settings->addSetting(&this->graphicsFrameStatsOverlay, this->groupId_graphics);
     // -- Clip planes
     this->clipPlanesCappingOn.setDescription(
                 tr("Enable capping of currently clipped graphics"));
@@ -104,6 +162,51 @@ AppModule::AppModule(Application* app)
     settings->addSetting(&this->meshDefaultsMaterial, this->sectionId_graphicsMeshDefaults);
     settings->addSetting(&this->meshDefaultsShowEdges, this->sectionId_graphicsMeshDefaults);
     settings->addSetting(&this->meshDefaultsShowNodes, this->sectionId_graphicsMeshDefaults);
+
+    // Meshing
+    this->meshingOnImport.setDescription(
+                tr("Compute the mesh of imported BRep shapes right after file transfer, in parallel "
+                   "across unique solids, instead of lazily at first display"));
+    this->meshingProgressive.setDescription(
+                tr("Display first a coarse mesh of imported shapes, then refine it in background "
+                   "up to the deflections above, starting with the biggest parts on screen"));
+    this->meshingDeflectionType.setDescription(
+                tr("Absolute: the chordal deflection is a length\n"
+                   "Relative: the chordal deflection is a ratio of the model bounding box diagonal"));
+    this->meshingChordalDeflection.setDescription(
+                tr("For the tessellation of faces the chordal deflection limits the distance between "
+                   "a curve and its tessellation"));
+    this->meshingRelativeChordalDeflection.setDescription(
+                tr("Ratio of the model bounding box diagonal used as chordal deflection"));
+    this->meshingAngularDeflection.setDescription(
+                tr("For the tessellation of faces the angular deflection limits the angle between "
+                   "subsequent segments in a polyline"));
+    settings->addSetting(&this->meshingOnImport, this->groupId_meshing);
+    settings->addSetting(&this->meshingDeflectionType, this->groupId_meshing);
+    settings->addSetting(&this->meshingChordalDeflection, this->groupId_meshing);
+    settings->addSetting(&this->meshingRelativeChordalDeflection, this->groupId_meshing);
+    settings->addSetting(&this->meshingAngularDeflection, this->groupId_meshing);
+    settings->addSetting(&this->meshingProgressive, this->groupId_meshing);
+    this->meshingChordalDeflection.setRange(1e-6, 1e6);
+    this->meshingChordalDeflection.setConstraintsEnabled(true);
+    this->meshingRelativeChordalDeflection.setRange(1e-6, 1.);
+    this->meshingRelativeChordalDeflection.setSingleStep(0.001);
+    this->meshingRelativeChordalDeflection.setConstraintsEnabled(true);
+    this->meshingAngularDeflection.setRange(0.01, 3.14159265358979323846 / 2.);
+    this->meshingAngularDeflection.setConstraintsEnabled(true);
+    // -- Cache
+    this->meshingCacheOn.setDescription(
+                tr("Store on disk the meshes computed at import, so they are reused next time the "
+                   "same shapes are imported with the same deflection parameters"));
+    this->meshingCacheMaxSize.setDescription(
+                tr("Maximum disk space(in megabytes) used by the mesh cache. Least recently used "
+                   "meshes are discarded when the limit is exceeded"));
+    settings->addSetting(&this->meshingCacheOn, this->sectionId_meshingCache);
+    settings->addSetting(&this->meshingCacheMaxSize, this->sectionId_meshingCache);
+    this->meshingCacheMaxSize.setRange(16, 1024 * 1024);
+    this->meshingCacheMaxSize.setSingleStep(64);
+    this->meshingCacheMaxSize.setConstraintsEnabled(true);
+
     // Import
     auto groupId_Import = settings->addGroup(textId("import"));
     for (const IO::Format& format : app->ioSystem()->readerFormats()) {
@@ -142,6 +245,7 @@ AppModule::AppModule(Application* app)
     settings->addGroupResetFunction(this->groupId_system, [&]{
         this->unitSystemDecimals.setValue(2);
         this->unitSystemSchema.setValue(UnitSystem::SI);
+        this->threadBudget.setValue(0);
     });
     settings->addGroupResetFunction(this->groupId_application, [&]{
         this->language.setValue(enumLanguages.findValue("en"));
@@ -152,6 +256,10 @@ AppModule::AppModule(Application* app)
     });
     settings->addGroupResetFunction(this->groupId_graphics, [&]{
         this->defaultShowOriginTrihedron.setValue(true);
+        this->graphicsStaticBatching.setValue(false);
+        this->graphicsHlrExact.setValue(false);
+        this->graphicsInteractionLod.setValue(false);
+        this->graphicsFrameStatsOverlay.setValue(false);
         this->clipPlanesCappingOn.setValue(true);
         this->clipPlanesCappingHatchOn.setValue(true);
         const GraphicsMeshEntityDriver::DefaultValues meshDefaults;
@@ -161,6 +269,17 @@ AppModule::AppModule(Application* app)
         this->meshDefaultsShowEdges.setValue(meshDefaults.showEdges);
         this->meshDefaultsShowNodes.setValue(meshDefaults.showNodes);
     });
+    settings->addGroupResetFunction(this->groupId_meshing, [&]{
+        const TessellationParameters params;
+        this->meshingOnImport.setValue(true);
+        this->meshingDeflectionType.setValue(params.deflectionMode);
+        this->meshingChordalDeflection.setQuantity(params.chordalDeflection * Quantity_Millimeter);
+        this->meshingRelativeChordalDeflection.setValue(params.relativeChordalDeflection);
+        this->meshingAngularDeflection.setQuantity(params.angularDeflection * Quantity_Radian);
+        this->meshingProgressive.setValue(false);
+        this->meshingCacheOn.setValue(true);
+        this->meshingCacheMaxSize.setValue(512);
+    });
 }
 
 StringUtils::TextOptions AppModule::defaultTextOptions() const
@@ -183,12 +302,38 @@ const PropertyGroup* AppModule::findReaderParameters(const IO::Format& format) c
     return it != m_mapFormatReaderParameters.cend() ? it->second : nullptr;
 }
 
+PropertyGroup* AppModule::findReaderParameters(const IO::Format& format)
+{
+    auto it = m_mapFormatReaderParameters.find(format.identifier);
+    return it != m_mapFormatReaderParameters.end() ? it->second : nullptr;
+}
+
 const PropertyGroup *AppModule::findWriterParameters(const IO::Format& format) const
 {
     auto it = m_mapFormatWriterParameters.find(format.identifier);
     return it != m_mapFormatWriterParameters.cend() ? it->second : nullptr;
 }
 
+TessellationParameters AppModule::tessellationParameters() const
+{
+    TessellationParameters params;
+    params.enabled = this->meshingOnImport.value();
+    params.deflectionMode =
+            this->meshingDeflectionType.valueAs<TessellationParameters::DeflectionMode>();
+    params.chordalDeflection = this->meshingChordalDeflection.quantity().value();
+    params.relativeChordalDeflection = this->meshingRelativeChordalDeflection.value();
+    params.angularDeflection = this->meshingAngularDeflection.quantity().value();
+    params.progressive = this->meshingProgressive.value();
+    return params;
+}
+
+GraphicsHlr::Algorithm AppModule::hlrAlgorithm() const
+{
+    return this->graphicsHlrExact.value() ?
+                GraphicsHlr::Algorithm::Exact :
+                GraphicsHlr::Algorithm::Polygonal;
+}
+
 AppModule* AppModule::get(const ApplicationPtr& app)
 {
     if (app)
@@ -199,6 +344,19 @@ AppModule* AppModule::get(const ApplicationPtr& app)
 
 void AppModule::onPropertyChanged(Property *prop)
 {
+    if (prop == &this->threadBudget)
+        ThreadBudget::setThreadCount(this->threadBudget.value());
+
+    if (prop == &this->meshingCacheOn) {
+        const QString cacheDir =
+                QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+                + QDir::separator() + "tessellation";
+        TessellationCache::setDirectory(this->meshingCacheOn.value() ? cacheDir : QString());
+    }
+
+    if (prop == &this->meshingCacheMaxSize)
+        TessellationCache::setMaxSize(uint64_t(this->meshingCacheMaxSize.value()) * 1024 * 1024);
+
     if (prop == &this->meshDefaultsColor
             || prop == &this->meshDefaultsEdgeColor
             || prop == &this->meshDefaultsMaterial
@@ -13,6 +13,8 @@
 #include "../base/property_enumeration.h"
 #include "../base/settings_index.h"
 #include "../base/string_utils.h"
+#include "../base/tessellation.h"
+#include "../graphics/graphics_hlr.h"
 
 #include <fougtools/qttools/core/qbytearray_hfunc.h>
 #include <QtCore/QObject>
@@ -38,12 +40,19 @@ public:
 
     const PropertyGroup* findReaderParameters(const IO::Format& format) const override;
     const PropertyGroup* findWriterParameters(const IO::Format& format) const override;
+    PropertyGroup* findReaderParameters(const IO::Format& format);
+
+    TessellationParameters tessellationParameters() const;
+    GraphicsHlr::Algorithm hlrAlgorithm() const;
 
     // System
     const Settings_GroupIndex groupId_system;
     const Settings_SectionIndex sectionId_systemUnits;
     PropertyInt unitSystemDecimals;
     PropertyEnumeration unitSystemSchema;
+    // -- Threads
+    const Settings_SectionIndex sectionId_systemThreads;
+    PropertyInt threadBudget;
     // Application
     const Settings_GroupIndex groupId_application;
     PropertyEnumeration language;
@@ -54,6 +63,10 @@ public:
     // Graphics
     const Settings_GroupIndex groupId_graphics;
     PropertyBool defaultShowOriginTrihedron;
+    PropertyBool graphicsStaticBatching;
+    PropertyBool graphicsHlrExact;
+    PropertyBool graphicsInteractionLod;
+    PropertyBool graphicsFrameStatsOverlay;
     // -- ClipPlanes
     const Settings_SectionIndex sectionId_graphicsClipPlanes;
     PropertyBool clipPlanesCappingOn;
@@ -65,6 +78,18 @@ public:
     PropertyEnumeration meshDefaultsMaterial;
     PropertyBool meshDefaultsShowEdges;
     PropertyBool meshDefaultsShowNodes;
+    // Meshing
+    const Settings_GroupIndex groupId_meshing;
+    PropertyBool meshingOnImport;
+    PropertyEnumeration meshingDeflectionType;
+    PropertyLength meshingChordalDeflection;
+    PropertyDouble meshingRelativeChordalDeflection;
+    PropertyAngle meshingAngularDeflection;
+    PropertyBool meshingProgressive;
+    // -- Cache
+    const Settings_SectionIndex sectionId_meshingCache;
+    PropertyBool meshingCacheOn;
+    PropertyInt meshingCacheMaxSize;
 
 protected:
     void onPropertyChanged(Property* prop) override;
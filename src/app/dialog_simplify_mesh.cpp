@@ -0,0 +1,66 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "dialog_simplify_mesh.h"
+#include "ui_dialog_simplify_mesh.h"
+
+#include <QtCore/QLocale>
+#include <algorithm>
+
+namespace Mayo {
+
+DialogSimplifyMesh::DialogSimplifyMesh(int meshTriangleCount, QWidget* parent)
+    : QDialog(parent),
+      m_ui(new Ui_DialogSimplifyMesh)
+{
+    m_ui->setupUi(this);
+
+    const MeshDecimationParameters defaults;
+    m_ui->comboBox_TargetMode->setCurrentIndex(int(defaults.targetMode));
+    m_ui->edit_TriangleCount->setMaximum(std::max(meshTriangleCount, 1));
+    m_ui->edit_TriangleCount->setValue(std::min(defaults.targetTriangleCount, meshTriangleCount));
+    m_ui->edit_Ratio->setValue(defaults.targetRatio * 100.);
+    m_ui->edit_MaxError->setValue(defaults.maxError);
+    m_ui->label_MeshInfo->setText(
+                tr("Mesh has %1 triangles").arg(QLocale().toString(meshTriangleCount)));
+
+    QObject::connect(
+                m_ui->comboBox_TargetMode, qOverload<int>(&QComboBox::currentIndexChanged),
+                this, &DialogSimplifyMesh::onTargetModeChanged);
+    this->onTargetModeChanged();
+}
+
+DialogSimplifyMesh::~DialogSimplifyMesh()
+{
+    delete m_ui;
+}
+
+MeshDecimationParameters DialogSimplifyMesh::parameters() const
+{
+    MeshDecimationParameters params;
+    params.targetMode =
+            MeshDecimationParameters::TargetMode(m_ui->comboBox_TargetMode->currentIndex());
+    params.targetTriangleCount = m_ui->edit_TriangleCount->value();
+    params.targetRatio = m_ui->edit_Ratio->value() / 100.;
+    params.maxError = m_ui->edit_MaxError->value();
+    return params;
+}
+
+bool DialogSimplifyMesh::keepOriginalMesh() const
+{
+    return m_ui->checkBox_KeepOriginal->isChecked();
+}
+
+void DialogSimplifyMesh::onTargetModeChanged()
+{
+    using TargetMode = MeshDecimationParameters::TargetMode;
+    const auto mode = TargetMode(m_ui->comboBox_TargetMode->currentIndex());
+    m_ui->edit_TriangleCount->setEnabled(mode == TargetMode::TriangleCount);
+    m_ui->edit_Ratio->setEnabled(mode == TargetMode::Ratio);
+    m_ui->edit_MaxError->setEnabled(mode == TargetMode::MaxError);
+}
+
+} // namespace Mayo
@@ -0,0 +1,29 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "../base/mesh_decimation.h"
+#include <QtWidgets/QDialog>
+
+namespace Mayo {
+
+class DialogSimplifyMesh : public QDialog {
+    Q_OBJECT
+public:
+    DialogSimplifyMesh(int meshTriangleCount, QWidget* parent = nullptr);
+    ~DialogSimplifyMesh();
+
+    MeshDecimationParameters parameters() const;
+    bool keepOriginalMesh() const;
+
+private:
+    void onTargetModeChanged();
+
+    class Ui_DialogSimplifyMesh* m_ui = nullptr;
+};
+
+} // namespace Mayo
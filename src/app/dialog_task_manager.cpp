@@ -10,6 +10,7 @@
 #include "../base/settings.h"
 #include "../base/string_utils.h"
 #include "../base/task_manager.h"
+#include "../base/thread_budget.h"
 #include "ui_dialog_task_manager.h"
 #include "theme.h"
 
@@ -139,6 +140,7 @@ void DialogTaskManager::onTaskStarted(TaskId taskId)
     m_taskIdToWidget.insert(taskId, widget);
     ++m_taskCount;
     this->onTaskProgressStep(taskId, QString());
+    this->updateThreadUsage();
 }
 
 void DialogTaskManager::onTaskEnded(TaskId taskId)
@@ -154,6 +156,7 @@ void DialogTaskManager::onTaskEnded(TaskId taskId)
     }
 
     --m_taskCount;
+    this->updateThreadUsage();
     if (m_taskCount == 0) {
         m_isRunning = false;
         this->accept();
@@ -166,6 +169,7 @@ void DialogTaskManager::onTaskProgress(TaskId taskId, int percent)
     if (widget) {
         if (percent >= 0) {
             widget->m_progress->setValue(percent);
+            this->updateThreadUsage();
         }
         else {
             widget->createUnboundedProgressTimer();
@@ -201,6 +205,17 @@ void DialogTaskManager::interruptTask()
     }
 }
 
+void DialogTaskManager::updateThreadUsage()
+{
+    const QString strOccPoolState = ThreadBudget::isOccPoolInUse() ? tr("busy") : tr("idle");
+    m_ui->label_ThreadUsage->setText(
+                tr("Running tasks: %1/%2 - OpenCascade thread pool: %3 threads (%4)")
+                .arg(m_taskMgr->runningTaskCount())
+                .arg(ThreadBudget::threadCount())
+                .arg(ThreadBudget::occPoolThreadCount())
+                .arg(strOccPoolState));
+}
+
 DialogTaskManager::TaskWidget* DialogTaskManager::taskWidget(TaskId taskId)
 {
     auto it = m_taskIdToWidget.find(taskId);
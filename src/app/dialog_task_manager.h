@@ -30,6 +30,7 @@ private:
     void onTaskProgress(TaskId taskId, int percent);
     void onTaskProgressStep(TaskId taskId, const QString& name);
     void interruptTask();
+    void updateThreadUsage();
 
     class Ui_DialogTaskManager* m_ui = nullptr;
     TaskManager* m_taskMgr = nullptr;
@@ -6,21 +6,47 @@
 
 #include "document_tree_node_properties_providers.h"
 
+#include "../base/bnd_utils.h"
 #include "../base/caf_utils.h"
 #include "../base/document.h"
 #include "../base/document_tree_node.h"
+#include "../base/mass_properties.h"
+#include "../base/mesh_analysis.h"
+#include "../base/mesh_utils.h"
 #include "../base/meta_enum.h"
+#include "../base/point_cloud.h"
 #include "../base/string_utils.h"
+#include "../base/task_manager.h"
+#include "../base/tessellation.h"
 #include "../base/xcaf.h"
 
 #include <TDataXtd_Triangulation.hxx>
+#include <TopoDS_TShape.hxx>
+#include <QtCore/QTimer>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <functional>
+#include <shared_mutex>
 
 namespace Mayo {
 
+namespace Internal {
+
+// Dimensions of an oriented bounding box, in decreasing order
+static std::array<double, 3> orientedBoxDimensions(const Bnd_OBB& obb)
+{
+    std::array<double, 3> dims = { 2 * obb.XHSize(), 2 * obb.YHSize(), 2 * obb.ZHSize() };
+    std::sort(dims.begin(), dims.end(), std::greater<double>());
+    return dims;
+}
+
+} // namespace Internal
+
 class XCaf_DocumentTreeNodePropertiesProvider::Properties : public PropertyGroupSignals {
     MAYO_DECLARE_TEXT_ID_FUNCTIONS(Mayo::XCaf_DocumentTreeNodeProperties)
 public:
-    Properties(const DocumentTreeNode& treeNode)
+    Properties(const DocumentTreeNode& treeNode, DocumentTreeNodePropertiesComputer* computer)
         : m_propertyName(this, textId("Name")),
           m_propertyShapeType(this, textId("Shape")),
           m_propertyXdeShapeKind(this, textId("XdeShape")),
@@ -34,6 +60,16 @@ public:
           m_propertyReferredValidationCentroid(this, textId("ProductCentroid")),
           m_propertyReferredValidationArea(this, textId("ProductArea")),
           m_propertyReferredValidationVolume(this, textId("ProductVolume")),
+          m_propertyComputedStatus(this, textId("ComputedProperties")),
+          m_propertyComputedArea(this, textId("ComputedArea")),
+          m_propertyComputedVolume(this, textId("ComputedVolume")),
+          m_propertyComputedCentroid(this, textId("ComputedCentroid")),
+          m_propertyBndBoxMin(this, textId("BoundingBoxMin")),
+          m_propertyBndBoxMax(this, textId("BoundingBoxMax")),
+          m_propertyOrientedBoxCenter(this, textId("OrientedBoxCenter")),
+          m_propertyOrientedBoxLength(this, textId("OrientedBoxLength")),
+          m_propertyOrientedBoxWidth(this, textId("OrientedBoxWidth")),
+          m_propertyOrientedBoxHeight(this, textId("OrientedBoxHeight")),
           m_label(treeNode.label())
     {
         const TDF_Label& label = m_label;
@@ -129,6 +165,70 @@ public:
             this->removeProperty(&m_propertyReferredColor);
         }
 
+        // Properties computed from geometry, asynchronously if not already in cache
+        const TopoDS_Shape shape = XCAFDoc_ShapeTool::GetShape(label);
+        auto fnFindComputed = [=](MassProperties* massProps, Bnd_OBB* obb) {
+            return MassPropertiesCache::find(shape, massProps)
+                    && OrientedBoundingBoxCache::find(shape, obb);
+        };
+        MassProperties massProps;
+        Bnd_OBB obb;
+        const bool isComputed = fnFindComputed(&massProps, &obb);
+        if (isComputed) {
+            this->removeProperty(&m_propertyComputedStatus);
+            m_propertyComputedArea.setQuantity(massProps.area * Quantity_SquaredMillimeter);
+            m_propertyComputedVolume.setQuantity(massProps.volume * Quantity_CubicMillimeter);
+            m_propertyComputedCentroid.setValue(massProps.centroid);
+            if (!massProps.hasVolume)
+                this->removeProperty(&m_propertyComputedVolume);
+        }
+        else {
+            m_propertyComputedStatus.setValue(textId("Computing...").tr());
+            this->removeProperty(&m_propertyComputedArea);
+            this->removeProperty(&m_propertyComputedVolume);
+            this->removeProperty(&m_propertyComputedCentroid);
+            // Task outlives this object if selection changes, results are kept in cache anyway
+            computer->compute(
+                        shape.TShape(),
+                        textId("Mass properties").tr(),
+                        [=](TaskProgress* progress) {
+                            MassPropertiesCache::compute(shape, progress);
+                            if (!TaskProgress::isAbortRequested(progress))
+                                OrientedBoundingBoxCache::compute(shape);
+                        },
+                        this,
+                        [=]{
+                            MassProperties massPropsComputed;
+                            Bnd_OBB obbComputed;
+                            return fnFindComputed(&massPropsComputed, &obbComputed);
+                        });
+        }
+
+        // Bounding boxes, the oriented one is computed along with mass properties
+        const Bnd_Box bndBox = BndUtils::geometryBoundingBox(shape);
+        if (!bndBox.IsVoid()) {
+            m_propertyBndBoxMin.setValue(bndBox.CornerMin());
+            m_propertyBndBoxMax.setValue(bndBox.CornerMax());
+        }
+        else {
+            this->removeProperty(&m_propertyBndBoxMin);
+            this->removeProperty(&m_propertyBndBoxMax);
+        }
+
+        if (isComputed && !obb.IsVoid()) {
+            const std::array<double, 3> dims = Internal::orientedBoxDimensions(obb);
+            m_propertyOrientedBoxCenter.setValue(gp_Pnt(obb.Center()));
+            m_propertyOrientedBoxLength.setQuantity(dims.at(0) * Quantity_Millimeter);
+            m_propertyOrientedBoxWidth.setQuantity(dims.at(1) * Quantity_Millimeter);
+            m_propertyOrientedBoxHeight.setQuantity(dims.at(2) * Quantity_Millimeter);
+        }
+        else {
+            this->removeProperty(&m_propertyOrientedBoxCenter);
+            this->removeProperty(&m_propertyOrientedBoxLength);
+            this->removeProperty(&m_propertyOrientedBoxWidth);
+            this->removeProperty(&m_propertyOrientedBoxHeight);
+        }
+
         for (Property* prop : this->properties())
             prop->setUserReadOnly(true);
 
@@ -161,10 +261,78 @@ public:
     PropertyArea m_propertyReferredValidationArea;
     PropertyVolume m_propertyReferredValidationVolume;
 
+    PropertyQString m_propertyComputedStatus;
+    PropertyArea m_propertyComputedArea;
+    PropertyVolume m_propertyComputedVolume;
+    PropertyOccPnt m_propertyComputedCentroid;
+
+    PropertyOccPnt m_propertyBndBoxMin;
+    PropertyOccPnt m_propertyBndBoxMax;
+    PropertyOccPnt m_propertyOrientedBoxCenter;
+    PropertyLength m_propertyOrientedBoxLength;
+    PropertyLength m_propertyOrientedBoxWidth;
+    PropertyLength m_propertyOrientedBoxHeight;
+
     TDF_Label m_label;
     TDF_Label m_labelReferred;
 };
 
+DocumentTreeNodePropertiesComputer::DocumentTreeNodePropertiesComputer()
+    : m_taskMgr(new TaskManager)
+{
+    QObject::connect(
+                m_taskMgr.get(), &TaskManager::ended,
+                m_taskMgr.get(), [=](TaskId taskId) {
+        auto it = std::find_if(
+                    m_mapTask.cbegin(), m_mapTask.cend(),
+                    [=](const auto& pair) { return pair.second == taskId; });
+        if (it != m_mapTask.cend())
+            m_mapTask.erase(it);
+    });
+}
+
+DocumentTreeNodePropertiesComputer::~DocumentTreeNodePropertiesComputer()
+{
+    for (const auto& pair : m_mapTask) {
+        m_taskMgr->requestAbort(pair.second);
+        m_taskMgr->waitForDone(pair.second);
+    }
+}
+
+void DocumentTreeNodePropertiesComputer::compute(
+        const Handle_Standard_Transient& object,
+        const QString& title,
+        TaskJob fn,
+        PropertyGroupSignals* props,
+        std::function<bool()> fnIsComputed)
+{
+    TaskId taskId = 0;
+    auto it = m_mapTask.find(object.get());
+    if (it != m_mapTask.cend()) {
+        taskId = it->second;
+    }
+    else {
+        // 'object' is captured, so its address can't be reused by another object until task ends
+        // Geometry is read, so triangulations mustn't be replaced meanwhile
+        taskId = m_taskMgr->newTask([=](TaskProgress* progress) {
+            const std::shared_lock<std::shared_mutex> lock(Tessellation::triangulationMutex());
+            if (!object.IsNull())
+                fn(progress);
+        });
+        m_taskMgr->setTitle(taskId, title);
+        m_mapTask.insert({ object.get(), taskId });
+        m_taskMgr->run(taskId);
+    }
+
+    QObject::connect(m_taskMgr.get(), &TaskManager::ended, props, [=](TaskId endedTaskId) {
+        if (endedTaskId == taskId && fnIsComputed())
+            emit props->propertyListChanged(); // Not emitted if task was aborted
+    });
+    // Task may have ended before the connection above
+    if (fnIsComputed())
+        QTimer::singleShot(0, props, [=]{ emit props->propertyListChanged(); });
+}
+
 bool XCaf_DocumentTreeNodePropertiesProvider::supports(const DocumentTreeNode& treeNode) const
 {
     return XCaf::isShape(treeNode.label());
@@ -176,15 +344,32 @@ XCaf_DocumentTreeNodePropertiesProvider::properties(const DocumentTreeNode& tree
     if (!treeNode.isValid())
         return {};
 
-    return std::make_unique<Properties>(treeNode);
+    return std::make_unique<Properties>(treeNode, &m_computer);
 }
 
 class Mesh_DocumentTreeNodePropertiesProvider::Properties : public PropertyGroupSignals {
     MAYO_DECLARE_TEXT_ID_FUNCTIONS(Mayo::Mesh_DocumentTreeNodeProperties)
 public:
-        Properties(const DocumentTreeNode& treeNode)
+        Properties(const DocumentTreeNode& treeNode, DocumentTreeNodePropertiesComputer* computer)
       : m_propertyNodeCount(this, textId("NodeCount")),
-        m_propertyTriangleCount(this, textId("TriangleCount"))
+        m_propertyTriangleCount(this, textId("TriangleCount")),
+        m_propertyArea(this, textId("Area")),
+        m_propertyVolume(this, textId("Volume")),
+        m_propertyCentroid(this, textId("Centroid")),
+        m_propertyInertia(this, textId("Inertia")),
+        m_propertyBndBoxMin(this, textId("BoundingBoxMin")),
+        m_propertyBndBoxMax(this, textId("BoundingBoxMax")),
+        m_propertyOrientedBoxCenter(this, textId("OrientedBoxCenter")),
+        m_propertyOrientedBoxLength(this, textId("OrientedBoxLength")),
+        m_propertyOrientedBoxWidth(this, textId("OrientedBoxWidth")),
+        m_propertyOrientedBoxHeight(this, textId("OrientedBoxHeight")),
+        m_propertyComponentCount(this, textId("Components")),
+        m_propertyBoundaryEdgeCount(this, textId("BoundaryEdges")),
+        m_propertyNonManifoldEdgeCount(this, textId("NonManifoldEdges")),
+        m_propertyMisorientedEdgeCount(this, textId("MisorientedEdges")),
+        m_propertyDegenerateTriangleCount(this, textId("DegenerateTriangles")),
+        m_propertySliverTriangleCount(this, textId("SliverTriangles")),
+        m_propertyDuplicateTriangleCount(this, textId("DuplicateTriangles"))
     {
         auto attrTriangulation = CafUtils::findAttribute<TDataXtd_Triangulation>(treeNode.label());
         Handle_Poly_Triangulation polyTri;
@@ -193,12 +378,104 @@ public:
 
         m_propertyNodeCount.setValue(!polyTri.IsNull() ? polyTri->NbNodes() : 0);
         m_propertyTriangleCount.setValue(!polyTri.IsNull() ? polyTri->NbTriangles() : 0);
-        m_propertyNodeCount.setUserReadOnly(true);
-        m_propertyTriangleCount.setUserReadOnly(true);
+
+        // Integral properties
+        const MeshUtils::TriangulationProperties meshProps =
+                MeshUtils::triangulationProperties(polyTri);
+        m_propertyArea.setQuantity(meshProps.area * Quantity_SquaredMillimeter);
+        m_propertyVolume.setQuantity(std::abs(meshProps.signedVolume) * Quantity_CubicMillimeter);
+        m_propertyCentroid.setValue(meshProps.centroid);
+        const gp_Mat& inertia = meshProps.inertia;
+        m_propertyInertia.setValue(
+                    QString("Ixx=%1 Iyy=%2 Izz=%3 Ixy=%4 Ixz=%5 Iyz=%6")
+                    .arg(inertia.Value(1, 1)).arg(inertia.Value(2, 2)).arg(inertia.Value(3, 3))
+                    .arg(inertia.Value(1, 2)).arg(inertia.Value(1, 3)).arg(inertia.Value(2, 3)));
+        if (!meshProps.bndBox.IsVoid()) {
+            m_propertyBndBoxMin.setValue(meshProps.bndBox.CornerMin());
+            m_propertyBndBoxMax.setValue(meshProps.bndBox.CornerMax());
+        }
+        else {
+            this->removeProperty(&m_propertyBndBoxMin);
+            this->removeProperty(&m_propertyBndBoxMax);
+        }
+
+        // Oriented bounding box, asynchronously if not already in cache
+        Bnd_OBB obb;
+        if (!polyTri.IsNull() && !OrientedBoundingBoxCache::find(polyTri, &obb)) {
+            computer->compute(
+                        polyTri,
+                        textId("Oriented bounding box").tr(),
+                        [=](TaskProgress*) { OrientedBoundingBoxCache::compute(polyTri); },
+                        this,
+                        [=]{
+                            Bnd_OBB obbComputed;
+                            return OrientedBoundingBoxCache::find(polyTri, &obbComputed);
+                        });
+        }
+
+        if (!obb.IsVoid()) {
+            const std::array<double, 3> dims = Internal::orientedBoxDimensions(obb);
+            m_propertyOrientedBoxCenter.setValue(gp_Pnt(obb.Center()));
+            m_propertyOrientedBoxLength.setQuantity(dims.at(0) * Quantity_Millimeter);
+            m_propertyOrientedBoxWidth.setQuantity(dims.at(1) * Quantity_Millimeter);
+            m_propertyOrientedBoxHeight.setQuantity(dims.at(2) * Quantity_Millimeter);
+        }
+        else {
+            this->removeProperty(&m_propertyOrientedBoxCenter);
+            this->removeProperty(&m_propertyOrientedBoxLength);
+            this->removeProperty(&m_propertyOrientedBoxWidth);
+            this->removeProperty(&m_propertyOrientedBoxHeight);
+        }
+
+        if (std::abs(meshProps.signedVolume) <= 0.) {
+            this->removeProperty(&m_propertyVolume);
+            this->removeProperty(&m_propertyInertia);
+        }
+
+        // Quality and topology, available once the mesh was analyzed
+        auto analysis = !polyTri.IsNull() ? MeshAnalysisCache::find(polyTri) : nullptr;
+        if (analysis) {
+            m_propertyComponentCount.setValue(analysis->componentCount);
+            m_propertyBoundaryEdgeCount.setValue(int(analysis->vecBoundaryEdge.size()));
+            m_propertyNonManifoldEdgeCount.setValue(int(analysis->vecNonManifoldEdge.size()));
+            m_propertyMisorientedEdgeCount.setValue(int(analysis->vecMisorientedEdge.size()));
+            m_propertyDegenerateTriangleCount.setValue(int(analysis->vecDegenerateTriangle.size()));
+            m_propertySliverTriangleCount.setValue(int(analysis->vecSliverTriangle.size()));
+            m_propertyDuplicateTriangleCount.setValue(int(analysis->vecDuplicateTriangle.size()));
+        }
+        else {
+            this->removeProperty(&m_propertyComponentCount);
+            this->removeProperty(&m_propertyBoundaryEdgeCount);
+            this->removeProperty(&m_propertyNonManifoldEdgeCount);
+            this->removeProperty(&m_propertyMisorientedEdgeCount);
+            this->removeProperty(&m_propertyDegenerateTriangleCount);
+            this->removeProperty(&m_propertySliverTriangleCount);
+            this->removeProperty(&m_propertyDuplicateTriangleCount);
+        }
+
+        for (Property* prop : this->properties())
+            prop->setUserReadOnly(true);
     }
 
     PropertyInt m_propertyNodeCount; // Read-only
     PropertyInt m_propertyTriangleCount; // Read-only
+    PropertyArea m_propertyArea; // Read-only
+    PropertyVolume m_propertyVolume; // Read-only
+    PropertyOccPnt m_propertyCentroid; // Read-only
+    PropertyQString m_propertyInertia; // Read-only
+    PropertyOccPnt m_propertyBndBoxMin; // Read-only
+    PropertyOccPnt m_propertyBndBoxMax; // Read-only
+    PropertyOccPnt m_propertyOrientedBoxCenter; // Read-only
+    PropertyLength m_propertyOrientedBoxLength; // Read-only
+    PropertyLength m_propertyOrientedBoxWidth; // Read-only
+    PropertyLength m_propertyOrientedBoxHeight; // Read-only
+    PropertyInt m_propertyComponentCount; // Read-only
+    PropertyInt m_propertyBoundaryEdgeCount; // Read-only
+    PropertyInt m_propertyNonManifoldEdgeCount; // Read-only
+    PropertyInt m_propertyMisorientedEdgeCount; // Read-only
+    PropertyInt m_propertyDegenerateTriangleCount; // Read-only
+    PropertyInt m_propertySliverTriangleCount; // Read-only
+    PropertyInt m_propertyDuplicateTriangleCount; // Read-only
 };
 
 bool Mesh_DocumentTreeNodePropertiesProvider::supports(const DocumentTreeNode& treeNode) const
@@ -208,6 +485,58 @@ bool Mesh_DocumentTreeNodePropertiesProvider::supports(const DocumentTreeNode& t
 
 std::unique_ptr<PropertyGroupSignals>
 Mesh_DocumentTreeNodePropertiesProvider::properties(const DocumentTreeNode& treeNode) const
+{
+    if (!treeNode.isValid())
+        return {};
+
+    return std::make_unique<Properties>(treeNode, &m_computer);
+}
+
+class PointCloud_DocumentTreeNodePropertiesProvider::Properties : public PropertyGroupSignals {
+    MAYO_DECLARE_TEXT_ID_FUNCTIONS(Mayo::PointCloud_DocumentTreeNodeProperties)
+public:
+    Properties(const DocumentTreeNode& treeNode)
+        : m_propertyPointCount(this, textId("PointCount")),
+          m_propertyHasColors(this, textId("HasColors")),
+          m_propertyOctreeNodeCount(this, textId("OctreeNodeCount")),
+          m_propertyBndBoxMin(this, textId("BoundingBoxMin")),
+          m_propertyBndBoxMax(this, textId("BoundingBoxMax"))
+    {
+        auto attrPointCloud = CafUtils::findAttribute<PointCloudAttribute>(treeNode.label());
+        Handle_PointCloud cloud;
+        if (!attrPointCloud.IsNull())
+            cloud = attrPointCloud->get();
+
+        m_propertyPointCount.setValue(!cloud.IsNull() ? cloud->pointCount() : 0);
+        m_propertyHasColors.setValue(!cloud.IsNull() ? cloud->hasColors() : false);
+        m_propertyOctreeNodeCount.setValue(!cloud.IsNull() ? int(cloud->octree().size()) : 0);
+        if (!cloud.IsNull() && !cloud->boundingBox().IsVoid()) {
+            m_propertyBndBoxMin.setValue(cloud->boundingBox().CornerMin());
+            m_propertyBndBoxMax.setValue(cloud->boundingBox().CornerMax());
+        }
+        else {
+            this->removeProperty(&m_propertyBndBoxMin);
+            this->removeProperty(&m_propertyBndBoxMax);
+        }
+
+        for (Property* prop : this->properties())
+            prop->setUserReadOnly(true);
+    }
+
+    PropertyInt m_propertyPointCount; // Read-only
+    PropertyBool m_propertyHasColors; // Read-only
+    PropertyInt m_propertyOctreeNodeCount; // Read-only
+    PropertyOccPnt m_propertyBndBoxMin; // Read-only
+    PropertyOccPnt m_propertyBndBoxMax; // Read-only
+};
+
+bool PointCloud_DocumentTreeNodePropertiesProvider::supports(const DocumentTreeNode& treeNode) const
+{
+    return CafUtils::hasAttribute<PointCloudAttribute>(treeNode.label());
+}
+
+std::unique_ptr<PropertyGroupSignals>
+PointCloud_DocumentTreeNodePropertiesProvider::properties(const DocumentTreeNode& treeNode) const
 {
     if (!treeNode.isValid())
         return {};
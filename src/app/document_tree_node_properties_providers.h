@@ -8,11 +8,41 @@
 
 #include "../base/document_tree_node_properties_provider.h"
 #include "../base/property_builtins.h"
+#include "../base/task.h"
 
+#include <Standard_Transient.hxx>
 #include <TDF_Label.hxx>
+#include <functional>
+#include <unordered_map>
 
 namespace Mayo {
 
+class TaskManager;
+
+// Computes in background the properties not yet in cache(see MassPropertiesCache for example)
+// There is at most one task per object(TopoDS_TShape, Poly_Triangulation, ...), whatever the
+// count of PropertyGroupSignals waiting for it
+// Tasks don't run on the global TaskManager, so they don't pop up the task manager dialog
+class DocumentTreeNodePropertiesComputer {
+public:
+    DocumentTreeNodePropertiesComputer();
+    ~DocumentTreeNodePropertiesComputer();
+
+    // Runs 'fn' computing the properties of 'object', unless a task is already running for it
+    // 'props' is notified with PropertyGroupSignals::propertyListChanged() once the task ended
+    // and 'fnIsComputed' returns true(ie the task wasn't aborted)
+    void compute(
+            const Handle_Standard_Transient& object,
+            const QString& title,
+            TaskJob fn,
+            PropertyGroupSignals* props,
+            std::function<bool()> fnIsComputed);
+
+private:
+    std::unique_ptr<TaskManager> m_taskMgr;
+    std::unordered_map<const Standard_Transient*, TaskId> m_mapTask; // Tasks in progress
+};
+
 class XCaf_DocumentTreeNodePropertiesProvider : public DocumentTreeNodePropertiesProvider {
 public:
     bool supports(const DocumentTreeNode& treeNode) const override;
@@ -20,6 +50,7 @@ public:
 
 private:
     class Properties;
+    mutable DocumentTreeNodePropertiesComputer m_computer;
 };
 
 class Mesh_DocumentTreeNodePropertiesProvider : public DocumentTreeNodePropertiesProvider {
@@ -27,6 +58,16 @@ public:
     bool supports(const DocumentTreeNode& treeNode) const override;
     std::unique_ptr<PropertyGroupSignals> properties(const DocumentTreeNode& treeNode) const override;
 
+private:
+    class Properties;
+    mutable DocumentTreeNodePropertiesComputer m_computer;
+};
+
+class PointCloud_DocumentTreeNodePropertiesProvider : public DocumentTreeNodePropertiesProvider {
+public:
+    bool supports(const DocumentTreeNode& treeNode) const override;
+    std::unique_ptr<PropertyGroupSignals> properties(const DocumentTreeNode& treeNode) const override;
+
 private:
     class Properties;
 };
@@ -7,8 +7,11 @@
 #include "../base/application.h"
 #include "../base/document_tree_node_properties_provider.h"
 #include "../base/io_occ.h"
+#include "../base/io_occ_stl.h"
+#include "../base/io_point_cloud.h"
 #include "../base/io_system.h"
 #include "../base/settings.h"
+#include "../base/tracing.h"
 #include "../gui/gui_application.h"
 #include "../graphics/graphics_entity_driver.h"
 #include "app_module.h"
@@ -27,6 +30,7 @@
 #include <QtWidgets/QApplication>
 #include <iostream>
 #include <memory>
+#include <vector>
 
 namespace Mayo {
 
@@ -34,9 +38,40 @@ class Main { Q_DECLARE_TR_FUNCTIONS(Mayo::Main) };
 
 struct CommandLineArguments {
     QString themeName;
+    QString traceFilepath;
     QStringList listFileToOpen;
+    bool meshSimplifyOn = false;
+    MeshDecimationParameters meshSimplification;
 };
 
+// Parses a mesh simplification target, one of "N"(triangle count), "X%"(ratio of the initial
+// triangle count) or "Emm"(maximum error as a length in millimeters)
+static bool parseMeshSimplificationTarget(QString str, MeshDecimationParameters* params)
+{
+    bool ok = false;
+    str = str.trimmed();
+    if (str.endsWith('%')) {
+        const double pct = str.left(str.size() - 1).toDouble(&ok);
+        ok = ok && pct > 0 && pct <= 100;
+        params->targetMode = MeshDecimationParameters::TargetMode::Ratio;
+        params->targetRatio = pct / 100.;
+    }
+    else if (str.endsWith("mm")) {
+        const double error = str.left(str.size() - 2).toDouble(&ok);
+        ok = ok && error >= 0;
+        params->targetMode = MeshDecimationParameters::TargetMode::MaxError;
+        params->maxError = error;
+    }
+    else {
+        const int count = str.toInt(&ok);
+        ok = ok && count > 0;
+        params->targetMode = MeshDecimationParameters::TargetMode::TriangleCount;
+        params->targetTriangleCount = count;
+    }
+
+    return ok;
+}
+
 static CommandLineArguments processCommandLine()
 {
     CommandLineArguments args;
@@ -53,6 +88,19 @@ static CommandLineArguments processCommandLine()
                 Main::tr("name"));
     cmdParser.addOption(cmdOptionTheme);
 
+    const QCommandLineOption cmdOptionTrace(
+                "trace",
+                Main::tr("Record timeline events and save them on exit as Chrome trace JSON file"),
+                Main::tr("file"));
+    cmdParser.addOption(cmdOptionTrace);
+
+    const QCommandLineOption cmdOptionSimplifyMesh(
+                "simplify-mesh",
+                Main::tr("Simplify imported STL meshes down to a triangle count(eg 100000), "
+                         "a ratio(eg 25%) or a maximum error(eg 0.05mm)"),
+                Main::tr("target"));
+    cmdParser.addOption(cmdOptionSimplifyMesh);
+
     cmdParser.addPositionalArgument(
                 Main::tr("files"),
                 Main::tr("Files to open at startup, optionally"),
@@ -65,6 +113,18 @@ static CommandLineArguments processCommandLine()
     if (cmdParser.isSet(cmdOptionTheme))
         args.themeName = cmdParser.value(cmdOptionTheme);
 
+    if (cmdParser.isSet(cmdOptionTrace))
+        args.traceFilepath = cmdParser.value(cmdOptionTrace);
+
+    if (cmdParser.isSet(cmdOptionSimplifyMesh)) {
+        const QString strTarget = cmdParser.value(cmdOptionSimplifyMesh);
+        args.meshSimplifyOn = parseMeshSimplificationTarget(strTarget, &args.meshSimplification);
+        if (!args.meshSimplifyOn) {
+            const QString errorText = Main::tr("ERROR: Invalid mesh simplification target '%1'");
+            std::cerr << qUtf8Printable(errorText.arg(strTarget)) << std::endl;
+        }
+    }
+
     args.listFileToOpen = cmdParser.positionalArguments();
 
     return args;
@@ -81,13 +141,17 @@ Theme* mayoTheme()
 static int runApp(QApplication* qtApp)
 {
     const CommandLineArguments args = processCommandLine();
+    if (!args.traceFilepath.isEmpty())
+        Tracing::setEnabled(true);
+
     Application::setOpenCascadeEnvironment("opencascade.conf");
 
     auto app = Application::instance().get();
     auto guiApp = new GuiApplication(app);
 
-    // Register IO OpenCascade objects
+    // Register IO objects
     app->ioSystem()->addFactoryReader(std::make_unique<IO::OccFactoryReader>());
+    app->ioSystem()->addFactoryReader(std::make_unique<IO::PointCloudFactoryReader>());
     app->ioSystem()->addFactoryWriter(std::make_unique<IO::OccFactoryWriter>());
     IO::addPredefinedFormatProbes(app->ioSystem());
 
@@ -98,6 +162,8 @@ static int runApp(QApplication* qtApp)
     // Register Graphics entity drivers
     guiApp->graphicsEntityDriverTable()->addDriver(std::make_unique<GraphicsMeshEntityDriver>());
     guiApp->graphicsEntityDriverTable()->addDriver(std::make_unique<GraphicsShapeEntityDriver>());
+    guiApp->graphicsEntityDriverTable()->addDriver(
+                std::make_unique<GraphicsPointCloudEntityDriver>());
 
     // Register AppModule
     auto appModule = new AppModule(app);
@@ -107,6 +173,8 @@ static int runApp(QApplication* qtApp)
                 std::make_unique<XCaf_DocumentTreeNodePropertiesProvider>());
     app->documentTreeNodePropertiesProviderTable()->addProvider(
                 std::make_unique<Mesh_DocumentTreeNodePropertiesProvider>());
+    app->documentTreeNodePropertiesProviderTable()->addProvider(
+                std::make_unique<PointCloud_DocumentTreeNodePropertiesProvider>());
 
     // Register WidgetModelTreeBuilter prototypes
     WidgetModelTree::addPrototypeBuilder(std::make_unique<WidgetModelTreeBuilder_Mesh>());
@@ -142,8 +210,28 @@ static int runApp(QApplication* qtApp)
 
     app->settings()->resetAll();
     app->settings()->load();
+    // Mesh simplification requested on command-line overrides STL reader settings for this
+    // session only, previous values are restored before settings are saved
+    PropertyGroup* stlReaderParams = appModule->findReaderParameters(IO::Format_STL);
+    std::vector<QVariant> vecStlReaderParamValue;
+    if (args.meshSimplifyOn && stlReaderParams) {
+        for (const Property* property : stlReaderParams->properties())
+            vecStlReaderParamValue.push_back(property->valueAsVariant());
+
+        IO::OccStlReader::setSimplificationProperties(stlReaderParams, args.meshSimplification);
+    }
+
     const int code = qtApp->exec();
+    for (size_t i = 0; i < vecStlReaderParamValue.size(); ++i)
+        stlReaderParams->properties()[i]->setValueFromVariant(vecStlReaderParamValue.at(i));
+
     app->settings()->save();
+    app->waitForReleasedDocuments();
+    if (!args.traceFilepath.isEmpty() && !Tracing::writeChromeTraceFile(args.traceFilepath)) {
+        const QString errorText = Main::tr("ERROR: Failed to write trace file '%1'").arg(args.traceFilepath);
+        std::cerr << qUtf8Printable(errorText) << std::endl;
+    }
+
     return code;
 }
 
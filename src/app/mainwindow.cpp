@@ -9,28 +9,39 @@
 
 #include "../base/application.h"
 #include "../base/application_item_selection_model.h"
+#include "../base/caf_utils.h"
 #include "../base/document.h"
 #include "../base/io_format.h"
 #include "../base/io_system.h"
+#include "../base/mesh_analysis.h"
+#include "../base/mesh_decimation.h"
+#include "../base/mesh_normals.h"
 #include "../base/messenger.h"
+#include "../base/scope_import.h"
 #include "../base/settings.h"
 #include "../base/task_manager.h"
+#include "../base/tessellation.h"
+#include "../base/tracing.h"
+#include "../graphics/ais_mesh_defects.h"
 #include "../graphics/graphics_entity_driver.h"
 #include "../graphics/graphics_utils.h"
 #include "../gui/gui_application.h"
 #include "../gui/gui_document.h"
 #include "../gui/gui_document_list_model.h"
+#include "../gui/gui_hidden_line_display.h"
 #include "app_module.h"
 #include "dialog_about.h"
 #include "dialog_inspect_xde.h"
 #include "dialog_options.h"
 #include "dialog_save_image_view.h"
+#include "dialog_simplify_mesh.h"
 #include "dialog_task_manager.h"
 #include "document_tree_node_properties_providers.h"
 #include "theme.h"
 #include "widget_file_system.h"
 #include "widget_gui_document.h"
 #include "widget_message_indicator.h"
+#include "widget_metrics.h"
 #include "widget_model_tree.h"
 #include "widget_occ_view_controller.h"
 #include "widget_properties_editor.h"
@@ -51,9 +62,14 @@
 #include <QtGui/QDropEvent>
 #include <QtWidgets/QActionGroup>
 #include <QtWidgets/QApplication>
+#include <QtWidgets/QDockWidget>
 #include <QtWidgets/QFileDialog>
 #include <QtDebug>
 
+#include <TDataXtd_Triangulation.hxx>
+#include <memory>
+#include <shared_mutex>
+
 namespace Mayo {
 
 namespace Internal {
@@ -182,6 +198,19 @@ static void handleMessage(Messenger::MessageType msgType, const QString& text, Q
     }
 }
 
+// Returns the single selected entity being a mesh(triangulation attribute), null node otherwise
+static DocumentTreeNode findMeshEntity(Span<const ApplicationItem> spanAppItem)
+{
+    if (spanAppItem.size() != 1 || !spanAppItem[0].isDocumentTreeNode())
+        return DocumentTreeNode::null();
+
+    const DocumentTreeNode& node = spanAppItem[0].documentTreeNode();
+    if (node.isEntity() && CafUtils::hasAttribute<TDataXtd_Triangulation>(node.label()))
+        return node;
+
+    return DocumentTreeNode::null();
+}
+
 } // namespace Internal
 
 MainWindow::MainWindow(GuiApplication* guiApp, QWidget *parent)
@@ -223,6 +252,7 @@ MainWindow::MainWindow(GuiApplication* guiApp, QWidget *parent)
     m_ui->actionToggleLeftSidebar->setChecked(m_ui->widget_Left->isVisible());
     m_ui->actionToggleFullscreen->setChecked(this->isFullScreen());
     m_ui->actionToggleOriginTrihedron->setChecked(false);
+    m_ui->actionRecordTrace->setChecked(Tracing::isEnabled());
 
     mayoTheme()->setupHeaderComboBox(m_ui->combo_LeftContents);
     mayoTheme()->setupHeaderComboBox(m_ui->combo_GuiDocuments);
@@ -273,12 +303,12 @@ MainWindow::MainWindow(GuiApplication* guiApp, QWidget *parent)
     }
     QObject::connect(m_ui->menu_Projection, &QMenu::triggered, this, [=](QAction* action){
         if (this->currentWidgetGuiDocument()) {
-            const GuiDocument* guiDoc = this->currentWidgetGuiDocument()->guiDocument();
+            GuiDocument* guiDoc = this->currentWidgetGuiDocument()->guiDocument();
             guiDoc->v3dView()->Camera()->SetProjectionType(
                         action == m_ui->actionProjectionOrthographic ?
                             Graphic3d_Camera::Projection_Orthographic :
                             Graphic3d_Camera::Projection_Perspective);
-            guiDoc->v3dView()->Update();
+            guiDoc->graphicsScene()->redraw();
         }
     });
     QObject::connect(
@@ -297,6 +327,18 @@ MainWindow::MainWindow(GuiApplication* guiApp, QWidget *parent)
     QObject::connect(
                 m_ui->actionInspectXDE, &QAction::triggered,
                 this, &MainWindow::inspectXde);
+    QObject::connect(
+                m_ui->actionSimplifyMesh, &QAction::triggered,
+                this, &MainWindow::simplifyMesh);
+    QObject::connect(
+                m_ui->actionShowMeshDefects, &QAction::triggered,
+                this, &MainWindow::showMeshDefects);
+    QObject::connect(
+                m_ui->actionRecordTrace, &QAction::toggled,
+                [](bool on) { Tracing::setEnabled(on); });
+    QObject::connect(
+                m_ui->actionSaveTrace, &QAction::triggered,
+                this, &MainWindow::saveTrace);
     QObject::connect(
                 m_ui->actionOptions, &QAction::triggered,
                 this, &MainWindow::editOptions);
@@ -343,6 +385,32 @@ MainWindow::MainWindow(GuiApplication* guiApp, QWidget *parent)
     QObject::connect(
                 guiApp->selectionModel(), &ApplicationItemSelectionModel::changed,
                 this, &MainWindow::onApplicationItemSelectionChanged);
+    QObject::connect(
+                guiApp->application()->settings(), &Settings::changed,
+                this, [=](Property* property) {
+        const AppModule* appModule = AppModule::get(guiApp->application());
+        if (property == &appModule->graphicsStaticBatching) {
+            for (GuiDocument* guiDoc : guiApp->guiDocuments()) {
+                guiDoc->graphicsScene()->setStaticBatchingEnabled(
+                            appModule->graphicsStaticBatching.value());
+                guiDoc->graphicsScene()->redraw();
+            }
+        }
+        else if (property == &appModule->graphicsHlrExact) {
+            for (GuiDocument* guiDoc : guiApp->guiDocuments())
+                guiDoc->hiddenLineDisplay()->setAlgorithm(appModule->hlrAlgorithm());
+        }
+        else if (property == &appModule->graphicsInteractionLod) {
+            for (GuiDocument* guiDoc : guiApp->guiDocuments())
+                guiDoc->setInteractionLodEnabled(appModule->graphicsInteractionLod.value());
+        }
+        else if (property == &appModule->graphicsFrameStatsOverlay) {
+            for (GuiDocument* guiDoc : guiApp->guiDocuments()) {
+                guiDoc->graphicsScene()->setFrameStatsOverlayVisible(
+                            appModule->graphicsFrameStatsOverlay.value());
+            }
+        }
+    });
     QObject::connect(
                 m_ui->listView_OpenedDocuments, &QListView::clicked,
                 [=](const QModelIndex& index) { this->setCurrentDocumentIndex(index.row()); });
@@ -374,6 +442,15 @@ MainWindow::MainWindow(GuiApplication* guiApp, QWidget *parent)
 
     new DialogTaskManager(TaskManager::globalInstance(), this);
 
+    // Performance metrics panel, hidden by default
+    auto dockMetrics = new QDockWidget(tr("Performance Metrics"), this);
+    dockMetrics->setObjectName("dock_Metrics");
+    dockMetrics->setWidget(new WidgetMetrics(dockMetrics));
+    this->addDockWidget(Qt::RightDockWidgetArea, dockMetrics);
+    dockMetrics->hide();
+    m_ui->menu_Window->addSeparator();
+    m_ui->menu_Window->addAction(dockMetrics->toggleViewAction());
+
     // BEWARE MainWindow::onGuiDocumentAdded() must be called before
     // MainWindow::onCurrentDocumentIndexChanged()
     auto guiDocModel = new GuiDocumentListModel(guiApp, this);
@@ -482,6 +559,8 @@ void MainWindow::importInCurrentDoc()
         return;
 
     auto app = m_guiApp->application();
+    const TessellationParameters tessellationParams = AppModule::get(app)->tessellationParameters();
+    m_guiApp->setTessellationParameters(tessellationParams);
     auto taskMgr = TaskManager::globalInstance();
     const TaskId taskId = taskMgr->newTask([=](TaskProgress* progress) {
         QTime chrono;
@@ -492,6 +571,7 @@ void MainWindow::importInCurrentDoc()
                 .withParametersProvider(AppModule::get(app))
                 .withMessenger(Messenger::defaultInstance())
                 .withTaskProgress(progress)
+                .withTessellation(tessellationParams)
                 .execute();
         if (okImport)
             Messenger::defaultInstance()->emitInfo(tr("Import time: %1ms").arg(chrono.elapsed()));
@@ -603,6 +683,163 @@ void MainWindow::inspectXde()
     }
 }
 
+void MainWindow::simplifyMesh()
+{
+    const Span<const ApplicationItem> spanAppItem = m_guiApp->selectionModel()->selectedItems();
+    const DocumentTreeNode meshNode = Internal::findMeshEntity(spanAppItem);
+    if (!meshNode.isValid())
+        return;
+
+    const DocumentPtr doc = meshNode.document();
+    const TreeNodeId meshNodeId = meshNode.id();
+    const TDF_Label meshLabel = meshNode.label();
+    const Handle_Poly_Triangulation mesh =
+            CafUtils::findAttribute<TDataXtd_Triangulation>(meshLabel)->Get();
+    if (mesh.IsNull())
+        return;
+
+    auto dlg = new DialogSimplifyMesh(mesh->NbTriangles(), this);
+    QObject::connect(dlg, &QDialog::accepted, this, [=]{
+        const MeshDecimationParameters params = dlg->parameters();
+        const bool keepOriginal = dlg->keepOriginalMesh();
+        const QString meshName = CafUtils::labelAttrStdName(meshLabel);
+        const double creaseAngle = MeshNormals::labelCreaseAngle(meshLabel);
+        auto taskMgr = TaskManager::globalInstance();
+        auto ptrOk = std::make_shared<bool>(false);
+        const TaskId taskId = taskMgr->newTask([=](TaskProgress* progress) {
+            QTime chrono;
+            chrono.start();
+            // Mesh is welded in the document, so decimation keeps its creases connected
+            const Handle_Poly_Triangulation meshSimplified =
+                    MeshDecimation::decimate(mesh, params, progress);
+            if (meshSimplified.IsNull())
+                return;
+
+            SingleScopeImport import(doc);
+            TDataXtd_Triangulation::Set(import.entityLabel(), meshSimplified);
+            if (creaseAngle >= 0.)
+                MeshNormals::setLabelCreaseAngle(import.entityLabel(), creaseAngle);
+
+            const QString simplifiedName = tr("%1 (simplified)").arg(meshName);
+            CafUtils::setLabelAttrStdName(import.entityLabel(), simplifiedName);
+            *ptrOk = true;
+            Messenger::defaultInstance()->emitInfo(
+                        tr("Mesh simplified from %1 to %2 triangles in %3ms")
+                        .arg(mesh->NbTriangles())
+                        .arg(meshSimplified->NbTriangles())
+                        .arg(chrono.elapsed()));
+        });
+
+        // Original mesh is destroyed in GUI thread once the simplified one is added
+        if (!keepOriginal) {
+            auto ptrConnection = std::make_shared<QMetaObject::Connection>();
+            *ptrConnection = QObject::connect(taskMgr, &TaskManager::ended, this, [=](TaskId id) {
+                if (id != taskId)
+                    return;
+
+                QObject::disconnect(*ptrConnection);
+                const bool isMeshAlive =
+                        doc->isEntity(meshNodeId)
+                        && doc->modelTree().nodeData(meshNodeId) == meshLabel;
+                if (*ptrOk && isMeshAlive)
+                    doc->destroyEntity(meshNodeId);
+            });
+        }
+
+        taskMgr->setTitle(taskId, tr("Simplify %1").arg(meshName));
+        taskMgr->run(taskId);
+    });
+    qtgui::QWidgetUtils::asyncDialogExec(dlg);
+}
+
+void MainWindow::showMeshDefects(bool on)
+{
+    const Span<const ApplicationItem> spanAppItem = m_guiApp->selectionModel()->selectedItems();
+    const DocumentTreeNode meshNode = Internal::findMeshEntity(spanAppItem);
+    if (!meshNode.isValid())
+        return;
+
+    const DocumentPtr doc = meshNode.document();
+    const TreeNodeId meshNodeId = meshNode.id();
+    const TDF_Label meshLabel = meshNode.label();
+    GuiDocument* guiDoc = m_guiApp->findGuiDocument(doc);
+    if (guiDoc)
+        guiDoc->removeEntityOverlays(meshNodeId);
+
+    if (!on)
+        return;
+
+    const Handle_Poly_Triangulation mesh =
+            CafUtils::findAttribute<TDataXtd_Triangulation>(meshLabel)->Get();
+    if (mesh.IsNull())
+        return;
+
+    // Called in GUI thread once the analysis is available
+    auto fnShowDefects = [=]{
+        auto analysis = MeshAnalysisCache::find(mesh);
+        GuiDocument* guiDoc = m_guiApp->findGuiDocument(doc);
+        const bool isMeshAlive =
+                doc->isEntity(meshNodeId)
+                && doc->modelTree().nodeData(meshNodeId) == meshLabel;
+        if (!analysis || !guiDoc || !isMeshAlive)
+            return;
+
+        guiDoc->removeEntityOverlays(meshNodeId);
+        guiDoc->addEntityOverlay(meshNodeId, new AIS_MeshDefects(mesh, analysis));
+        this->onApplicationItemSelectionChanged(); // Refresh analysis properties
+        Messenger::defaultInstance()->emitInfo(
+                    tr("%1 : %2 component(s), %3 boundary edge(s), "
+                       "%4 non-manifold edge(s), %5 misoriented edge(s), "
+                       "%6 degenerate, %7 sliver and %8 duplicate triangle(s)")
+                    .arg(CafUtils::labelAttrStdName(meshLabel))
+                    .arg(analysis->componentCount)
+                    .arg(analysis->vecBoundaryEdge.size())
+                    .arg(analysis->vecNonManifoldEdge.size())
+                    .arg(analysis->vecMisorientedEdge.size())
+                    .arg(analysis->vecDegenerateTriangle.size())
+                    .arg(analysis->vecSliverTriangle.size())
+                    .arg(analysis->vecDuplicateTriangle.size()));
+    };
+
+    if (MeshAnalysisCache::find(mesh)) {
+        fnShowDefects();
+        return;
+    }
+
+    auto taskMgr = TaskManager::globalInstance();
+    const TaskId taskId = taskMgr->newTask([=](TaskProgress* progress) {
+        const std::shared_lock<std::shared_mutex> lock(Tessellation::triangulationMutex());
+        MeshAnalysisCache::compute(mesh, progress);
+    });
+    auto ptrConnection = std::make_shared<QMetaObject::Connection>();
+    *ptrConnection = QObject::connect(taskMgr, &TaskManager::ended, this, [=](TaskId id) {
+        if (id != taskId)
+            return;
+
+        QObject::disconnect(*ptrConnection);
+        fnShowDefects();
+    });
+    taskMgr->setTitle(taskId, tr("Analyze %1").arg(CafUtils::labelAttrStdName(meshLabel)));
+    taskMgr->run(taskId);
+}
+
+void MainWindow::saveTrace()
+{
+    const QString filepath =
+            QFileDialog::getSaveFileName(
+                this,
+                tr("Select Output File"),
+                QString(),
+                tr("Chrome Trace (*.json)"));
+    if (filepath.isEmpty())
+        return;
+
+    if (Tracing::writeChromeTraceFile(filepath))
+        Messenger::defaultInstance()->emitInfo(tr("Trace saved to '%1'").arg(filepath));
+    else
+        Messenger::defaultInstance()->emitError(tr("Failed to write trace file '%1'").arg(filepath));
+}
+
 void MainWindow::toggleFullscreen()
 {
     if (this->isFullScreen()) {
@@ -653,6 +890,10 @@ void MainWindow::onApplicationItemSelectionChanged()
                 QObject::connect(dataProps, &PropertyGroupSignals::propertyChanged, this, [=]{
                     uiModelTree->refreshItemText(item);
                 });
+                QObject::connect(
+                            dataProps, &PropertyGroupSignals::propertyListChanged,
+                            this, &MainWindow::onApplicationItemSelectionChanged,
+                            Qt::QueuedConnection);
             }
 
             GuiDocument* guiDoc = m_guiApp->findGuiDocument(item.document());
@@ -707,6 +948,12 @@ void MainWindow::onGuiDocumentAdded(GuiDocument* guiDoc)
 {
     auto app = m_guiApp->application();
     auto widget = new WidgetGuiDocument(guiDoc);
+    guiDoc->graphicsScene()->setStaticBatchingEnabled(
+                AppModule::get(app)->graphicsStaticBatching.value());
+    guiDoc->hiddenLineDisplay()->setAlgorithm(AppModule::get(app)->hlrAlgorithm());
+    guiDoc->setInteractionLodEnabled(AppModule::get(app)->graphicsInteractionLod.value());
+    guiDoc->graphicsScene()->setFrameStatsOverlayVisible(
+                AppModule::get(app)->graphicsFrameStatsOverlay.value());
     if (AppModule::get(app)->defaultShowOriginTrihedron.value()) {
         guiDoc->toggleOriginTrihedronVisibility();
         guiDoc->graphicsScene()->redraw();
@@ -714,9 +961,13 @@ void MainWindow::onGuiDocumentAdded(GuiDocument* guiDoc)
 
     V3dViewController* ctrl = widget->controller();
     QObject::connect(ctrl, &V3dViewController::mouseMoved, [=](const QPoint& pos2d) {
-        guiDoc->graphicsScene()->highlightAt(pos2d, widget->guiDocument()->v3dView());
+        guiDoc->activateSelectionAt(pos2d);
+        guiDoc->graphicsScene()->requestHighlightAt(pos2d, guiDoc->v3dView());
+    });
+    QObject::connect(
+                guiDoc->graphicsScene(), &GraphicsScene::highlightedAt, [=](const QPoint& pos2d) {
+        // Main selector holds the results of the highlight picking, no need to pick again
         auto selector = guiDoc->graphicsScene()->mainSelector();
-        selector->Pick(pos2d.x(), pos2d.y(), guiDoc->v3dView());
         const gp_Pnt pos3d =
                 selector->NbPicked() > 0 ?
                     selector->PickedPoint(1) :
@@ -820,7 +1071,7 @@ void MainWindow::closeCurrentDocument()
 void MainWindow::closeDocument(WidgetGuiDocument* widget)
 {
     if (widget) {
-        const DocumentPtr& doc = widget->guiDocument()->document();
+        const DocumentPtr doc = widget->guiDocument()->document();
         m_ui->stack_GuiDocuments->removeWidget(widget);
         widget->deleteLater();
         m_guiApp->application()->closeDocument(doc);
@@ -856,6 +1107,8 @@ void MainWindow::closeAllDocuments()
 void MainWindow::openDocumentsFromList(const QStringList& listFilePath)
 {
     auto app = m_guiApp->application();
+    const TessellationParameters tessellationParams = AppModule::get(app)->tessellationParameters();
+    m_guiApp->setTessellationParameters(tessellationParams);
     auto taskMgr = TaskManager::globalInstance();
     static std::mutex mutexApp;
     for (const QString& filePath : listFilePath) {
@@ -881,6 +1134,7 @@ void MainWindow::openDocumentsFromList(const QStringList& listFilePath)
                         .withParametersProvider(AppModule::get(app))
                         .withMessenger(Messenger::defaultInstance())
                         .withTaskProgress(progress)
+                        .withTessellation(tessellationParams)
                         .execute();
                 if (okImport)
                     Messenger::defaultInstance()->emitInfo(tr("Import time: %1ms").arg(chrono.elapsed()));
@@ -930,6 +1184,13 @@ void MainWindow::updateControlsActivation()
                 spanSelectedAppItem.size() == 1
                 && firstAppItem.isValid()
                 && firstAppItem.document()->isXCafDocument());
+    const DocumentTreeNode meshNode = Internal::findMeshEntity(spanSelectedAppItem);
+    m_ui->actionSimplifyMesh->setEnabled(meshNode.isValid());
+    m_ui->actionShowMeshDefects->setEnabled(meshNode.isValid());
+    const GuiDocument* meshGuiDoc =
+            meshNode.isValid() ? m_guiApp->findGuiDocument(meshNode.document()) : nullptr;
+    m_ui->actionShowMeshDefects->setChecked(
+                meshGuiDoc && meshGuiDoc->hasEntityOverlays(meshNode.id()));
 }
 
 int MainWindow::currentDocumentIndex() const
@@ -48,6 +48,9 @@ private:
     void editOptions();
     void saveImageView();
     void inspectXde();
+    void simplifyMesh();
+    void showMeshDefects(bool on);
+    void saveTrace();
     void toggleFullscreen();
     void toggleLeftSidebar();
     void aboutMayo();
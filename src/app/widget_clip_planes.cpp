@@ -11,6 +11,7 @@
 #include "../base/math_utils.h"
 #include "../base/settings.h"
 #include "../base/tkernel_utils.h"
+#include "../graphics/graphics_scene.h"
 #include "../graphics/graphics_utils.h"
 #include "app_module.h"
 #include "ui_widget_clip_planes.h"
@@ -24,10 +25,12 @@
 
 namespace Mayo {
 
-WidgetClipPlanes::WidgetClipPlanes(const Handle_V3d_View& view3d, QWidget* parent)
+WidgetClipPlanes::WidgetClipPlanes(
+        const Handle_V3d_View& view3d, GraphicsScene* gfxScene, QWidget* parent)
     : QWidget(parent),
       m_ui(new Ui_WidgetClipPlanes),
-      m_view(view3d)
+      m_view(view3d),
+      m_gfxScene(gfxScene)
 {
     m_ui->setupUi(this);
     this->createPlaneCappingTexture();
@@ -85,7 +88,7 @@ WidgetClipPlanes::WidgetClipPlanes(const Handle_V3d_View& view3d, QWidget* paren
             for (ClipPlaneData& data : m_vecClipPlaneData)
                 data.graphics->SetCapping(appModule->clipPlanesCappingOn.value());
 
-            m_view->Redraw();
+            m_gfxScene->redraw();
         }
         else if (property == &appModule->clipPlanesCappingHatchOn) {
             Handle_Graphic3d_TextureMap hatchTexture;
@@ -95,7 +98,7 @@ WidgetClipPlanes::WidgetClipPlanes(const Handle_V3d_View& view3d, QWidget* paren
             for (ClipPlaneData& data : m_vecClipPlaneData)
                 data.graphics->SetCappingTexture(hatchTexture);
 
-            m_view->Redraw();
+            m_gfxScene->redraw();
         }
     });
     m_ui->widget_CustomDir->setVisible(false);
@@ -119,7 +122,7 @@ void WidgetClipPlanes::setRanges(const Bnd_Box& bndBox)
             data.ui.check_On->setChecked(false);
     }
 
-    m_view->Redraw();
+    m_gfxScene->redraw();
 }
 
 void WidgetClipPlanes::setClippingOn(bool on)
@@ -127,7 +130,7 @@ void WidgetClipPlanes::setClippingOn(bool on)
     for (ClipPlaneData& data : m_vecClipPlaneData)
         data.graphics->SetOn(on ? data.ui.check_On->isChecked() : false);
 
-    m_view->Redraw();
+    m_gfxScene->redraw();
 }
 
 void WidgetClipPlanes::connectUi(ClipPlaneData* data)
@@ -141,7 +144,7 @@ void WidgetClipPlanes::connectUi(ClipPlaneData* data)
     QObject::connect(ui.check_On, &QCheckBox::clicked, [=](bool on) {
         ui.widget_Control->setEnabled(on);
         this->setPlaneOn(gfx, on);
-        m_view->Redraw();
+        m_gfxScene->redraw();
     });
 
     if (data->ui.customXDirSpin()) {
@@ -165,7 +168,7 @@ void WidgetClipPlanes::connectUi(ClipPlaneData* data)
         const double dPct = ui.spinValueToSliderValue(pos);
         posSlider->setValue(qRound(dPct));
         GraphicsUtils::Gpx3dClipPlane_setPosition(gfx, pos);
-        m_view->Redraw();
+        m_gfxScene->redraw();
     });
 
     QObject::connect(posSlider, &QSlider::valueChanged, [=](int pct) {
@@ -173,14 +176,14 @@ void WidgetClipPlanes::connectUi(ClipPlaneData* data)
         QSignalBlocker sigBlock(posSpin); Q_UNUSED(sigBlock);
         posSpin->setValue(pos);
         GraphicsUtils::Gpx3dClipPlane_setPosition(gfx, pos);
-        m_view->Redraw();
+        m_gfxScene->redraw();
     });
 
     QObject::connect(ui.inverseBtn(), &QAbstractButton::clicked, [=]{
         const gp_Dir invNormal = gfx->ToPlane().Axis().Direction().Reversed();
         GraphicsUtils::Gpx3dClipPlane_setNormal(gfx, invNormal);
         GraphicsUtils::Gpx3dClipPlane_setPosition(gfx, data->ui.posSpin()->value());
-        m_view->Redraw();
+        m_gfxScene->redraw();
     });
 
     // Custom plane normal
@@ -198,7 +201,7 @@ void WidgetClipPlanes::connectUi(ClipPlaneData* data)
                 const auto bbc = BndBoxCoords::get(m_bndBox);
                 this->setPlaneRange(data, MathUtils::planeRange(bbc, normal));
                 GraphicsUtils::Gpx3dClipPlane_setNormal(gfx, normal);
-                m_view->Redraw();
+                m_gfxScene->redraw();
             }
         });
     };
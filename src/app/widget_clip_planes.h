@@ -19,10 +19,13 @@ class QAbstractButton;
 
 namespace Mayo {
 
+class GraphicsScene;
+
 class WidgetClipPlanes : public QWidget {
     Q_OBJECT
 public:
-    WidgetClipPlanes(const Handle_V3d_View& view3d, QWidget* parent = nullptr);
+    WidgetClipPlanes(
+            const Handle_V3d_View& view3d, GraphicsScene* gfxScene, QWidget* parent = nullptr);
     ~WidgetClipPlanes();
 
     void setRanges(const Bnd_Box& box);
@@ -60,6 +63,7 @@ private:
 
     class Ui_WidgetClipPlanes* m_ui;
     Handle_V3d_View m_view;
+    GraphicsScene* m_gfxScene = nullptr;
     std::vector<ClipPlaneData> m_vecClipPlaneData;
     Bnd_Box m_bndBox;
     Handle_Graphic3d_TextureMap m_textureCapping;
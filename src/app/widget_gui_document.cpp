@@ -9,6 +9,7 @@
 #include "../graphics/graphics_utils.h"
 #include "../graphics/v3d_view_camera_animation.h"
 #include "../gui/gui_document.h"
+#include "../gui/gui_hidden_line_display.h"
 #include "button_flat.h"
 #include "theme.h"
 #include "widget_clip_planes.h"
@@ -92,7 +93,9 @@ WidgetGuiDocument::WidgetGuiDocument(GuiDocument* guiDoc, QWidget* parent)
     m_btnEditClipping->setCheckable(true);
 
     QObject::connect(m_btnFitAll, &ButtonFlat::clicked, this, [=]{
-        m_guiDoc->runViewCameraAnimation(&GraphicsUtils::V3dView_fitAll);
+        m_guiDoc->runViewCameraAnimation([=](Handle_V3d_View view) {
+            GraphicsUtils::V3dView_fitAll(view, m_guiDoc->graphicsBoundingBox());
+        });
     });
     QObject::connect(
                 m_btnEditClipping, &ButtonFlat::clicked,
@@ -103,10 +106,30 @@ WidgetGuiDocument::WidgetGuiDocument(GuiDocument* guiDoc, QWidget* parent)
     QObject::connect(
                 m_controller, &V3dViewController::viewScaled,
                 m_guiDoc, &GuiDocument::stopViewCameraAnimation);
+    QObject::connect(
+                m_controller, &V3dViewController::dynamicActionStarted,
+                m_guiDoc->graphicsScene(), &GraphicsScene::cancelHighlightRequest);
+    QObject::connect(
+                m_controller, &V3dViewController::dynamicActionStarted,
+                m_guiDoc, &GuiDocument::beginViewInteraction);
+    QObject::connect(
+                m_controller, &V3dViewController::dynamicActionEnded,
+                m_guiDoc, &GuiDocument::endViewInteraction);
+    QObject::connect(
+                m_controller, &V3dViewController::redrawRequested,
+                m_guiDoc->graphicsScene(), &GraphicsScene::redraw);
+    QObject::connect(
+                m_controller, &V3dViewController::viewScaled,
+                m_guiDoc->hiddenLineDisplay(), &GuiHiddenLineDisplay::onViewChanged);
+    QObject::connect(
+                m_controller, &V3dViewController::viewScaled,
+                m_guiDoc, &GuiDocument::updateViewLevelOfDetail);
     QObject::connect(
                 m_controller, &V3dViewController::mouseClicked, this, [=](Qt::MouseButton btn) {
-        if (btn == Qt::MouseButton::LeftButton)
+        if (btn == Qt::MouseButton::LeftButton) {
+            m_guiDoc->graphicsScene()->flushHighlightRequest();
             m_guiDoc->processAction(m_guiDoc->graphicsScene()->currentHighlightedOwner());
+        }
     });
     QObject::connect(
                 m_guiDoc, &GuiDocument::viewTrihedronModeChanged,
@@ -135,7 +158,7 @@ void WidgetGuiDocument::toggleWidgetClipPlanes()
 {
     if (!m_widgetClipPlanes) {
         auto panel = new Internal::PanelView3d(this);
-        auto widget = new WidgetClipPlanes(m_guiDoc->v3dView(), panel);
+        auto widget = new WidgetClipPlanes(m_guiDoc->v3dView(), m_guiDoc->graphicsScene(), panel);
         qtgui::QWidgetUtils::addContentsWidget(panel, widget);
         panel->show();
         panel->adjustSize();
@@ -0,0 +1,124 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "widget_metrics.h"
+
+#include "../base/messenger.h"
+#include "../base/metrics.h"
+
+#include <QtCore/QTimer>
+#include <QtWidgets/QBoxLayout>
+#include <QtWidgets/QFileDialog>
+#include <QtWidgets/QHeaderView>
+#include <QtWidgets/QPushButton>
+#include <QtWidgets/QTreeWidget>
+
+namespace Mayo {
+
+namespace Internal {
+
+static QString metricsSampleText(const Metrics::Sample& sample)
+{
+    switch (sample.kind) {
+    case Metrics::Kind::Counter:
+        return QString::number(qint64(sample.value));
+    case Metrics::Kind::Gauge:
+        return QString::number(sample.value, 'g', 6);
+    case Metrics::Kind::Histogram:
+        return WidgetMetrics::tr("n=%1 mean=%2 min=%3 max=%4 p50=%5 p95=%6")
+                .arg(sample.count)
+                .arg(sample.value, 0, 'f', 2)
+                .arg(sample.min, 0, 'f', 2)
+                .arg(sample.max, 0, 'f', 2)
+                .arg(sample.p50, 0, 'f', 2)
+                .arg(sample.p95, 0, 'f', 2);
+    }
+
+    return QString();
+}
+
+} // namespace Internal
+
+WidgetMetrics::WidgetMetrics(QWidget* parent)
+    : QWidget(parent),
+      m_treeWidget(new QTreeWidget(this)),
+      m_refreshTimer(new QTimer(this))
+{
+    auto btnReset = new QPushButton(tr("Reset"), this);
+    auto btnExport = new QPushButton(tr("Export JSON"), this);
+    auto btnLayout = new QHBoxLayout;
+    btnLayout->addStretch();
+    btnLayout->addWidget(btnReset);
+    btnLayout->addWidget(btnExport);
+
+    auto layout = new QVBoxLayout;
+    layout->addWidget(m_treeWidget);
+    layout->addLayout(btnLayout);
+    layout->setContentsMargins(0, 0, 0, 0);
+    this->setLayout(layout);
+
+    m_treeWidget->setColumnCount(2);
+    m_treeWidget->setHeaderLabels({ tr("Metric"), tr("Value") });
+    m_treeWidget->setIndentation(0);
+    m_treeWidget->setSelectionMode(QAbstractItemView::NoSelection);
+    m_treeWidget->header()->setSectionResizeMode(0, QHeaderView::ResizeToContents);
+
+    m_refreshTimer->setInterval(500);
+    QObject::connect(m_refreshTimer, &QTimer::timeout, this, &WidgetMetrics::refresh);
+    QObject::connect(btnReset, &QPushButton::clicked, [=]{
+        Metrics::resetAll();
+        this->refresh();
+    });
+    QObject::connect(btnExport, &QPushButton::clicked, this, &WidgetMetrics::exportToJson);
+}
+
+void WidgetMetrics::showEvent(QShowEvent* event)
+{
+    this->refresh();
+    m_refreshTimer->start();
+    QWidget::showEvent(event);
+}
+
+void WidgetMetrics::hideEvent(QHideEvent* event)
+{
+    m_refreshTimer->stop();
+    QWidget::hideEvent(event);
+}
+
+void WidgetMetrics::refresh()
+{
+    const std::vector<Metrics::Sample> vecSample = Metrics::snapshot();
+    // Metrics are never unregistered, so existing items can be updated in place
+    for (int i = 0; i < int(vecSample.size()); ++i) {
+        const Metrics::Sample& sample = vecSample.at(i);
+        const QString name = QString::fromUtf8(sample.name);
+        QTreeWidgetItem* item = m_treeWidget->topLevelItem(i);
+        if (!item || item->text(0) != name) {
+            item = new QTreeWidgetItem;
+            item->setText(0, name);
+            m_treeWidget->insertTopLevelItem(i, item);
+        }
+
+        item->setText(1, Internal::metricsSampleText(sample));
+    }
+}
+
+void WidgetMetrics::exportToJson()
+{
+    const QString filepath =
+            QFileDialog::getSaveFileName(
+                this,
+                tr("Select Output File"),
+                QString(),
+                tr("JSON files (*.json)"));
+    if (filepath.isEmpty())
+        return;
+
+    if (!Metrics::writeJsonFile(filepath))
+        Messenger::defaultInstance()->emitError(tr("Failed to write metrics file '%1'").arg(filepath));
+}
+
+} // namespace Mayo
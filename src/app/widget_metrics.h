@@ -0,0 +1,34 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include <QtWidgets/QWidget>
+class QTimer;
+class QTreeWidget;
+
+namespace Mayo {
+
+// Provides a live view on the values of the Metrics registry
+// Values are refreshed periodically while the widget is visible
+class WidgetMetrics : public QWidget {
+    Q_OBJECT
+public:
+    WidgetMetrics(QWidget* parent = nullptr);
+
+protected:
+    void showEvent(QShowEvent* event) override;
+    void hideEvent(QHideEvent* event) override;
+
+private:
+    void refresh();
+    void exportToJson();
+
+    QTreeWidget* m_treeWidget = nullptr;
+    QTimer* m_refreshTimer = nullptr;
+};
+
+} // namespace Mayo
@@ -6,6 +6,7 @@
 
 #include "widget_model_tree_builder_mesh.h"
 #include "../base/caf_utils.h"
+#include "../base/point_cloud.h"
 #include "theme.h"
 #include "widget_model_tree.h"
 
@@ -16,7 +17,8 @@ namespace Mayo {
 
 bool WidgetModelTreeBuilder_Mesh::supportsDocumentTreeNode(const DocumentTreeNode& node) const
 {
-    return CafUtils::hasAttribute<TDataXtd_Triangulation>(node.label());
+    return CafUtils::hasAttribute<TDataXtd_Triangulation>(node.label())
+            || CafUtils::hasAttribute<PointCloudAttribute>(node.label());
 }
 
 QTreeWidgetItem* WidgetModelTreeBuilder_Mesh::createTreeItem(const DocumentTreeNode& node)
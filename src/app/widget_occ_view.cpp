@@ -6,6 +6,7 @@
 
 #include "widget_occ_view.h"
 #include "occt_window.h"
+#include "../base/metrics.h"
 
 #include <QtGui/QResizeEvent>
 
@@ -47,7 +48,10 @@ void WidgetOccView::showEvent(QShowEvent*)
 
 void WidgetOccView::paintEvent(QPaintEvent*)
 {
+    // Frames rendered on scene changes are recorded by GraphicsScene, expose events apart
+    static Metrics::Counter& counterExpose = Metrics::counter("graphics.exposeCount");
     m_view->Redraw();
+    counterExpose.add();
 }
 
 void WidgetOccView::resizeEvent(QResizeEvent* event)
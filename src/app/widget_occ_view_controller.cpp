@@ -91,8 +91,10 @@ bool WidgetOccViewController::eventFilter(QObject* watched, QEvent* event)
             const QPoint currPos = m_widgetView->mapFromGlobal(QCursor::pos());
             const int factor = 5;
             const int dX = factor * 100;
-            view->StartZoomAtPoint(currPos.x(), currPos.y());
-            view->ZoomAtPoint(currPos.x(), currPos.y(), currPos.x() + dX, currPos.y());
+            this->changeView([=](const Handle_V3d_View& v3dView) {
+                v3dView->StartZoomAtPoint(currPos.x(), currPos.y());
+                v3dView->ZoomAtPoint(currPos.x(), currPos.y(), currPos.x() + dX, currPos.y());
+            });
         }
 
         break;
@@ -104,8 +106,9 @@ bool WidgetOccViewController::eventFilter(QObject* watched, QEvent* event)
                 && this->currentDynamicAction() == DynamicAction::InstantZoom)
         {
             this->stopDynamicAction();
-            view->Camera()->Copy(m_prevCamera);
-            view->Update();
+            this->changeView([=](const Handle_V3d_View& v3dView) {
+                v3dView->Camera()->Copy(m_prevCamera);
+            });
         }
 
         break;
@@ -128,7 +131,9 @@ bool WidgetOccViewController::eventFilter(QObject* watched, QEvent* event)
                 view->StartRotation(prevPos.x(), prevPos.y());
             }
 
-            view->Rotation(currPos.x(), currPos.y());
+            this->changeView([=](const Handle_V3d_View& v3dView) {
+                v3dView->Rotation(currPos.x(), currPos.y());
+            });
         }
         else if (mouseEvent->buttons() == Qt::RightButton) {
             if (!this->isPanningStarted()) {
@@ -136,7 +141,9 @@ bool WidgetOccViewController::eventFilter(QObject* watched, QEvent* event)
                 this->startDynamicAction(DynamicAction::Panning);
             }
 
-            view->Pan(currPos.x() - prevPos.x(), prevPos.y() - currPos.y());
+            this->changeView([=](const Handle_V3d_View& v3dView) {
+                v3dView->Pan(currPos.x() - prevPos.x(), prevPos.y() - currPos.y());
+            });
         }
         else if (mouseEvent->buttons() == Qt::MiddleButton) {
             if (!this->isWindowZoomingStarted()) {
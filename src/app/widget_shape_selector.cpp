@@ -218,11 +218,12 @@ void GpxShapeSelector::onShapeTypeChanged(TopAbs_ShapeEnum shapeEnum)
 
 void GpxShapeSelector::onView3dMouseMove(const QPoint& pos)
 {
-    this->graphicsScene()->highlightAt(pos, m_guiDocument->v3dView());
+    this->graphicsScene()->requestHighlightAt(pos, m_guiDocument->v3dView());
 }
 
 void GpxShapeSelector::onView3dMouseClicked(Qt::MouseButton btn)
 {
+    this->graphicsScene()->flushHighlightRequest();
     const bool hadSelected = this->hasSelectedShapes();
     auto detectedEntity = Handle_StdSelect_BRepOwner::DownCast(this->context()->DetectedOwner());
     AIS_StatusOfPick pickStatus = AIS_SOP_NothingSelected;
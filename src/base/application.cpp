@@ -7,6 +7,8 @@
 #include "application.h"
 #include "document_tree_node_properties_provider.h"
 #include "io_system.h"
+#include "memory_utils.h"
+#include "metrics.h"
 #include "property_builtins.h"
 #include "qmeta_quantity_color.h"
 #include "settings.h"
@@ -26,10 +28,16 @@
 #include <QtCore/QCoreApplication>
 #include <QtCore/QDir>
 #include <QtCore/QFileInfo>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QRunnable>
 #include <QtCore/QSettings>
+#include <QtCore/QThread>
+#include <QtCore/QThreadPool>
 #include <QtCore/QtDebug>
 
 #include <atomic>
+#include <chrono>
+#include <thread>
 #include <unordered_map>
 
 namespace Mayo {
@@ -44,12 +52,67 @@ public:
     opencascade::handle<CDM_Document> CreateDocument() override { return new Document; }
 };
 
+namespace Internal {
+
+// Releases a closed document, ie destroys its OCAF data(labels, attributes, shapes, ...)
+// Meant to be run in a low-priority background thread
+class DocumentReleaseTask : public QRunnable {
+public:
+    DocumentReleaseTask(const DocumentPtr& doc)
+        : m_doc(doc)
+    {}
+
+    void run() override
+    {
+        static Metrics::Counter& counterReleased = Metrics::counter("document.releasedCount");
+        static Metrics::Counter& counterReclaimed = Metrics::counter("memory.reclaimedBytes");
+        static Metrics::Gauge& gaugePending = Metrics::gauge("document.pendingReleaseCount");
+        static Metrics::Gauge& gaugeResidentMemory = Metrics::gauge("memory.residentBytes");
+        static Metrics::Histogram& histoReleaseTime = Metrics::histogram("document.releaseTimeMs");
+
+        QThread::currentThread()->setPriority(QThread::LowestPriority);
+        // Give other owners(GUI objects being destroyed, pending signal arguments, ...) a chance
+        // to drop their references, so final destruction happens here and not in the GUI thread
+        for (int i = 0; i < 200 && m_doc->GetRefCount() > 1; ++i)
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+        const uint64_t residentMemoryBefore = MemoryUtils::processResidentMemory();
+        QElapsedTimer chrono;
+        chrono.start();
+        m_doc.Nullify();
+        MemoryUtils::releaseFreedMemory();
+        histoReleaseTime.record(chrono.nsecsElapsed() / 1e6);
+
+        const uint64_t residentMemoryAfter = MemoryUtils::processResidentMemory();
+        if (residentMemoryAfter < residentMemoryBefore)
+            counterReclaimed.add(residentMemoryBefore - residentMemoryAfter);
+
+        counterReleased.add();
+        gaugePending.add(-1);
+        gaugeResidentMemory.set(double(residentMemoryAfter));
+    }
+
+private:
+    DocumentPtr m_doc;
+};
+
+} // namespace Internal
+
 struct Application::Private {
+    Private() {
+        m_documentReleasePool.setMaxThreadCount(1);
+    }
+
+    ~Private() {
+        m_documentReleasePool.waitForDone();
+    }
+
     std::atomic<Document::Identifier> m_seqDocumentIdentifier = {};
     std::unordered_map<Document::Identifier, DocumentPtr> m_mapIdentifierDocument;
     Settings m_settings;
     IO::System m_ioSystem;
     DocumentTreeNodePropertiesProviderTable m_documentTreeNodePropertiesProviderTable;
+    QThreadPool m_documentReleasePool;
 };
 
 Application::~Application()
@@ -144,7 +207,24 @@ int Application::findIndexOfDocument(const DocumentPtr& doc) const
 
 void Application::closeDocument(const DocumentPtr& doc)
 {
-    TDocStd_Application::Close(doc);
+    if (doc.IsNull())
+        return;
+
+    // Keep a copy, 'doc' may refer to an object destroyed by observers of documentAboutToClose()
+    DocumentPtr docClosed = doc;
+    TDocStd_Application::Close(docClosed);
+
+    // Document is now detached from the application and GUI, stop any event processing on it so
+    // it can be safely destroyed in a background thread
+    QObject::disconnect(docClosed.get(), nullptr, nullptr, nullptr);
+    docClosed->moveToThread(nullptr);
+    Metrics::gauge("document.pendingReleaseCount").add(1);
+    d->m_documentReleasePool.start(new Internal::DocumentReleaseTask(docClosed));
+}
+
+void Application::waitForReleasedDocuments()
+{
+    d->m_documentReleasePool.waitForDone();
 }
 
 Settings* Application::settings() const
@@ -180,6 +260,10 @@ void Application::setOpenCascadeEnvironment(const QString& settingsFilepath)
         "MMGT_OPT",
         "MMGT_CLEAR",
         "MMGT_REENTRANT",
+        "MMGT_MMAP",
+        "MMGT_CELLSIZE",
+        "MMGT_NBPAGES",
+        "MMGT_THRESHOLD",
         "CSF_LANGUAGE",
         "CSF_EXCEPTION_PROMPT"
     };
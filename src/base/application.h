@@ -44,7 +44,10 @@ public:
     DocumentPtr findDocumentByLocation(const QFileInfo& loc) const;
     int findIndexOfDocument(const DocumentPtr& doc) const;
 
+    // Closes 'doc' and detaches it immediately from the application
+    // Final release of the document data is done asynchronously in a low-priority thread
     void closeDocument(const DocumentPtr& doc);
+    void waitForReleasedDocuments();
 
     Settings* settings() const;
     IO::System* ioSystem() const;
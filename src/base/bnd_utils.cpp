@@ -5,9 +5,271 @@
 ****************************************************************************/
 
 #include "bnd_utils.h"
+#include "thread_budget.h"
+#include "tracing.h"
+
+#include <BRep_Tool.hxx>
+#include <BRepBndLib.hxx>
+#include <math_Jacobi.hxx>
+#include <math_Matrix.hxx>
+#include <math_Vector.hxx>
+#include <TopExp.hxx>
+#include <TopExp_Explorer.hxx>
+#include <TopoDS.hxx>
+#include <TopoDS_TShape.hxx>
+#include <TopTools_IndexedMapOfShape.hxx>
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 namespace Mayo {
 
+namespace Internal {
+
+static const int bndNodesChunkSize = 64 * 1024;
+
+// Oldest entries are evicted beyond this count, as entries keep their key object alive
+static const size_t obbCacheMaxEntryCount = 10000;
+
+struct ObbCacheEntry {
+    Handle_Standard_Transient object; // TopoDS_TShape or Poly_Triangulation
+    Bnd_OBB obb; // Box of the object without location
+};
+
+struct ObbCacheData {
+    std::mutex mutex;
+    std::unordered_map<const Standard_Transient*, ObbCacheEntry> mapEntry;
+    std::deque<const Standard_Transient*> queueKey; // Insertion order
+};
+
+static ObbCacheData& obbCacheData()
+{
+    static ObbCacheData data;
+    return data;
+}
+
+static bool obbCacheFind(const Handle_Standard_Transient& object, Bnd_OBB* obb)
+{
+    ObbCacheData& data = obbCacheData();
+    std::lock_guard<std::mutex> lock(data.mutex);
+    auto it = data.mapEntry.find(object.get());
+    if (it == data.mapEntry.cend())
+        return false;
+
+    *obb = it->second.obb;
+    return true;
+}
+
+static void obbCacheInsert(const Handle_Standard_Transient& object, const Bnd_OBB& obb)
+{
+    ObbCacheData& data = obbCacheData();
+    std::lock_guard<std::mutex> lock(data.mutex);
+    auto itInsert = data.mapEntry.insert({ object.get(), { object, obb } });
+    if (!itInsert.second)
+        return;
+
+    data.queueKey.push_back(object.get());
+    while (data.queueKey.size() > obbCacheMaxEntryCount) {
+        data.mapEntry.erase(data.queueKey.front());
+        data.queueKey.pop_front();
+    }
+}
+
+static void obbCacheErase(const std::unordered_set<const Standard_Transient*>& setKey)
+{
+    ObbCacheData& data = obbCacheData();
+    std::lock_guard<std::mutex> lock(data.mutex);
+    for (const Standard_Transient* key : setKey)
+        data.mapEntry.erase(key);
+
+    auto itQueueEnd = std::remove_if(
+                data.queueKey.begin(), data.queueKey.end(),
+                [&](const Standard_Transient* key) { return setKey.find(key) != setKey.cend(); });
+    data.queueKey.erase(itQueueEnd, data.queueKey.end());
+}
+
+static Bnd_OBB transformed(const Bnd_OBB& obb, const TopLoc_Location& loc)
+{
+    if (obb.IsVoid() || loc.IsIdentity())
+        return obb;
+
+    const gp_Trsf& trsf = loc.Transformation();
+    const double scale = std::abs(trsf.ScaleFactor());
+    return Bnd_OBB(
+                gp_Pnt(obb.Center()).Transformed(trsf),
+                gp_Dir(obb.XDirection()).Transformed(trsf),
+                gp_Dir(obb.YDirection()).Transformed(trsf),
+                gp_Dir(obb.ZDirection()).Transformed(trsf),
+                obb.XHSize() * scale,
+                obb.YHSize() * scale,
+                obb.ZHSize() * scale);
+}
+
+// Range of triangulation nodes [begin, end[ (0-based), placed with transformation 'trsf'
+// The triangulation is kept alive, as the face owning it may get another one meanwhile
+struct BndNodesChunk {
+    Handle_Poly_Triangulation mesh;
+    gp_Trsf trsf;
+    bool hasTrsf;
+    int begin;
+    int end;
+
+    template<typename FUNCTION> void forEachNode(FUNCTION fn) const {
+        const TColgp_Array1OfPnt& nodes = this->mesh->Nodes();
+        const int lower = nodes.Lower();
+        for (int i = this->begin; i < this->end; ++i) {
+            gp_XYZ coords = nodes.Value(lower + i).XYZ();
+            if (this->hasTrsf)
+                this->trsf.Transforms(coords);
+
+            fn(coords);
+        }
+    }
+};
+
+static void addNodesChunks(
+        std::vector<BndNodesChunk>* ptrVecChunk,
+        const Handle_Poly_Triangulation& mesh,
+        const TopLoc_Location& loc)
+{
+    if (mesh.IsNull())
+        return;
+
+    const int nodeCount = mesh->NbNodes();
+    for (int i = 0; i < nodeCount; i += bndNodesChunkSize) {
+        const int iEnd = std::min(i + bndNodesChunkSize, nodeCount);
+        const BndNodesChunk chunk = { mesh, loc.Transformation(), !loc.IsIdentity(), i, iEnd };
+        ptrVecChunk->push_back(chunk);
+    }
+}
+
+// Sums over the nodes of a chunk, coordinates are relative to a common origin
+struct BndNodesSums {
+    int count = 0;
+    double x = 0., y = 0., z = 0.;
+    double xx = 0., yy = 0., zz = 0., xy = 0., xz = 0., yz = 0.;
+};
+
+// Extents of the projections of nodes on six axes : three principal axes then the X,Y,Z axes
+struct BndNodesExtents {
+    double min[6];
+    double max[6];
+
+    BndNodesExtents() {
+        std::fill(std::begin(this->min), std::end(this->min), std::numeric_limits<double>::max());
+        std::fill(std::begin(this->max), std::end(this->max), -std::numeric_limits<double>::max());
+    }
+};
+
+static Bnd_OBB orientedBoundingBox(const std::vector<BndNodesChunk>& vecChunk)
+{
+    Bnd_OBB obb;
+    if (vecChunk.empty())
+        return obb;
+
+    // Coordinates are made relative to a node to limit cancellation errors
+    gp_XYZ origin = vecChunk.front().nodes->Value(vecChunk.front().nodes->Lower()).XYZ();
+    if (vecChunk.front().hasTrsf)
+        vecChunk.front().trsf.Transforms(origin);
+
+    // Covariance matrix of nodes
+    const int chunkCount = int(vecChunk.size());
+    std::vector<BndNodesSums> vecChunkSums(chunkCount);
+    ThreadBudget::parallelFor(0, chunkCount, [&](int iChunk) {
+        BndNodesSums& sums = vecChunkSums.at(iChunk);
+        vecChunk.at(iChunk).forEachNode([&](const gp_XYZ& coords) {
+            const double x = coords.X() - origin.X();
+            const double y = coords.Y() - origin.Y();
+            const double z = coords.Z() - origin.Z();
+            ++sums.count;
+            sums.x += x; sums.y += y; sums.z += z;
+            sums.xx += x*x; sums.yy += y*y; sums.zz += z*z;
+            sums.xy += x*y; sums.xz += x*z; sums.yz += y*z;
+        });
+    });
+
+    // Reduce in chunk order, so the result is deterministic
+    BndNodesSums total;
+    for (const BndNodesSums& sums : vecChunkSums) {
+        total.count += sums.count;
+        total.x += sums.x; total.y += sums.y; total.z += sums.z;
+        total.xx += sums.xx; total.yy += sums.yy; total.zz += sums.zz;
+        total.xy += sums.xy; total.xz += sums.xz; total.yz += sums.yz;
+    }
+
+    const double n = total.count;
+    const double mx = total.x / n, my = total.y / n, mz = total.z / n;
+    math_Matrix matCovariance(1, 3, 1, 3);
+    matCovariance(1, 1) = total.xx / n - mx*mx;
+    matCovariance(2, 2) = total.yy / n - my*my;
+    matCovariance(3, 3) = total.zz / n - mz*mz;
+    matCovariance(1, 2) = matCovariance(2, 1) = total.xy / n - mx*my;
+    matCovariance(1, 3) = matCovariance(3, 1) = total.xz / n - mx*mz;
+    matCovariance(2, 3) = matCovariance(3, 2) = total.yz / n - my*mz;
+
+    // Principal axes are the eigenvectors of the covariance matrix
+    gp_XYZ axes[6] = { gp::DX().XYZ(), gp::DY().XYZ(), gp::DZ().XYZ(),
+                       gp::DX().XYZ(), gp::DY().XYZ(), gp::DZ().XYZ() };
+    const math_Jacobi jacobi(matCovariance);
+    if (jacobi.IsDone()) {
+        math_Vector vec(1, 3);
+        for (int i = 0; i < 2; ++i) {
+            jacobi.Vector(i + 1, vec);
+            axes[i] = gp_XYZ(vec(1), vec(2), vec(3));
+        }
+
+        // Ensure a right-handed orthonormal frame
+        axes[2] = axes[0].Crossed(axes[1]);
+        for (int i = 0; i < 3; ++i)
+            axes[i].Normalize();
+    }
+
+    std::vector<BndNodesExtents> vecChunkExtents(chunkCount);
+    ThreadBudget::parallelFor(0, chunkCount, [&](int iChunk) {
+        BndNodesExtents& extents = vecChunkExtents.at(iChunk);
+        vecChunk.at(iChunk).forEachNode([&](const gp_XYZ& coords) {
+            const gp_XYZ vec = coords - origin;
+            for (int i = 0; i < 6; ++i) {
+                const double proj = vec.Dot(axes[i]);
+                extents.min[i] = std::min(extents.min[i], proj);
+                extents.max[i] = std::max(extents.max[i], proj);
+            }
+        });
+    });
+
+    BndNodesExtents totalExtents;
+    for (const BndNodesExtents& extents : vecChunkExtents) {
+        for (int i = 0; i < 6; ++i) {
+            totalExtents.min[i] = std::min(totalExtents.min[i], extents.min[i]);
+            totalExtents.max[i] = std::max(totalExtents.max[i], extents.max[i]);
+        }
+    }
+
+    // Keep the box of smallest area, principal axes can be a poor fit(eg uneven node density)
+    auto fnHalfSize = [&](int i) { return (totalExtents.max[i] - totalExtents.min[i]) / 2.; };
+    auto fnBoxArea = [&](int iAxis) {
+        const double hx = fnHalfSize(iAxis), hy = fnHalfSize(iAxis + 1), hz = fnHalfSize(iAxis + 2);
+        return hx*hy + hx*hz + hy*hz;
+    };
+    const int iFirstAxis = fnBoxArea(0) <= fnBoxArea(3) ? 0 : 3;
+    gp_XYZ center = origin;
+    for (int i = iFirstAxis; i < iFirstAxis + 3; ++i)
+        center += ((totalExtents.min[i] + totalExtents.max[i]) / 2.) * axes[i];
+
+    obb = Bnd_OBB(
+              gp_Pnt(center),
+              gp_Dir(axes[iFirstAxis]), gp_Dir(axes[iFirstAxis + 1]), gp_Dir(axes[iFirstAxis + 2]),
+              fnHalfSize(iFirstAxis), fnHalfSize(iFirstAxis + 1), fnHalfSize(iFirstAxis + 2));
+    return obb;
+}
+
+} // namespace Internal
+
 gp_Pnt BndBoxCoords::center() const
 {
     return {
@@ -46,4 +308,155 @@ void BndUtils::add(Bnd_Box* box, const Bnd_Box& other)
         box->Add(pnt);
 }
 
+bool BndUtils::isStrictlyInside(const Bnd_Box& box, const Bnd_Box& boxOuter)
+{
+    if (box.IsVoid())
+        return true;
+
+    if (boxOuter.IsVoid() || box.IsOpen() || boxOuter.IsOpen())
+        return false;
+
+    const auto bbc = BndBoxCoords::get(box);
+    const auto bbcOuter = BndBoxCoords::get(boxOuter);
+    return bbcOuter.xmin < bbc.xmin && bbc.xmax < bbcOuter.xmax
+            && bbcOuter.ymin < bbc.ymin && bbc.ymax < bbcOuter.ymax
+            && bbcOuter.zmin < bbc.zmin && bbc.zmax < bbcOuter.zmax;
+}
+
+Bnd_Box BndUtils::geometryBoundingBox(const TopoDS_Shape& shape)
+{
+    Bnd_Box box;
+    if (!shape.IsNull())
+        BRepBndLib::Add(shape, box, true/*useTriangulation*/);
+
+    return box;
+}
+
+Bnd_Box BndUtils::geometryBoundingBox(const Handle_Poly_Triangulation& mesh)
+{
+    Bnd_Box box;
+    if (mesh.IsNull() || mesh->NbNodes() == 0)
+        return box;
+
+    std::vector<Internal::BndNodesChunk> vecChunk;
+    Internal::addNodesChunks(&vecChunk, mesh, TopLoc_Location());
+    std::vector<Bnd_Box> vecChunkBox(vecChunk.size());
+    ThreadBudget::parallelFor(0, int(vecChunk.size()), [&](int iChunk) {
+        gp_XYZ cmin = gp_XYZ(1, 1, 1) * std::numeric_limits<double>::max();
+        gp_XYZ cmax = cmin.Reversed();
+        vecChunk.at(iChunk).forEachNode([&](const gp_XYZ& coords) {
+            cmin.SetCoord(
+                        std::min(cmin.X(), coords.X()),
+                        std::min(cmin.Y(), coords.Y()),
+                        std::min(cmin.Z(), coords.Z()));
+            cmax.SetCoord(
+                        std::max(cmax.X(), coords.X()),
+                        std::max(cmax.Y(), coords.Y()),
+                        std::max(cmax.Z(), coords.Z()));
+        });
+        vecChunkBox.at(iChunk).Update(cmin.X(), cmin.Y(), cmin.Z(), cmax.X(), cmax.Y(), cmax.Z());
+    });
+
+    for (const Bnd_Box& chunkBox : vecChunkBox)
+        box.Add(chunkBox);
+
+    return box;
+}
+
+Bnd_OBB BndUtils::orientedBoundingBox(const TopoDS_Shape& shape)
+{
+    Bnd_OBB obb;
+    if (shape.IsNull())
+        return obb;
+
+    MAYO_TRACE_SCOPE("brep", "orientedBoundingBox");
+    std::vector<Internal::BndNodesChunk> vecChunk;
+    for (TopExp_Explorer expl(shape, TopAbs_FACE); expl.More(); expl.Next()) {
+        TopLoc_Location loc;
+        const TopoDS_Face& face = TopoDS::Face(expl.Current());
+        const Handle_Poly_Triangulation& mesh = BRep_Tool::Triangulation(face, loc);
+        Internal::addNodesChunks(&vecChunk, mesh, loc);
+    }
+
+    if (!vecChunk.empty())
+        obb = Internal::orientedBoundingBox(vecChunk);
+    else
+        BRepBndLib::AddOBB(shape, obb, false/*useTriangulation*/);
+
+    return obb;
+}
+
+Bnd_OBB BndUtils::orientedBoundingBox(const Handle_Poly_Triangulation& mesh)
+{
+    MAYO_TRACE_SCOPE("mesh", "orientedBoundingBox");
+    std::vector<Internal::BndNodesChunk> vecChunk;
+    Internal::addNodesChunks(&vecChunk, mesh, TopLoc_Location());
+    return Internal::orientedBoundingBox(vecChunk);
+}
+
+bool OrientedBoundingBoxCache::find(const TopoDS_Shape& shape, Bnd_OBB* obb)
+{
+    if (shape.IsNull() || !obb)
+        return false;
+
+    Bnd_OBB obbLocationless;
+    if (!Internal::obbCacheFind(shape.TShape(), &obbLocationless))
+        return false;
+
+    *obb = Internal::transformed(obbLocationless, shape.Location());
+    return true;
+}
+
+bool OrientedBoundingBoxCache::find(const Handle_Poly_Triangulation& mesh, Bnd_OBB* obb)
+{
+    if (mesh.IsNull() || !obb)
+        return false;
+
+    return Internal::obbCacheFind(mesh, obb);
+}
+
+Bnd_OBB OrientedBoundingBoxCache::compute(const TopoDS_Shape& shape)
+{
+    Bnd_OBB obb;
+    if (shape.IsNull() || OrientedBoundingBoxCache::find(shape, &obb))
+        return obb;
+
+    const Bnd_OBB obbLocationless = BndUtils::orientedBoundingBox(shape.Located(TopLoc_Location()));
+    Internal::obbCacheInsert(shape.TShape(), obbLocationless);
+    return Internal::transformed(obbLocationless, shape.Location());
+}
+
+Bnd_OBB OrientedBoundingBoxCache::compute(const Handle_Poly_Triangulation& mesh)
+{
+    Bnd_OBB obb;
+    if (mesh.IsNull() || OrientedBoundingBoxCache::find(mesh, &obb))
+        return obb;
+
+    obb = BndUtils::orientedBoundingBox(mesh);
+    Internal::obbCacheInsert(mesh, obb);
+    return obb;
+}
+
+void OrientedBoundingBoxCache::erase(const TopoDS_Shape& shape)
+{
+    if (shape.IsNull())
+        return;
+
+    TopTools_IndexedMapOfShape mapSubShape;
+    TopExp::MapShapes(shape, mapSubShape);
+    std::unordered_set<const Standard_Transient*> setKey;
+    for (int i = 1; i <= mapSubShape.Extent(); ++i)
+        setKey.insert(mapSubShape.FindKey(i).TShape().get());
+
+    Internal::obbCacheErase(setKey);
+}
+
+void OrientedBoundingBoxCache::clear()
+{
+    Internal::ObbCacheData& data = Internal::obbCacheData();
+    std::lock_guard<std::mutex> lock(data.mutex);
+    data.mapEntry.clear();
+    data.queueKey.clear();
+}
+
 } // namespace Mayo
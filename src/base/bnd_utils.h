@@ -8,12 +8,51 @@
 
 #include <array>
 #include <Bnd_Box.hxx>
+#include <Bnd_OBB.hxx>
 #include <gp_Pnt.hxx>
+#include <Poly_Triangulation.hxx>
+#include <TopoDS_Shape.hxx>
 
 namespace Mayo {
 
 struct BndUtils {
     static void add(Bnd_Box* box, const Bnd_Box& other);
+
+    // Whether 'box' lies inside 'boxOuter' without touching any of its sides : then removing
+    // 'box' from a union equal to 'boxOuter' leaves the union unchanged. A void box is inside
+    static bool isStrictlyInside(const Bnd_Box& box, const Bnd_Box& boxOuter);
+
+    // Axis-aligned bounding box computed from geometry, no graphics presentation is required
+    // Face triangulations are used when available, otherwise the exact geometry
+    static Bnd_Box geometryBoundingBox(const TopoDS_Shape& shape);
+    static Bnd_Box geometryBoundingBox(const Handle_Poly_Triangulation& mesh);
+
+    // Oriented bounding box of the triangulation nodes, the smallest(by area) box of the one
+    // aligned on the principal axes of the nodes and the axis-aligned one
+    // Nodes are processed by chunks in parallel with ThreadBudget::parallelFor()
+    // Shapes without any triangulation fall back to BRepBndLib::AddOBB() on exact geometry
+    static Bnd_OBB orientedBoundingBox(const TopoDS_Shape& shape);
+    static Bnd_OBB orientedBoundingBox(const Handle_Poly_Triangulation& mesh);
+};
+
+// Oriented bounding boxes cached per TopoDS_TShape and per Poly_Triangulation object, so all the
+// instances of a product share the same computation. Boxes of shapes are computed from the
+// triangulations available at that time, they must be erased once these are replaced
+// Cache is thread-safe
+class OrientedBoundingBoxCache {
+public:
+    // Returns true and fills '*obb' if the box of 'shape' is already in the cache
+    static bool find(const TopoDS_Shape& shape, Bnd_OBB* obb);
+    static bool find(const Handle_Poly_Triangulation& mesh, Bnd_OBB* obb);
+
+    // Returns the box of 'shape', computing it with BndUtils::orientedBoundingBox() if not cached
+    static Bnd_OBB compute(const TopoDS_Shape& shape);
+    static Bnd_OBB compute(const Handle_Poly_Triangulation& mesh);
+
+    // Erases the boxes of 'shape' and of all its sub-shapes
+    static void erase(const TopoDS_Shape& shape);
+
+    static void clear();
 };
 
 struct BndBoxCoords {
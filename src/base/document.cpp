@@ -50,7 +50,7 @@ void Document::notifyNewXCafEntities(const TDF_LabelSequence& seqEntityBefore)
 
     for (const TDF_Label& label : seqDiff) {
         const TreeNodeId nodeId = m_xcaf.deepBuildAssemblyTree(0, label);
-        emit this->entityAdded(nodeId);
+        this->emitEntityAdded(nodeId);
     }
 }
 
@@ -58,7 +58,7 @@ void Document::notifyNewEntity(const TDF_Label& label)
 {
     // TODO Allow custom population of the model tree for the new entity
     const TreeNodeId nodeNewEntity = m_modelTree.appendChild(0, label);
-    emit this->entityAdded(nodeNewEntity);
+    this->emitEntityAdded(nodeNewEntity);
 
 #if 0
     // Remove 'label'
@@ -67,6 +67,14 @@ void Document::notifyNewEntity(const TDF_Label& label)
 #endif
 }
 
+void Document::emitEntityAdded(TreeNodeId entityTreeNodeId)
+{
+    if (m_entityAddedHoldCount > 0)
+        m_vecHeldEntityAdded.push_back(entityTreeNodeId);
+    else
+        emit this->entityAdded(entityTreeNodeId);
+}
+
 QString Document::name() const
 {
     return m_name;
@@ -186,6 +194,23 @@ void Document::destroyEntity(TreeNodeId entityTreeNodeId)
     m_modelTree.removeRoot(entityTreeNodeId);
 }
 
+void Document::holdEntityAddedSignals()
+{
+    ++m_entityAddedHoldCount;
+}
+
+void Document::releaseEntityAddedSignals()
+{
+    Expects(m_entityAddedHoldCount > 0);
+    if (--m_entityAddedHoldCount > 0)
+        return;
+
+    const std::vector<TreeNodeId> vecEntity = std::move(m_vecHeldEntityAdded);
+    m_vecHeldEntityAdded.clear();
+    for (TreeNodeId entityTreeNodeId : vecEntity)
+        emit this->entityAdded(entityTreeNodeId);
+}
+
 void Document::BeforeClose()
 {
     TDocStd_Document::BeforeClose();
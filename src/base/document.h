@@ -9,8 +9,10 @@
 #include "document_ptr.h"
 #include "document_tree_node.h"
 #include "libtree.h"
+#include "span.h"
 #include "xcaf.h"
 #include <QtCore/QObject>
+#include <vector>
 
 namespace Mayo {
 
@@ -61,6 +63,13 @@ public:
     TDF_Label newEntityLabel();
     void destroyEntity(TreeNodeId entityTreeNodeId);
 
+    // While held, entityAdded() signals are recorded and then emitted on release
+    // Allows post-processing of new entities(eg tessellation) before observers can access them
+    // Calls can be nested, signals are emitted when the outermost hold is released
+    void holdEntityAddedSignals();
+    void releaseEntityAddedSignals();
+    Span<const TreeNodeId> heldAddedEntities() const { return m_vecHeldEntityAdded; }
+
 signals:
     void nameChanged(const QString& name);
     void entityAdded(TreeNodeId entityTreeNodeId);
@@ -86,12 +95,15 @@ private:
     void setIdentifier(Identifier ident) { m_identifier = ident; }
     void notifyNewXCafEntities(const TDF_LabelSequence& seqEntityBefore);
     void notifyNewEntity(const TDF_Label& label);
+    void emitEntityAdded(TreeNodeId entityTreeNodeId);
 
     Identifier m_identifier = -1;
     QString m_name;
     QString m_filePath;
     XCaf m_xcaf;
     Tree<TDF_Label> m_modelTree;
+    int m_entityAddedHoldCount = 0;
+    std::vector<TreeNodeId> m_vecHeldEntityAdded;
 };
 
 } // namespace Mayo
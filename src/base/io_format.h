@@ -32,6 +32,9 @@ const Format Format_STL = { "STL", "STL(STereo-Lithography)", { "stl" } };
 const Format Format_OBJ = { "OBJ", "Wavefront OBJ", { "obj" } };
 const Format Format_GLTF = { "GLTF", "glTF(GL Transmission Format)", { "gltf", "glb" } };
 const Format Format_VRML = { "VRML", "VRML(ISO/CEI 14772-2)", { "wrl", "wrz", "vrml" } };
+const Format Format_PLY = { "PLY", "PLY(Polygon File Format)", { "ply" } };
+const Format Format_XYZ = { "XYZ", "XYZ point cloud", { "xyz" } };
+const Format Format_PTS = { "PTS", "PTS(Leica point cloud)", { "pts" } };
 
 } // namespace IO
 } // namespace Mayo
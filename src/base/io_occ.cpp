@@ -105,8 +105,9 @@ std::unique_ptr<PropertyGroup> OccFactoryReader::createProperties(
         { Format_STEP, &OccStepReader::createProperties },
 #if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 4, 0)
         { Format_GLTF, &OccGltfReader::createProperties },
-        { Format_OBJ, &OccObjReader::createProperties }
+        { Format_OBJ, &OccObjReader::createProperties },
 #endif
+        { Format_STL, &OccStlReader::createProperties }
     };
     return findGenerator<ReaderParametersGenerator>(format, array).fn(parentGroup);
 }
@@ -37,6 +37,13 @@ bool cafGenericReadTransfer(CAF_READER& reader, DocumentPtr doc, TaskProgress* p
 {
     Handle_Message_ProgressIndicator indicator = new OccProgressIndicator(progress);
     XCafScopeImport import(doc);
+    import.setTransientDataReleaser([&]{
+        // Transferred entities now live in the document, so the interface model and the
+        // transfer process(map of STEP/IGES entities to OpenCascade objects) can be dropped
+        Handle_XSControl_WorkSession ws = Private::cafWorkSession(reader);
+        ws->ClearData(7); // Transfer management(TransientProcess)
+        ws->ClearData(1); // Model, graph, check list, ...
+    });
     Handle_TDocStd_Document stdDoc = doc;
 #if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 5, 0)
     const bool okTransfer = reader.Transfer(stdDoc, indicator->Start());
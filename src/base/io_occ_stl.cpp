@@ -8,8 +8,10 @@
 
 #include "application_item.h"
 #include "document.h"
+#include "metrics.h"
 #include "caf_utils.h"
 #include "occ_progress_indicator.h"
+#include "property_builtins.h"
 #include "property_enumeration.h"
 #include "scope_import.h"
 #include "task_progress.h"
@@ -23,6 +25,8 @@
 #include <TDataXtd_Triangulation.hxx>
 #include <TopoDS_Compound.hxx>
 
+#include <climits>
+
 namespace Mayo {
 namespace IO {
 
@@ -71,13 +75,101 @@ public:
     PropertyEnumeration targetFormat;
 };
 
+class OccStlReader::Properties : public PropertyGroup {
+    MAYO_DECLARE_TEXT_ID_FUNCTIONS(Mayo::IO::OccStlReader_Properties)
+public:
+    Properties(PropertyGroup* parentGroup)
+        : PropertyGroup(parentGroup),
+          simplifyMesh(this, textId("simplifyMesh")),
+          simplifyTargetMode(this, textId("simplifyTargetMode"), &enumTargetMode),
+          simplifyTargetTriangleCount(this, textId("simplifyTargetTriangleCount")),
+          simplifyTargetRatio(this, textId("simplifyTargetRatio")),
+          simplifyMaxError(this, textId("simplifyMaxError")),
+          keepOriginalMesh(this, textId("keepOriginalMesh")),
+          smoothNormals(this, textId("smoothNormals")),
+          smoothNormalsCreaseAngle(this, textId("smoothNormalsCreaseAngle"))
+    {
+        this->simplifyMesh.setDescription(
+                    textId("Reduce the triangle count of the imported mesh, "
+                           "with quadric edge collapse").tr());
+        this->simplifyTargetRatio.setDescription(
+                    textId("Ratio of the initial triangle count to be kept, "
+                           "used with target 'Ratio'").tr());
+        this->simplifyMaxError.setDescription(
+                    textId("Maximum distance between the simplified and the initial mesh, "
+                           "used with target 'MaxError'").tr());
+        this->keepOriginalMesh.setDescription(
+                    textId("Import also the initial mesh, "
+                           "so it can be exported at full resolution").tr());
+        this->smoothNormals.setDescription(
+                    textId("Compute normals at mesh nodes, so shading is smooth").tr());
+        this->smoothNormalsCreaseAngle.setDescription(
+                    textId("Edges where adjacent triangles make a greater angle are kept sharp, "
+                           "used with option 'smoothNormals'").tr());
+        this->simplifyTargetTriangleCount.setRange(1, INT_MAX);
+        this->simplifyTargetTriangleCount.setConstraintsEnabled(true);
+        this->simplifyTargetRatio.setRange(0.001, 1.);
+        this->simplifyTargetRatio.setSingleStep(0.05);
+        this->simplifyTargetRatio.setConstraintsEnabled(true);
+        this->smoothNormalsCreaseAngle.setRange(0., 3.14159265358979323846);
+        this->smoothNormalsCreaseAngle.setConstraintsEnabled(true);
+    }
+
+    void restoreDefaults() override {
+        const MeshDecimationParameters defaults;
+        this->simplifyMesh.setValue(false);
+        this->simplifyTargetMode.setValue(int(defaults.targetMode));
+        this->simplifyTargetTriangleCount.setValue(defaults.targetTriangleCount);
+        this->simplifyTargetRatio.setValue(defaults.targetRatio);
+        this->simplifyMaxError.setQuantity(defaults.maxError * Quantity_Millimeter);
+        this->keepOriginalMesh.setValue(false);
+        const OccStlReader::Parameters params;
+        this->smoothNormals.setValue(params.smoothNormals);
+        this->smoothNormalsCreaseAngle.setQuantity(
+                    params.smoothNormalsCreaseAngle * Quantity_Radian);
+    }
+
+    static inline const Enumeration enumTargetMode = {
+        { int(MeshDecimationParameters::TargetMode::TriangleCount), textId("TriangleCount"), {} },
+        { int(MeshDecimationParameters::TargetMode::Ratio), textId("Ratio"), {} },
+        { int(MeshDecimationParameters::TargetMode::MaxError), textId("MaxError"), {} }
+    };
+
+    PropertyBool simplifyMesh;
+    PropertyEnumeration simplifyTargetMode;
+    PropertyInt simplifyTargetTriangleCount;
+    PropertyDouble simplifyTargetRatio;
+    PropertyLength simplifyMaxError;
+    PropertyBool keepOriginalMesh;
+    PropertyBool smoothNormals;
+    PropertyAngle smoothNormalsCreaseAngle;
+};
 
 bool OccStlReader::readFile(const QString& filepath, TaskProgress* progress)
 {
     Handle_Message_ProgressIndicator indicator = new OccProgressIndicator(progress);
     m_baseFilename = QFileInfo(filepath).baseName();
+    m_meshOriginal.Nullify();
     m_mesh = RWStl::ReadFile(OSD_Path(filepath.toLocal8Bit().constData()), TKernelUtils::start(indicator));
-    return !m_mesh.IsNull();
+    if (m_mesh.IsNull())
+        return false;
+
+    static Metrics::Counter& counterTriangles = Metrics::counter("mesh.trianglesCreated");
+    counterTriangles.add(m_mesh->NbTriangles());
+    if (m_params.simplifyMesh) {
+        progress->setStep(Properties::textIdTr("Simplifying mesh"));
+        Handle_Poly_Triangulation meshSimplified =
+                MeshDecimation::decimate(m_mesh, m_params.simplification, progress);
+        if (meshSimplified.IsNull())
+            return false;
+
+        if (m_params.keepOriginalMesh)
+            m_meshOriginal = m_mesh;
+
+        m_mesh = meshSimplified;
+    }
+
+    return true;
 }
 
 bool OccStlReader::transfer(DocumentPtr doc, TaskProgress* progress)
@@ -85,13 +177,65 @@ bool OccStlReader::transfer(DocumentPtr doc, TaskProgress* progress)
     if (m_mesh.IsNull())
         return false;
 
+    // Meshes are stored welded, split normals are computed by the graphics
+    auto fnSetCreaseAngle = [=](const TDF_Label& label) {
+        if (m_params.smoothNormals)
+            MeshNormals::setLabelCreaseAngle(label, m_params.smoothNormalsCreaseAngle);
+    };
+
+    if (!m_meshOriginal.IsNull()) {
+        SingleScopeImport import(doc);
+        TDataXtd_Triangulation::Set(import.entityLabel(), m_meshOriginal);
+        fnSetCreaseAngle(import.entityLabel());
+        CafUtils::setLabelAttrStdName(import.entityLabel(), m_baseFilename);
+    }
+
     SingleScopeImport import(doc);
     TDataXtd_Triangulation::Set(import.entityLabel(), m_mesh);
-    CafUtils::setLabelAttrStdName(import.entityLabel(), m_baseFilename);
+    fnSetCreaseAngle(import.entityLabel());
+    if (!m_meshOriginal.IsNull())
+        CafUtils::setLabelAttrStdName(import.entityLabel(), m_baseFilename + " (simplified)");
+    else
+        CafUtils::setLabelAttrStdName(import.entityLabel(), m_baseFilename);
+
     progress->setValue(100);
     return true;
 }
 
+std::unique_ptr<PropertyGroup> OccStlReader::createProperties(PropertyGroup* parentGroup)
+{
+    return std::make_unique<Properties>(parentGroup);
+}
+
+void OccStlReader::applyProperties(const PropertyGroup* params)
+{
+    auto ptr = dynamic_cast<const Properties*>(params);
+    if (ptr) {
+        m_params.simplifyMesh = ptr->simplifyMesh.value();
+        m_params.simplification.targetMode =
+                ptr->simplifyTargetMode.valueAs<MeshDecimationParameters::TargetMode>();
+        m_params.simplification.targetTriangleCount = ptr->simplifyTargetTriangleCount.value();
+        m_params.simplification.targetRatio = ptr->simplifyTargetRatio.value();
+        m_params.simplification.maxError = ptr->simplifyMaxError.quantity().value();
+        m_params.keepOriginalMesh = ptr->keepOriginalMesh.value();
+        m_params.smoothNormals = ptr->smoothNormals.value();
+        m_params.smoothNormalsCreaseAngle = ptr->smoothNormalsCreaseAngle.quantity().value();
+    }
+}
+
+void OccStlReader::setSimplificationProperties(
+        PropertyGroup* params, const MeshDecimationParameters& simplification)
+{
+    auto ptr = dynamic_cast<Properties*>(params);
+    if (ptr) {
+        ptr->simplifyMesh.setValue(true);
+        ptr->simplifyTargetMode.setValue(int(simplification.targetMode));
+        ptr->simplifyTargetTriangleCount.setValue(simplification.targetTriangleCount);
+        ptr->simplifyTargetRatio.setValue(simplification.targetRatio);
+        ptr->simplifyMaxError.setQuantity(simplification.maxError * Quantity_Millimeter);
+    }
+}
+
 bool OccStlWriter::transfer(Span<const ApplicationItem> appItems, TaskProgress* /*progress*/)
 {
 //    if (appItems.size() > 1)
@@ -8,6 +8,8 @@
 
 #include "io_reader.h"
 #include "io_writer.h"
+#include "mesh_decimation.h"
+#include "mesh_normals.h"
 #include <Poly_Triangulation.hxx>
 #include <TopoDS_Shape.hxx>
 #include <QtCore/QString>
@@ -21,8 +23,32 @@ public:
     bool readFile(const QString& filepath, TaskProgress* progress) override;
     bool transfer(DocumentPtr doc, TaskProgress* progress) override;
 
+    static std::unique_ptr<PropertyGroup> createProperties(PropertyGroup* parentGroup);
+    void applyProperties(const PropertyGroup* params) override;
+
+    // Parameters
+    struct Parameters {
+        bool simplifyMesh = false;
+        MeshDecimationParameters simplification;
+        // Simplified mesh is imported along with the original one, typically for export
+        bool keepOriginalMesh = false;
+        // Mesh is displayed with smooth normals split along creases, document keeps it welded
+        bool smoothNormals = true;
+        double smoothNormalsCreaseAngle = MeshNormals::DefaultCreaseAngle; // Angle in radians
+    };
+    Parameters& parameters() { return m_params; }
+    const Parameters& constParameters() const { return m_params; }
+
+    // Sets the simplification parameters of 'params', typically reader properties found in
+    // settings, so that meshes are simplified with 'simplification' on import
+    static void setSimplificationProperties(
+            PropertyGroup* params, const MeshDecimationParameters& simplification);
+
 private:
+    class Properties;
+    Parameters m_params;
     Handle_Poly_Triangulation m_mesh;
+    Handle_Poly_Triangulation m_meshOriginal;
     QString m_baseFilename;
 };
 
@@ -0,0 +1,701 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "io_point_cloud.h"
+
+#include "caf_utils.h"
+#include "document.h"
+#include "metrics.h"
+#include "property.h"
+#include "scope_import.h"
+#include "task_progress.h"
+#include "thread_budget.h"
+#include "tracing.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QList>
+#include <QtCore/QtGlobal>
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace Mayo {
+namespace IO {
+
+namespace {
+
+// ASCII contents are parsed by chunks of this size(in bytes), adjusted to line boundaries
+static const size_t pointCloudTextChunkSize = 4 * 1024 * 1024;
+
+// Binary contents are parsed by chunks of this count of points
+static const int pointCloudBinaryChunkSize = 64 * 1024;
+
+// Values beyond this count in a line are ignored
+static const int pointCloudMaxColumnCount = 16;
+
+static bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+static double pow10(int exponent)
+{
+    static const double table[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    if (exponent >= 0 && exponent <= 22)
+        return table[exponent];
+    else if (exponent < 0 && exponent >= -22)
+        return 1. / table[-exponent];
+
+    return std::pow(10., exponent);
+}
+
+// Locale-independent parsing of a decimal number starting at 'p'
+// Returns the position past the number, or nullptr if there is no number at 'p'
+static const char* parseNumber(const char* p, const char* end, double* value)
+{
+    bool isNegative = false;
+    if (p != end && (*p == '-' || *p == '+')) {
+        isNegative = *p == '-';
+        ++p;
+    }
+
+    // Only the first 19 significant digits are kept in the mantissa, so it can't overflow
+    uint64_t mantissa = 0;
+    int significantDigitCount = 0;
+    int exponent = 0;
+    bool hasDigits = false;
+    auto fnAddDigit = [&](char c, int exponentOffset) {
+        hasDigits = true;
+        if (significantDigitCount < 19) {
+            mantissa = mantissa * 10 + (c - '0');
+            if (mantissa != 0)
+                ++significantDigitCount;
+
+            exponent += exponentOffset;
+        }
+        else {
+            exponent += exponentOffset + 1;
+        }
+    };
+
+    for (; p != end && isDigit(*p); ++p)
+        fnAddDigit(*p, 0);
+
+    if (p != end && *p == '.') {
+        for (++p; p != end && isDigit(*p); ++p)
+            fnAddDigit(*p, -1);
+    }
+
+    if (!hasDigits)
+        return nullptr;
+
+    if (p != end && (*p == 'e' || *p == 'E')) {
+        const char* pExp = p + 1;
+        bool isExpNegative = false;
+        if (pExp != end && (*pExp == '-' || *pExp == '+')) {
+            isExpNegative = *pExp == '-';
+            ++pExp;
+        }
+
+        if (pExp != end && isDigit(*pExp)) {
+            int exp = 0;
+            for (; pExp != end && isDigit(*pExp); ++pExp)
+                exp = std::min(exp * 10 + (*pExp - '0'), 9999);
+
+            exponent += isExpNegative ? -exp : exp;
+            p = pExp;
+        }
+    }
+
+    const double absValue = mantissa != 0 ? double(mantissa) * pow10(exponent) : 0.;
+    *value = isNegative ? -absValue : absValue;
+    return p;
+}
+
+// Parses the numeric values of the line starting at 'p', parsing stops at the first token
+// not being a number. Values can be separated by spaces, tabs or commas
+// Returns the position of the next line
+static const char* parseLineValues(const char* p, const char* end, double* values, int* count)
+{
+    *count = 0;
+    while (p != end && *p != '\n') {
+        if (*p == ' ' || *p == '\t' || *p == ',' || *p == '\r') {
+            ++p;
+            continue;
+        }
+
+        const char* next = nullptr;
+        if (*count < pointCloudMaxColumnCount)
+            next = parseNumber(p, end, values + *count);
+
+        if (!next)
+            break;
+
+        ++(*count);
+        p = next;
+    }
+
+    const void* eol = p != end ? std::memchr(p, '\n', end - p) : nullptr;
+    return eol ? static_cast<const char*>(eol) + 1 : end;
+}
+
+static uint8_t toColorComponent(double value)
+{
+    return uint8_t(std::clamp(std::round(value), 0., 255.));
+}
+
+// Columns of point values in lines of ASCII contents
+struct PointCloudColumns {
+    int coord[3] = { 0, 1, 2 };
+    int color[3] = { -1, -1, -1 }; // Negative if there is no color
+    double colorScale = 1.; // Factor to get 8-bit color components from values
+
+    bool hasColors() const { return this->color[0] >= 0; }
+    int minColumnCount() const {
+        return 1 + std::max({
+                this->coord[0], this->coord[1], this->coord[2],
+                this->color[0], this->color[1], this->color[2] });
+    }
+};
+
+// Points parsed from a chunk of ASCII contents
+struct PointCloudTextChunk {
+    const char* begin;
+    const char* end;
+    std::vector<float> vecCoord;
+    std::vector<uint8_t> vecColor;
+};
+
+// Parses the points of lines in [begin, end), lines having less values than required by
+// 'columns' are skipped(eg comments, headers)
+// Chunks are parsed in parallel then points are concatenated in file order
+static bool parseTextPoints(
+        const char* begin,
+        const char* end,
+        const PointCloudColumns& columns,
+        PointCloud* cloud,
+        TaskProgress* progress)
+{
+    std::vector<PointCloudTextChunk> vecChunk;
+    for (const char* chunkBegin = begin; chunkBegin != end; ) {
+        const char* chunkEnd = end;
+        const size_t remaining = end - chunkBegin;
+        if (remaining > pointCloudTextChunkSize) {
+            const char* pos = chunkBegin + pointCloudTextChunkSize;
+            const void* eol = std::memchr(pos, '\n', remaining - pointCloudTextChunkSize);
+            chunkEnd = eol ? static_cast<const char*>(eol) + 1 : end;
+        }
+
+        PointCloudTextChunk chunk;
+        chunk.begin = chunkBegin;
+        chunk.end = chunkEnd;
+        vecChunk.push_back(std::move(chunk));
+        chunkBegin = chunkEnd;
+    }
+
+    const int minColumnCount = columns.minColumnCount();
+    ThreadBudget::parallelFor(0, int(vecChunk.size()), [&](int iChunk) {
+        if (TaskProgress::isAbortRequested(progress))
+            return;
+
+        PointCloudTextChunk& chunk = vecChunk.at(iChunk);
+        double values[pointCloudMaxColumnCount];
+        for (const char* p = chunk.begin; p != chunk.end; ) {
+            int count;
+            p = parseLineValues(p, chunk.end, values, &count);
+            if (count < minColumnCount)
+                continue;
+
+            for (int k = 0; k < 3; ++k)
+                chunk.vecCoord.push_back(float(values[columns.coord[k]]));
+
+            if (columns.hasColors()) {
+                for (int k = 0; k < 3; ++k) {
+                    const double value = values[columns.color[k]] * columns.colorScale;
+                    chunk.vecColor.push_back(toColorComponent(value));
+                }
+            }
+        }
+    });
+
+    if (TaskProgress::isAbortRequested(progress))
+        return false;
+
+    std::vector<size_t> vecChunkOffset(vecChunk.size() + 1, 0);
+    for (size_t i = 0; i < vecChunk.size(); ++i)
+        vecChunkOffset.at(i + 1) = vecChunkOffset.at(i) + vecChunk.at(i).vecCoord.size();
+
+    std::vector<float>& vecCoord = cloud->changeCoords();
+    std::vector<uint8_t>& vecColor = cloud->changeColors();
+    vecCoord.resize(vecChunkOffset.back());
+    vecColor.resize(columns.hasColors() ? vecChunkOffset.back() : 0);
+    ThreadBudget::parallelFor(0, int(vecChunk.size()), [&](int iChunk) {
+        PointCloudTextChunk& chunk = vecChunk.at(iChunk);
+        const size_t offset = vecChunkOffset.at(iChunk);
+        std::copy(chunk.vecCoord.cbegin(), chunk.vecCoord.cend(), vecCoord.begin() + offset);
+        std::copy(chunk.vecColor.cbegin(), chunk.vecColor.cend(), vecColor.begin() + offset);
+        chunk.vecCoord = {};
+        chunk.vecColor = {};
+    });
+
+    return true;
+}
+
+// Columns of XYZ and PTS contents are deduced from the first line having a point
+// XYZ : "x y z [r g b]", PTS : "x y z intensity [r g b]" preceded by a line for point count
+static PointCloudColumns textPointCloudColumns(
+        const Format& format, const char* begin, const char* end)
+{
+    PointCloudColumns columns;
+    double values[pointCloudMaxColumnCount];
+    int count = 0;
+    for (const char* p = begin; p != end && count < 3; )
+        p = parseLineValues(p, end, values, &count);
+
+    const int firstColorColumn = format == Format_PTS ? 4 : 3;
+    if (count < firstColorColumn + 3)
+        return columns;
+
+    // Colors are integer values in [0, 255], otherwise columns are normals or alike
+    for (int i = firstColorColumn; i < firstColorColumn + 3; ++i) {
+        if (values[i] < 0 || values[i] > 255 || values[i] != std::floor(values[i]))
+            return columns;
+    }
+
+    for (int k = 0; k < 3; ++k)
+        columns.color[k] = firstColorColumn + k;
+
+    return columns;
+}
+
+enum class PlyScalarType {
+    Unknown, Int8, UInt8, Int16, UInt16, Int32, UInt32, Float32, Float64
+};
+
+static PlyScalarType plyScalarType(const QByteArray& str)
+{
+    if (str == "char" || str == "int8")
+        return PlyScalarType::Int8;
+    else if (str == "uchar" || str == "uint8")
+        return PlyScalarType::UInt8;
+    else if (str == "short" || str == "int16")
+        return PlyScalarType::Int16;
+    else if (str == "ushort" || str == "uint16")
+        return PlyScalarType::UInt16;
+    else if (str == "int" || str == "int32")
+        return PlyScalarType::Int32;
+    else if (str == "uint" || str == "uint32")
+        return PlyScalarType::UInt32;
+    else if (str == "float" || str == "float32")
+        return PlyScalarType::Float32;
+    else if (str == "double" || str == "float64")
+        return PlyScalarType::Float64;
+
+    return PlyScalarType::Unknown;
+}
+
+static int plyScalarSize(PlyScalarType type)
+{
+    switch (type) {
+    case PlyScalarType::Int8:
+    case PlyScalarType::UInt8: return 1;
+    case PlyScalarType::Int16:
+    case PlyScalarType::UInt16: return 2;
+    case PlyScalarType::Int32:
+    case PlyScalarType::UInt32:
+    case PlyScalarType::Float32: return 4;
+    case PlyScalarType::Float64: return 8;
+    case PlyScalarType::Unknown: break;
+    }
+
+    return 0;
+}
+
+// Factor to get 8-bit color components from values of 'type'
+static double plyColorScale(PlyScalarType type)
+{
+    switch (type) {
+    case PlyScalarType::UInt16: return 255. / 65535.;
+    case PlyScalarType::Float32:
+    case PlyScalarType::Float64: return 255.;
+    default: return 1.;
+    }
+}
+
+template<typename T> T plyLoad(const char* p, bool swapBytes)
+{
+    T value;
+    std::memcpy(&value, p, sizeof(T));
+    if (swapBytes) {
+        char* bytes = reinterpret_cast<char*>(&value);
+        std::reverse(bytes, bytes + sizeof(T));
+    }
+
+    return value;
+}
+
+static double plyBinaryValue(const char* p, PlyScalarType type, bool swapBytes)
+{
+    switch (type) {
+    case PlyScalarType::Int8: return plyLoad<int8_t>(p, swapBytes);
+    case PlyScalarType::UInt8: return plyLoad<uint8_t>(p, swapBytes);
+    case PlyScalarType::Int16: return plyLoad<int16_t>(p, swapBytes);
+    case PlyScalarType::UInt16: return plyLoad<uint16_t>(p, swapBytes);
+    case PlyScalarType::Int32: return plyLoad<int32_t>(p, swapBytes);
+    case PlyScalarType::UInt32: return plyLoad<uint32_t>(p, swapBytes);
+    case PlyScalarType::Float32: return plyLoad<float>(p, swapBytes);
+    case PlyScalarType::Float64: return plyLoad<double>(p, swapBytes);
+    case PlyScalarType::Unknown: break;
+    }
+
+    return 0.;
+}
+
+struct PlyProperty {
+    QByteArray name;
+    PlyScalarType type = PlyScalarType::Unknown;
+    bool isList = false;
+};
+
+struct PlyElement {
+    QByteArray name;
+    qint64 count = 0;
+    std::vector<PlyProperty> vecProperty;
+
+    bool hasListProperty() const {
+        return std::any_of(this->vecProperty.cbegin(), this->vecProperty.cend(), [](const auto& p) {
+            return p.isList;
+        });
+    }
+
+    // Size in bytes of an element item, only meaningful when there is no list property
+    int binaryStride() const {
+        int stride = 0;
+        for (const PlyProperty& property : this->vecProperty)
+            stride += plyScalarSize(property.type);
+
+        return stride;
+    }
+
+    int findProperty(const char* name) const {
+        for (unsigned i = 0; i < this->vecProperty.size(); ++i) {
+            if (this->vecProperty.at(i).name == name)
+                return int(i);
+        }
+
+        return -1;
+    }
+};
+
+enum class PlyEncoding {
+    Ascii, BinaryLittleEndian, BinaryBigEndian
+};
+
+struct PlyHeader {
+    PlyEncoding encoding = PlyEncoding::Ascii;
+    std::vector<PlyElement> vecElement;
+    size_t dataOffset = 0; // Position of element data, past the "end_header" line
+};
+
+static bool parsePlyHeader(const char* data, size_t size, PlyHeader* header)
+{
+    bool hasFormat = false;
+    size_t pos = 0;
+    for (int lineId = 0; pos < size; ++lineId) {
+        const void* eol = std::memchr(data + pos, '\n', size - pos);
+        if (!eol)
+            return false;
+
+        const size_t lineEnd = static_cast<const char*>(eol) - data;
+        const QByteArray line = QByteArray(data + pos, int(lineEnd - pos)).simplified();
+        pos = lineEnd + 1;
+        if (lineId == 0) {
+            if (line != "ply")
+                return false;
+
+            continue;
+        }
+
+        const QList<QByteArray> tokens = line.split(' ');
+        const QByteArray& keyword = tokens.front();
+        if (keyword == "format" && tokens.size() >= 2) {
+            if (tokens.at(1) == "ascii")
+                header->encoding = PlyEncoding::Ascii;
+            else if (tokens.at(1) == "binary_little_endian")
+                header->encoding = PlyEncoding::BinaryLittleEndian;
+            else if (tokens.at(1) == "binary_big_endian")
+                header->encoding = PlyEncoding::BinaryBigEndian;
+            else
+                return false;
+
+            hasFormat = true;
+        }
+        else if (keyword == "element" && tokens.size() == 3) {
+            PlyElement element;
+            element.name = tokens.at(1);
+            bool ok = false;
+            element.count = tokens.at(2).toLongLong(&ok);
+            if (!ok || element.count < 0)
+                return false;
+
+            header->vecElement.push_back(std::move(element));
+        }
+        else if (keyword == "property" && tokens.size() >= 3) {
+            if (header->vecElement.empty())
+                return false;
+
+            PlyProperty property;
+            property.isList = tokens.at(1) == "list";
+            property.type = plyScalarType(tokens.at(property.isList ? 3 : 1));
+            property.name = tokens.back();
+            if (!property.isList && property.type == PlyScalarType::Unknown)
+                return false;
+
+            header->vecElement.back().vecProperty.push_back(std::move(property));
+        }
+        else if (keyword == "end_header") {
+            header->dataOffset = pos;
+            return hasFormat;
+        }
+    }
+
+    return false;
+}
+
+// Returns the position past 'lineCount' lines from 'p', or nullptr if there are less lines
+static const char* skipLines(const char* p, const char* end, qint64 lineCount)
+{
+    for (qint64 i = 0; i < lineCount; ++i) {
+        const void* eol = p != end ? std::memchr(p, '\n', end - p) : nullptr;
+        if (!eol)
+            return i == lineCount - 1 && p != end ? end : nullptr;
+
+        p = static_cast<const char*>(eol) + 1;
+    }
+
+    return p;
+}
+
+// Parses the "vertex" element of PLY contents, elements preceding it must not have list
+// properties as their size couldn't be computed without being parsed
+static bool parsePlyPoints(const char* data, size_t size, PointCloud* cloud, TaskProgress* progress)
+{
+    PlyHeader header;
+    if (!parsePlyHeader(data, size, &header))
+        return false;
+
+    auto itVertex = std::find_if(
+                header.vecElement.cbegin(), header.vecElement.cend(), [](const PlyElement& e) {
+        return e.name == "vertex";
+    });
+    if (itVertex == header.vecElement.cend() || itVertex->hasListProperty())
+        return false;
+
+    const bool isAscii = header.encoding == PlyEncoding::Ascii;
+    const char* dataEnd = data + size;
+    const char* vertexBegin = data + header.dataOffset;
+    for (auto it = header.vecElement.cbegin(); it != itVertex; ++it) {
+        if (it->hasListProperty())
+            return false;
+
+        if (isAscii) {
+            vertexBegin = skipLines(vertexBegin, dataEnd, it->count);
+            if (!vertexBegin)
+                return false;
+        }
+        else {
+            const qint64 elementSize = it->count * it->binaryStride();
+            if (elementSize > dataEnd - vertexBegin)
+                return false;
+
+            vertexBegin += elementSize;
+        }
+    }
+
+    const PlyElement& vertex = *itVertex;
+    const int idCoord[3] = {
+        vertex.findProperty("x"), vertex.findProperty("y"), vertex.findProperty("z")
+    };
+    if (idCoord[0] < 0 || idCoord[1] < 0 || idCoord[2] < 0)
+        return false;
+
+    int idColor[3] = {
+        vertex.findProperty("red"), vertex.findProperty("green"), vertex.findProperty("blue")
+    };
+    if (idColor[0] < 0 || idColor[1] < 0 || idColor[2] < 0) {
+        idColor[0] = vertex.findProperty("diffuse_red");
+        idColor[1] = vertex.findProperty("diffuse_green");
+        idColor[2] = vertex.findProperty("diffuse_blue");
+    }
+
+    const bool hasColors = idColor[0] >= 0 && idColor[1] >= 0 && idColor[2] >= 0;
+    const double colorScale =
+            hasColors ? plyColorScale(vertex.vecProperty.at(idColor[0]).type) : 1.;
+    if (isAscii) {
+        const char* vertexEnd = skipLines(vertexBegin, dataEnd, vertex.count);
+        if (!vertexEnd)
+            return false;
+
+        PointCloudColumns columns;
+        std::copy(idCoord, idCoord + 3, columns.coord);
+        if (hasColors)
+            std::copy(idColor, idColor + 3, columns.color);
+
+        columns.colorScale = colorScale;
+        return parseTextPoints(vertexBegin, vertexEnd, columns, cloud, progress);
+    }
+
+    // Binary items have a fixed size, so chunks of points are decoded in parallel in place
+    const int stride = vertex.binaryStride();
+    if (vertex.count * stride > dataEnd - vertexBegin || vertex.count > INT_MAX)
+        return false;
+
+    int offset[6] = {};
+    PlyScalarType type[6] = {};
+    for (int k = 0; k < 6; ++k) {
+        const int id = k < 3 ? idCoord[k] : idColor[k - 3];
+        if (id < 0)
+            continue;
+
+        for (int i = 0; i < id; ++i)
+            offset[k] += plyScalarSize(vertex.vecProperty.at(i).type);
+
+        type[k] = vertex.vecProperty.at(id).type;
+    }
+
+    const bool isHostBigEndian = Q_BYTE_ORDER == Q_BIG_ENDIAN;
+    const bool swapBytes = (header.encoding == PlyEncoding::BinaryBigEndian) != isHostBigEndian;
+    const int pointCount = int(vertex.count);
+    std::vector<float>& vecCoord = cloud->changeCoords();
+    std::vector<uint8_t>& vecColor = cloud->changeColors();
+    vecCoord.resize(3 * size_t(pointCount));
+    vecColor.resize(hasColors ? 3 * size_t(pointCount) : 0);
+    const int chunkSize = pointCloudBinaryChunkSize;
+    const int chunkCount = (pointCount + chunkSize - 1) / chunkSize;
+    ThreadBudget::parallelFor(0, chunkCount, [&](int iChunk) {
+        if (TaskProgress::isAbortRequested(progress))
+            return;
+
+        const int iEnd = std::min(pointCount, (iChunk + 1) * chunkSize);
+        for (int i = iChunk * chunkSize; i < iEnd; ++i) {
+            const char* item = vertexBegin + size_t(i) * stride;
+            float* coords = vecCoord.data() + 3 * size_t(i);
+            for (int k = 0; k < 3; ++k)
+                coords[k] = float(plyBinaryValue(item + offset[k], type[k], swapBytes));
+
+            if (hasColors) {
+                uint8_t* color = vecColor.data() + 3 * size_t(i);
+                for (int k = 0; k < 3; ++k) {
+                    const char* itemValue = item + offset[k + 3];
+                    const double value = plyBinaryValue(itemValue, type[k + 3], swapBytes);
+                    color[k] = toColorComponent(value * colorScale);
+                }
+            }
+        }
+    });
+
+    return !TaskProgress::isAbortRequested(progress);
+}
+
+} // namespace
+
+PointCloudReader::PointCloudReader(const Format& format)
+    : m_format(format)
+{
+}
+
+bool PointCloudReader::readFile(const QString& filepath, TaskProgress* progress)
+{
+    MAYO_TRACE_SCOPE("io", "PointCloudReader::readFile");
+    m_baseFilename = QFileInfo(filepath).baseName();
+    m_cloud.Nullify();
+    QFile file(filepath);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    const qint64 fileSize = file.size();
+    const uchar* fileData = fileSize > 0 ? file.map(0, fileSize) : nullptr;
+    if (!fileData)
+        return false;
+
+    progress->setStep(PointCloudReader::textIdTr("Parsing points"));
+    const char* data = reinterpret_cast<const char*>(fileData);
+    Handle_PointCloud cloud = PointCloudReader::parse(m_format, data, size_t(fileSize), progress);
+    file.unmap(const_cast<uchar*>(fileData));
+    if (cloud.IsNull())
+        return false;
+
+    static Metrics::Counter& counterPoints = Metrics::counter("pointcloud.pointsRead");
+    counterPoints.add(cloud->pointCount());
+    progress->setStep(PointCloudReader::textIdTr("Building octree"));
+    if (!cloud->buildOctree(PointCloud::DefaultNodePointCount, progress))
+        return false;
+
+    m_cloud = cloud;
+    return true;
+}
+
+bool PointCloudReader::transfer(DocumentPtr doc, TaskProgress* progress)
+{
+    if (m_cloud.IsNull())
+        return false;
+
+    SingleScopeImport import(doc);
+    PointCloudAttribute::Set(import.entityLabel(), m_cloud);
+    CafUtils::setLabelAttrStdName(import.entityLabel(), m_baseFilename);
+    progress->setValue(100);
+    return true;
+}
+
+Handle_PointCloud PointCloudReader::parse(
+        const Format& format, const char* data, size_t size, TaskProgress* progress)
+{
+    MAYO_TRACE_SCOPE("pointcloud", "parse");
+    Handle_PointCloud cloud = new PointCloud;
+    bool ok = false;
+    if (format == Format_PLY) {
+        ok = parsePlyPoints(data, size, cloud.get(), progress);
+    }
+    else if (format == Format_XYZ || format == Format_PTS) {
+        const char* end = data + size;
+        const PointCloudColumns columns = textPointCloudColumns(format, data, end);
+        ok = parseTextPoints(data, end, columns, cloud.get(), progress);
+    }
+
+    return ok ? cloud : Handle_PointCloud();
+}
+
+Span<const Format> PointCloudFactoryReader::formats() const
+{
+    static const Format array[] = { Format_PLY, Format_XYZ, Format_PTS };
+    return array;
+}
+
+std::unique_ptr<Reader> PointCloudFactoryReader::create(const Format& format) const
+{
+    for (const Format& candidate : this->formats()) {
+        if (candidate == format)
+            return std::make_unique<PointCloudReader>(format);
+    }
+
+    return {};
+}
+
+std::unique_ptr<PropertyGroup> PointCloudFactoryReader::createProperties(
+        const Format& /*format*/, PropertyGroup* /*parentGroup*/) const
+{
+    return {};
+}
+
+} // namespace IO
+} // namespace Mayo
@@ -0,0 +1,52 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "io_format.h"
+#include "io_reader.h"
+#include "point_cloud.h"
+#include "text_id.h"
+#include <QtCore/QString>
+
+namespace Mayo {
+namespace IO {
+
+// Reader for point cloud file formats : PLY(vertex element, ascii or binary), XYZ and PTS
+// File is memory-mapped and parsed in parallel by chunks, then the octree of the point cloud
+// is built for level of detail display
+class PointCloudReader : public Reader {
+    MAYO_DECLARE_TEXT_ID_FUNCTIONS(Mayo::IO::PointCloudReader)
+public:
+    PointCloudReader(const Format& format);
+
+    bool readFile(const QString& filepath, TaskProgress* progress) override;
+    bool transfer(DocumentPtr doc, TaskProgress* progress) override;
+
+    // Parses the 'size' bytes of 'data', contents of a file in 'format'
+    // Returns null handle if contents are invalid or parsing was aborted
+    // Octree of the returned point cloud isn't built
+    static Handle_PointCloud parse(
+            const Format& format, const char* data, size_t size, TaskProgress* progress = nullptr);
+
+private:
+    Format m_format;
+    Handle_PointCloud m_cloud;
+    QString m_baseFilename;
+};
+
+// Provides factory for PointCloudReader objects
+class PointCloudFactoryReader : public FactoryReader {
+public:
+    Span<const Format> formats() const override;
+    std::unique_ptr<Reader> create(const Format& format) const override;
+    std::unique_ptr<PropertyGroup> createProperties(
+            const Format& format,
+            PropertyGroup* parentGroup) const override;
+};
+
+} // namespace IO
+} // namespace Mayo
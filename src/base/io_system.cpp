@@ -11,8 +11,12 @@
 #include "io_reader.h"
 #include "io_writer.h"
 #include "messenger.h"
+#include "metrics.h"
 #include "task_manager.h"
 #include "task_progress.h"
+#include "thread_budget.h"
+#include "tracing.h"
+#include "xcaf.h"
 
 #include <QtCore/QDebug>
 #include <QtCore/QFile>
@@ -323,6 +327,10 @@ bool System::importInDocument(const Args_ImportInDocument& args)
     Messenger* messenger = args.messenger ? args.messenger : nullMessenger();
 
     bool ok = true;
+    const bool hasTessellationStage = args.tessellation.enabled;
+    // Observers of the document are notified of new entities only once they are meshed
+    doc->holdEntityAddedSignals();
+    auto _ = gsl::finally([=]{ doc->releaseEntityAddedSignals(); });
 
     using ReaderPtr = std::unique_ptr<Reader>;
     auto fnAddError = [&](QString filepath, QString errorMsg) {
@@ -333,10 +341,16 @@ bool System::importInDocument(const Args_ImportInDocument& args)
         fnAddError(filepath, errorMsg);
         return {};
     };
-    auto fnReadFile = [&](QString filepath, TaskProgress* subProgress) -> ReaderPtr {
-        subProgress->beginScope(40, tr("Reading file"));
+    auto fnReadFile = [&](QString filepath, TaskProgress* subProgress, int scopeSize) -> ReaderPtr {
+        subProgress->beginScope(scopeSize, tr("Reading file"));
         auto _ = gsl::finally([=]{ subProgress->endScope(); });
-        const Format fileFormat = this->probeFormat(filepath);
+        MAYO_TRACE_SCOPE("io", "readFile");
+        Format fileFormat = Format_Unknown;
+        {
+            MAYO_TRACE_SCOPE("io", "probeFormat");
+            fileFormat = this->probeFormat(filepath);
+        }
+
         if (fileFormat == Format_Unknown)
             return fnReadFileError(filepath, tr("Unknown format"));
 
@@ -350,11 +364,19 @@ bool System::importInDocument(const Args_ImportInDocument& args)
         if (!reader->readFile(filepath, subProgress))
             return fnReadFileError(filepath, tr("File read problem"));
 
+        static Metrics::Counter& counterBytesRead = Metrics::counter("io.bytesRead");
+        static Metrics::Counter& counterFilesRead = Metrics::counter("io.filesRead");
+        counterBytesRead.add(QFileInfo(filepath).size());
+        counterFilesRead.add();
+
         return reader;
     };
-    auto fnTransfer = [&](QString filepath, const ReaderPtr& reader, TaskProgress* subProgress) {
-        subProgress->beginScope(60, tr("Transferring file"));
+    auto fnTransfer = [&](
+            QString filepath, const ReaderPtr& reader, TaskProgress* subProgress, int scopeSize)
+    {
+        subProgress->beginScope(scopeSize, tr("Transferring file"));
         if (reader) {
+            MAYO_TRACE_SCOPE("io", "transfer");
             if (!reader->transfer(doc, subProgress) && !TaskProgress::isAbortRequested(subProgress))
                 fnAddError(filepath, tr("File transfer problem"));
         }
@@ -362,11 +384,34 @@ bool System::importInDocument(const Args_ImportInDocument& args)
         subProgress->endScope();
     };
 
+    auto fnTessellate = [&](int scopeSize) {
+        progress->beginScope(scopeSize, tr("Meshing"));
+        std::vector<TopoDS_Shape> vecShape;
+        for (TreeNodeId entityTreeNodeId : doc->heldAddedEntities()) {
+            const TDF_Label entityLabel = doc->modelTree().nodeData(entityTreeNodeId);
+            if (XCaf::isShape(entityLabel))
+                vecShape.push_back(XCaf::shape(entityLabel));
+        }
+
+        const TessellationParameters params =
+                args.tessellation.progressive ?
+                    Tessellation::coarseParameters(args.tessellation) :
+                    args.tessellation;
+        Tessellation::tessellate(vecShape, params, progress);
+        progress->endScope();
+    };
+
+    const int tessellationScopeSize = hasTessellationStage ? 30 : 0;
     if (listFilepath.size() == 1) { // Single file case
-        const ReaderPtr reader = fnReadFile(listFilepath.front(), progress);
-        fnTransfer(listFilepath.front(), reader, progress);
+        const int readScopeSize = hasTessellationStage ? 30 : 40;
+        const int transferScopeSize = 100 - readScopeSize - tessellationScopeSize;
+        const ReaderPtr reader = fnReadFile(listFilepath.front(), progress, readScopeSize);
+        fnTransfer(listFilepath.front(), reader, progress, transferScopeSize);
     }
     else { // Many files case
+        if (hasTessellationStage)
+            progress->beginScope(100 - tessellationScopeSize, tr("Importing files"));
+
         struct TaskData {
             std::unique_ptr<Reader> reader;
             QString filepath;
@@ -377,6 +422,9 @@ bool System::importInDocument(const Args_ImportInDocument& args)
         std::vector<TaskData> vecTaskData;
         vecTaskData.resize(listFilepath.size());
 
+        // Files are read by child tasks, which need the run slot of this task to start when the
+        // thread budget is used up. Transfers are sequential so they don't oversubscribe much
+        const ThreadBudget::RunSlotYield runSlotYield;
         TaskManager childTaskManager;
         QObject::connect(
                     &childTaskManager, &TaskManager::progressChanged,
@@ -387,7 +435,7 @@ bool System::importInDocument(const Args_ImportInDocument& args)
             taskData.filepath = listFilepath.at(i);
             const TaskId childTaskId = childTaskManager.newTask([&](TaskProgress* progressChild) {
                 taskData.progress = progressChild;
-                taskData.reader = fnReadFile(taskData.filepath, progressChild);
+                taskData.reader = fnReadFile(taskData.filepath, progressChild, 40);
             });
             taskData.taskId = childTaskId;
             childTaskManager.run(childTaskId, TaskAutoDestroy::Off);
@@ -411,13 +459,19 @@ bool System::importInDocument(const Args_ImportInDocument& args)
             }
 
             if (itTaskData != vecTaskData.end()) {
-                fnTransfer(itTaskData->filepath, itTaskData->reader, itTaskData->progress);
+                fnTransfer(itTaskData->filepath, itTaskData->reader, itTaskData->progress, 60);
                 itTaskData->transferred = true;
                 --taskDataCount;
             }
         } // endwhile
+
+        if (hasTessellationStage)
+            progress->endScope();
     }
 
+    if (hasTessellationStage && !progress->isAbortRequested())
+        fnTessellate(tessellationScopeSize);
+
     return ok;
 }
 
@@ -540,6 +594,12 @@ System::Operation_ImportInDocument::withFilepath(const QString& filepath)
     return this->withFilepaths({ filepath });
 }
 
+System::Operation_ImportInDocument&
+System::Operation_ImportInDocument::withTessellation(const TessellationParameters& params) {
+    m_args.tessellation = params;
+    return *this;
+}
+
 bool System::Operation_ImportInDocument::execute() {
     return m_system.importInDocument(m_args);
 }
@@ -563,6 +623,13 @@ auto findFirstNonSpace(const QByteArray& str) {
     return std::find_if_not(str.cbegin(), str.cend(), isSpace);
 }
 
+bool matchRegexAtBegin(const QByteArray& str, const std::regex& rx) {
+    return std::regex_search(str.cbegin(), str.cend(), rx, std::regex_constants::match_continuous);
+}
+
+// Regular expression of a decimal number, possibly with exponent
+const char numberRegexPattern[] = "[-\\+]?([0-9]+\\.?[0-9]*|\\.[0-9]+)([eE][-\\+]?[0-9]+)?";
+
 } // namespace
 
 Format probeFormat_STEP(const System::FormatProbeInput& input)
@@ -659,6 +726,38 @@ Format probeFormat_OBJ(const System::FormatProbeInput& input)
     return Format_Unknown;
 }
 
+Format probeFormat_PLY(const System::FormatProbeInput& input)
+{
+    // regex : ^ply\r?\n
+    const QByteArray& sample = input.contentsBegin;
+    if (sample.startsWith("ply\n") || sample.startsWith("ply\r\n"))
+        return Format_PLY;
+
+    return Format_Unknown;
+}
+
+Format probeFormat_PTS(const System::FormatProbeInput& input)
+{
+    // First line is the count of points, next lines have at least 3 numbers
+    const std::string num = numberRegexPattern;
+    const std::regex rx("^\\s*[0-9]+\\s*\\r?\\n\\s*" + num + "(\\s+" + num + "){2,}\\s");
+    if (matchRegexAtBegin(input.contentsBegin, rx))
+        return Format_PTS;
+
+    return Format_Unknown;
+}
+
+Format probeFormat_XYZ(const System::FormatProbeInput& input)
+{
+    // First line has at least 3 numbers, separated by spaces or commas
+    const std::string num = numberRegexPattern;
+    const std::regex rx("^[ \\t]*" + num + "([ \\t]*[ \\t,][ \\t]*" + num + "){2,}[ \\t,]*\\r?\\n");
+    if (matchRegexAtBegin(input.contentsBegin, rx))
+        return Format_XYZ;
+
+    return Format_Unknown;
+}
+
 void addPredefinedFormatProbes(System* system)
 {
     if (!system)
@@ -669,6 +768,9 @@ void addPredefinedFormatProbes(System* system)
     system->addFormatProbe(probeFormat_OCCBREP);
     system->addFormatProbe(probeFormat_STL);
     system->addFormatProbe(probeFormat_OBJ);
+    system->addFormatProbe(probeFormat_PLY);
+    system->addFormatProbe(probeFormat_PTS);
+    system->addFormatProbe(probeFormat_XYZ);
 }
 
 } // namespace IO
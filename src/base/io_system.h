@@ -12,6 +12,7 @@
 #include "io_writer.h"
 #include "property.h"
 #include "span.h"
+#include "tessellation.h"
 
 #include <QtCore/QCoreApplication>
 #include <functional>
@@ -64,6 +65,8 @@ public:
         const ParametersProvider* parametersProvider = nullptr;
         Messenger* messenger = nullptr;
         TaskProgress* progress = nullptr;
+        // Meshing stage applied to the new entities once all files are transferred
+        TessellationParameters tessellation;
     };
     bool importInDocument(const Args_ImportInDocument& args);
 
@@ -89,6 +92,7 @@ public:
         Operation& withParametersProvider(const ParametersProvider* provider);
         Operation& withMessenger(Messenger* messenger);
         Operation& withTaskProgress(TaskProgress* progress);
+        Operation& withTessellation(const TessellationParameters& params);
         bool execute();
 
     private:
@@ -134,6 +138,9 @@ Format probeFormat_IGES(const System::FormatProbeInput& input);
 Format probeFormat_OCCBREP(const System::FormatProbeInput& input);
 Format probeFormat_STL(const System::FormatProbeInput& input);
 Format probeFormat_OBJ(const System::FormatProbeInput& input);
+Format probeFormat_PLY(const System::FormatProbeInput& input);
+Format probeFormat_PTS(const System::FormatProbeInput& input);
+Format probeFormat_XYZ(const System::FormatProbeInput& input);
 void addPredefinedFormatProbes(System* system);
 
 } // namespace IO
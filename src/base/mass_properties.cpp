@@ -0,0 +1,314 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "mass_properties.h"
+
+#include "metrics.h"
+#include "task_progress.h"
+#include "thread_budget.h"
+#include "tracing.h"
+
+#include <BRepGProp.hxx>
+#include <GProp_GProps.hxx>
+#include <TopExp.hxx>
+#include <TopExp_Explorer.hxx>
+#include <TopoDS.hxx>
+#include <TopoDS_TShape.hxx>
+#include <TopTools_DataMapOfShapeInteger.hxx>
+#include <TopTools_IndexedMapOfShape.hxx>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace Mayo {
+
+namespace Internal {
+
+// Oldest entries are evicted beyond this count, as entries keep their TopoDS_TShape alive
+static const size_t massPropertiesCacheMaxEntryCount = 10000;
+
+struct MassPropertiesCacheEntry {
+    Handle_TopoDS_TShape tshape;
+    MassProperties props; // Properties of the shape without location
+};
+
+struct MassPropertiesCacheData {
+    std::mutex mutex;
+    std::unordered_map<const TopoDS_TShape*, MassPropertiesCacheEntry> mapEntry;
+    std::deque<const TopoDS_TShape*> queueKey; // Insertion order
+};
+
+static MassPropertiesCacheData& massPropertiesCacheData()
+{
+    static MassPropertiesCacheData data;
+    return data;
+}
+
+static bool findLocationless(const TopoDS_Shape& shape, MassProperties* props)
+{
+    MassPropertiesCacheData& data = massPropertiesCacheData();
+    std::lock_guard<std::mutex> lock(data.mutex);
+    auto it = data.mapEntry.find(shape.TShape().get());
+    if (it == data.mapEntry.cend())
+        return false;
+
+    *props = it->second.props;
+    return true;
+}
+
+static void insertLocationless(const TopoDS_Shape& shape, const MassProperties& props)
+{
+    MassPropertiesCacheData& data = massPropertiesCacheData();
+    std::lock_guard<std::mutex> lock(data.mutex);
+    const TopoDS_TShape* key = shape.TShape().get();
+    auto itInsert = data.mapEntry.insert({ key, { shape.TShape(), props } });
+    if (!itInsert.second)
+        return;
+
+    data.queueKey.push_back(key);
+    while (data.queueKey.size() > massPropertiesCacheMaxEntryCount) {
+        data.mapEntry.erase(data.queueKey.front());
+        data.queueKey.pop_front();
+    }
+}
+
+static void eraseLocationless(const std::unordered_set<const TopoDS_TShape*>& setKey)
+{
+    MassPropertiesCacheData& data = massPropertiesCacheData();
+    std::lock_guard<std::mutex> lock(data.mutex);
+    for (const TopoDS_TShape* key : setKey)
+        data.mapEntry.erase(key);
+
+    auto itQueueEnd = std::remove_if(
+                data.queueKey.begin(), data.queueKey.end(),
+                [&](const TopoDS_TShape* key) { return setKey.find(key) != setKey.cend(); });
+    data.queueKey.erase(itQueueEnd, data.queueKey.end());
+}
+
+static MassProperties transformed(const MassProperties& props, const TopLoc_Location& loc)
+{
+    MassProperties propsTrsf = props;
+    if (!loc.IsIdentity())
+        propsTrsf.centroid.Transform(loc.Transformation());
+
+    return propsTrsf;
+}
+
+// Accumulates properties of disjoint shapes
+class MassPropertiesSum {
+public:
+    void add(const MassProperties& props) {
+        m_area += props.area;
+        if (props.hasVolume) {
+            m_volume += props.volume;
+            m_volumeMoment += props.volume * props.centroid.XYZ();
+        }
+        else {
+            m_surfaceArea += props.area;
+            m_surfaceMoment += props.area * props.centroid.XYZ();
+        }
+    }
+
+    MassProperties result() const {
+        MassProperties props;
+        props.area = m_area;
+        props.volume = m_volume;
+        props.hasVolume = m_volume > 0.;
+        if (props.hasVolume)
+            props.centroid = gp_Pnt(m_volumeMoment / m_volume);
+        else if (m_surfaceArea > 0.)
+            props.centroid = gp_Pnt(m_surfaceMoment / m_surfaceArea);
+
+        return props;
+    }
+
+private:
+    double m_area = 0.;
+    double m_volume = 0.;
+    gp_XYZ m_volumeMoment;
+    double m_surfaceArea = 0.; // Area of the shapes without volume
+    gp_XYZ m_surfaceMoment;
+};
+
+} // namespace Internal
+
+bool MassPropertiesCache::find(const TopoDS_Shape& shape, MassProperties* props)
+{
+    if (shape.IsNull() || !props)
+        return false;
+
+    MassProperties propsLocationless;
+    if (!Internal::findLocationless(shape.Located(TopLoc_Location()), &propsLocationless))
+        return false;
+
+    *props = Internal::transformed(propsLocationless, shape.Location());
+    return true;
+}
+
+MassProperties MassPropertiesCache::compute(const TopoDS_Shape& shape, TaskProgress* progress)
+{
+    MassProperties props;
+    if (shape.IsNull() || MassPropertiesCache::find(shape, &props))
+        return props;
+
+    MAYO_TRACE_SCOPE("brep", "massProperties");
+    static Metrics::Counter& counterFaces = Metrics::counter("massProperties.facesComputed");
+
+    // Solids and free faces, instances of the same unit share the same computation
+    const TopoDS_Shape root = shape.Located(TopLoc_Location());
+    struct Instance {
+        int unitIndex;
+        TopLoc_Location location;
+    };
+    std::vector<TopoDS_Shape> vecUnit;
+    std::vector<Instance> vecInstance;
+    TopTools_DataMapOfShapeInteger mapUnitIndex;
+    auto fnAddInstance = [&](const TopoDS_Shape& instance) {
+        const TopoDS_Shape unit = instance.Located(TopLoc_Location());
+        int unitIndex = -1;
+        if (!mapUnitIndex.Find(unit, unitIndex)) {
+            unitIndex = int(vecUnit.size());
+            mapUnitIndex.Bind(unit, unitIndex);
+            vecUnit.push_back(unit);
+        }
+
+        vecInstance.push_back({ unitIndex, instance.Location() });
+    };
+
+    for (TopExp_Explorer expl(root, TopAbs_SOLID); expl.More(); expl.Next())
+        fnAddInstance(expl.Current());
+
+    for (TopExp_Explorer expl(root, TopAbs_FACE, TopAbs_SOLID); expl.More(); expl.Next())
+        fnAddInstance(expl.Current());
+
+    // Faces of the units not in cache are the parallel jobs
+    struct FaceJob {
+        int unitIndex;
+        TopoDS_Face face;
+        bool inSolid;
+        double area;
+        gp_XYZ areaMoment;
+        double volume; // Contribution to the volume of the solid, signed
+        gp_XYZ volumeMoment;
+    };
+    std::vector<MassProperties> vecUnitProps(vecUnit.size());
+    std::vector<char> vecUnitCached(vecUnit.size(), 0);
+    std::vector<FaceJob> vecJob;
+    for (size_t i = 0; i < vecUnit.size(); ++i) {
+        const TopoDS_Shape& unit = vecUnit.at(i);
+        vecUnitCached.at(i) = Internal::findLocationless(unit, &vecUnitProps.at(i));
+        if (vecUnitCached.at(i))
+            continue;
+
+        const bool inSolid = unit.ShapeType() == TopAbs_SOLID;
+        for (TopExp_Explorer expl(unit, TopAbs_FACE); expl.More(); expl.Next())
+            vecJob.push_back({ int(i), TopoDS::Face(expl.Current()), inSolid, 0., {}, 0., {} });
+    }
+
+    std::atomic<int> doneCount = {};
+    std::mutex progressMutex;
+    int progressPct = 0;
+    const int jobCount = int(vecJob.size());
+    ThreadBudget::parallelFor(0, jobCount, [&](int i) {
+        if (TaskProgress::isAbortRequested(progress))
+            return;
+
+        FaceJob& job = vecJob.at(i);
+        GProp_GProps surfaceProps;
+        BRepGProp::SurfaceProperties(job.face, surfaceProps);
+        job.area = surfaceProps.Mass();
+        job.areaMoment = job.area * surfaceProps.CentreOfMass().XYZ();
+        if (job.inSolid) {
+            // Divergence theorem : volume of a solid is the sum of the face contributions
+            GProp_GProps volumeProps;
+            BRepGProp::VolumeProperties(job.face, volumeProps);
+            job.volume = volumeProps.Mass();
+            if (std::abs(job.volume) > 0.)
+                job.volumeMoment = job.volume * volumeProps.CentreOfMass().XYZ();
+        }
+
+        const int done = ++doneCount;
+        if (progress) {
+            std::lock_guard<std::mutex> lock(progressMutex);
+            const int pct = (done * 100) / jobCount;
+            if (pct > progressPct) {
+                progressPct = pct;
+                progress->setValue(pct);
+            }
+        }
+    });
+
+    if (TaskProgress::isAbortRequested(progress))
+        return {};
+
+    counterFaces.add(jobCount);
+
+    // Reduce face contributions per unit, in job order so the result is deterministic
+    std::vector<double> vecUnitVolume(vecUnit.size(), 0.);
+    std::vector<gp_XYZ> vecUnitVolumeMoment(vecUnit.size());
+    std::vector<gp_XYZ> vecUnitAreaMoment(vecUnit.size());
+    for (const FaceJob& job : vecJob) {
+        vecUnitProps.at(job.unitIndex).area += job.area;
+        vecUnitAreaMoment.at(job.unitIndex) += job.areaMoment;
+        vecUnitVolume.at(job.unitIndex) += job.volume;
+        vecUnitVolumeMoment.at(job.unitIndex) += job.volumeMoment;
+    }
+
+    for (size_t i = 0; i < vecUnit.size(); ++i) {
+        if (vecUnitCached.at(i))
+            continue;
+
+        MassProperties& unitProps = vecUnitProps.at(i);
+        const double volume = vecUnitVolume.at(i);
+        unitProps.hasVolume = std::abs(volume) > 0.;
+        unitProps.volume = std::abs(volume);
+        if (unitProps.hasVolume)
+            unitProps.centroid = gp_Pnt(vecUnitVolumeMoment.at(i) / volume);
+        else if (unitProps.area > 0.)
+            unitProps.centroid = gp_Pnt(vecUnitAreaMoment.at(i) / unitProps.area);
+
+        Internal::insertLocationless(vecUnit.at(i), unitProps);
+    }
+
+    // Sum located instances
+    Internal::MassPropertiesSum sum;
+    for (const Instance& instance : vecInstance)
+        sum.add(Internal::transformed(vecUnitProps.at(instance.unitIndex), instance.location));
+
+    const MassProperties rootProps = sum.result();
+    Internal::insertLocationless(root, rootProps);
+    return Internal::transformed(rootProps, shape.Location());
+}
+
+void MassPropertiesCache::erase(const TopoDS_Shape& shape)
+{
+    if (shape.IsNull())
+        return;
+
+    TopTools_IndexedMapOfShape mapSubShape;
+    TopExp::MapShapes(shape, mapSubShape);
+    std::unordered_set<const TopoDS_TShape*> setKey;
+    for (int i = 1; i <= mapSubShape.Extent(); ++i)
+        setKey.insert(mapSubShape.FindKey(i).TShape().get());
+
+    Internal::eraseLocationless(setKey);
+}
+
+void MassPropertiesCache::clear()
+{
+    Internal::MassPropertiesCacheData& data = Internal::massPropertiesCacheData();
+    std::lock_guard<std::mutex> lock(data.mutex);
+    data.mapEntry.clear();
+    data.queueKey.clear();
+}
+
+} // namespace Mayo
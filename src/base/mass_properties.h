@@ -0,0 +1,44 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include <gp_Pnt.hxx>
+#include <TopoDS_Shape.hxx>
+
+namespace Mayo {
+
+class TaskProgress;
+
+struct MassProperties {
+    bool hasVolume = false; // True if shape contains solids
+    double area = 0.; // Length in mm²
+    double volume = 0.; // Length in mm³
+    // Center of mass of the solids, or of the faces if there is no volume
+    gp_Pnt centroid;
+};
+
+// Mass properties of BRep shapes computed from geometry with BRepGProp
+// Properties are cached per TopoDS_TShape, so all the instances of a product(and of its
+// sub-parts) share the same computation. Cache is thread-safe
+class MassPropertiesCache {
+public:
+    // Returns true and fills '*props' if properties of 'shape' are already in the cache
+    static bool find(const TopoDS_Shape& shape, MassProperties* props);
+
+    // Returns the properties of 'shape', computing them if not cached
+    // Faces of the solids and free faces not already in the cache are processed in parallel with
+    // ThreadBudget::parallelFor()
+    static MassProperties compute(const TopoDS_Shape& shape, TaskProgress* progress = nullptr);
+
+    // Erases the properties of 'shape' and of all its sub-shapes, to be called once their faces
+    // got new triangulations(faces without surface are computed from them)
+    static void erase(const TopoDS_Shape& shape);
+
+    static void clear();
+};
+
+} // namespace Mayo
@@ -0,0 +1,63 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "memory_utils.h"
+
+#include <Standard.hxx>
+#include <cstdio>
+
+#if defined(_WIN32)
+#  include <windows.h>
+#  include <malloc.h>
+#  include <psapi.h>
+#elif defined(__APPLE__)
+#  include <mach/mach.h>
+#elif defined(__linux__)
+#  include <malloc.h>
+#  include <unistd.h>
+#endif
+
+namespace Mayo {
+
+uint64_t MemoryUtils::processResidentMemory()
+{
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters = {};
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return counters.WorkingSetSize;
+#elif defined(__APPLE__)
+    mach_task_basic_info info = {};
+    mach_msg_type_number_t infoCount = MACH_TASK_BASIC_INFO_COUNT;
+    const kern_return_t ret =
+            task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &infoCount);
+    if (ret == KERN_SUCCESS)
+        return info.resident_size;
+#elif defined(__linux__)
+    FILE* file = std::fopen("/proc/self/statm", "r");
+    if (file) {
+        unsigned long sizePages = 0;
+        unsigned long residentPages = 0;
+        const int count = std::fscanf(file, "%lu %lu", &sizePages, &residentPages);
+        std::fclose(file);
+        if (count == 2)
+            return uint64_t(residentPages) * uint64_t(sysconf(_SC_PAGESIZE));
+    }
+#endif
+
+    return 0;
+}
+
+void MemoryUtils::releaseFreedMemory()
+{
+    Standard::Purge();
+#if defined(_WIN32)
+    _heapmin();
+#elif defined(__linux__) && defined(__GLIBC__)
+    malloc_trim(0);
+#endif
+}
+
+} // namespace Mayo
@@ -0,0 +1,24 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+
+namespace Mayo {
+
+class MemoryUtils {
+public:
+    // Returns the resident set size(physical memory in use) of the current process in bytes
+    // Returns 0 if not supported on the current platform
+    static uint64_t processResidentMemory();
+
+    // Gives back to the operating system the memory already freed but still retained by
+    // OpenCascade(Standard_MMgrOpt free lists) and C runtime allocators
+    static void releaseFreedMemory();
+};
+
+} // namespace Mayo
@@ -0,0 +1,389 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "mesh_analysis.h"
+
+#include "mesh_utils.h"
+#include "metrics.h"
+#include "task_progress.h"
+#include "thread_budget.h"
+#include "tracing.h"
+
+#include <gp_XYZ.hxx>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <iterator>
+#include <mutex>
+#include <unordered_map>
+
+namespace Mayo {
+
+namespace Internal {
+
+// Count of triangles processed by a parallel job
+static const int meshAnalysisChunkSize = 65536;
+// Count of hash partitions of the edge map, each one is sorted by a parallel job
+static const int meshAnalysisShardCount = 256;
+// Results can be big(they list edges), so few meshes are kept in cache
+static const size_t meshAnalysisCacheMaxEntryCount = 8;
+
+// Triangle side, stored with its lowest node index first
+struct MeshAnalysisHalfEdge {
+    uint32_t node1;
+    uint32_t node2;
+    uint32_t id; // 3 * triangle + corner, zero-based. Side goes from corner to next corner
+
+    bool operator<(const MeshAnalysisHalfEdge& other) const {
+        if (this->node1 != other.node1)
+            return this->node1 < other.node1;
+
+        if (this->node2 != other.node2)
+            return this->node2 < other.node2;
+
+        return this->id < other.id;
+    }
+};
+
+static int meshAnalysisShard(uint32_t node1, uint32_t node2)
+{
+    const uint64_t hash =
+            (uint64_t(node1) * 0x9E3779B97F4A7C15ull) ^ (uint64_t(node2) * 0xC2B2AE3D27D4EB4Full);
+    return int((hash >> 32) % meshAnalysisShardCount);
+}
+
+// Triangle nodes, zero-based indices of the welded nodes
+static void meshAnalysisTriangle(
+        const Poly_Array1OfTriangle& triangles, const std::vector<int>& vecWeld, int t, int (&n)[3])
+{
+    triangles.Value(triangles.Lower() + t).Get(n[0], n[1], n[2]);
+    for (int& node : n)
+        node = vecWeld[node - 1];
+}
+
+template<typename T>
+static void meshAnalysisAppend(std::vector<T>* vec, const std::vector<T>& other)
+{
+    vec->insert(vec->end(), other.cbegin(), other.cend());
+}
+
+static int meshAnalysisFindRoot(std::vector<int>& vecParent, int node)
+{
+    while (vecParent[node] != node) {
+        vecParent[node] = vecParent[vecParent[node]]; // Path halving
+        node = vecParent[node];
+    }
+
+    return node;
+}
+
+struct MeshAnalysisCacheEntry {
+    Handle_Poly_Triangulation mesh;
+    std::shared_ptr<const MeshAnalysisResult> result;
+};
+
+struct MeshAnalysisCacheData {
+    std::mutex mutex;
+    std::unordered_map<const Poly_Triangulation*, MeshAnalysisCacheEntry> mapEntry;
+    std::deque<const Poly_Triangulation*> queueKey; // Insertion order
+};
+
+static MeshAnalysisCacheData& meshAnalysisCacheData()
+{
+    static MeshAnalysisCacheData data;
+    return data;
+}
+
+} // namespace Internal
+
+MeshAnalysisResult MeshAnalysis::analyze(
+        const Handle_Poly_Triangulation& mesh,
+        const MeshAnalysisParameters& params,
+        TaskProgress* progress)
+{
+    MeshAnalysisResult result;
+    if (mesh.IsNull())
+        return result;
+
+    MAYO_TRACE_SCOPE("mesh", "analyze");
+    static Metrics::Counter& counterTriangles = Metrics::counter("mesh.trianglesAnalyzed");
+    using HalfEdge = Internal::MeshAnalysisHalfEdge;
+    using Edge = MeshAnalysisResult::Edge;
+    const int shardCount = Internal::meshAnalysisShardCount;
+    const int triangleCount = mesh->NbTriangles();
+    const int nodeCount = mesh->NbNodes();
+    const int chunkCount =
+            (triangleCount + Internal::meshAnalysisChunkSize - 1) / Internal::meshAnalysisChunkSize;
+    const TColgp_Array1OfPnt& nodes = mesh->Nodes();
+    const Poly_Array1OfTriangle& triangles = mesh->Triangles();
+    result.triangleCount = triangleCount;
+    const std::vector<int> vecWeld = MeshUtils::weldNodeMap(nodes, params.weldTolerance);
+    if (TaskProgress::isAbortRequested(progress))
+        return {};
+
+    // Triangle quality and count of sides per shard, for each chunk
+    struct ChunkData {
+        std::vector<int> vecDegenerateTriangle;
+        std::vector<int> vecSliverTriangle;
+    };
+    std::vector<ChunkData> vecChunk(chunkCount);
+    std::vector<uint32_t> vecChunkShardCount(size_t(chunkCount) * shardCount, 0);
+    const double qualityFactor = 2. * std::sqrt(3.); // Cross product norm is twice the area
+    ThreadBudget::parallelFor(0, chunkCount, [&](int c) {
+        if (TaskProgress::isAbortRequested(progress))
+            return;
+
+        ChunkData& chunk = vecChunk[c];
+        uint32_t* shardCounts = &vecChunkShardCount[size_t(c) * shardCount];
+        const int triBegin = c * Internal::meshAnalysisChunkSize;
+        const int triEnd = std::min(triBegin + Internal::meshAnalysisChunkSize, triangleCount);
+        for (int t = triBegin; t < triEnd; ++t) {
+            int n[3];
+            Internal::meshAnalysisTriangle(triangles, vecWeld, t, n);
+            for (int i = 0; i < 3; ++i) {
+                const uint32_t node1 = uint32_t(std::min(n[i], n[(i + 1) % 3]));
+                const uint32_t node2 = uint32_t(std::max(n[i], n[(i + 1) % 3]));
+                if (node1 != node2)
+                    ++shardCounts[Internal::meshAnalysisShard(node1, node2)];
+            }
+
+            if (n[0] == n[1] || n[1] == n[2] || n[2] == n[0]) {
+                chunk.vecDegenerateTriangle.push_back(t + 1);
+                continue;
+            }
+
+            const gp_XYZ& p1 = nodes.Value(nodes.Lower() + n[0]).XYZ();
+            const gp_XYZ& p2 = nodes.Value(nodes.Lower() + n[1]).XYZ();
+            const gp_XYZ& p3 = nodes.Value(nodes.Lower() + n[2]).XYZ();
+            const gp_XYZ v12 = p2 - p1;
+            const gp_XYZ v23 = p3 - p2;
+            const gp_XYZ v31 = p1 - p3;
+            const double sumSquaredLength =
+                    v12.SquareModulus() + v23.SquareModulus() + v31.SquareModulus();
+            const double quality =
+                    sumSquaredLength > 0. ?
+                        qualityFactor * v12.Crossed(v23).Modulus() / sumSquaredLength :
+                        0.;
+            if (quality < params.degenerateQualityThreshold)
+                chunk.vecDegenerateTriangle.push_back(t + 1);
+            else if (quality < params.sliverQualityThreshold)
+                chunk.vecSliverTriangle.push_back(t + 1);
+        }
+    });
+
+    if (TaskProgress::isAbortRequested(progress))
+        return {};
+
+    // Edge map : sides are scattered by shard, chunks write to disjoint ranges
+    std::vector<uint32_t> vecShardStart(shardCount + 1, 0);
+    {
+        uint32_t offset = 0;
+        for (int s = 0; s < shardCount; ++s) {
+            vecShardStart[s] = offset;
+            for (int c = 0; c < chunkCount; ++c) {
+                uint32_t& count = vecChunkShardCount[size_t(c) * shardCount + s];
+                const uint32_t chunkShardCount = count;
+                count = offset; // Now holds the write offset of the chunk into the shard
+                offset += chunkShardCount;
+            }
+        }
+
+        vecShardStart[shardCount] = offset;
+    }
+
+    std::vector<HalfEdge> vecHalfEdge(vecShardStart[shardCount]);
+    ThreadBudget::parallelFor(0, chunkCount, [&](int c) {
+        uint32_t* shardOffsets = &vecChunkShardCount[size_t(c) * shardCount];
+        const int triBegin = c * Internal::meshAnalysisChunkSize;
+        const int triEnd = std::min(triBegin + Internal::meshAnalysisChunkSize, triangleCount);
+        for (int t = triBegin; t < triEnd; ++t) {
+            int n[3];
+            Internal::meshAnalysisTriangle(triangles, vecWeld, t, n);
+            for (int i = 0; i < 3; ++i) {
+                const uint32_t node1 = uint32_t(std::min(n[i], n[(i + 1) % 3]));
+                const uint32_t node2 = uint32_t(std::max(n[i], n[(i + 1) % 3]));
+                if (node1 != node2) {
+                    const int shard = Internal::meshAnalysisShard(node1, node2);
+                    vecHalfEdge[shardOffsets[shard]++] = { node1, node2, uint32_t(3 * t + i) };
+                }
+            }
+        }
+    });
+
+    if (progress)
+        progress->setValue(40);
+
+    if (TaskProgress::isAbortRequested(progress))
+        return {};
+
+    // Sort each shard so sides of the same edge are contiguous, then classify edges
+    struct ShardData {
+        std::vector<Edge> vecBoundaryEdge;
+        std::vector<Edge> vecNonManifoldEdge;
+        std::vector<Edge> vecMisorientedEdge;
+        std::vector<int> vecDuplicateTriangle;
+    };
+    std::vector<ShardData> vecShard(shardCount);
+    ThreadBudget::parallelFor(0, shardCount, [&](int s) {
+        if (TaskProgress::isAbortRequested(progress))
+            return;
+
+        ShardData& shard = vecShard[s];
+        const auto itShardBegin = vecHalfEdge.begin() + vecShardStart[s];
+        const auto itShardEnd = vecHalfEdge.begin() + vecShardStart[s + 1];
+        std::sort(itShardBegin, itShardEnd);
+        auto itGroup = itShardBegin;
+        while (itGroup != itShardEnd) {
+            auto itGroupEnd = std::find_if(itGroup, itShardEnd, [=](const HalfEdge& he) {
+                return he.node1 != itGroup->node1 || he.node2 != itGroup->node2;
+            });
+            const Edge edge = { int(itGroup->node1) + 1, int(itGroup->node2) + 1 };
+            const auto sideCount = std::distance(itGroup, itGroupEnd);
+            if (sideCount == 1) {
+                shard.vecBoundaryEdge.push_back(edge);
+            }
+            else if (sideCount > 2) {
+                shard.vecNonManifoldEdge.push_back(edge);
+            }
+            else {
+                // Consistently oriented triangles run through their common edge in opposite ways
+                auto fnIsForward = [&](const HalfEdge& he) {
+                    int n[3];
+                    Internal::meshAnalysisTriangle(triangles, vecWeld, he.id / 3, n);
+                    return uint32_t(n[he.id % 3]) == he.node1;
+                };
+                if (fnIsForward(*itGroup) == fnIsForward(*(itGroup + 1)))
+                    shard.vecMisorientedEdge.push_back(edge);
+            }
+
+            // Duplicate triangles share all their edges, they are reported once from the edge
+            // joining their two lowest nodes
+            auto fnThirdNode = [&](const HalfEdge& he) {
+                int n[3];
+                Internal::meshAnalysisTriangle(triangles, vecWeld, he.id / 3, n);
+                return uint32_t(n[(he.id + 2) % 3]);
+            };
+            for (auto itSide = itGroup + 1; itSide < itGroupEnd; ++itSide) {
+                const uint32_t thirdNode = fnThirdNode(*itSide);
+                if (thirdNode <= itSide->node2)
+                    continue;
+
+                for (auto itPrevSide = itGroup; itPrevSide < itSide; ++itPrevSide) {
+                    if (fnThirdNode(*itPrevSide) == thirdNode) {
+                        shard.vecDuplicateTriangle.push_back(int(itSide->id / 3) + 1);
+                        break;
+                    }
+                }
+            }
+
+            itGroup = itGroupEnd;
+        }
+    });
+
+    if (progress)
+        progress->setValue(80);
+
+    if (TaskProgress::isAbortRequested(progress))
+        return {};
+
+    // Connected components, union-find over the nodes
+    {
+        std::vector<int> vecParent(nodeCount);
+        std::vector<char> vecNodeUsed(nodeCount, 0);
+        for (int i = 0; i < nodeCount; ++i)
+            vecParent[i] = i;
+
+        for (int t = 0; t < triangleCount; ++t) {
+            int n[3];
+            Internal::meshAnalysisTriangle(triangles, vecWeld, t, n);
+            const int root = Internal::meshAnalysisFindRoot(vecParent, n[0]);
+            vecNodeUsed[n[0]] = 1;
+            for (int i = 1; i < 3; ++i) {
+                vecParent[Internal::meshAnalysisFindRoot(vecParent, n[i])] = root;
+                vecNodeUsed[n[i]] = 1;
+            }
+        }
+
+        for (int i = 0; i < nodeCount; ++i) {
+            if (vecNodeUsed[i] && vecParent[i] == i)
+                ++result.componentCount;
+        }
+    }
+
+    // Gather lists, in chunk and shard order
+    for (const ChunkData& chunk : vecChunk) {
+        Internal::meshAnalysisAppend(&result.vecDegenerateTriangle, chunk.vecDegenerateTriangle);
+        Internal::meshAnalysisAppend(&result.vecSliverTriangle, chunk.vecSliverTriangle);
+    }
+
+    for (const ShardData& shard : vecShard) {
+        Internal::meshAnalysisAppend(&result.vecBoundaryEdge, shard.vecBoundaryEdge);
+        Internal::meshAnalysisAppend(&result.vecNonManifoldEdge, shard.vecNonManifoldEdge);
+        Internal::meshAnalysisAppend(&result.vecMisorientedEdge, shard.vecMisorientedEdge);
+        Internal::meshAnalysisAppend(&result.vecDuplicateTriangle, shard.vecDuplicateTriangle);
+    }
+
+    auto fnEdgeLess = [](const Edge& lhs, const Edge& rhs) {
+        return lhs.node1 != rhs.node1 ? lhs.node1 < rhs.node1 : lhs.node2 < rhs.node2;
+    };
+    std::sort(result.vecBoundaryEdge.begin(), result.vecBoundaryEdge.end(), fnEdgeLess);
+    std::sort(result.vecNonManifoldEdge.begin(), result.vecNonManifoldEdge.end(), fnEdgeLess);
+    std::sort(result.vecMisorientedEdge.begin(), result.vecMisorientedEdge.end(), fnEdgeLess);
+    std::sort(result.vecDuplicateTriangle.begin(), result.vecDuplicateTriangle.end());
+    counterTriangles.add(triangleCount);
+    if (progress)
+        progress->setValue(100);
+
+    return result;
+}
+
+std::shared_ptr<const MeshAnalysisResult> MeshAnalysisCache::find(
+        const Handle_Poly_Triangulation& mesh)
+{
+    Internal::MeshAnalysisCacheData& data = Internal::meshAnalysisCacheData();
+    std::lock_guard<std::mutex> lock(data.mutex);
+    auto it = data.mapEntry.find(mesh.get());
+    return it != data.mapEntry.cend() ? it->second.result : nullptr;
+}
+
+std::shared_ptr<const MeshAnalysisResult> MeshAnalysisCache::compute(
+        const Handle_Poly_Triangulation& mesh, TaskProgress* progress)
+{
+    std::shared_ptr<const MeshAnalysisResult> result = MeshAnalysisCache::find(mesh);
+    if (result || mesh.IsNull())
+        return result;
+
+    MeshAnalysisResult analysis = MeshAnalysis::analyze(mesh, {}, progress);
+    if (TaskProgress::isAbortRequested(progress))
+        return nullptr;
+
+    result = std::make_shared<MeshAnalysisResult>(std::move(analysis));
+    Internal::MeshAnalysisCacheData& data = Internal::meshAnalysisCacheData();
+    std::lock_guard<std::mutex> lock(data.mutex);
+    auto itInsert = data.mapEntry.insert({ mesh.get(), { mesh, result } });
+    if (!itInsert.second)
+        return itInsert.first->second.result;
+
+    data.queueKey.push_back(mesh.get());
+    while (data.queueKey.size() > Internal::meshAnalysisCacheMaxEntryCount) {
+        data.mapEntry.erase(data.queueKey.front());
+        data.queueKey.pop_front();
+    }
+
+    return result;
+}
+
+void MeshAnalysisCache::clear()
+{
+    Internal::MeshAnalysisCacheData& data = Internal::meshAnalysisCacheData();
+    std::lock_guard<std::mutex> lock(data.mutex);
+    data.mapEntry.clear();
+    data.queueKey.clear();
+}
+
+} // namespace Mayo
@@ -0,0 +1,77 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include <Poly_Triangulation.hxx>
+#include <memory>
+#include <vector>
+
+namespace Mayo {
+
+class TaskProgress;
+
+struct MeshAnalysisParameters {
+    // Quality of a triangle is 4√3*area/(sum of squared edge lengths), 1 for an equilateral one
+    double sliverQualityThreshold = 0.1; // Triangles of lower quality are slivers
+    double degenerateQualityThreshold = 1e-9; // Triangles of lower quality are degenerate
+    // Nodes closer than this distance are the same node(eg split along creases), no welding if <= 0
+    double weldTolerance = 1e-7;
+};
+
+struct MeshAnalysisResult {
+    // Nodes are welded ones : lowest index among the nodes at the same position
+    struct Edge {
+        int node1; // Node index, lowest one
+        int node2; // Node index
+    };
+
+    int triangleCount = 0;
+    int componentCount = 0; // Count of groups of triangles connected by their welded nodes
+
+    // Triangle indices
+    std::vector<int> vecDegenerateTriangle; // Null area or repeated nodes
+    std::vector<int> vecSliverTriangle;
+    std::vector<int> vecDuplicateTriangle; // Same nodes as a triangle of lower index
+
+    std::vector<Edge> vecBoundaryEdge; // Edges of a single triangle
+    std::vector<Edge> vecNonManifoldEdge; // Edges shared by more than two triangles
+    // Edges shared by two triangles running through them in the same direction
+    std::vector<Edge> vecMisorientedEdge;
+
+    bool isClosed() const { return vecBoundaryEdge.empty(); }
+    bool isManifold() const { return vecNonManifoldEdge.empty(); }
+    bool isOrientationConsistent() const { return vecMisorientedEdge.empty(); }
+};
+
+// Quality and topology checks of triangle meshes
+struct MeshAnalysis {
+    // Triangles are processed by chunks in parallel with ThreadBudget::parallelFor(). Their edges
+    // are gathered in an edge map distributed over hash shards, each shard being then sorted and
+    // scanned in parallel. Result doesn't depend on the thread count, lists are sorted by index
+    // Nodes are welded first(hash grid) so that meshes split along creases keep their topology
+    static MeshAnalysisResult analyze(
+            const Handle_Poly_Triangulation& mesh,
+            const MeshAnalysisParameters& params = {},
+            TaskProgress* progress = nullptr);
+};
+
+// Analysis results of meshes computed with default parameters, cached per Poly_Triangulation
+// object. Cache is thread-safe
+class MeshAnalysisCache {
+public:
+    // Returns the cached analysis of 'mesh', if any
+    static std::shared_ptr<const MeshAnalysisResult> find(const Handle_Poly_Triangulation& mesh);
+
+    // Returns the analysis of 'mesh', computing it if not cached
+    // Returns null pointer if the operation was aborted
+    static std::shared_ptr<const MeshAnalysisResult> compute(
+            const Handle_Poly_Triangulation& mesh, TaskProgress* progress = nullptr);
+
+    static void clear();
+};
+
+} // namespace Mayo
@@ -0,0 +1,513 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "mesh_decimation.h"
+
+#include "metrics.h"
+#include "task_progress.h"
+#include "thread_budget.h"
+#include "tracing.h"
+
+#include <gp_XYZ.hxx>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <queue>
+#include <vector>
+
+namespace Mayo {
+
+namespace Internal {
+
+// Weight of the planes constraining boundary edges, relative to the squared edge length
+static const double decimationBoundaryWeight = 100.;
+// Collapses are rejected if the normal of a triangle rotates more than ~80°
+static const double decimationMinNormalCosine = 0.2;
+// Progress is reported and abort checked every N collapse candidates
+static const int decimationProgressStep = 4096;
+
+// Symmetric 4x4 matrix of a quadric error metric, plus the area of the triangle planes it sums
+// Error of a point is the area-weighted sum of its squared distances to the planes
+struct DecimationQuadric {
+    double a2 = 0.;
+    double ab = 0.;
+    double ac = 0.;
+    double ad = 0.;
+    double b2 = 0.;
+    double bc = 0.;
+    double bd = 0.;
+    double c2 = 0.;
+    double cd = 0.;
+    double d2 = 0.;
+    double area = 0.;
+
+    static DecimationQuadric fromPlane(const gp_XYZ& n, double d, double weight) {
+        DecimationQuadric q;
+        q.a2 = weight * n.X() * n.X();
+        q.ab = weight * n.X() * n.Y();
+        q.ac = weight * n.X() * n.Z();
+        q.ad = weight * n.X() * d;
+        q.b2 = weight * n.Y() * n.Y();
+        q.bc = weight * n.Y() * n.Z();
+        q.bd = weight * n.Y() * d;
+        q.c2 = weight * n.Z() * n.Z();
+        q.cd = weight * n.Z() * d;
+        q.d2 = weight * d * d;
+        return q;
+    }
+
+    DecimationQuadric& operator+=(const DecimationQuadric& other) {
+        this->a2 += other.a2;
+        this->ab += other.ab;
+        this->ac += other.ac;
+        this->ad += other.ad;
+        this->b2 += other.b2;
+        this->bc += other.bc;
+        this->bd += other.bd;
+        this->c2 += other.c2;
+        this->cd += other.cd;
+        this->d2 += other.d2;
+        this->area += other.area;
+        return *this;
+    }
+
+    // Mean squared distance of 'p' to the planes
+    double error(const gp_XYZ& p) const {
+        const double x = p.X();
+        const double y = p.Y();
+        const double z = p.Z();
+        const double err =
+                this->a2*x*x + 2*this->ab*x*y + 2*this->ac*x*z + 2*this->ad*x
+                + this->b2*y*y + 2*this->bc*y*z + 2*this->bd*y
+                + this->c2*z*z + 2*this->cd*z
+                + this->d2;
+        return std::max(err, 0.) / (this->area > 0. ? this->area : 1.);
+    }
+
+    // Point minimizing the error, false if the quadric is singular(eg flat or linear region)
+    bool findOptimum(gp_XYZ* p) const {
+        const double i00 = this->b2*this->c2 - this->bc*this->bc;
+        const double i01 = this->ac*this->bc - this->ab*this->c2;
+        const double i02 = this->ab*this->bc - this->ac*this->b2;
+        const double i11 = this->a2*this->c2 - this->ac*this->ac;
+        const double i12 = this->ab*this->ac - this->a2*this->bc;
+        const double i22 = this->a2*this->b2 - this->ab*this->ab;
+        const double det = this->a2*i00 + this->ab*i01 + this->ac*i02;
+        const double trace = this->a2 + this->b2 + this->c2;
+        if (std::abs(det) <= 1e-9 * trace * trace * trace)
+            return false;
+
+        const double k = -1. / det;
+        p->SetX(k * (i00*this->ad + i01*this->bd + i02*this->cd));
+        p->SetY(k * (i01*this->ad + i11*this->bd + i12*this->cd));
+        p->SetZ(k * (i02*this->ad + i12*this->bd + i22*this->cd));
+        return true;
+    }
+};
+
+class QuadricDecimator {
+public:
+    struct Candidate {
+        double cost;
+        int v1;
+        int v2;
+        int version1;
+        int version2;
+    };
+
+    QuadricDecimator(const Handle_Poly_Triangulation& mesh)
+    {
+        const TColgp_Array1OfPnt& nodes = mesh->Nodes();
+        m_vecPos.resize(nodes.Size());
+        for (int i = nodes.Lower(); i <= nodes.Upper(); ++i)
+            m_vecPos.at(i - nodes.Lower()) = nodes.Value(i).XYZ();
+
+        const Poly_Array1OfTriangle& triangles = mesh->Triangles();
+        m_vecTri.reserve(triangles.Size());
+        for (const Poly_Triangle& tri : triangles) {
+            int v1, v2, v3;
+            tri.Get(v1, v2, v3);
+            v1 -= nodes.Lower();
+            v2 -= nodes.Lower();
+            v3 -= nodes.Lower();
+            if (v1 != v2 && v2 != v3 && v3 != v1)
+                m_vecTri.push_back({ v1, v2, v3 });
+        }
+
+        m_vecTriRemoved.resize(m_vecTri.size(), 0);
+        m_liveTriangleCount = int(m_vecTri.size());
+        m_vecVertexVersion.resize(m_vecPos.size(), 0);
+        m_vecVertexTris.resize(m_vecPos.size());
+        for (int t = 0; t < int(m_vecTri.size()); ++t) {
+            for (int v : m_vecTri.at(t))
+                m_vecVertexTris.at(v).push_back(t);
+        }
+    }
+
+    int liveTriangleCount() const { return m_liveTriangleCount; }
+    double maxAppliedError() const { return m_maxAppliedError; }
+
+    void computeQuadrics()
+    {
+        MAYO_TRACE_SCOPE("mesh", "decimationQuadrics");
+        std::vector<gp_XYZ> vecTriNormal(m_vecTri.size());
+        std::vector<DecimationQuadric> vecTriQuadric(m_vecTri.size());
+        ThreadBudget::parallelFor(0, int(m_vecTri.size()), [&](int t) {
+            const std::array<int, 3>& tri = m_vecTri.at(t);
+            const gp_XYZ& p1 = m_vecPos.at(tri[0]);
+            gp_XYZ n = (m_vecPos.at(tri[1]) - p1).Crossed(m_vecPos.at(tri[2]) - p1);
+            const double doubleArea = n.Modulus();
+            if (doubleArea <= 0.)
+                return;
+
+            n /= doubleArea;
+            DecimationQuadric q = DecimationQuadric::fromPlane(n, -n.Dot(p1), 0.5 * doubleArea);
+            q.area = 0.5 * doubleArea;
+            vecTriNormal.at(t) = n;
+            vecTriQuadric.at(t) = q;
+        });
+
+        // Each vertex sums the quadrics of its triangles, boundary edges are seen from both
+        // vertices so each one only constrains its own quadric
+        m_vecQuadric.resize(m_vecPos.size());
+        ThreadBudget::parallelFor(0, int(m_vecPos.size()), [&](int v) {
+            DecimationQuadric& q = m_vecQuadric.at(v);
+            const std::vector<int>& vecTri = m_vecVertexTris.at(v);
+            for (int t : vecTri) {
+                q += vecTriQuadric.at(t);
+                for (int w : m_vecTri.at(t)) {
+                    if (w == v)
+                        continue;
+
+                    const auto fnHasEdge = [&](int s) { return this->triContains(s, w); };
+                    if (std::count_if(vecTri.cbegin(), vecTri.cend(), fnHasEdge) != 1)
+                        continue;
+
+                    const gp_XYZ edge = m_vecPos.at(w) - m_vecPos.at(v);
+                    gp_XYZ n = edge.Crossed(vecTriNormal.at(t));
+                    const double nLength = n.Modulus();
+                    if (nLength <= 0.)
+                        continue;
+
+                    n /= nLength;
+                    const double weight = decimationBoundaryWeight * edge.SquareModulus();
+                    q += DecimationQuadric::fromPlane(n, -n.Dot(m_vecPos.at(v)), weight);
+                }
+            }
+        });
+    }
+
+    std::vector<Candidate> initialCandidates()
+    {
+        MAYO_TRACE_SCOPE("mesh", "decimationCandidates");
+        std::vector<Candidate> vecCandidate;
+        vecCandidate.reserve(m_vecTri.size() * 3 / 2);
+        std::vector<int> vecNeighbor;
+        for (int v = 0; v < int(m_vecPos.size()); ++v) {
+            this->neighbors(v, &vecNeighbor);
+            for (int w : vecNeighbor) {
+                if (w > v)
+                    vecCandidate.push_back({ 0., v, w, 0, 0 });
+            }
+        }
+
+        ThreadBudget::parallelFor(0, int(vecCandidate.size()), [&](int i) {
+            Candidate& candidate = vecCandidate.at(i);
+            candidate.cost = this->collapseError(candidate.v1, candidate.v2, nullptr);
+        });
+
+        return vecCandidate;
+    }
+
+    bool run(int targetTriangleCount, double maxError, TaskProgress* progress)
+    {
+        MAYO_TRACE_SCOPE("mesh", "decimationCollapses");
+        const auto fnGreaterCost = [](const Candidate& lhs, const Candidate& rhs) {
+            return lhs.cost > rhs.cost;
+        };
+        std::priority_queue<Candidate, std::vector<Candidate>, decltype(fnGreaterCost)>
+                queueCandidate(fnGreaterCost, this->initialCandidates());
+
+        const int initialTriangleCount = m_liveTriangleCount;
+        int iteration = 0;
+        std::vector<int> vecNeighbor;
+        while (!queueCandidate.empty() && m_liveTriangleCount > targetTriangleCount) {
+            if (++iteration % decimationProgressStep == 0) {
+                if (TaskProgress::isAbortRequested(progress))
+                    return false;
+
+                if (progress && targetTriangleCount > 0) {
+                    const int64_t removed = initialTriangleCount - m_liveTriangleCount;
+                    const int64_t toRemove = initialTriangleCount - targetTriangleCount;
+                    progress->setValue(int((removed * 100) / std::max(toRemove, int64_t(1))));
+                }
+            }
+
+            const Candidate candidate = queueCandidate.top();
+            if (candidate.cost > maxError * maxError)
+                break; // Next candidates are even more costly
+
+            queueCandidate.pop();
+            if (m_vecVertexVersion.at(candidate.v1) != candidate.version1
+                    || m_vecVertexVersion.at(candidate.v2) != candidate.version2)
+            {
+                continue; // Outdated
+            }
+
+            gp_XYZ pos;
+            this->collapseError(candidate.v1, candidate.v2, &pos);
+            if (!this->collapse(candidate.v1, candidate.v2, pos))
+                continue;
+
+            m_maxAppliedError = std::max(candidate.cost, m_maxAppliedError);
+            const int v = candidate.v1;
+            this->neighbors(v, &vecNeighbor);
+            for (int w : vecNeighbor) {
+                const double cost = this->collapseError(v, w, nullptr);
+                queueCandidate.push(
+                            { cost, v, w, m_vecVertexVersion.at(v), m_vecVertexVersion.at(w) });
+            }
+        }
+
+        return true;
+    }
+
+    Handle_Poly_Triangulation result() const
+    {
+        std::vector<int> vecNewIndex(m_vecPos.size(), 0);
+        for (size_t t = 0; t < m_vecTri.size(); ++t) {
+            if (!m_vecTriRemoved.at(t)) {
+                for (int v : m_vecTri.at(t))
+                    vecNewIndex.at(v) = 1;
+            }
+        }
+
+        int nodeCount = 0;
+        for (int& index : vecNewIndex) {
+            if (index != 0)
+                index = ++nodeCount;
+        }
+
+        Handle_Poly_Triangulation mesh =
+                new Poly_Triangulation(nodeCount, m_liveTriangleCount, false);
+        TColgp_Array1OfPnt& nodes = mesh->ChangeNodes();
+        for (size_t v = 0; v < m_vecPos.size(); ++v) {
+            if (vecNewIndex.at(v) != 0)
+                nodes.ChangeValue(vecNewIndex.at(v)) = gp_Pnt(m_vecPos.at(v));
+        }
+
+        Poly_Array1OfTriangle& triangles = mesh->ChangeTriangles();
+        int triIndex = 0;
+        for (size_t t = 0; t < m_vecTri.size(); ++t) {
+            if (!m_vecTriRemoved.at(t)) {
+                const std::array<int, 3>& tri = m_vecTri.at(t);
+                triangles.ChangeValue(++triIndex) = Poly_Triangle(
+                            vecNewIndex.at(tri[0]), vecNewIndex.at(tri[1]), vecNewIndex.at(tri[2]));
+            }
+        }
+
+        return mesh;
+    }
+
+private:
+    bool triContains(int t, int v) const
+    {
+        const std::array<int, 3>& tri = m_vecTri.at(t);
+        return tri[0] == v || tri[1] == v || tri[2] == v;
+    }
+
+    // Sorted unique vertices sharing a live triangle with 'v'
+    void neighbors(int v, std::vector<int>* vecNeighbor) const
+    {
+        vecNeighbor->clear();
+        for (int t : m_vecVertexTris.at(v)) {
+            for (int w : m_vecTri.at(t)) {
+                if (w != v)
+                    vecNeighbor->push_back(w);
+            }
+        }
+
+        std::sort(vecNeighbor->begin(), vecNeighbor->end());
+        auto itUniqueEnd = std::unique(vecNeighbor->begin(), vecNeighbor->end());
+        vecNeighbor->erase(itUniqueEnd, vecNeighbor->end());
+    }
+
+    // Error of the collapse of edge(v1, v2) into the best of the optimal point, the end points
+    // and the midpoint
+    double collapseError(int v1, int v2, gp_XYZ* ptrPos) const
+    {
+        DecimationQuadric q = m_vecQuadric.at(v1);
+        q += m_vecQuadric.at(v2);
+        const gp_XYZ& p1 = m_vecPos.at(v1);
+        const gp_XYZ& p2 = m_vecPos.at(v2);
+        const gp_XYZ pMid = 0.5 * (p1 + p2);
+        gp_XYZ bestPos = pMid;
+        double bestError = q.error(pMid);
+        auto fnTry = [&](const gp_XYZ& p) {
+            const double err = q.error(p);
+            if (err < bestError) {
+                bestError = err;
+                bestPos = p;
+            }
+        };
+        fnTry(p1);
+        fnTry(p2);
+        gp_XYZ pOpt;
+        // Optimum far away from the edge is a sign of ill-conditioning
+        if (q.findOptimum(&pOpt) && (pOpt - pMid).SquareModulus() <= (p2 - p1).SquareModulus())
+            fnTry(pOpt);
+
+        if (ptrPos)
+            *ptrPos = bestPos;
+
+        return bestError;
+    }
+
+    bool collapse(int v1, int v2, const gp_XYZ& pos)
+    {
+        // Link condition : common neighbors must be exactly the apexes of the shared triangles,
+        // otherwise the collapse creates a non-manifold edge
+        std::vector<int> vecNeighbor1;
+        std::vector<int> vecNeighbor2;
+        this->neighbors(v1, &vecNeighbor1);
+        this->neighbors(v2, &vecNeighbor2);
+        std::vector<int> vecCommon;
+        std::set_intersection(
+                    vecNeighbor1.cbegin(), vecNeighbor1.cend(),
+                    vecNeighbor2.cbegin(), vecNeighbor2.cend(),
+                    std::back_inserter(vecCommon));
+        const std::vector<int>& vecTri2 = m_vecVertexTris.at(v2);
+        const auto fnHasV1 = [=](int t) { return this->triContains(t, v1); };
+        const auto sharedCount = std::count_if(vecTri2.cbegin(), vecTri2.cend(), fnHasV1);
+        if (sharedCount == 0 || int(vecCommon.size()) != sharedCount)
+            return false;
+
+        // Reject flipped triangles
+        auto fnFlips = [=](int v) {
+            for (int t : m_vecVertexTris.at(v)) {
+                if (this->triContains(t, v1) && this->triContains(t, v2))
+                    continue; // Removed by the collapse
+
+                const std::array<int, 3>& tri = m_vecTri.at(t);
+                std::array<gp_XYZ, 3> pnts = {
+                    m_vecPos.at(tri[0]), m_vecPos.at(tri[1]), m_vecPos.at(tri[2])
+                };
+                const gp_XYZ nBefore = (pnts[1] - pnts[0]).Crossed(pnts[2] - pnts[0]);
+                for (int i = 0; i < 3; ++i) {
+                    if (tri[i] == v)
+                        pnts[i] = pos;
+                }
+
+                const gp_XYZ nAfter = (pnts[1] - pnts[0]).Crossed(pnts[2] - pnts[0]);
+                const double lengthProduct = nBefore.Modulus() * nAfter.Modulus();
+                if (lengthProduct <= 0.)
+                    return nBefore.SquareModulus() > 0.;
+
+                if (nBefore.Dot(nAfter) < decimationMinNormalCosine * lengthProduct)
+                    return true;
+            }
+
+            return false;
+        };
+        if (fnFlips(v1) || fnFlips(v2))
+            return false;
+
+        // Merge v2 into v1
+        m_vecPos.at(v1) = pos;
+        m_vecQuadric.at(v1) += m_vecQuadric.at(v2);
+        std::vector<int>& vecTri1 = m_vecVertexTris.at(v1);
+        for (int t : vecTri2) {
+            if (this->triContains(t, v1)) {
+                m_vecTriRemoved.at(t) = 1;
+                --m_liveTriangleCount;
+                // Detach from the apex
+                for (int w : m_vecTri.at(t)) {
+                    if (w != v1 && w != v2) {
+                        std::vector<int>& vecTriW = m_vecVertexTris.at(w);
+                        auto itRemoveBegin = std::remove(vecTriW.begin(), vecTriW.end(), t);
+                        vecTriW.erase(itRemoveBegin, vecTriW.end());
+                    }
+                }
+            }
+            else {
+                std::replace(m_vecTri.at(t).begin(), m_vecTri.at(t).end(), v2, v1);
+                vecTri1.push_back(t);
+            }
+        }
+
+        const auto fnIsRemoved = [=](int t) { return m_vecTriRemoved.at(t) != 0; };
+        vecTri1.erase(std::remove_if(vecTri1.begin(), vecTri1.end(), fnIsRemoved), vecTri1.end());
+        m_vecVertexTris.at(v2).clear();
+        m_vecVertexTris.at(v2).shrink_to_fit();
+        m_vecVertexVersion.at(v2) = -1;
+        ++m_vecVertexVersion.at(v1);
+        return true;
+    }
+
+    std::vector<gp_XYZ> m_vecPos;
+    std::vector<DecimationQuadric> m_vecQuadric;
+    std::vector<std::array<int, 3>> m_vecTri;
+    std::vector<char> m_vecTriRemoved;
+    std::vector<std::vector<int>> m_vecVertexTris;
+    std::vector<int> m_vecVertexVersion; // -1 once the vertex is collapsed
+    int m_liveTriangleCount = 0;
+    double m_maxAppliedError = 0.;
+};
+
+} // namespace Internal
+
+int MeshDecimation::targetTriangleCount(const MeshDecimationParameters& params, int triangleCount)
+{
+    switch (params.targetMode) {
+    case MeshDecimationParameters::TargetMode::TriangleCount:
+        return std::max(0, std::min(params.targetTriangleCount, triangleCount));
+    case MeshDecimationParameters::TargetMode::Ratio:
+        return int(triangleCount * std::max(0., std::min(params.targetRatio, 1.)));
+    case MeshDecimationParameters::TargetMode::MaxError:
+        return 0;
+    }
+
+    return triangleCount;
+}
+
+Handle_Poly_Triangulation MeshDecimation::decimate(
+        const Handle_Poly_Triangulation& mesh,
+        const MeshDecimationParameters& params,
+        TaskProgress* progress)
+{
+    if (mesh.IsNull())
+        return {};
+
+    MAYO_TRACE_SCOPE("mesh", "decimate");
+    const int targetCount = MeshDecimation::targetTriangleCount(params, mesh->NbTriangles());
+    const double maxError =
+            params.targetMode == MeshDecimationParameters::TargetMode::MaxError ?
+                params.maxError :
+                std::numeric_limits<double>::max();
+
+    Internal::QuadricDecimator decimator(mesh);
+    decimator.computeQuadrics();
+    if (TaskProgress::isAbortRequested(progress))
+        return {};
+
+    if (!decimator.run(targetCount, maxError, progress))
+        return {};
+
+    Handle_Poly_Triangulation result = decimator.result();
+    result->Deflection(std::max(mesh->Deflection(), std::sqrt(decimator.maxAppliedError())));
+    static Metrics::Counter& counterDecimated = Metrics::counter("mesh.trianglesDecimated");
+    counterDecimated.add(mesh->NbTriangles() - result->NbTriangles());
+    if (progress)
+        progress->setValue(100);
+
+    return result;
+}
+
+} // namespace Mayo
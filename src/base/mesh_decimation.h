@@ -0,0 +1,46 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include <Poly_Triangulation.hxx>
+
+namespace Mayo {
+
+class TaskProgress;
+
+struct MeshDecimationParameters {
+    enum class TargetMode {
+        TriangleCount, // Stop once the mesh has 'targetTriangleCount' triangles
+        Ratio,         // Stop once the mesh has 'targetRatio' of its initial triangle count
+        MaxError       // Stop before the geometric error exceeds 'maxError'
+    };
+
+    TargetMode targetMode = TargetMode::Ratio;
+    int targetTriangleCount = 10000;
+    double targetRatio = 0.5;
+    double maxError = 0.1; // Length in mm
+};
+
+// Simplification of triangle meshes by iterative edge collapse, driven by quadric error
+// metrics(Garland-Heckbert). Mesh boundaries are preserved with penalty quadrics and collapses
+// that would flip a triangle or create a non-manifold edge are rejected
+struct MeshDecimation {
+    // Returns the count of triangles the decimation of a mesh with 'triangleCount' triangles will
+    // aim at. It's zero for TargetMode::MaxError, where only the error criterion applies
+    static int targetTriangleCount(const MeshDecimationParameters& params, int triangleCount);
+
+    // Returns a new triangulation, simplification of 'mesh'. Quadrics and initial collapse costs
+    // are computed in parallel with ThreadBudget::parallelFor(), collapses are then applied
+    // sequentially by increasing cost. UV nodes and normals of 'mesh' are not carried over
+    // Returns a null handle if 'mesh' is null or the operation was aborted
+    static Handle_Poly_Triangulation decimate(
+            const Handle_Poly_Triangulation& mesh,
+            const MeshDecimationParameters& params,
+            TaskProgress* progress = nullptr);
+};
+
+} // namespace Mayo
@@ -0,0 +1,241 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "mesh_normals.h"
+
+#include "metrics.h"
+#include "task_progress.h"
+#include "thread_budget.h"
+#include "tracing.h"
+
+#include <Standard_GUID.hxx>
+#include <TDataStd_Real.hxx>
+#include <TShort_HArray1OfShortReal.hxx>
+#include <gp_XYZ.hxx>
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+namespace Mayo {
+
+namespace Internal {
+
+static const Standard_GUID& meshNormalsCreaseAngleGuid()
+{
+    static const Standard_GUID guid("8d3e5b1a-2c4f-4e6d-a1b7-93f0c2d4e815");
+    return guid;
+}
+
+static int meshNormalsFindRoot(std::vector<int>& vecParent, int corner)
+{
+    while (vecParent[corner] != corner) {
+        vecParent[corner] = vecParent[vecParent[corner]]; // Path halving
+        corner = vecParent[corner];
+    }
+
+    return corner;
+}
+
+} // namespace Internal
+
+Handle_Poly_Triangulation MeshNormals::computeSmooth(
+        const Handle_Poly_Triangulation& mesh, double creaseAngle, TaskProgress* progress)
+{
+    if (mesh.IsNull())
+        return {};
+
+    MAYO_TRACE_SCOPE("mesh", "computeSmoothNormals");
+    static Metrics::Counter& counterNodes = Metrics::counter("mesh.nodesSplitAtCreases");
+    const int nodeCount = mesh->NbNodes();
+    const int triangleCount = mesh->NbTriangles();
+    const TColgp_Array1OfPnt& nodes = mesh->Nodes();
+    const Poly_Array1OfTriangle& triangles = mesh->Triangles();
+    const double cosCrease = std::cos(creaseAngle);
+
+    // Normals of the triangles, magnitude is twice the triangle area
+    std::vector<gp_XYZ> vecTriNormal(triangleCount);
+    std::vector<double> vecTriNormalLength(triangleCount);
+    ThreadBudget::parallelFor(0, triangleCount, [&](int t) {
+        int n1, n2, n3;
+        triangles.Value(t + 1).Get(n1, n2, n3);
+        const gp_XYZ& p1 = nodes.Value(n1).XYZ();
+        const gp_XYZ& p2 = nodes.Value(n2).XYZ();
+        const gp_XYZ& p3 = nodes.Value(n3).XYZ();
+        vecTriNormal[t] = (p2 - p1).Crossed(p3 - p1);
+        vecTriNormalLength[t] = vecTriNormal[t].Modulus();
+    });
+
+    // Triangle corners around each node, stored as compressed rows
+    // Corner 'c' is the vertex 'c % 3' of triangle 'c / 3'
+    std::vector<int> vecCornerNode(3 * size_t(triangleCount));
+    std::vector<int> vecNodeCornerStart(nodeCount + 1, 0);
+    for (int t = 0; t < triangleCount; ++t) {
+        int n[3];
+        triangles.Value(t + 1).Get(n[0], n[1], n[2]);
+        for (int c = 0; c < 3; ++c) {
+            vecCornerNode[3 * t + c] = n[c] - 1;
+            ++vecNodeCornerStart[n[c]];
+        }
+    }
+
+    for (int v = 0; v < nodeCount; ++v)
+        vecNodeCornerStart[v + 1] += vecNodeCornerStart[v];
+
+    std::vector<int> vecNodeCorner(vecCornerNode.size());
+    {
+        std::vector<int> vecNodeCursor(vecNodeCornerStart.cbegin(), vecNodeCornerStart.cend() - 1);
+        for (size_t c = 0; c < vecCornerNode.size(); ++c)
+            vecNodeCorner[vecNodeCursor[vecCornerNode[c]]++] = int(c);
+    }
+
+    if (progress)
+        progress->setValue(30);
+
+    if (TaskProgress::isAbortRequested(progress))
+        return {};
+
+    // Group the corners of each node : triangles sharing a side through the node are joined when
+    // their normals deviate less than the crease angle. Sides are sorted by their other node so
+    // joining is O(k log k) for a node of valence k
+    // Normals of the groups of node 'v' are stored from index vecNodeCornerStart[v]
+    std::vector<int> vecCornerGroup(vecCornerNode.size(), -1);
+    std::vector<int> vecCornerParent(vecCornerNode.size()); // Union-find, within a node
+    std::vector<std::pair<int, int>> vecSide(2 * vecCornerNode.size()); // {other node, corner}
+    std::vector<gp_XYZ> vecGroupNormal(vecCornerNode.size());
+    std::vector<int> vecNodeGroupStart(nodeCount + 1, 0);
+    auto fnIsSmoothSide = [&](int tri1, int tri2) {
+        const double minDot = cosCrease * vecTriNormalLength[tri1] * vecTriNormalLength[tri2];
+        return vecTriNormal[tri1].Dot(vecTriNormal[tri2]) >= minDot;
+    };
+    ThreadBudget::parallelFor(0, nodeCount, [&](int v) {
+        const int begin = vecNodeCornerStart[v];
+        const int end = vecNodeCornerStart[v + 1];
+        std::pair<int, int>* sides = &vecSide[2 * size_t(begin)];
+        for (int i = begin; i < end; ++i) {
+            const int corner = vecNodeCorner[i];
+            const int triCorner = corner - corner % 3;
+            sides[2 * (i - begin)] = { vecCornerNode[triCorner + (corner + 1) % 3], corner };
+            sides[2 * (i - begin) + 1] = { vecCornerNode[triCorner + (corner + 2) % 3], corner };
+            vecCornerParent[corner] = corner;
+        }
+
+        const int sideCount = 2 * (end - begin);
+        std::sort(sides, sides + sideCount);
+        for (int i = 0; i < sideCount; ) {
+            int iEnd = i + 1;
+            while (iEnd < sideCount && sides[iEnd].first == sides[i].first)
+                ++iEnd;
+
+            // More than two sides only on non-manifold edges
+            for (int j = i; j < iEnd; ++j) {
+                for (int k = j + 1; k < iEnd; ++k) {
+                    const int corner1 = sides[j].second;
+                    const int corner2 = sides[k].second;
+                    if (fnIsSmoothSide(corner1 / 3, corner2 / 3)) {
+                        const int root1 = Internal::meshNormalsFindRoot(vecCornerParent, corner1);
+                        const int root2 = Internal::meshNormalsFindRoot(vecCornerParent, corner2);
+                        vecCornerParent[root2] = root1;
+                    }
+                }
+            }
+
+            i = iEnd;
+        }
+
+        // Groups are numbered in corner order, normal is the sum of the grouped triangles ones
+        int groupCount = 0;
+        for (int i = begin; i < end; ++i) {
+            const int corner = vecNodeCorner[i];
+            const int root = Internal::meshNormalsFindRoot(vecCornerParent, corner);
+            if (vecCornerGroup[root] < 0) {
+                vecCornerGroup[root] = groupCount;
+                ++groupCount;
+            }
+
+            const int group = vecCornerGroup[root];
+            vecGroupNormal[begin + group] += vecTriNormal[corner / 3];
+            vecCornerGroup[corner] = group;
+        }
+
+        // Isolated node is kept, without normal
+        vecNodeGroupStart[v + 1] = std::max(groupCount, 1);
+    });
+
+    for (int v = 0; v < nodeCount; ++v)
+        vecNodeGroupStart[v + 1] += vecNodeGroupStart[v];
+
+    if (progress)
+        progress->setValue(70);
+
+    if (TaskProgress::isAbortRequested(progress))
+        return {};
+
+    const int newNodeCount = vecNodeGroupStart[nodeCount];
+    const bool hasUvNodes = mesh->HasUVNodes();
+    Handle_Poly_Triangulation meshSmooth =
+            new Poly_Triangulation(newNodeCount, triangleCount, hasUvNodes);
+    meshSmooth->Deflection(mesh->Deflection());
+    Handle_TShort_HArray1OfShortReal normals = new TShort_HArray1OfShortReal(1, 3 * newNodeCount);
+    TColgp_Array1OfPnt& newNodes = meshSmooth->ChangeNodes();
+    TShort_Array1OfShortReal& newNormals = normals->ChangeArray1();
+    ThreadBudget::parallelFor(0, nodeCount, [&](int v) {
+        const int groupCount = vecNodeGroupStart[v + 1] - vecNodeGroupStart[v];
+        for (int group = 0; group < groupCount; ++group) {
+            const int newNode = vecNodeGroupStart[v] + group + 1;
+            newNodes.ChangeValue(newNode) = nodes.Value(v + 1);
+            if (hasUvNodes)
+                meshSmooth->ChangeUVNodes().ChangeValue(newNode) = mesh->UVNodes().Value(v + 1);
+
+            gp_XYZ normal;
+            if (vecNodeCornerStart[v] < vecNodeCornerStart[v + 1])
+                normal = vecGroupNormal[vecNodeCornerStart[v] + group];
+
+            const double normalLength = normal.Modulus();
+            if (normalLength > 0.)
+                normal /= normalLength;
+
+            newNormals.ChangeValue(3 * newNode - 2) = static_cast<Standard_ShortReal>(normal.X());
+            newNormals.ChangeValue(3 * newNode - 1) = static_cast<Standard_ShortReal>(normal.Y());
+            newNormals.ChangeValue(3 * newNode) = static_cast<Standard_ShortReal>(normal.Z());
+        }
+    });
+
+    Poly_Array1OfTriangle& newTriangles = meshSmooth->ChangeTriangles();
+    ThreadBudget::parallelFor(0, triangleCount, [&](int t) {
+        int n[3];
+        for (int c = 0; c < 3; ++c) {
+            const int corner = 3 * t + c;
+            n[c] = vecNodeGroupStart[vecCornerNode[corner]] + vecCornerGroup[corner] + 1;
+        }
+
+        newTriangles.ChangeValue(t + 1) = Poly_Triangle(n[0], n[1], n[2]);
+    });
+
+    meshSmooth->SetNormals(normals);
+    counterNodes.add(newNodeCount - nodeCount);
+    if (progress)
+        progress->setValue(100);
+
+    return meshSmooth;
+}
+
+void MeshNormals::setLabelCreaseAngle(const TDF_Label& label, double creaseAngle)
+{
+    TDataStd_Real::Set(label, Internal::meshNormalsCreaseAngleGuid(), creaseAngle);
+}
+
+double MeshNormals::labelCreaseAngle(const TDF_Label& label)
+{
+    Handle_TDataStd_Real attrCreaseAngle;
+    if (label.FindAttribute(Internal::meshNormalsCreaseAngleGuid(), attrCreaseAngle))
+        return attrCreaseAngle->Get();
+
+    return -1.;
+}
+
+} // namespace Mayo
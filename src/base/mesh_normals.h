@@ -0,0 +1,39 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include <Poly_Triangulation.hxx>
+#include <TDF_Label.hxx>
+
+namespace Mayo {
+
+class TaskProgress;
+
+// Generation of smooth normals at the nodes of triangle meshes
+struct MeshNormals {
+    // Default angle above which an edge is kept sharp, in radians(60°)
+    static constexpr double DefaultCreaseAngle = 1.0471975511965976;
+
+    // Returns a new triangulation, copy of 'mesh' with normals at nodes
+    // Triangles around a node are grouped across their common sides where normals deviate less
+    // than 'creaseAngle', a group gets the area-weighted average of its triangle normals. Nodes
+    // with several groups are duplicated so creases keep flat shading, 'mesh' must be welded
+    // Triangle normals and node normals are computed in parallel with ThreadBudget::parallelFor()
+    // Returns a null handle if 'mesh' is null or the operation was aborted
+    static Handle_Poly_Triangulation computeSmooth(
+            const Handle_Poly_Triangulation& mesh,
+            double creaseAngle = DefaultCreaseAngle,
+            TaskProgress* progress = nullptr);
+
+    // Crease angle of the normals to display for the mesh stored at 'label'
+    // Document keeps the welded mesh, split copy from computeSmooth() is for display only
+    static void setLabelCreaseAngle(const TDF_Label& label, double creaseAngle);
+    // Returns a negative value if 'label' has no crease angle
+    static double labelCreaseAngle(const TDF_Label& label);
+};
+
+} // namespace Mayo
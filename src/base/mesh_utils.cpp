@@ -5,11 +5,56 @@
 ****************************************************************************/
 
 #include "mesh_utils.h"
+#include "thread_budget.h"
+#include "tracing.h"
+
 #include <QtCore/QtGlobal>
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <vector>
 
 namespace Mayo {
 
+namespace Internal {
+
+// Count of triangles(and nodes) processed by a task of MeshUtils::triangulationProperties()
+// Fixed so partial sums, and then rounding errors, don't depend on the thread count
+static const int meshPropertiesChunkSize = 64 * 1024;
+
+struct MeshPropertiesSums {
+    double area = 0.;
+    double volume = 0.;
+    gp_XYZ surfaceMoment;
+    gp_XYZ moment;
+    double mxx = 0.;
+    double myy = 0.;
+    double mzz = 0.;
+    double mxy = 0.;
+    double mxz = 0.;
+    double myz = 0.;
+    Bnd_Box bndBox;
+
+    MeshPropertiesSums& operator+=(const MeshPropertiesSums& other) {
+        this->area += other.area;
+        this->volume += other.volume;
+        this->surfaceMoment += other.surfaceMoment;
+        this->moment += other.moment;
+        this->mxx += other.mxx;
+        this->myy += other.myy;
+        this->mzz += other.mzz;
+        this->mxy += other.mxy;
+        this->mxz += other.mxz;
+        this->myz += other.myz;
+        this->bndBox.Add(other.bndBox);
+        return *this;
+    }
+};
+
+} // namespace Internal
+
 double MeshUtils::triangleSignedVolume(const gp_XYZ& p1, const gp_XYZ& p2, const gp_XYZ& p3)
 {
     return p1.Dot(p2.Crossed(p3)) / 6.0f;
@@ -31,39 +76,245 @@ double MeshUtils::triangleArea(const gp_XYZ& p1, const gp_XYZ& p2, const gp_XYZ&
 
 double MeshUtils::triangulationVolume(const Handle_Poly_Triangulation& triangulation)
 {
-    double volume = 0;
-    const TColgp_Array1OfPnt& vecNode = triangulation->Nodes();
-    // TODO Parallelize computation
-    for (const Poly_Triangle& tri : triangulation->Triangles()) {
-        int v1, v2, v3;
-        tri.Get(v1, v2, v3);
-        volume += MeshUtils::triangleSignedVolume(
-                    vecNode.Value(v1).Coord(),
-                    vecNode.Value(v2).Coord(),
-                    vecNode.Value(v3).Coord());
-    }
-
-    return std::abs(volume);
+    return std::abs(MeshUtils::triangulationProperties(triangulation).signedVolume);
 }
 
 double MeshUtils::triangulationArea(const Handle_Poly_Triangulation& triangulation)
 {
-    double area = 0;
+    return MeshUtils::triangulationProperties(triangulation).area;
+}
+
+MeshUtils::TriangulationProperties MeshUtils::triangulationProperties(
+        const Handle_Poly_Triangulation& triangulation)
+{
+    TriangulationProperties props;
+    if (triangulation.IsNull() || triangulation->NbNodes() == 0)
+        return props;
+
+    MAYO_TRACE_SCOPE("mesh", "triangulationProperties");
     const TColgp_Array1OfPnt& vecNode = triangulation->Nodes();
-    // TODO Parallelize computation
-    for (const Poly_Triangle& tri : triangulation->Triangles()) {
-        int v1, v2, v3;
-        tri.Get(v1, v2, v3);
-        area += MeshUtils::triangleArea(
-                    vecNode.Value(v1).Coord(),
-                    vecNode.Value(v2).Coord(),
-                    vecNode.Value(v3).Coord());
+    const Poly_Array1OfTriangle& vecTriangle = triangulation->Triangles();
+    // Coordinates are made relative to a node of the mesh to limit cancellation errors
+    const gp_XYZ origin = vecNode.First().XYZ();
+    const int triangleCount = vecTriangle.Size();
+    const int nodeCount = vecNode.Size();
+    const int chunkSize = Internal::meshPropertiesChunkSize;
+    const int chunkCount = (std::max(triangleCount, nodeCount) + chunkSize - 1) / chunkSize;
+    std::vector<Internal::MeshPropertiesSums> vecChunkSums(chunkCount);
+    ThreadBudget::parallelFor(0, chunkCount, [&](int iChunk) {
+        // Plain scalar accumulators, this loop is a candidate to compiler auto-vectorization
+        double area = 0.;
+        double volume = 0.;
+        double surfMx = 0., surfMy = 0., surfMz = 0.;
+        double mx = 0., my = 0., mz = 0.;
+        double mxx = 0., myy = 0., mzz = 0., mxy = 0., mxz = 0., myz = 0.;
+        const int triBegin = iChunk * chunkSize;
+        const int triEnd = std::min(triBegin + chunkSize, triangleCount);
+        for (int i = triBegin; i < triEnd; ++i) {
+            int n1, n2, n3;
+            vecTriangle.Value(vecTriangle.Lower() + i).Get(n1, n2, n3);
+            const gp_XYZ& c1 = vecNode.Value(n1).XYZ();
+            const gp_XYZ& c2 = vecNode.Value(n2).XYZ();
+            const gp_XYZ& c3 = vecNode.Value(n3).XYZ();
+            const double ax = c1.X() - origin.X();
+            const double ay = c1.Y() - origin.Y();
+            const double az = c1.Z() - origin.Z();
+            const double bx = c2.X() - origin.X();
+            const double by = c2.Y() - origin.Y();
+            const double bz = c2.Z() - origin.Z();
+            const double cx = c3.X() - origin.X();
+            const double cy = c3.Y() - origin.Y();
+            const double cz = c3.Z() - origin.Z();
+
+            // Triangle area
+            const double ux = bx - ax, uy = by - ay, uz = bz - az;
+            const double vx = cx - ax, vy = cy - ay, vz = cz - az;
+            const double nx = uy*vz - uz*vy;
+            const double ny = uz*vx - ux*vz;
+            const double nz = ux*vy - uy*vx;
+            const double triArea = 0.5 * std::sqrt(nx*nx + ny*ny + nz*nz);
+            const double sx = ax + bx + cx;
+            const double sy = ay + by + cy;
+            const double sz = az + bz + cz;
+            area += triArea;
+            surfMx += triArea * sx;
+            surfMy += triArea * sy;
+            surfMz += triArea * sz;
+
+            // Signed tetrahedron(origin, a, b, c) : volume, first and second moments
+            const double tetVolume =
+                    (ax*(by*cz - bz*cy) + ay*(bz*cx - bx*cz) + az*(bx*cy - by*cx)) / 6.;
+            volume += tetVolume;
+            mx += tetVolume * sx;
+            my += tetVolume * sy;
+            mz += tetVolume * sz;
+            mxx += tetVolume * (ax*ax + bx*bx + cx*cx + sx*sx);
+            myy += tetVolume * (ay*ay + by*by + cy*cy + sy*sy);
+            mzz += tetVolume * (az*az + bz*bz + cz*cz + sz*sz);
+            mxy += tetVolume * (ax*ay + bx*by + cx*cy + sx*sy);
+            mxz += tetVolume * (ax*az + bx*bz + cx*cz + sx*sz);
+            myz += tetVolume * (ay*az + by*bz + cy*cz + sy*sz);
+        }
+
+        Internal::MeshPropertiesSums& sums = vecChunkSums.at(iChunk);
+        sums.area = area;
+        sums.volume = volume;
+        sums.surfaceMoment = gp_XYZ(surfMx, surfMy, surfMz) / 3.;
+        sums.moment = gp_XYZ(mx, my, mz) / 4.;
+        sums.mxx = mxx / 20.;
+        sums.myy = myy / 20.;
+        sums.mzz = mzz / 20.;
+        sums.mxy = mxy / 20.;
+        sums.mxz = mxz / 20.;
+        sums.myz = myz / 20.;
+
+        const int nodeBegin = iChunk * chunkSize;
+        const int nodeEnd = std::min(nodeBegin + chunkSize, nodeCount);
+        for (int i = nodeBegin; i < nodeEnd; ++i)
+            sums.bndBox.Add(vecNode.Value(vecNode.Lower() + i));
+    });
+
+    // Reduce in chunk order, so the result is deterministic
+    Internal::MeshPropertiesSums total;
+    for (const Internal::MeshPropertiesSums& sums : vecChunkSums)
+        total += sums;
+
+    props.area = total.area;
+    props.signedVolume = total.volume;
+    props.bndBox = total.bndBox;
+    if (std::abs(total.volume) > std::numeric_limits<double>::min()) {
+        const gp_XYZ c = total.moment / total.volume;
+        // Parallel axis theorem, signs cancel out with inward-oriented triangles
+        const double vol = total.volume;
+        const double ixx = (total.myy + total.mzz) / vol - (c.Y()*c.Y() + c.Z()*c.Z());
+        const double iyy = (total.mxx + total.mzz) / vol - (c.X()*c.X() + c.Z()*c.Z());
+        const double izz = (total.mxx + total.myy) / vol - (c.X()*c.X() + c.Y()*c.Y());
+        const double ixy = -(total.mxy / vol - c.X()*c.Y());
+        const double ixz = -(total.mxz / vol - c.X()*c.Z());
+        const double iyz = -(total.myz / vol - c.Y()*c.Z());
+        const double mass = std::abs(vol);
+        props.centroid = gp_Pnt(origin + c);
+        props.inertia.SetRows(
+                    mass * gp_XYZ(ixx, ixy, ixz),
+                    mass * gp_XYZ(ixy, iyy, iyz),
+                    mass * gp_XYZ(ixz, iyz, izz));
+    }
+    else if (total.area > 0.) {
+        props.centroid = gp_Pnt(origin + total.surfaceMoment / total.area);
     }
 
-    return area;
+    return props;
 }
 
 // Adapted from http://cs.smith.edu/~jorourke/Code/polyorient.C
+std::vector<int> MeshUtils::weldNodeMap(const TColgp_Array1OfPnt& nodes, double tolerance)
+{
+    const int nodeCount = nodes.Length();
+    std::vector<int> vecWeld(nodeCount);
+    for (int i = 0; i < nodeCount; ++i)
+        vecWeld[i] = i;
+
+    if (tolerance <= 0.)
+        return vecWeld;
+
+    // Hash grid of the kept nodes. Cells are twice the tolerance so near nodes lie in the same
+    // cell or in an adjacent one, which is probed only when the node is close to the common side
+    const double cellSize = 2. * tolerance;
+    const double sqTolerance = tolerance * tolerance;
+    auto fnCellHash = [](int64_t x, int64_t y, int64_t z) {
+        return (uint64_t(x) * 0x9E3779B97F4A7C15ull)
+                ^ (uint64_t(y) * 0xC2B2AE3D27D4EB4Full)
+                ^ (uint64_t(z) * 0x165667B19E3779F9ull);
+    };
+    std::unordered_map<uint64_t, int> mapCellFirstNode; // Hash collisions are harmless
+    std::vector<int> vecNextNode(nodeCount, -1); // Linked list of the kept nodes of a cell
+    mapCellFirstNode.reserve(nodeCount);
+    for (int i = 0; i < nodeCount; ++i) {
+        const gp_XYZ& pnt = nodes.Value(nodes.Lower() + i).XYZ();
+        int64_t cell[3];
+        int cellMin[3];
+        int cellMax[3];
+        for (int a = 0; a < 3; ++a) {
+            const double coord = pnt.Coord(a + 1);
+            cell[a] = int64_t(std::floor(coord / cellSize));
+            cellMin[a] = coord - cell[a] * cellSize <= tolerance ? -1 : 0;
+            cellMax[a] = (cell[a] + 1) * cellSize - coord <= tolerance ? 1 : 0;
+        }
+
+        for (int dx = cellMin[0]; dx <= cellMax[0] && vecWeld[i] == i; ++dx) {
+            for (int dy = cellMin[1]; dy <= cellMax[1] && vecWeld[i] == i; ++dy) {
+                for (int dz = cellMin[2]; dz <= cellMax[2] && vecWeld[i] == i; ++dz) {
+                    const uint64_t hash = fnCellHash(cell[0] + dx, cell[1] + dy, cell[2] + dz);
+                    auto itCell = mapCellFirstNode.find(hash);
+                    if (itCell == mapCellFirstNode.cend())
+                        continue;
+
+                    for (int j = itCell->second; j >= 0; j = vecNextNode[j]) {
+                        const gp_XYZ& other = nodes.Value(nodes.Lower() + j).XYZ();
+                        if ((other - pnt).SquareModulus() <= sqTolerance) {
+                            vecWeld[i] = j;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+
+        if (vecWeld[i] == i) {
+            auto itInsert = mapCellFirstNode.insert({ fnCellHash(cell[0], cell[1], cell[2]), i });
+            if (!itInsert.second) {
+                vecNextNode[i] = itInsert.first->second;
+                itInsert.first->second = i;
+            }
+        }
+    }
+
+    return vecWeld;
+}
+Handle_Poly_Triangulation MeshUtils::weldedTriangulation(
+        const Handle_Poly_Triangulation& triangulation, double tolerance)
+{
+    if (triangulation.IsNull())
+        return {};
+
+    const TColgp_Array1OfPnt& nodes = triangulation->Nodes();
+    const std::vector<int> vecWeld = MeshUtils::weldNodeMap(nodes, tolerance);
+    std::vector<int> vecNewNode(vecWeld.size(), 0); // One-based indices of the kept nodes
+    int newNodeCount = 0;
+    for (size_t i = 0; i < vecWeld.size(); ++i) {
+        if (vecWeld[i] == int(i))
+            vecNewNode[i] = ++newNodeCount;
+    }
+
+    std::vector<Poly_Triangle> vecTriangle;
+    vecTriangle.reserve(triangulation->NbTriangles());
+    for (int t = 1; t <= triangulation->NbTriangles(); ++t) {
+        int n[3];
+        triangulation->Triangle(t).Get(n[0], n[1], n[2]);
+        for (int& node : n)
+            node = vecNewNode[vecWeld[node - 1]];
+
+        if (n[0] != n[1] && n[1] != n[2] && n[2] != n[0])
+            vecTriangle.emplace_back(n[0], n[1], n[2]);
+    }
+
+    if (vecTriangle.empty())
+        return {};
+
+    Handle_Poly_Triangulation welded =
+            new Poly_Triangulation(newNodeCount, int(vecTriangle.size()), false);
+    welded->Deflection(triangulation->Deflection());
+    for (size_t i = 0; i < vecWeld.size(); ++i) {
+        if (vecNewNode[i] != 0)
+            welded->ChangeNode(vecNewNode[i]) = nodes.Value(nodes.Lower() + int(i));
+    }
+
+    for (size_t t = 0; t < vecTriangle.size(); ++t)
+        welded->ChangeTriangle(int(t) + 1) = vecTriangle[t];
+
+    return welded;
+}
+
 MeshUtils::Orientation MeshUtils::orientation(const AdaptorPolyline2d& polyline)
 {
     const int pntCount = polyline.pointCount();
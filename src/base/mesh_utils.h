@@ -6,7 +6,11 @@
 
 #pragma once
 
+#include <Bnd_Box.hxx>
+#include <gp_Mat.hxx>
+#include <gp_Pnt.hxx>
 #include <Poly_Triangulation.hxx>
+#include <vector>
 class gp_XYZ;
 
 namespace Mayo {
@@ -18,6 +22,34 @@ struct MeshUtils {
     static double triangulationVolume(const Handle_Poly_Triangulation& triangulation);
     static double triangulationArea(const Handle_Poly_Triangulation& triangulation);
 
+    // Integral properties of a triangulation, the enclosed volume has unit density
+    struct TriangulationProperties {
+        double area = 0.;
+        double signedVolume = 0.; // Negative if triangles are oriented inwards
+        // Center of mass of the enclosed volume, or of the surface if volume is null(open mesh)
+        gp_Pnt centroid;
+        // Inertia tensor of the enclosed volume relative to the centroid
+        gp_Mat inertia;
+        Bnd_Box bndBox;
+    };
+
+    // Computes all the properties in a single pass over the triangles, which are processed by
+    // chunks in parallel with ThreadBudget::parallelFor()
+    // Result doesn't depend on the thread count
+    static TriangulationProperties triangulationProperties(
+            const Handle_Poly_Triangulation& triangulation);
+
+    // Maps each node to the first node located within 'tolerance' of it, zero-based indices
+    // Nodes are visited in index order(hash grid lookup) so the mapping doesn't depend on hashing
+    // Identity mapping if 'tolerance' <= 0
+    static std::vector<int> weldNodeMap(const TColgp_Array1OfPnt& nodes, double tolerance);
+
+    // Returns a copy of 'triangulation' where nodes closer than 'tolerance' are merged(eg nodes
+    // duplicated along face boundaries), without normals and UV nodes. Collapsed triangles are
+    // removed, returns a null handle if none is left
+    static Handle_Poly_Triangulation weldedTriangulation(
+            const Handle_Poly_Triangulation& triangulation, double tolerance);
+
     enum class Orientation {
         Unknown,
         Clockwise,
@@ -0,0 +1,239 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "metrics.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace Mayo {
+
+namespace Internal {
+
+struct MetricsRegistry {
+    std::mutex mutex;
+    std::map<std::string, std::unique_ptr<Metrics::Counter>> mapCounter;
+    std::map<std::string, std::unique_ptr<Metrics::Gauge>> mapGauge;
+    std::map<std::string, std::unique_ptr<Metrics::Histogram>> mapHistogram;
+};
+
+static MetricsRegistry& metricsRegistry()
+{
+    static MetricsRegistry registry;
+    return registry;
+}
+
+template<typename METRIC>
+static METRIC& findOrCreateMetric(std::map<std::string, std::unique_ptr<METRIC>>& map, const char* name)
+{
+    auto& registry = metricsRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    std::unique_ptr<METRIC>& ptr = map[name];
+    if (!ptr)
+        ptr = std::make_unique<METRIC>();
+
+    return *ptr;
+}
+
+template<typename PREDICATE>
+static void atomicUpdate(std::atomic<double>* value, double arg, PREDICATE fnMustReplace)
+{
+    double current = value->load(std::memory_order_relaxed);
+    while (fnMustReplace(current, arg)
+           && !value->compare_exchange_weak(current, arg, std::memory_order_relaxed))
+    {
+    }
+}
+
+static void atomicAdd(std::atomic<double>* value, double delta)
+{
+    double current = value->load(std::memory_order_relaxed);
+    while (!value->compare_exchange_weak(current, current + delta, std::memory_order_relaxed)) {
+    }
+}
+
+} // namespace Internal
+
+void Metrics::Gauge::add(double delta)
+{
+    Internal::atomicAdd(&m_value, delta);
+}
+
+void Metrics::Histogram::record(double value)
+{
+    int bucket = 0;
+    if (value > 0.) {
+        const int exponent = static_cast<int>(std::floor(std::log2(value)));
+        bucket = std::clamp(exponent + BucketOffset, 0, BucketCount - 1);
+    }
+
+    m_buckets.at(bucket).fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    Internal::atomicAdd(&m_sum, value);
+    Internal::atomicUpdate(&m_min, value, [](double current, double v) { return v < current; });
+    Internal::atomicUpdate(&m_max, value, [](double current, double v) { return v > current; });
+}
+
+double Metrics::Histogram::min() const
+{
+    return this->count() > 0 ? m_min.load(std::memory_order_relaxed) : 0.;
+}
+
+double Metrics::Histogram::max() const
+{
+    return this->count() > 0 ? m_max.load(std::memory_order_relaxed) : 0.;
+}
+
+double Metrics::Histogram::mean() const
+{
+    const int64_t count = this->count();
+    return count > 0 ? this->sum() / count : 0.;
+}
+
+double Metrics::Histogram::percentile(double p) const
+{
+    const int64_t count = this->count();
+    if (count == 0)
+        return 0.;
+
+    const double rank = std::clamp(p, 0., 1.) * count;
+    int64_t accum = 0;
+    for (int i = 0; i < BucketCount; ++i) {
+        accum += this->bucketCount(i);
+        if (accum >= rank)
+            return std::min(Histogram::bucketUpperBound(i), this->max());
+    }
+
+    return this->max();
+}
+
+double Metrics::Histogram::bucketUpperBound(int i)
+{
+    return std::ldexp(1., i + 1 - BucketOffset);
+}
+
+void Metrics::Histogram::reset()
+{
+    for (std::atomic<int64_t>& bucket : m_buckets)
+        bucket.store(0, std::memory_order_relaxed);
+
+    m_count.store(0, std::memory_order_relaxed);
+    m_sum.store(0., std::memory_order_relaxed);
+    m_min.store(std::numeric_limits<double>::max(), std::memory_order_relaxed);
+    m_max.store(std::numeric_limits<double>::lowest(), std::memory_order_relaxed);
+}
+
+Metrics::Counter& Metrics::counter(const char* name)
+{
+    return Internal::findOrCreateMetric(Internal::metricsRegistry().mapCounter, name);
+}
+
+Metrics::Gauge& Metrics::gauge(const char* name)
+{
+    return Internal::findOrCreateMetric(Internal::metricsRegistry().mapGauge, name);
+}
+
+Metrics::Histogram& Metrics::histogram(const char* name)
+{
+    return Internal::findOrCreateMetric(Internal::metricsRegistry().mapHistogram, name);
+}
+
+std::vector<Metrics::Sample> Metrics::snapshot()
+{
+    std::vector<Sample> vecSample;
+    auto& registry = Internal::metricsRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (const auto& mapPair : registry.mapCounter) {
+        const double value = mapPair.second->value();
+        vecSample.push_back({ mapPair.first.c_str(), Kind::Counter, value, 0, 0., 0., 0., 0. });
+    }
+
+    for (const auto& mapPair : registry.mapGauge) {
+        const double value = mapPair.second->value();
+        vecSample.push_back({ mapPair.first.c_str(), Kind::Gauge, value, 0, 0., 0., 0., 0. });
+    }
+
+    for (const auto& mapPair : registry.mapHistogram) {
+        const Histogram& histo = *mapPair.second;
+        vecSample.push_back({
+                mapPair.first.c_str(), Kind::Histogram,
+                histo.mean(), histo.count(), histo.min(), histo.max(),
+                histo.percentile(0.5), histo.percentile(0.95) });
+    }
+
+    std::sort(vecSample.begin(), vecSample.end(), [](const Sample& lhs, const Sample& rhs) {
+        return lhs.name < rhs.name;
+    });
+    return vecSample;
+}
+
+void Metrics::resetAll()
+{
+    auto& registry = Internal::metricsRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (auto& mapPair : registry.mapCounter)
+        mapPair.second->reset();
+
+    for (auto& mapPair : registry.mapGauge)
+        mapPair.second->reset();
+
+    for (auto& mapPair : registry.mapHistogram)
+        mapPair.second->reset();
+}
+
+QByteArray Metrics::toJson(const std::vector<Sample>& samples)
+{
+    QJsonArray jsonMetrics;
+    for (const Sample& sample : samples) {
+        QJsonObject jsonSample;
+        jsonSample.insert("name", QString::fromUtf8(sample.name));
+        switch (sample.kind) {
+        case Kind::Counter:
+            jsonSample.insert("type", "counter");
+            jsonSample.insert("value", sample.value);
+            break;
+        case Kind::Gauge:
+            jsonSample.insert("type", "gauge");
+            jsonSample.insert("value", sample.value);
+            break;
+        case Kind::Histogram:
+            jsonSample.insert("type", "histogram");
+            jsonSample.insert("count", double(sample.count));
+            jsonSample.insert("mean", sample.value);
+            jsonSample.insert("min", sample.min);
+            jsonSample.insert("max", sample.max);
+            jsonSample.insert("p50", sample.p50);
+            jsonSample.insert("p95", sample.p95);
+            break;
+        }
+
+        jsonMetrics.append(jsonSample);
+    }
+
+    QJsonObject jsonRoot;
+    jsonRoot.insert("metrics", jsonMetrics);
+    return QJsonDocument(jsonRoot).toJson();
+}
+
+bool Metrics::writeJsonFile(const QString& filepath)
+{
+    QFile file(filepath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    const QByteArray json = Metrics::toJson(Metrics::snapshot());
+    return file.write(json) == json.size();
+}
+
+} // namespace Mayo
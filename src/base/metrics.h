@@ -0,0 +1,102 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include <QtCore/QByteArray>
+#include <QtCore/QString>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace Mayo {
+
+// Process-wide registry of named performance metrics(counters, gauges and histograms)
+// Metric objects are created on first access and then live until program exit, so hot paths
+// should cache the returned reference(eg in a function-local static) and only pay the cost
+// of a few relaxed atomic operations per update
+class Metrics {
+public:
+    // Monotonic integer value(eg number of bytes read)
+    class Counter {
+    public:
+        void add(int64_t n = 1) { m_value.fetch_add(n, std::memory_order_relaxed); }
+        int64_t value() const { return m_value.load(std::memory_order_relaxed); }
+        void reset() { m_value.store(0, std::memory_order_relaxed); }
+
+    private:
+        std::atomic<int64_t> m_value = {};
+    };
+
+    // Instantaneous value that can go up and down(eg memory in use)
+    class Gauge {
+    public:
+        void set(double value) { m_value.store(value, std::memory_order_relaxed); }
+        void add(double delta);
+        double value() const { return m_value.load(std::memory_order_relaxed); }
+        void reset() { this->set(0.); }
+
+    private:
+        std::atomic<double> m_value = {};
+    };
+
+    // Distribution of sampled values(eg frame time in milliseconds)
+    // Samples are accumulated in power-of-two buckets, bucket i counting values in
+    // [2^(i-BucketOffset), 2^(i+1-BucketOffset)[
+    class Histogram {
+    public:
+        static constexpr int BucketCount = 24;
+        static constexpr int BucketOffset = 4;
+
+        void record(double value);
+
+        int64_t count() const { return m_count.load(std::memory_order_relaxed); }
+        double sum() const { return m_sum.load(std::memory_order_relaxed); }
+        double min() const;
+        double max() const;
+        double mean() const;
+        double percentile(double p) const; // Approximation, 'p' in [0, 1]
+        int64_t bucketCount(int i) const { return m_buckets.at(i).load(std::memory_order_relaxed); }
+        static double bucketUpperBound(int i);
+
+        void reset();
+
+    private:
+        std::atomic<int64_t> m_count = {};
+        std::atomic<double> m_sum = {};
+        std::atomic<double> m_min = { std::numeric_limits<double>::max() };
+        std::atomic<double> m_max = { std::numeric_limits<double>::lowest() };
+        std::array<std::atomic<int64_t>, BucketCount> m_buckets = {};
+    };
+
+    enum class Kind { Counter, Gauge, Histogram };
+
+    struct Sample {
+        QByteArray name;
+        Kind kind;
+        double value; // Counter/Gauge value, Histogram mean
+        int64_t count; // Histogram only
+        double min; // Histogram only
+        double max; // Histogram only
+        double p50; // Histogram only
+        double p95; // Histogram only
+    };
+
+    static Counter& counter(const char* name);
+    static Gauge& gauge(const char* name);
+    static Histogram& histogram(const char* name);
+
+    // Returns the current value of all metrics, sorted by name
+    static std::vector<Sample> snapshot();
+    static void resetAll();
+
+    static QByteArray toJson(const std::vector<Sample>& samples);
+    static bool writeJsonFile(const QString& filepath);
+};
+
+} // namespace Mayo
@@ -0,0 +1,317 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "point_cloud.h"
+
+#include "caf_utils.h"
+#include "task_progress.h"
+#include "thread_budget.h"
+#include "tracing.h"
+
+#include <Standard_GUID.hxx>
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <queue>
+#include <utility>
+
+namespace Mayo {
+
+namespace Internal {
+
+static const int pointCloudChunkSize = 64 * 1024;
+
+// Octree depth is bounded so coincident points don't lead to infinite subdivision
+static const int pointCloudOctreeMaxDepth = 21;
+
+// Offsets of the octant ranges of a node, last one is past-the-end of the node range
+using PointCloudOctantOffsets = std::array<int, 9>;
+
+static int pointCloudOctant(const float* coords, const float* center)
+{
+    return (coords[0] >= center[0] ? 1 : 0)
+            | (coords[1] >= center[1] ? 2 : 0)
+            | (coords[2] >= center[2] ? 4 : 0);
+}
+
+// Partitions in place the points of 'node' by octant, as an American flag sort
+static void partitionOctreeNode(
+        const PointCloud::OctreeNode& node,
+        float* coords,
+        uint8_t* colors,
+        PointCloudOctantOffsets* ptrOffsets)
+{
+    int octantCount[8] = {};
+    for (int i = node.pointBegin; i < node.pointEnd; ++i)
+        ++octantCount[pointCloudOctant(coords + 3 * size_t(i), node.center)];
+
+    PointCloudOctantOffsets& offsets = *ptrOffsets;
+    offsets.at(0) = node.pointBegin;
+    for (int octant = 0; octant < 8; ++octant)
+        offsets.at(octant + 1) = offsets.at(octant) + octantCount[octant];
+
+    int next[8];
+    std::copy(offsets.cbegin(), offsets.cbegin() + 8, next);
+    for (int octant = 0; octant < 8; ++octant) {
+        while (next[octant] < offsets.at(octant + 1)) {
+            const int i = next[octant];
+            const int octantPoint = pointCloudOctant(coords + 3 * size_t(i), node.center);
+            if (octantPoint == octant) {
+                ++next[octant];
+                continue;
+            }
+
+            // Move point to its octant, the point coming in place is then processed
+            const size_t j = next[octantPoint]++;
+            const size_t offsetI = 3 * size_t(i);
+            std::swap_ranges(coords + offsetI, coords + offsetI + 3, coords + 3 * j);
+            if (colors)
+                std::swap_ranges(colors + offsetI, colors + offsetI + 3, colors + 3 * j);
+        }
+    }
+}
+
+static int lodNodeStride(const PointCloud::OctreeNode& node, int nodeMaxPointCount)
+{
+    return std::max(1, (node.pointCount() + nodeMaxPointCount - 1) / nodeMaxPointCount);
+}
+
+static int lodNodeDrawnCount(const PointCloud::OctreeNode& node, int stride)
+{
+    return (node.pointCount() + stride - 1) / stride;
+}
+
+} // namespace Internal
+
+gp_Pnt PointCloud::point(int i) const
+{
+    const float* c = this->coords(i);
+    return gp_Pnt(c[0], c[1], c[2]);
+}
+
+bool PointCloud::buildOctree(int maxNodePointCount, TaskProgress* progress)
+{
+    MAYO_TRACE_SCOPE("pointcloud", "buildOctree");
+    m_vecOctreeNode.clear();
+    m_bndBox.SetVoid();
+    m_maxNodePointCount = std::max(1, maxNodePointCount);
+    const int pointCount = this->pointCount();
+    if (pointCount == 0)
+        return true;
+
+    // Bounding box, reduced by chunks in parallel
+    const int chunkSize = Internal::pointCloudChunkSize;
+    const int chunkCount = (pointCount + chunkSize - 1) / chunkSize;
+    std::vector<std::array<float, 6>> vecChunkMinMax(chunkCount);
+    ThreadBudget::parallelFor(0, chunkCount, [&](int iChunk) {
+        std::array<float, 6>& minMax = vecChunkMinMax.at(iChunk);
+        std::fill(minMax.begin(), minMax.begin() + 3, std::numeric_limits<float>::max());
+        std::fill(minMax.begin() + 3, minMax.end(), std::numeric_limits<float>::lowest());
+        const int iEnd = std::min(pointCount, (iChunk + 1) * chunkSize);
+        for (int i = iChunk * chunkSize; i < iEnd; ++i) {
+            const float* c = this->coords(i);
+            for (int k = 0; k < 3; ++k) {
+                minMax[k] = std::min(minMax[k], c[k]);
+                minMax[k + 3] = std::max(minMax[k + 3], c[k]);
+            }
+        }
+    });
+
+    for (const std::array<float, 6>& minMax : vecChunkMinMax)
+        m_bndBox.Update(minMax[0], minMax[1], minMax[2], minMax[3], minMax[4], minMax[5]);
+
+    // Root node is the cube enclosing the bounding box
+    {
+        const gp_Pnt pntMin = m_bndBox.CornerMin();
+        const gp_Pnt pntMax = m_bndBox.CornerMax();
+        OctreeNode root;
+        root.center[0] = float((pntMin.X() + pntMax.X()) / 2.);
+        root.center[1] = float((pntMin.Y() + pntMax.Y()) / 2.);
+        root.center[2] = float((pntMin.Z() + pntMax.Z()) / 2.);
+        root.halfSize = float(std::max({
+                    pntMax.X() - pntMin.X(), pntMax.Y() - pntMin.Y(), pntMax.Z() - pntMin.Z()
+                }) / 2.);
+        root.pointBegin = 0;
+        root.pointEnd = pointCount;
+        m_vecOctreeNode.push_back(root);
+    }
+
+    // Breadth-first subdivision, nodes of the same depth have disjoint point ranges
+    float* coords = m_vecCoord.data();
+    uint8_t* colors = this->hasColors() ? m_vecColor.data() : nullptr;
+    std::vector<int> vecDepthNode = { 0 };
+    for (int depth = 0; !vecDepthNode.empty(); ++depth) {
+        if (TaskProgress::isAbortRequested(progress)) {
+            m_vecOctreeNode.clear();
+            return false;
+        }
+
+        const bool isDepthMax = depth >= Internal::pointCloudOctreeMaxDepth;
+        std::vector<Internal::PointCloudOctantOffsets> vecOffsets(vecDepthNode.size());
+        ThreadBudget::parallelFor(0, int(vecDepthNode.size()), [&](int i) {
+            const OctreeNode& node = m_vecOctreeNode.at(vecDepthNode.at(i));
+            vecOffsets.at(i).fill(-1);
+            if (!isDepthMax && node.pointCount() > m_maxNodePointCount)
+                Internal::partitionOctreeNode(node, coords, colors, &vecOffsets.at(i));
+        });
+
+        std::vector<int> vecNextDepthNode;
+        for (unsigned i = 0; i < vecDepthNode.size(); ++i) {
+            const Internal::PointCloudOctantOffsets& offsets = vecOffsets.at(i);
+            if (offsets.at(0) == -1)
+                continue; // Leaf
+
+            const int iNode = vecDepthNode.at(i);
+            m_vecOctreeNode.at(iNode).firstChild = int(m_vecOctreeNode.size());
+            for (int octant = 0; octant < 8; ++octant) {
+                if (offsets.at(octant) == offsets.at(octant + 1))
+                    continue;
+
+                const OctreeNode& node = m_vecOctreeNode.at(iNode);
+                OctreeNode child;
+                child.halfSize = node.halfSize / 2.f;
+                for (int k = 0; k < 3; ++k) {
+                    const float sign = (octant & (1 << k)) ? 1.f : -1.f;
+                    child.center[k] = node.center[k] + sign * child.halfSize;
+                }
+
+                child.pointBegin = offsets.at(octant);
+                child.pointEnd = offsets.at(octant + 1);
+                vecNextDepthNode.push_back(int(m_vecOctreeNode.size()));
+                m_vecOctreeNode.push_back(child);
+                ++m_vecOctreeNode.at(iNode).childCount;
+            }
+        }
+
+        vecDepthNode = std::move(vecNextDepthNode);
+        if (progress)
+            progress->setValue(std::min(99, (depth + 1) * 15));
+    }
+
+    if (progress)
+        progress->setValue(100);
+
+    return true;
+}
+
+std::vector<PointCloud::LodNode> PointCloud::selectLevelOfDetail(
+        int pointBudget, const FunctionScreenSize& fnScreenSize) const
+{
+    std::vector<LodNode> vecLodNode;
+    if (m_vecOctreeNode.empty() || pointBudget <= 0)
+        return vecLodNode;
+
+    struct Candidate {
+        double screenSize;
+        int node;
+        bool operator<(const Candidate& other) const { return this->screenSize < other.screenSize; }
+    };
+
+    const int nodeMaxPointCount = std::min(m_maxNodePointCount, pointBudget);
+    auto fnDrawnCount = [=](const OctreeNode& node) {
+        const int stride = Internal::lodNodeStride(node, nodeMaxPointCount);
+        return Internal::lodNodeDrawnCount(node, stride);
+    };
+
+    const double rootScreenSize = fnScreenSize(m_vecOctreeNode.front());
+    if (rootScreenSize < 0)
+        return vecLodNode;
+
+    // Biggest nodes on screen are refined first, while the point budget allows
+    std::priority_queue<Candidate> queueCandidate;
+    queueCandidate.push({ rootScreenSize, 0 });
+    int drawnCount = fnDrawnCount(m_vecOctreeNode.front());
+    while (!queueCandidate.empty()) {
+        const Candidate candidate = queueCandidate.top();
+        queueCandidate.pop();
+        const OctreeNode& node = m_vecOctreeNode.at(candidate.node);
+        const int nodeDrawnCount = fnDrawnCount(node);
+        const double screenArea = candidate.screenSize * candidate.screenSize;
+        if (!node.isLeaf() && screenArea > nodeDrawnCount) {
+            Candidate children[8];
+            int visibleChildCount = 0;
+            int childrenDrawnCount = 0;
+            for (int i = node.firstChild; i < node.firstChild + node.childCount; ++i) {
+                const OctreeNode& child = m_vecOctreeNode.at(i);
+                const double childScreenSize = fnScreenSize(child);
+                if (childScreenSize >= 0) {
+                    children[visibleChildCount++] = { childScreenSize, i };
+                    childrenDrawnCount += fnDrawnCount(child);
+                }
+            }
+
+            if (drawnCount - nodeDrawnCount + childrenDrawnCount <= pointBudget) {
+                drawnCount += childrenDrawnCount - nodeDrawnCount;
+                for (int i = 0; i < visibleChildCount; ++i)
+                    queueCandidate.push(children[i]);
+
+                continue;
+            }
+        }
+
+        vecLodNode.push_back({ candidate.node, Internal::lodNodeStride(node, nodeMaxPointCount) });
+    }
+
+    return vecLodNode;
+}
+
+int PointCloud::lodPointCount(const std::vector<LodNode>& vecLodNode, const PointCloud& cloud)
+{
+    int count = 0;
+    for (const LodNode& lodNode : vecLodNode)
+        count += Internal::lodNodeDrawnCount(cloud.octree().at(lodNode.node), lodNode.stride);
+
+    return count;
+}
+
+const Standard_GUID& PointCloudAttribute::GetID()
+{
+    static const Standard_GUID guid("3a9c8d52-6f1e-4b7a-9d24-5e0c1f7b8a63");
+    return guid;
+}
+
+Handle_PointCloudAttribute PointCloudAttribute::Set(
+        const TDF_Label& label, const Handle_PointCloud& cloud)
+{
+    Handle_PointCloudAttribute attr = CafUtils::findAttribute<PointCloudAttribute>(label);
+    if (attr.IsNull()) {
+        attr = new PointCloudAttribute;
+        label.AddAttribute(attr);
+    }
+
+    attr->set(cloud);
+    return attr;
+}
+
+void PointCloudAttribute::set(const Handle_PointCloud& cloud)
+{
+    this->Backup();
+    m_cloud = cloud;
+}
+
+const Standard_GUID& PointCloudAttribute::ID() const
+{
+    return PointCloudAttribute::GetID();
+}
+
+void PointCloudAttribute::Restore(const opencascade::handle<TDF_Attribute>& with)
+{
+    m_cloud = Handle_PointCloudAttribute::DownCast(with)->m_cloud;
+}
+
+opencascade::handle<TDF_Attribute> PointCloudAttribute::NewEmpty() const
+{
+    return new PointCloudAttribute;
+}
+
+void PointCloudAttribute::Paste(
+        const opencascade::handle<TDF_Attribute>& into,
+        const opencascade::handle<TDF_RelocationTable>& /*table*/) const
+{
+    Handle_PointCloudAttribute::DownCast(into)->m_cloud = m_cloud;
+}
+
+} // namespace Mayo
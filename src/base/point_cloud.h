@@ -0,0 +1,120 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include <Bnd_Box.hxx>
+#include <gp_Pnt.hxx>
+#include <Standard_Transient.hxx>
+#include <TDF_Attribute.hxx>
+#include <TDF_Label.hxx>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace Mayo {
+
+class TaskProgress;
+
+class PointCloud;
+DEFINE_STANDARD_HANDLE(PointCloud, Standard_Transient)
+
+// Compact store of points : float32 coordinates and optional 8-bit RGB colors
+// Once buildOctree() is called, points are ordered so the points of each octree node are
+// contiguous, allowing level of detail selection with selectLevelOfDetail()
+class PointCloud : public Standard_Transient {
+public:
+    // Default maximum count of points in an octree leaf, also the count of points drawn for
+    // any node of the level of detail
+    static constexpr int DefaultNodePointCount = 4096;
+
+    int pointCount() const { return int(m_vecCoord.size() / 3); }
+    const float* coords(int i) const { return m_vecCoord.data() + 3 * size_t(i); } // 0-based index
+    gp_Pnt point(int i) const;
+    bool hasColors() const { return !m_vecColor.empty(); }
+    const uint8_t* color(int i) const { return m_vecColor.data() + 3 * size_t(i); } // 0-based index
+
+    // Raw storage of XYZ coordinates and RGB colors, three components per point
+    // Colors are either empty or of the same size as coordinates
+    std::vector<float>& changeCoords() { return m_vecCoord; }
+    std::vector<uint8_t>& changeColors() { return m_vecColor; }
+
+    // Bounding box of points, computed by buildOctree()
+    const Bnd_Box& boundingBox() const { return m_bndBox; }
+
+    // Octree nodes are cubic cells, children of a node are contiguous in the node array
+    struct OctreeNode {
+        float center[3];
+        float halfSize;
+        int pointBegin; // Index of the first point of the node
+        int pointEnd; // Past-the-end index
+        int firstChild = -1;
+        int childCount = 0;
+
+        int pointCount() const { return this->pointEnd - this->pointBegin; }
+        bool isLeaf() const { return this->childCount == 0; }
+    };
+    const std::vector<OctreeNode>& octree() const { return m_vecOctreeNode; }
+
+    // Builds the octree(root node at index 0), reordering points
+    // Nodes of each depth are partitioned in parallel with ThreadBudget::parallelFor()
+    // Returns false if the operation was aborted
+    bool buildOctree(
+            int maxNodePointCount = DefaultNodePointCount, TaskProgress* progress = nullptr);
+    int maxNodePointCount() const { return m_maxNodePointCount; }
+
+    // Node of the level of detail : points pointBegin, pointBegin+stride, ... are drawn
+    struct LodNode {
+        int node;
+        int stride;
+    };
+
+    // Returns the octree nodes to be drawn so that at most 'pointBudget' points are drawn
+    // Coarse nodes draw a subset of their points, they are refined first when they appear the
+    // biggest on screen, as returned by 'fnScreenSize'(negative when node isn't visible)
+    // Refinement stops once a node has no more than one drawn point per pixel
+    using FunctionScreenSize = std::function<double (const OctreeNode&)>;
+    std::vector<LodNode> selectLevelOfDetail(
+            int pointBudget, const FunctionScreenSize& fnScreenSize) const;
+    static int lodPointCount(const std::vector<LodNode>& vecLodNode, const PointCloud& cloud);
+
+    DEFINE_STANDARD_RTTI_INLINE(PointCloud, Standard_Transient)
+
+private:
+    std::vector<float> m_vecCoord;
+    std::vector<uint8_t> m_vecColor;
+    Bnd_Box m_bndBox;
+    std::vector<OctreeNode> m_vecOctreeNode;
+    int m_maxNodePointCount = DefaultNodePointCount;
+};
+
+class PointCloudAttribute;
+DEFINE_STANDARD_HANDLE(PointCloudAttribute, TDF_Attribute)
+
+// Document attribute holding a point cloud entity, the counterpart of TDataXtd_Triangulation
+// for meshes
+class PointCloudAttribute : public TDF_Attribute {
+public:
+    static const Standard_GUID& GetID();
+    static Handle_PointCloudAttribute Set(const TDF_Label& label, const Handle_PointCloud& cloud);
+
+    const Handle_PointCloud& get() const { return m_cloud; }
+    void set(const Handle_PointCloud& cloud);
+
+    const Standard_GUID& ID() const override;
+    void Restore(const opencascade::handle<TDF_Attribute>& with) override;
+    opencascade::handle<TDF_Attribute> NewEmpty() const override;
+    void Paste(
+            const opencascade::handle<TDF_Attribute>& into,
+            const opencascade::handle<TDF_RelocationTable>& table) const override;
+
+    DEFINE_STANDARD_RTTI_INLINE(PointCloudAttribute, TDF_Attribute)
+
+private:
+    Handle_PointCloud m_cloud;
+};
+
+} // namespace Mayo
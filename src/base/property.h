@@ -109,6 +109,8 @@ public:
 
 signals:
     void propertyChanged(Property* prop);
+    // Emitted when the set of properties is changed, views are expected to be rebuilt
+    void propertyListChanged();
 
 protected:
     void onPropertyChanged(Property* prop) override;
@@ -7,6 +7,8 @@
 #include "scope_import.h"
 
 #include "document.h"
+#include "memory_utils.h"
+#include "metrics.h"
 #include "xcaf.h"
 
 namespace Mayo {
@@ -37,8 +39,11 @@ XCafScopeImport::XCafScopeImport(const DocumentPtr& doc)
 
 XCafScopeImport::XCafScopeImport(XCafScopeImport&& other)
     : BaseScopeImport(std::move(other)),
-      m_seqLabelEntityOnEntry(std::move(other.m_seqLabelEntityOnEntry))
-{ }
+      m_seqLabelEntityOnEntry(std::move(other.m_seqLabelEntityOnEntry)),
+      m_fnReleaseTransientData(std::move(other.m_fnReleaseTransientData))
+{
+    other.m_fnReleaseTransientData = nullptr;
+}
 
 XCafScopeImport::~XCafScopeImport()
 {
@@ -48,6 +53,18 @@ XCafScopeImport::~XCafScopeImport()
     else {
         // TODO Remove new entities
     }
+
+    if (m_fnReleaseTransientData) {
+        m_fnReleaseTransientData();
+        MemoryUtils::releaseFreedMemory();
+        static Metrics::Gauge& gaugeResidentMemory = Metrics::gauge("memory.residentBytes");
+        gaugeResidentMemory.set(double(MemoryUtils::processResidentMemory()));
+    }
+}
+
+void XCafScopeImport::setTransientDataReleaser(std::function<void()> fn)
+{
+    m_fnReleaseTransientData = std::move(fn);
 }
 
 SingleScopeImport::SingleScopeImport(const DocumentPtr& doc)
@@ -8,6 +8,7 @@
 
 #include "document_ptr.h"
 #include <TDF_LabelSequence.hxx>
+#include <functional>
 
 namespace Mayo {
 
@@ -37,8 +38,14 @@ public:
     XCafScopeImport(const XCafScopeImport&) = delete;
     XCafScopeImport& operator=(const XCafScopeImport&) = delete;
 
+    // Function called on scope exit to free all the transient data created by the import
+    // process(eg translation maps and models of OpenCascade readers)
+    // Once done, memory freed is given back to the operating system in one go
+    void setTransientDataReleaser(std::function<void()> fn);
+
 private:
     const TDF_LabelSequence m_seqLabelEntityOnEntry;
+    std::function<void()> m_fnReleaseTransientData;
 };
 
 class SingleScopeImport : public BaseScopeImport {
@@ -6,8 +6,11 @@
 
 #include "task_manager.h"
 #include "math_utils.h"
+#include "thread_budget.h"
+#include "tracing.h"
 
 #include <QtCore/QCoreApplication>
+#include <gsl/gsl_util>
 #include <cassert>
 
 namespace Mayo {
@@ -54,9 +57,20 @@ void TaskManager::run(TaskId id, TaskAutoDestroy autoDestroy)
         return;
 
     entity->control = std::async([=]{
+        ThreadBudget::acquireRunSlot([=]{ return entity->taskProgress.isAbortRequested(); });
+        ++m_runningTaskCount;
+        ThreadBudget::syncOccPool();
         emit this->started(id);
-        const TaskJob& fn = entity->task.job();
-        fn(&entity->taskProgress);
+        {
+            auto _ = gsl::finally([=]{
+                --m_runningTaskCount;
+                ThreadBudget::releaseRunSlot();
+            });
+            MAYO_TRACE_SCOPE("task", entity->title.isEmpty() ? QString("Task #%1").arg(id) : entity->title);
+            const TaskJob& fn = entity->task.job();
+            fn(&entity->taskProgress);
+        }
+
         emit this->ended(id);
         if (autoDestroy == TaskAutoDestroy::On) {
             entity->isGarbage = true;
@@ -86,10 +100,16 @@ void TaskManager::requestAbort(TaskId id)
     Entity* entity = this->findEntity(id);
     if (entity) {
         emit this->abortRequested(id);
-        entity->taskProgress.requestAbort();
+        // Wake up the task if it's waiting for a run slot
+        ThreadBudget::notifyRunSlotWaiters([=]{ entity->taskProgress.requestAbort(); });
     }
 }
 
+int TaskManager::runningTaskCount() const
+{
+    return m_runningTaskCount.load();
+}
+
 int TaskManager::progress(TaskId id) const
 {
     const Entity* entity = this->findEntity(id);
@@ -17,6 +17,11 @@
 
 namespace Mayo {
 
+// Runs tasks asynchronously. Tasks of all the TaskManager instances share the process-wide run
+// slots of ThreadBudget, so at most ThreadBudget::threadCount() of them run concurrently
+// Tasks exceeding the budget wait for a run slot to be released before being started
+// Note: a task waiting for tasks of a child TaskManager has to give back its slot meanwhile, see
+//       ThreadBudget::RunSlotYield
 class TaskManager : public QObject {
     Q_OBJECT
 public:
@@ -35,6 +40,8 @@ public:
     bool waitForDone(TaskId id, int msecs = -1);
     void requestAbort(TaskId id);
 
+    int runningTaskCount() const;
+
 signals:
     void started(TaskId id);
     void progressStep(TaskId id, const QString& stepTitle);
@@ -57,6 +64,7 @@ private:
 
     std::atomic<TaskId> m_taskIdSeq = {};
     std::unordered_map<TaskId, std::unique_ptr<Entity>> m_mapEntity;
+    std::atomic<int> m_runningTaskCount = {}; // Tasks of this manager holding a run slot
 };
 
 } // namespace Mayo
@@ -7,6 +7,7 @@
 #include "task_progress.h"
 #include "task.h"
 #include "task_manager.h"
+#include "tracing.h"
 
 #include <cassert>
 #include <limits>
@@ -51,6 +52,7 @@ void TaskProgress::beginScope(int scopeSize, const QString& stepTitle)
     assert(scopeSize > 1);
     m_currentScopeSize = scopeSize;
     m_currentScopeValueStart = m_value;
+    Tracing::beginEvent("progress", stepTitle.isEmpty() ? QString("Scope") : stepTitle);
     if (!stepTitle.isEmpty())
         this->setStep(stepTitle);
 }
@@ -59,6 +61,7 @@ void TaskProgress::endScope()
 {
     this->setValue(100);
     m_currentScopeSize = -1;
+    Tracing::endEvent("progress");
 }
 
 void TaskProgress::requestAbort()
@@ -0,0 +1,234 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "tessellation.h"
+
+#include "metrics.h"
+#include "task_progress.h"
+#include "tessellation_cache.h"
+#include "thread_budget.h"
+#include "tracing.h"
+
+#include <Bnd_Box.hxx>
+#include <BRep_Builder.hxx>
+#include <BRep_Tool.hxx>
+#include <BRepBndLib.hxx>
+#include <BRepMesh_IncrementalMesh.hxx>
+#include <BRepTools.hxx>
+#include <Poly_Triangulation.hxx>
+#include <TopExp_Explorer.hxx>
+#include <TopoDS.hxx>
+#include <TopoDS_Compound.hxx>
+#include <TopTools_DataMapOfShapeInteger.hxx>
+#include <TopTools_MapOfShape.hxx>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <mutex>
+#include <numeric>
+
+namespace Mayo {
+
+namespace Internal {
+
+static int64_t triangleCount(const TopoDS_Shape& shape)
+{
+    int64_t count = 0;
+    for (TopExp_Explorer expl(shape, TopAbs_FACE); expl.More(); expl.Next()) {
+        TopLoc_Location loc;
+        const Handle_Poly_Triangulation& triangulation =
+                BRep_Tool::Triangulation(TopoDS::Face(expl.Current()), loc);
+        if (!triangulation.IsNull())
+            count += triangulation->NbTriangles();
+    }
+
+    return count;
+}
+
+// Returns the root of 'index' in the union-find forest 'vecParent', with path halving
+static int unionFindRoot(std::vector<int>* vecParent, int index)
+{
+    while (vecParent->at(index) != index) {
+        vecParent->at(index) = vecParent->at(vecParent->at(index));
+        index = vecParent->at(index);
+    }
+
+    return index;
+}
+
+} // namespace Internal
+
+double Tessellation::chordalDeflection(const TessellationParameters& params, const Bnd_Box& bndBox)
+{
+    if (params.deflectionMode == TessellationParameters::DeflectionMode::Absolute)
+        return params.chordalDeflection;
+
+    if (bndBox.IsVoid())
+        return params.chordalDeflection;
+
+    const double diagonal = std::sqrt(bndBox.SquareExtent());
+    return diagonal > 0. ? diagonal * params.relativeChordalDeflection : params.chordalDeflection;
+}
+
+double Tessellation::chordalDeflection(
+        const TessellationParameters& params, Span<const TopoDS_Shape> shapes)
+{
+    Bnd_Box bndBox;
+    if (params.deflectionMode == TessellationParameters::DeflectionMode::Relative) {
+        for (const TopoDS_Shape& shape : shapes)
+            BRepBndLib::Add(shape, bndBox, false); // Don't use triangulations
+    }
+
+    return Tessellation::chordalDeflection(params, bndBox);
+}
+
+TessellationParameters Tessellation::coarseParameters(const TessellationParameters& params)
+{
+    constexpr double chordalFactor = 10.;
+    constexpr double maxAngularDeflection = 1.; // ~57 degrees
+    TessellationParameters coarseParams = params;
+    coarseParams.chordalDeflection = params.chordalDeflection * chordalFactor;
+    coarseParams.relativeChordalDeflection =
+            std::min(params.relativeChordalDeflection * chordalFactor, 0.05);
+    coarseParams.angularDeflection = std::min(params.angularDeflection * 2, maxAngularDeflection);
+    coarseParams.progressive = false;
+    return coarseParams;
+}
+
+std::vector<TopoDS_Shape> Tessellation::meshingUnits(Span<const TopoDS_Shape> shapes)
+{
+    std::vector<TopoDS_Shape> vecCandidate;
+    TopTools_MapOfShape mapCandidate;
+    auto fnAddCandidate = [&](const TopoDS_Shape& shape) {
+        const TopoDS_Shape candidate = shape.Located(TopLoc_Location());
+        if (mapCandidate.Add(candidate))
+            vecCandidate.push_back(candidate);
+    };
+
+    for (const TopoDS_Shape& shape : shapes) {
+        for (TopExp_Explorer expl(shape, TopAbs_COMPSOLID); expl.More(); expl.Next())
+            fnAddCandidate(expl.Current());
+
+        for (TopExp_Explorer expl(shape, TopAbs_SOLID, TopAbs_COMPSOLID); expl.More(); expl.Next())
+            fnAddCandidate(expl.Current());
+
+        for (TopExp_Explorer expl(shape, TopAbs_SHELL, TopAbs_SOLID); expl.More(); expl.Next())
+            fnAddCandidate(expl.Current());
+
+        for (TopExp_Explorer expl(shape, TopAbs_FACE, TopAbs_SHELL); expl.More(); expl.Next())
+            fnAddCandidate(expl.Current());
+    }
+
+    // Units must not share edges, otherwise concurrent BRepMesh runs would race on the edge
+    // polygons and leave cracks between faces. Candidates can still share edges(eg solids glued
+    // in a plain compound, general fuse results), these ones are merged with union-find
+    const int candidateCount = int(vecCandidate.size());
+    std::vector<int> vecParent(candidateCount);
+    std::iota(vecParent.begin(), vecParent.end(), 0);
+    TopTools_DataMapOfShapeInteger mapEdgeCandidate;
+    for (int i = 0; i < candidateCount; ++i) {
+        for (TopExp_Explorer expl(vecCandidate.at(i), TopAbs_EDGE); expl.More(); expl.Next()) {
+            // Edge polygons are stored in the edge TShape, whatever the edge location
+            const TopoDS_Shape edge = expl.Current().Located(TopLoc_Location());
+            const int* ptrCandidate = mapEdgeCandidate.Seek(edge);
+            if (!ptrCandidate) {
+                mapEdgeCandidate.Bind(edge, i);
+                continue;
+            }
+
+            const int root = Internal::unionFindRoot(&vecParent, i);
+            const int otherRoot = Internal::unionFindRoot(&vecParent, *ptrCandidate);
+            vecParent.at(std::max(root, otherRoot)) = std::min(root, otherRoot);
+        }
+    }
+
+    std::vector<TopoDS_Shape> vecUnit;
+    std::vector<int> vecRootUnitIndex(candidateCount, -1);
+    BRep_Builder builder;
+    for (int i = 0; i < candidateCount; ++i) {
+        const TopoDS_Shape& candidate = vecCandidate.at(i);
+        int& unitIndex = vecRootUnitIndex.at(Internal::unionFindRoot(&vecParent, i));
+        if (unitIndex < 0) {
+            unitIndex = int(vecUnit.size());
+            vecUnit.push_back(candidate);
+            continue;
+        }
+
+        // Candidates are never compounds, so a compound unit is a group already created
+        TopoDS_Shape& unit = vecUnit.at(unitIndex);
+        if (unit.ShapeType() != TopAbs_COMPOUND) {
+            TopoDS_Compound group;
+            builder.MakeCompound(group);
+            builder.Add(group, unit);
+            unit = group;
+        }
+
+        builder.Add(unit, candidate);
+    }
+
+    return vecUnit;
+}
+
+int64_t Tessellation::tessellate(
+        Span<const TopoDS_Shape> shapes,
+        const TessellationParameters& params,
+        TaskProgress* progress)
+{
+    MAYO_TRACE_SCOPE("mesh", "tessellate");
+    const std::vector<TopoDS_Shape> vecUnit = Tessellation::meshingUnits(shapes);
+    if (vecUnit.empty())
+        return 0;
+
+    const double linDeflection = Tessellation::chordalDeflection(params, shapes);
+    const double angDeflection = params.angularDeflection;
+    const bool useCache = TessellationCache::isEnabled();
+    std::atomic<int64_t> triangleCount = {};
+    std::atomic<int> doneCount = {};
+    std::mutex progressMutex;
+    int progressPct = 0;
+    const int unitCount = int(vecUnit.size());
+    auto fnMeshUnit = [&](int i) {
+        if (TaskProgress::isAbortRequested(progress))
+            return;
+
+        const TopoDS_Shape& unit = vecUnit.at(i);
+        if (!BRepTools::Triangulation(unit, linDeflection)) {
+            const uint64_t cacheKey =
+                    useCache ? TessellationCache::shapeKey(unit, linDeflection, angDeflection) : 0;
+            if (!useCache || !TessellationCache::load(cacheKey, unit)) {
+                // Parallelism is at the unit level, so BRepMesh itself runs single-threaded
+                BRepMesh_IncrementalMesh mesher(unit, linDeflection, false, angDeflection, false);
+                triangleCount += Internal::triangleCount(unit);
+                if (useCache)
+                    TessellationCache::store(cacheKey, unit);
+            }
+        }
+
+        const int done = ++doneCount;
+        if (progress) {
+            std::lock_guard<std::mutex> lock(progressMutex);
+            const int pct = (done * 100) / unitCount;
+            if (pct > progressPct) {
+                progressPct = pct;
+                progress->setValue(pct);
+            }
+        }
+    };
+    ThreadBudget::parallelFor(0, unitCount, fnMeshUnit);
+
+    static Metrics::Counter& counterTriangles = Metrics::counter("mesh.trianglesCreated");
+    counterTriangles.add(triangleCount.load());
+    return triangleCount.load();
+}
+
+std::shared_mutex& Tessellation::triangulationMutex()
+{
+    static std::shared_mutex mutex;
+    return mutex;
+}
+
+} // namespace Mayo
@@ -0,0 +1,73 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "span.h"
+#include <TopoDS_Shape.hxx>
+#include <cstdint>
+#include <shared_mutex>
+#include <vector>
+class Bnd_Box;
+
+namespace Mayo {
+
+class TaskProgress;
+
+struct TessellationParameters {
+    enum class DeflectionMode {
+        Absolute, // Chordal deflection is a length
+        Relative  // Chordal deflection is a ratio of the model bounding box diagonal
+    };
+
+    bool enabled = false;
+    DeflectionMode deflectionMode = DeflectionMode::Relative;
+    double chordalDeflection = 1.; // Length in mm, used with DeflectionMode::Absolute
+    double relativeChordalDeflection = 0.001; // Used with DeflectionMode::Relative
+    double angularDeflection = 0.35; // Radians
+    // Import computes a coarse mesh for quick first display, the mesh is then refined in
+    // background up to the deflections above
+    bool progressive = false;
+};
+
+struct Tessellation {
+    // Returns the absolute chordal deflection to be applied on a model enclosed by 'bndBox'
+    static double chordalDeflection(const TessellationParameters& params, const Bnd_Box& bndBox);
+
+    // Returns the absolute chordal deflection to be applied on 'shapes' meshed all together
+    // The reference bounding box is computed from the shape geometries, whatever their current
+    // triangulations, so the deflection is the same before and after a first tessellation
+    static double chordalDeflection(
+            const TessellationParameters& params, Span<const TopoDS_Shape> shapes);
+
+    // Returns the parameters of the coarse mesh computed first with progressive tessellation
+    static TessellationParameters coarseParameters(const TessellationParameters& params);
+
+    // Returns the unique sub-shapes of 'shapes' that can be meshed independently : compsolids,
+    // solids not belonging to a compsolid, shells not belonging to a solid and faces not belonging
+    // to a shell. Such sub-shapes sharing edges(eg glued solids of a compound) are grouped into a
+    // single compound unit, so no edge belongs to two units
+    // Returned shapes have no location, so instances of the same product are meshed only once
+    static std::vector<TopoDS_Shape> meshingUnits(Span<const TopoDS_Shape> shapes);
+
+    // Meshes 'shapes' with BRepMesh_IncrementalMesh, meshing units are processed in parallel
+    // with ThreadBudget::parallelFor()
+    // Faces already meshed with a finer deflection are kept as is
+    // Units found in TessellationCache are not meshed, new meshes are stored in the cache
+    // Returns the count of triangles created
+    static int64_t tessellate(
+            Span<const TopoDS_Shape> shapes,
+            const TessellationParameters& params,
+            TaskProgress* progress = nullptr);
+
+    // Guards the triangulations of displayed shapes against their replacement by progressive
+    // tessellation(see GuiTessellationRefiner). Background tasks reading face geometry or
+    // triangulations(eg mass properties, bounding boxes) hold it shared, triangulations are
+    // replaced only while it's held exclusively
+    static std::shared_mutex& triangulationMutex();
+};
+
+} // namespace Mayo
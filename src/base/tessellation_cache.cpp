@@ -0,0 +1,763 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "tessellation_cache.h"
+
+#include "metrics.h"
+
+#include <BRep_Builder.hxx>
+#include <BRep_Tool.hxx>
+#include <BRepAdaptor_Surface.hxx>
+#include <BRepTools.hxx>
+#include <Poly_PolygonOnTriangulation.hxx>
+#include <Poly_Triangulation.hxx>
+#include <Precision.hxx>
+#include <TColStd_Array1OfInteger.hxx>
+#include <TColStd_HArray1OfReal.hxx>
+#include <TopExp.hxx>
+#include <TopExp_Explorer.hxx>
+#include <TopoDS.hxx>
+#include <TopoDS_Edge.hxx>
+#include <TopoDS_Face.hxx>
+#include <TopoDS_Vertex.hxx>
+#include <TopTools_IndexedMapOfShape.hxx>
+
+#include <QtCore/QDateTime>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QSaveFile>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+namespace Mayo {
+
+namespace Internal {
+
+// Binary layout of a cache entry file(native endianness, all blocks 8-bytes aligned) :
+//     TessellationCacheFileHeader
+//     for each face :
+//         TessellationCacheFaceHeader
+//         double[nodeCount * 3] : node coordinates
+//         double[nodeCount * 2] : UV node coordinates(only if hasUvNodes)
+//         int32_t[triangleCount * 3] : node indices(1-based), padded to 8 bytes
+//         for each edge of the face(order of TopExp::MapShapes()) :
+//             TessellationCacheEdgeHeader
+//             for each polygon of the edge(forward then reversed for an edge closed on the face) :
+//                 TessellationCachePolygonHeader
+//                 int32_t[nodeCount] : indices(1-based) of triangulation nodes, padded to 8 bytes
+//                 double[nodeCount] : parameters on the edge curve(only if hasParameters)
+struct TessellationCacheFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t key;
+    uint32_t faceCount;
+    uint32_t edgeCount;
+};
+
+struct TessellationCacheFaceHeader {
+    uint32_t nodeCount;
+    uint32_t triangleCount;
+    uint32_t hasUvNodes;
+    uint32_t edgeCount;
+    double deflection;
+};
+
+struct TessellationCacheEdgeHeader {
+    uint32_t polygonCount; // 0 if the edge has no polygon on the face triangulation
+    uint32_t reserved;
+};
+
+struct TessellationCachePolygonHeader {
+    uint32_t nodeCount;
+    uint32_t hasParameters;
+    double deflection;
+};
+
+// Polygons of an edge on the triangulation of a face
+struct TessellationCacheEdgePolygons {
+    TopoDS_Edge edge;
+    Handle_Poly_PolygonOnTriangulation polygon;
+    Handle_Poly_PolygonOnTriangulation polygonReversed; // Only for an edge closed on the face
+};
+
+static const char tessellationCacheMagic[4] = { 'M', 'T', 'C', 'H' };
+static const uint32_t tessellationCacheVersion = 2;
+
+static QString tessellationCacheFileSuffix() { return QStringLiteral("mtc"); }
+
+struct TessellationCacheState {
+    std::mutex mutex;
+    QString dirPath;
+    uint64_t maxSize = 512 * 1024 * 1024;
+    bool isIndexed = false;
+    uint64_t size = 0;
+    int64_t entryCount = 0;
+    std::atomic<int64_t> hitCount = {};
+    std::atomic<int64_t> missCount = {};
+    std::atomic<int64_t> storeCount = {};
+    std::atomic<int64_t> evictionCount = {};
+};
+
+static TessellationCacheState& tessellationCacheState()
+{
+    static TessellationCacheState state;
+    return state;
+}
+
+// 64bits FNV-1a hash
+class HashFnv1a {
+public:
+    void add(const void* data, size_t len) {
+        auto bytes = reinterpret_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < len; ++i) {
+            m_value ^= bytes[i];
+            m_value *= 1099511628211ull;
+        }
+    }
+
+    template<typename T> void add(T value) {
+        this->add(&value, sizeof(T));
+    }
+
+    void add(const gp_Pnt& pnt) {
+        this->add(pnt.X());
+        this->add(pnt.Y());
+        this->add(pnt.Z());
+    }
+
+    uint64_t value() const { return m_value; }
+
+private:
+    uint64_t m_value = 14695981039346656037ull;
+};
+
+// Signature of the face geometry : surface type, parametric bounds, grid of surface points and
+// boundary vertices
+static void addFaceSignature(HashFnv1a* hash, const TopoDS_Face& face)
+{
+    const BRepAdaptor_Surface surface(face);
+    hash->add(int(surface.GetType()));
+    hash->add(int(face.Orientation()));
+    double u1, u2, v1, v2;
+    BRepTools::UVBounds(face, u1, u2, v1, v2);
+    hash->add(u1);
+    hash->add(u2);
+    hash->add(v1);
+    hash->add(v2);
+    const bool isFinite =
+            !Precision::IsInfinite(u1) && !Precision::IsInfinite(u2)
+            && !Precision::IsInfinite(v1) && !Precision::IsInfinite(v2);
+    if (isFinite) {
+        constexpr int gridSize = 4;
+        for (int i = 0; i < gridSize; ++i) {
+            const double u = u1 + (u2 - u1) * i / (gridSize - 1);
+            for (int j = 0; j < gridSize; ++j) {
+                const double v = v1 + (v2 - v1) * j / (gridSize - 1);
+                hash->add(surface.Value(u, v));
+            }
+        }
+    }
+
+    for (TopExp_Explorer expl(face, TopAbs_VERTEX); expl.More(); expl.Next())
+        hash->add(BRep_Tool::Pnt(TopoDS::Vertex(expl.Current())));
+}
+
+static std::vector<TopoDS_Face> locationLessFaces(const TopoDS_Shape& shape)
+{
+    std::vector<TopoDS_Face> vecFace;
+    for (TopExp_Explorer expl(shape, TopAbs_FACE); expl.More(); expl.Next())
+        vecFace.push_back(TopoDS::Face(expl.Current().Located(TopLoc_Location())));
+
+    return vecFace;
+}
+
+static TopTools_IndexedMapOfShape faceEdges(const TopoDS_Face& face)
+{
+    TopTools_IndexedMapOfShape mapEdge;
+    TopExp::MapShapes(face, TopAbs_EDGE, mapEdge);
+    return mapEdge;
+}
+
+static QString tessellationCacheFilePath(const QString& dirPath, uint64_t key)
+{
+    const QString fileName = QString("%1.%2")
+            .arg(key, 16, 16, QLatin1Char('0'))
+            .arg(tessellationCacheFileSuffix());
+    return QDir(dirPath).filePath(fileName);
+}
+
+static QFileInfoList tessellationCacheFiles(const QString& dirPath)
+{
+    const QStringList nameFilters = { "*." + tessellationCacheFileSuffix() };
+    // Oldest first
+    return QDir(dirPath).entryInfoList(nameFilters, QDir::Files, QDir::Time | QDir::Reversed);
+}
+
+// Requires TessellationCacheState::mutex to be locked
+static void tessellationCacheIndex(TessellationCacheState* state)
+{
+    if (state->isIndexed)
+        return;
+
+    state->size = 0;
+    state->entryCount = 0;
+    for (const QFileInfo& fileInfo : tessellationCacheFiles(state->dirPath)) {
+        state->size += fileInfo.size();
+        ++state->entryCount;
+    }
+
+    state->isIndexed = true;
+}
+
+// Requires TessellationCacheState::mutex to be locked
+static void tessellationCacheEvict(TessellationCacheState* state)
+{
+    static Metrics::Counter& counterEvictions = Metrics::counter("tessellationCache.evictions");
+    if (state->size <= state->maxSize)
+        return;
+
+    // Evict down to 90% of the limit, so eviction doesn't run on every store
+    const uint64_t targetSize = (state->maxSize / 10) * 9;
+    for (const QFileInfo& fileInfo : tessellationCacheFiles(state->dirPath)) {
+        if (state->size <= targetSize)
+            break;
+
+        const uint64_t fileSize = fileInfo.size();
+        if (QFile::remove(fileInfo.absoluteFilePath())) {
+            state->size -= std::min(fileSize, state->size);
+            --state->entryCount;
+            ++state->evictionCount;
+            counterEvictions.add();
+        }
+    }
+}
+
+static void tessellationCacheUpdateGauge(const TessellationCacheState& state)
+{
+    static Metrics::Gauge& gaugeSize = Metrics::gauge("tessellationCache.sizeBytes");
+    gaugeSize.set(double(state.size));
+}
+
+class BufferReader {
+public:
+    BufferReader(const uchar* data, qint64 size)
+        : m_data(data), m_size(size)
+    {}
+
+    bool read(void* dst, qint64 len) {
+        if (m_pos + len > m_size)
+            return false;
+
+        std::memcpy(dst, m_data + m_pos, len);
+        m_pos += len;
+        return true;
+    }
+
+    bool skip(qint64 len) {
+        if (m_pos + len > m_size)
+            return false;
+
+        m_pos += len;
+        return true;
+    }
+
+private:
+    const uchar* m_data;
+    qint64 m_size;
+    qint64 m_pos = 0;
+};
+
+static qint64 paddingTo8(qint64 len)
+{
+    return (8 - (len % 8)) % 8;
+}
+
+static Handle_Poly_Triangulation readTriangulation(
+        BufferReader* reader, const TessellationCacheFaceHeader& faceHeader)
+{
+    const int nodeCount = int(faceHeader.nodeCount);
+    const int triangleCount = int(faceHeader.triangleCount);
+    if (nodeCount <= 0 || triangleCount <= 0)
+        return {};
+
+    Handle_Poly_Triangulation triangulation =
+            new Poly_Triangulation(nodeCount, triangleCount, faceHeader.hasUvNodes != 0);
+    TColgp_Array1OfPnt& vecNode = triangulation->ChangeNodes();
+    for (int i = 1; i <= nodeCount; ++i) {
+        double coords[3];
+        if (!reader->read(coords, sizeof(coords)))
+            return {};
+
+        vecNode.ChangeValue(i).SetCoord(coords[0], coords[1], coords[2]);
+    }
+
+    if (faceHeader.hasUvNodes) {
+        TColgp_Array1OfPnt2d& vecUvNode = triangulation->ChangeUVNodes();
+        for (int i = 1; i <= nodeCount; ++i) {
+            double coords[2];
+            if (!reader->read(coords, sizeof(coords)))
+                return {};
+
+            vecUvNode.ChangeValue(i).SetCoord(coords[0], coords[1]);
+        }
+    }
+
+    Poly_Array1OfTriangle& vecTriangle = triangulation->ChangeTriangles();
+    for (int i = 1; i <= triangleCount; ++i) {
+        int32_t indices[3];
+        if (!reader->read(indices, sizeof(indices)))
+            return {};
+
+        for (int32_t index : indices) {
+            if (index < 1 || index > nodeCount)
+                return {};
+        }
+
+        vecTriangle.ChangeValue(i).Set(indices[0], indices[1], indices[2]);
+    }
+
+    if (!reader->skip(paddingTo8(qint64(triangleCount) * 3 * sizeof(int32_t))))
+        return {};
+
+    triangulation->Deflection(faceHeader.deflection);
+    return triangulation;
+}
+
+// Indices of polygon nodes must be valid in a triangulation having 'triangulationNodeCount' nodes
+static Handle_Poly_PolygonOnTriangulation readPolygon(
+        BufferReader* reader, int triangulationNodeCount)
+{
+    TessellationCachePolygonHeader polygonHeader;
+    if (!reader->read(&polygonHeader, sizeof(polygonHeader)))
+        return {};
+
+    const int nodeCount = int(polygonHeader.nodeCount);
+    if (nodeCount < 2 || nodeCount > triangulationNodeCount)
+        return {};
+
+    TColStd_Array1OfInteger vecNodeIndex(1, nodeCount);
+    for (int i = 1; i <= nodeCount; ++i) {
+        int32_t index;
+        if (!reader->read(&index, sizeof(index)))
+            return {};
+
+        if (index < 1 || index > triangulationNodeCount)
+            return {};
+
+        vecNodeIndex.ChangeValue(i) = index;
+    }
+
+    if (!reader->skip(paddingTo8(qint64(nodeCount) * sizeof(int32_t))))
+        return {};
+
+    Handle_Poly_PolygonOnTriangulation polygon;
+    if (polygonHeader.hasParameters) {
+        TColStd_Array1OfReal vecParam(1, nodeCount);
+        for (int i = 1; i <= nodeCount; ++i) {
+            if (!reader->read(&vecParam.ChangeValue(i), sizeof(double)))
+                return {};
+        }
+
+        polygon = new Poly_PolygonOnTriangulation(vecNodeIndex, vecParam);
+    }
+    else {
+        polygon = new Poly_PolygonOnTriangulation(vecNodeIndex);
+    }
+
+    polygon->Deflection(polygonHeader.deflection);
+    return polygon;
+}
+
+// Reads the triangulation of 'face' along with the polygons of its edges
+// Returns false if the entry data doesn't match the topology of 'face'
+static bool readFace(
+        BufferReader* reader,
+        const TopoDS_Face& face,
+        Handle_Poly_Triangulation* ptrTriangulation,
+        std::vector<TessellationCacheEdgePolygons>* ptrVecEdgePolygons)
+{
+    TessellationCacheFaceHeader faceHeader;
+    if (!reader->read(&faceHeader, sizeof(faceHeader)))
+        return false;
+
+    const TopTools_IndexedMapOfShape mapEdge = faceEdges(face);
+    if (faceHeader.edgeCount != uint32_t(mapEdge.Extent()))
+        return false;
+
+    *ptrTriangulation = readTriangulation(reader, faceHeader);
+    if (ptrTriangulation->IsNull())
+        return false;
+
+    const int triangulationNodeCount = (*ptrTriangulation)->NbNodes();
+    for (int i = 1; i <= mapEdge.Extent(); ++i) {
+        TessellationCacheEdgeHeader edgeHeader;
+        if (!reader->read(&edgeHeader, sizeof(edgeHeader)))
+            return false;
+
+        if (edgeHeader.polygonCount == 0)
+            continue;
+
+        const TopoDS_Edge edge = TopoDS::Edge(mapEdge.FindKey(i).Oriented(TopAbs_FORWARD));
+        const uint32_t expectedPolygonCount = BRep_Tool::IsClosed(edge, face) ? 2 : 1;
+        if (edgeHeader.polygonCount != expectedPolygonCount)
+            return false;
+
+        TessellationCacheEdgePolygons edgePolygons;
+        edgePolygons.edge = edge;
+        edgePolygons.polygon = readPolygon(reader, triangulationNodeCount);
+        if (edgePolygons.polygon.IsNull())
+            return false;
+
+        if (expectedPolygonCount == 2) {
+            edgePolygons.polygonReversed = readPolygon(reader, triangulationNodeCount);
+            if (edgePolygons.polygonReversed.IsNull())
+                return false;
+        }
+
+        ptrVecEdgePolygons->push_back(std::move(edgePolygons));
+    }
+
+    return true;
+}
+
+static void writeTriangulation(
+        QByteArray* buffer,
+        const Handle_Poly_Triangulation& triangulation,
+        const TopLoc_Location& loc,
+        uint32_t edgeCount)
+{
+    auto fnAppend = [=](const void* data, int len) {
+        buffer->append(reinterpret_cast<const char*>(data), len);
+    };
+
+    TessellationCacheFaceHeader faceHeader = {};
+    faceHeader.nodeCount = triangulation->NbNodes();
+    faceHeader.triangleCount = triangulation->NbTriangles();
+    faceHeader.hasUvNodes = triangulation->HasUVNodes() ? 1 : 0;
+    faceHeader.edgeCount = edgeCount;
+    faceHeader.deflection = triangulation->Deflection();
+    fnAppend(&faceHeader, sizeof(faceHeader));
+
+    const gp_Trsf& trsf = loc.Transformation();
+    for (const gp_Pnt& node : triangulation->Nodes()) {
+        const gp_Pnt pnt = loc.IsIdentity() ? node : node.Transformed(trsf);
+        const double coords[] = { pnt.X(), pnt.Y(), pnt.Z() };
+        fnAppend(coords, sizeof(coords));
+    }
+
+    if (triangulation->HasUVNodes()) {
+        for (const gp_Pnt2d& uvNode : triangulation->UVNodes()) {
+            const double coords[] = { uvNode.X(), uvNode.Y() };
+            fnAppend(coords, sizeof(coords));
+        }
+    }
+
+    for (const Poly_Triangle& triangle : triangulation->Triangles()) {
+        int n1, n2, n3;
+        triangle.Get(n1, n2, n3);
+        const int32_t indices[] = { n1, n2, n3 };
+        fnAppend(indices, sizeof(indices));
+    }
+
+    const qint64 padding = paddingTo8(qint64(faceHeader.triangleCount) * 3 * sizeof(int32_t));
+    buffer->append(int(padding), '\0');
+}
+
+static void writePolygon(QByteArray* buffer, const Handle_Poly_PolygonOnTriangulation& polygon)
+{
+    auto fnAppend = [=](const void* data, int len) {
+        buffer->append(reinterpret_cast<const char*>(data), len);
+    };
+
+    TessellationCachePolygonHeader polygonHeader = {};
+    polygonHeader.nodeCount = polygon->NbNodes();
+    polygonHeader.hasParameters = polygon->HasParameters() ? 1 : 0;
+    polygonHeader.deflection = polygon->Deflection();
+    fnAppend(&polygonHeader, sizeof(polygonHeader));
+
+    for (int index : polygon->Nodes()) {
+        const int32_t index32 = index;
+        fnAppend(&index32, sizeof(index32));
+    }
+
+    const qint64 padding = paddingTo8(qint64(polygonHeader.nodeCount) * sizeof(int32_t));
+    buffer->append(int(padding), '\0');
+    if (polygon->HasParameters()) {
+        for (double param : polygon->Parameters()->Array1())
+            fnAppend(&param, sizeof(param));
+    }
+}
+
+// Writes the triangulation of 'face' along with the polygons of its edges
+// Returns false if 'face' isn't triangulated
+static bool writeFace(QByteArray* buffer, const TopoDS_Face& face)
+{
+    TopLoc_Location loc;
+    const Handle_Poly_Triangulation& triangulation = BRep_Tool::Triangulation(face, loc);
+    if (triangulation.IsNull())
+        return false;
+
+    const TopTools_IndexedMapOfShape mapEdge = faceEdges(face);
+    writeTriangulation(buffer, triangulation, loc, uint32_t(mapEdge.Extent()));
+    for (int i = 1; i <= mapEdge.Extent(); ++i) {
+        const TopoDS_Edge edge = TopoDS::Edge(mapEdge.FindKey(i).Oriented(TopAbs_FORWARD));
+        const Handle_Poly_PolygonOnTriangulation polygon =
+                BRep_Tool::PolygonOnTriangulation(edge, triangulation, loc);
+        Handle_Poly_PolygonOnTriangulation polygonReversed;
+        const bool isClosed = BRep_Tool::IsClosed(edge, face);
+        if (isClosed) {
+            polygonReversed = BRep_Tool::PolygonOnTriangulation(
+                        TopoDS::Edge(edge.Reversed()), triangulation, loc);
+        }
+
+        TessellationCacheEdgeHeader edgeHeader = {};
+        if (!polygon.IsNull() && (!isClosed || !polygonReversed.IsNull()))
+            edgeHeader.polygonCount = isClosed ? 2 : 1;
+
+        buffer->append(reinterpret_cast<const char*>(&edgeHeader), sizeof(edgeHeader));
+        if (edgeHeader.polygonCount > 0)
+            writePolygon(buffer, polygon);
+
+        if (edgeHeader.polygonCount > 1)
+            writePolygon(buffer, polygonReversed);
+    }
+
+    return true;
+}
+
+} // namespace Internal
+
+bool TessellationCache::isEnabled()
+{
+    return !TessellationCache::directory().isEmpty();
+}
+
+QString TessellationCache::directory()
+{
+    Internal::TessellationCacheState& state = Internal::tessellationCacheState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    return state.dirPath;
+}
+
+void TessellationCache::setDirectory(const QString& dirPath)
+{
+    Internal::TessellationCacheState& state = Internal::tessellationCacheState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (dirPath == state.dirPath)
+        return;
+
+    if (!dirPath.isEmpty())
+        QDir().mkpath(dirPath);
+
+    state.dirPath = dirPath;
+    state.isIndexed = false;
+}
+
+uint64_t TessellationCache::maxSize()
+{
+    Internal::TessellationCacheState& state = Internal::tessellationCacheState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    return state.maxSize;
+}
+
+void TessellationCache::setMaxSize(uint64_t bytes)
+{
+    Internal::TessellationCacheState& state = Internal::tessellationCacheState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.maxSize = bytes;
+    if (!state.dirPath.isEmpty()) {
+        Internal::tessellationCacheIndex(&state);
+        Internal::tessellationCacheEvict(&state);
+        Internal::tessellationCacheUpdateGauge(state);
+    }
+}
+
+uint64_t TessellationCache::shapeKey(
+        const TopoDS_Shape& shape, double linDeflection, double angDeflection)
+{
+    Internal::HashFnv1a hash;
+    hash.add(Internal::tessellationCacheVersion);
+    hash.add(linDeflection);
+    hash.add(angDeflection);
+    for (TopExp_Explorer expl(shape, TopAbs_FACE); expl.More(); expl.Next())
+        Internal::addFaceSignature(&hash, TopoDS::Face(expl.Current()));
+
+    return hash.value();
+}
+
+bool TessellationCache::load(uint64_t key, const TopoDS_Shape& shape)
+{
+    static Metrics::Counter& counterHits = Metrics::counter("tessellationCache.hits");
+    static Metrics::Counter& counterMisses = Metrics::counter("tessellationCache.misses");
+    Internal::TessellationCacheState& state = Internal::tessellationCacheState();
+    auto fnMiss = [&]{
+        ++state.missCount;
+        counterMisses.add();
+        return false;
+    };
+
+    const QString dirPath = TessellationCache::directory();
+    if (dirPath.isEmpty())
+        return fnMiss();
+
+    QFile file(Internal::tessellationCacheFilePath(dirPath, key));
+    if (!file.open(QIODevice::ReadOnly))
+        return fnMiss();
+
+    const qint64 fileSize = file.size();
+    const uchar* fileData = file.map(0, fileSize);
+    if (!fileData)
+        return fnMiss();
+
+    Internal::BufferReader reader(fileData, fileSize);
+    Internal::TessellationCacheFileHeader fileHeader;
+    if (!reader.read(&fileHeader, sizeof(fileHeader))
+            || std::memcmp(fileHeader.magic, Internal::tessellationCacheMagic, 4) != 0
+            || fileHeader.version != Internal::tessellationCacheVersion
+            || fileHeader.key != key)
+    {
+        return fnMiss();
+    }
+
+    // Entry must match the topology of 'shape', in case of a key collision
+    const std::vector<TopoDS_Face> vecFace = Internal::locationLessFaces(shape);
+    TopTools_IndexedMapOfShape mapEdge;
+    TopExp::MapShapes(shape, TopAbs_EDGE, mapEdge);
+    if (fileHeader.faceCount != vecFace.size()
+            || fileHeader.edgeCount != uint32_t(mapEdge.Extent()))
+    {
+        return fnMiss();
+    }
+
+    // Shape is updated only once all triangulations and edge polygons are successfully read
+    std::vector<Handle_Poly_Triangulation> vecTriangulation(vecFace.size());
+    std::vector<std::vector<Internal::TessellationCacheEdgePolygons>> vecFaceEdgePolygons(
+                vecFace.size());
+    for (size_t i = 0; i < vecFace.size(); ++i) {
+        const bool ok = Internal::readFace(
+                    &reader, vecFace.at(i), &vecTriangulation.at(i), &vecFaceEdgePolygons.at(i));
+        if (!ok)
+            return fnMiss();
+    }
+
+    BRep_Builder builder;
+    for (size_t i = 0; i < vecFace.size(); ++i) {
+        const Handle_Poly_Triangulation& triangulation = vecTriangulation.at(i);
+        builder.UpdateFace(vecFace.at(i), triangulation);
+        // Face has no location, so polygons are attached with identity location
+        const TopLoc_Location loc;
+        for (const Internal::TessellationCacheEdgePolygons& edgePolys : vecFaceEdgePolygons.at(i)) {
+            if (edgePolys.polygonReversed.IsNull()) {
+                builder.UpdateEdge(edgePolys.edge, edgePolys.polygon, triangulation, loc);
+            }
+            else {
+                builder.UpdateEdge(
+                            edgePolys.edge,
+                            edgePolys.polygon,
+                            edgePolys.polygonReversed,
+                            triangulation,
+                            loc);
+            }
+        }
+    }
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+    // Modification time is used as "last used" time for eviction
+    file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+#endif
+    ++state.hitCount;
+    counterHits.add();
+    return true;
+}
+
+bool TessellationCache::store(uint64_t key, const TopoDS_Shape& shape)
+{
+    static Metrics::Counter& counterStores = Metrics::counter("tessellationCache.stores");
+    const std::vector<TopoDS_Face> vecFace = Internal::locationLessFaces(shape);
+    if (vecFace.empty())
+        return false;
+
+    QByteArray buffer;
+    Internal::TessellationCacheFileHeader fileHeader = {};
+    std::memcpy(fileHeader.magic, Internal::tessellationCacheMagic, 4);
+    fileHeader.version = Internal::tessellationCacheVersion;
+    fileHeader.key = key;
+    fileHeader.faceCount = uint32_t(vecFace.size());
+    TopTools_IndexedMapOfShape mapEdge;
+    TopExp::MapShapes(shape, TopAbs_EDGE, mapEdge);
+    fileHeader.edgeCount = uint32_t(mapEdge.Extent());
+    buffer.append(reinterpret_cast<const char*>(&fileHeader), sizeof(fileHeader));
+    for (const TopoDS_Face& face : vecFace) {
+        if (!Internal::writeFace(&buffer, face))
+            return false;
+    }
+
+    Internal::TessellationCacheState& state = Internal::tessellationCacheState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (state.dirPath.isEmpty())
+        return false;
+
+    Internal::tessellationCacheIndex(&state);
+    const QString filePath = Internal::tessellationCacheFilePath(state.dirPath, key);
+    const QFileInfo fileInfo(filePath);
+    const uint64_t replacedSize = fileInfo.exists() ? fileInfo.size() : 0;
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    file.write(buffer);
+    if (!file.commit())
+        return false;
+
+    if (replacedSize == 0)
+        ++state.entryCount;
+
+    state.size = state.size - std::min(replacedSize, state.size) + buffer.size();
+    ++state.storeCount;
+    counterStores.add();
+    Internal::tessellationCacheEvict(&state);
+    Internal::tessellationCacheUpdateGauge(state);
+    return true;
+}
+
+void TessellationCache::clear()
+{
+    Internal::TessellationCacheState& state = Internal::tessellationCacheState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (state.dirPath.isEmpty())
+        return;
+
+    for (const QFileInfo& fileInfo : Internal::tessellationCacheFiles(state.dirPath))
+        QFile::remove(fileInfo.absoluteFilePath());
+
+    state.size = 0;
+    state.entryCount = 0;
+    state.isIndexed = true;
+    Internal::tessellationCacheUpdateGauge(state);
+}
+
+TessellationCache::Statistics TessellationCache::statistics()
+{
+    Internal::TessellationCacheState& state = Internal::tessellationCacheState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (!state.dirPath.isEmpty())
+        Internal::tessellationCacheIndex(&state);
+
+    Statistics stats = {};
+    stats.hitCount = state.hitCount.load();
+    stats.missCount = state.missCount.load();
+    stats.storeCount = state.storeCount.load();
+    stats.evictionCount = state.evictionCount.load();
+    stats.entryCount = state.entryCount;
+    stats.size = state.size;
+    return stats;
+}
+
+} // namespace Mayo
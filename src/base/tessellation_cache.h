@@ -0,0 +1,60 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include <QtCore/QString>
+#include <TopoDS_Shape.hxx>
+#include <cstdint>
+
+namespace Mayo {
+
+// Persistent on-disk cache of face triangulations
+// An entry holds the triangulations of all faces of a meshing unit(see Tessellation::meshingUnits())
+// along with the polygons of their edges on these triangulations
+// and is keyed by a hash of the face geometries combined with the deflection parameters, so it
+// is stable across sessions and independent of the document the shape comes from
+// Each entry is a file made of a fixed header followed by contiguous node/triangle arrays, it is
+// memory-mapped on load
+// The cache is disabled until a directory is set
+class TessellationCache {
+public:
+    static bool isEnabled();
+    static QString directory();
+    static void setDirectory(const QString& dirPath);
+
+    // Once the total size of entries exceeds this limit, least recently used entries are evicted
+    static uint64_t maxSize();
+    static void setMaxSize(uint64_t bytes);
+
+    static uint64_t shapeKey(const TopoDS_Shape& shape, double linDeflection, double angDeflection);
+
+    // Attaches to the faces of 'shape' the triangulations found in entry 'key', and to their edges
+    // the polygons on these triangulations
+    // Returns false if there is no valid entry for 'key' or if it doesn't match the face, edge
+    // and node counts of 'shape'
+    static bool load(uint64_t key, const TopoDS_Shape& shape);
+
+    // Writes the triangulations of the faces of 'shape' and the polygons of their edges as
+    // entry 'key'
+    // Nothing is done if any face is not triangulated
+    static bool store(uint64_t key, const TopoDS_Shape& shape);
+
+    // Removes all entries from the cache directory
+    static void clear();
+
+    struct Statistics {
+        int64_t hitCount;
+        int64_t missCount;
+        int64_t storeCount;
+        int64_t evictionCount;
+        int64_t entryCount;
+        uint64_t size; // Total size in bytes of entries
+    };
+    static Statistics statistics();
+};
+
+} // namespace Mayo
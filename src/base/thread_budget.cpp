@@ -0,0 +1,168 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "thread_budget.h"
+#include "tkernel_utils.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 4, 0)
+#  include <OSD_ThreadPool.hxx>
+#endif
+
+namespace Mayo {
+
+namespace Internal {
+
+static std::atomic<int> threadBudgetCount = {};
+static std::atomic<bool> threadBudgetOccPoolDirty = {};
+static std::mutex threadBudgetOccPoolMutex;
+
+static std::mutex threadBudgetRunSlotMutex;
+static std::condition_variable threadBudgetRunSlotCondition;
+static int threadBudgetRunSlotCount = 0; // Guarded by threadBudgetRunSlotMutex
+static thread_local bool threadBudgetIsRunSlotHeld = false;
+
+} // namespace Internal
+
+int ThreadBudget::threadCount()
+{
+    const int count = Internal::threadBudgetCount.load();
+    return count > 0 ? count : ThreadBudget::hardwareThreadCount();
+}
+
+void ThreadBudget::setThreadCount(int count)
+{
+    Internal::threadBudgetCount.store(std::max(count, 0));
+    Internal::threadBudgetOccPoolDirty.store(true);
+    ThreadBudget::syncOccPool();
+}
+
+int ThreadBudget::hardwareThreadCount()
+{
+    return std::max(1, int(std::thread::hardware_concurrency()));
+}
+
+int ThreadBudget::occPoolThreadCount()
+{
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 4, 0)
+    return OSD_ThreadPool::DefaultPool()->NbThreads();
+#else
+    return ThreadBudget::hardwareThreadCount();
+#endif
+}
+
+bool ThreadBudget::isOccPoolInUse()
+{
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 4, 0)
+    return OSD_ThreadPool::DefaultPool()->IsInUse();
+#else
+    return false;
+#endif
+}
+
+void ThreadBudget::syncOccPool()
+{
+    if (!Internal::threadBudgetOccPoolDirty.load())
+        return;
+
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 4, 0)
+    std::lock_guard<std::mutex> lock(Internal::threadBudgetOccPoolMutex);
+    const opencascade::handle<OSD_ThreadPool>& pool = OSD_ThreadPool::DefaultPool();
+    // OSD_ThreadPool::Init() must not be called while the pool is busy, retry later
+    if (pool->IsInUse())
+        return;
+
+    // NbThreads() includes the calling thread, so the pool itself creates threadCount() - 1 ones
+    const int count = ThreadBudget::threadCount();
+    if (pool->NbThreads() != count)
+        pool->Init(count);
+#endif
+
+    Internal::threadBudgetOccPoolDirty.store(false);
+}
+
+void ThreadBudget::acquireRunSlot(const std::function<bool()>& fnIsAbortRequested)
+{
+    std::unique_lock<std::mutex> lock(Internal::threadBudgetRunSlotMutex);
+    Internal::threadBudgetRunSlotCondition.wait(lock, [&]{
+        return Internal::threadBudgetRunSlotCount < ThreadBudget::threadCount()
+                || (fnIsAbortRequested && fnIsAbortRequested());
+    });
+    ++Internal::threadBudgetRunSlotCount;
+    Internal::threadBudgetIsRunSlotHeld = true;
+}
+
+void ThreadBudget::releaseRunSlot()
+{
+    {
+        std::lock_guard<std::mutex> lock(Internal::threadBudgetRunSlotMutex);
+        --Internal::threadBudgetRunSlotCount;
+        Internal::threadBudgetIsRunSlotHeld = false;
+    }
+
+    // Waiters have distinct abort predicates, any of them may be the one able to proceed
+    Internal::threadBudgetRunSlotCondition.notify_all();
+}
+
+int ThreadBudget::acquiredRunSlotCount()
+{
+    std::lock_guard<std::mutex> lock(Internal::threadBudgetRunSlotMutex);
+    return Internal::threadBudgetRunSlotCount;
+}
+
+void ThreadBudget::notifyRunSlotWaiters(const std::function<void()>& fn)
+{
+    {
+        std::lock_guard<std::mutex> lock(Internal::threadBudgetRunSlotMutex);
+        fn();
+    }
+
+    Internal::threadBudgetRunSlotCondition.notify_all();
+}
+
+ThreadBudget::RunSlotYield::RunSlotYield()
+    : m_isSlotReleased(Internal::threadBudgetIsRunSlotHeld)
+{
+    if (m_isSlotReleased)
+        ThreadBudget::releaseRunSlot();
+}
+
+ThreadBudget::RunSlotYield::~RunSlotYield()
+{
+    if (m_isSlotReleased)
+        ThreadBudget::acquireRunSlot(nullptr);
+}
+
+ThreadBudget::FreeRunSlots::FreeRunSlots(int maxCount)
+{
+    if (maxCount <= 0)
+        return;
+
+    std::lock_guard<std::mutex> lock(Internal::threadBudgetRunSlotMutex);
+    const int freeCount = ThreadBudget::threadCount() - Internal::threadBudgetRunSlotCount;
+    m_count = std::max(0, std::min(maxCount, freeCount));
+    Internal::threadBudgetRunSlotCount += m_count;
+}
+
+ThreadBudget::FreeRunSlots::~FreeRunSlots()
+{
+    if (m_count <= 0)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(Internal::threadBudgetRunSlotMutex);
+        Internal::threadBudgetRunSlotCount -= m_count;
+    }
+
+    Internal::threadBudgetRunSlotCondition.notify_all();
+}
+
+} // namespace Mayo
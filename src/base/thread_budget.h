@@ -0,0 +1,115 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "tkernel_utils.h"
+
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 4, 0)
+#  include <OSD_ThreadPool.hxx>
+#else
+#  include <OSD_Parallel.hxx>
+#endif
+#include <functional>
+
+namespace Mayo {
+
+// Global budget of worker threads, shared by TaskManager(max count of concurrently running
+// tasks) and OpenCascade default thread pool(used by parallelFor())
+// Threads of the pool are counted inside the budget : a parallel loop runs on the calling thread
+// plus the run slots free at the time of the call, so tasks and pool threads together never use
+// more than threadCount() threads
+class ThreadBudget {
+public:
+    // Returns the effective thread count, always >= 1
+    static int threadCount();
+
+    // Sets the thread count, a value <= 0 means "count of hardware threads"
+    // The OpenCascade default pool is reinitialized now, or as soon as it isn't in use anymore
+    static void setThreadCount(int count);
+
+    static int hardwareThreadCount();
+
+    // Usage of the OpenCascade default thread pool
+    static int occPoolThreadCount();
+    static bool isOccPoolInUse();
+
+    // Applies the pending thread count to the OpenCascade default pool if it's possible
+    // The pool then has threadCount() - 1 threads, the calling thread being the last one
+    // This is called by TaskManager each time a task is started
+    static void syncOccPool();
+
+    // Run slots : process-wide count of tasks running at once, whatever their TaskManager
+    // acquireRunSlot() blocks until less than threadCount() slots are acquired, or until
+    // 'fnIsAbortRequested' returns true(the slot is acquired anyway then)
+    static void acquireRunSlot(const std::function<bool()>& fnIsAbortRequested);
+    static void releaseRunSlot();
+    static int acquiredRunSlotCount();
+
+    // Calls fn(i) for each i in [begin, end) in parallel on the OpenCascade default pool
+    // Pool threads are borrowed as free run slots, without waiting. If the budget is used up the
+    // loop runs within the run slot the calling task already holds, ie single-threaded
+    // Note: with OpenCascade < 7.4 the pool can't be limited, the loop is then either
+    //       single-threaded or run with all the OSD_Parallel threads
+    template<typename FUNCTION>
+    static void parallelFor(int begin, int end, const FUNCTION& fn);
+
+    // Calls 'fn' while holding the run slots lock then wakes up the threads waiting for a slot
+    // State checked by 'fnIsAbortRequested'(eg abort flag) must be changed this way, otherwise
+    // the wake up could be missed
+    static void notifyRunSlotWaiters(const std::function<void()>& fn);
+
+    // Gives back the run slot held by the calling thread(if any) for the lifetime of the object
+    // then acquires it again. Meant for a task waiting for child tasks, which otherwise could
+    // never start once the budget is used
+    class RunSlotYield {
+    public:
+        RunSlotYield();
+        ~RunSlotYield();
+
+        RunSlotYield(const RunSlotYield&) = delete;
+        RunSlotYield& operator=(const RunSlotYield&) = delete;
+
+    private:
+        bool m_isSlotReleased = false;
+    };
+
+    // Acquires up to 'maxCount' run slots among the free ones without waiting, for the lifetime
+    // of the object
+    class FreeRunSlots {
+    public:
+        explicit FreeRunSlots(int maxCount);
+        ~FreeRunSlots();
+
+        FreeRunSlots(const FreeRunSlots&) = delete;
+        FreeRunSlots& operator=(const FreeRunSlots&) = delete;
+
+        int count() const { return m_count; }
+
+    private:
+        int m_count = 0;
+    };
+};
+
+
+
+// --
+// -- Implementation
+// --
+
+template<typename FUNCTION>
+void ThreadBudget::parallelFor(int begin, int end, const FUNCTION& fn)
+{
+    const FreeRunSlots extraSlots(end - begin - 1);
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 4, 0)
+    OSD_ThreadPool::Launcher launcher(*OSD_ThreadPool::DefaultPool(), extraSlots.count() + 1);
+    launcher.Perform(begin, end, [&](int /*threadIndex*/, int i) { fn(i); });
+#else
+    OSD_Parallel::For(begin, end, fn, extraSlots.count() == 0);
+#endif
+}
+
+} // namespace Mayo
@@ -0,0 +1,190 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "tracing.h"
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QFile>
+#include <chrono>
+#include <mutex>
+
+namespace Mayo {
+
+namespace Internal {
+
+struct TracingData {
+    std::mutex mutex;
+    std::vector<Tracing::Event> vecEvent;
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+};
+
+static TracingData& tracingData()
+{
+    static TracingData data;
+    return data;
+}
+
+static int tracingThreadId()
+{
+    static std::atomic<int> nextId = {};
+    thread_local const int id = ++nextId;
+    return id;
+}
+
+static void appendJsonString(QByteArray* dst, const QByteArray& str)
+{
+    dst->append('"');
+    for (const char c : str) {
+        switch (c) {
+        case '"': dst->append("\\\""); break;
+        case '\\': dst->append("\\\\"); break;
+        case '\n': dst->append("\\n"); break;
+        case '\r': dst->append("\\r"); break;
+        case '\t': dst->append("\\t"); break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20)
+                dst->append(QByteArray("\\u00") + QByteArray::number(int(c), 16).rightJustified(2, '0'));
+            else
+                dst->append(c);
+        }
+    }
+
+    dst->append('"');
+}
+
+} // namespace Internal
+
+std::atomic<bool>& Tracing::enabledFlag()
+{
+    static std::atomic<bool> flag = {};
+    return flag;
+}
+
+void Tracing::setEnabled(bool on)
+{
+    if (on && !Tracing::isEnabled()) {
+        auto& data = Internal::tracingData();
+        std::lock_guard<std::mutex> lock(data.mutex);
+        if (data.vecEvent.empty())
+            data.startTime = std::chrono::steady_clock::now();
+    }
+
+    Tracing::enabledFlag().store(on, std::memory_order_relaxed);
+}
+
+void Tracing::beginEvent(const char* category, const QByteArray& name)
+{
+    if (Tracing::isEnabled())
+        Tracing::addEvent(category, Phase::Begin, name);
+}
+
+void Tracing::beginEvent(const char* category, const QString& name)
+{
+    if (Tracing::isEnabled())
+        Tracing::addEvent(category, Phase::Begin, name.toUtf8());
+}
+
+void Tracing::endEvent(const char* category)
+{
+    if (Tracing::isEnabled())
+        Tracing::addEvent(category, Phase::End, QByteArray());
+}
+
+void Tracing::instantEvent(const char* category, const QByteArray& name)
+{
+    if (Tracing::isEnabled())
+        Tracing::addEvent(category, Phase::Instant, name);
+}
+
+std::vector<Tracing::Event> Tracing::events()
+{
+    auto& data = Internal::tracingData();
+    std::lock_guard<std::mutex> lock(data.mutex);
+    return data.vecEvent;
+}
+
+void Tracing::clear()
+{
+    auto& data = Internal::tracingData();
+    std::lock_guard<std::mutex> lock(data.mutex);
+    data.vecEvent.clear();
+    data.startTime = std::chrono::steady_clock::now();
+}
+
+QByteArray Tracing::toChromeTraceJson(const std::vector<Event>& events)
+{
+    const QByteArray strPid = QByteArray::number(QCoreApplication::applicationPid());
+    QByteArray json;
+    json.reserve(int(events.size()) * 96 + 64);
+    json.append("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    bool isFirst = true;
+    for (const Event& event : events) {
+        if (!isFirst)
+            json.append(",\n");
+
+        json.append("{\"name\":");
+        Internal::appendJsonString(&json, event.name);
+        json.append(",\"cat\":");
+        Internal::appendJsonString(&json, event.category ? event.category : "");
+        json.append(",\"ph\":\"").append(static_cast<char>(event.phase)).append('"');
+        json.append(",\"ts\":").append(QByteArray::number(qint64(event.timestampUs)));
+        json.append(",\"pid\":").append(strPid);
+        json.append(",\"tid\":").append(QByteArray::number(event.threadId));
+        if (event.phase == Phase::Instant)
+            json.append(",\"s\":\"t\"");
+
+        json.append('}');
+        isFirst = false;
+    }
+
+    json.append("]}\n");
+    return json;
+}
+
+bool Tracing::writeChromeTraceFile(const QString& filepath)
+{
+    QFile file(filepath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    const QByteArray json = Tracing::toChromeTraceJson(Tracing::events());
+    return file.write(json) == json.size();
+}
+
+void Tracing::addEvent(const char* category, Phase phase, const QByteArray& name)
+{
+    const auto now = std::chrono::steady_clock::now();
+    const int threadId = Internal::tracingThreadId();
+    auto& data = Internal::tracingData();
+    std::lock_guard<std::mutex> lock(data.mutex);
+    const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(now - data.startTime);
+    data.vecEvent.push_back({ name, category, phase, int64_t(elapsed.count()), threadId });
+}
+
+TracingScope::TracingScope(const char* category, const char* name)
+    : m_category(category),
+      m_active(Tracing::isEnabled())
+{
+    if (m_active)
+        Tracing::beginEvent(category, QByteArray(name));
+}
+
+TracingScope::TracingScope(const char* category, const QString& name)
+    : m_category(category),
+      m_active(Tracing::isEnabled())
+{
+    if (m_active)
+        Tracing::beginEvent(category, name);
+}
+
+TracingScope::~TracingScope()
+{
+    // End event is recorded even if tracing was disabled meanwhile, so begin/end stay balanced
+    if (m_active)
+        Tracing::addEvent(m_category, Tracing::Phase::End, QByteArray());
+}
+
+} // namespace Mayo
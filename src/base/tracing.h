@@ -0,0 +1,72 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include <QtCore/QByteArray>
+#include <QtCore/QString>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace Mayo {
+
+// Records timeline events(nested begin/end scopes) from any thread, and exports them in the
+// Chrome Trace Event format(loadable in chrome://tracing or https://ui.perfetto.dev)
+// When tracing is disabled the cost of an event is a single relaxed atomic load
+class Tracing {
+public:
+    enum class Phase : char { Begin = 'B', End = 'E', Instant = 'i' };
+
+    struct Event {
+        QByteArray name;
+        const char* category;
+        Phase phase;
+        int64_t timestampUs; // Microseconds since tracing start
+        int threadId;
+    };
+
+    static bool isEnabled() { return Tracing::enabledFlag().load(std::memory_order_relaxed); }
+    static void setEnabled(bool on);
+
+    static void beginEvent(const char* category, const QByteArray& name);
+    static void beginEvent(const char* category, const QString& name);
+    static void endEvent(const char* category);
+    static void instantEvent(const char* category, const QByteArray& name);
+
+    static std::vector<Event> events();
+    static void clear();
+
+    static QByteArray toChromeTraceJson(const std::vector<Event>& events);
+    static bool writeChromeTraceFile(const QString& filepath);
+
+private:
+    friend class TracingScope;
+    static std::atomic<bool>& enabledFlag();
+    static void addEvent(const char* category, Phase phase, const QByteArray& name);
+};
+
+// RAII helper emitting a begin event on construction and the matching end event on destruction
+class TracingScope {
+public:
+    TracingScope(const char* category, const char* name);
+    TracingScope(const char* category, const QString& name);
+    ~TracingScope();
+
+    TracingScope(const TracingScope&) = delete;
+    TracingScope& operator=(const TracingScope&) = delete;
+
+private:
+    const char* m_category;
+    bool m_active;
+};
+
+} // namespace Mayo
+
+#define MAYO_TRACING_CAT2(x, y) x##y
+#define MAYO_TRACING_CAT(x, y) MAYO_TRACING_CAT2(x, y)
+#define MAYO_TRACE_SCOPE(category, name) \
+    Mayo::TracingScope MAYO_TRACING_CAT(tracingScope_, __LINE__)(category, name)
@@ -0,0 +1,58 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "ais_hlr_lines.h"
+
+#include <Graphic3d_ArrayOfSegments.hxx>
+#include <Graphic3d_AspectLine3d.hxx>
+#include <Graphic3d_Group.hxx>
+
+namespace Mayo {
+
+namespace Internal {
+
+static void hlrLinesAddGroup(
+        const Handle_Prs3d_Presentation& pres,
+        const std::vector<gp_Pnt>& vecPoint,
+        const Handle_Graphic3d_AspectLine3d& aspect)
+{
+    if (vecPoint.empty())
+        return;
+
+    Handle_Graphic3d_ArrayOfSegments segments = new Graphic3d_ArrayOfSegments(int(vecPoint.size()));
+    for (const gp_Pnt& pnt : vecPoint)
+        segments->AddVertex(pnt);
+
+    Handle_Graphic3d_Group group = pres->NewGroup();
+    group->SetGroupPrimitivesAspect(aspect);
+    group->AddPrimitiveArray(segments);
+}
+
+} // namespace Internal
+
+void AIS_HlrLines::ComputeSelection(const opencascade::handle<SelectMgr_Selection>&, const int)
+{
+}
+
+void AIS_HlrLines::Compute(
+        const opencascade::handle<PrsMgr_PresentationManager3d>&,
+        const opencascade::handle<Prs3d_Presentation>& pres,
+        const int)
+{
+    if (!m_result)
+        return;
+
+    Internal::hlrLinesAddGroup(
+                pres,
+                m_result->vecHiddenPoint,
+                new Graphic3d_AspectLine3d(Quantity_NOC_GRAY50, Aspect_TOL_DASH, 1.));
+    Internal::hlrLinesAddGroup(
+                pres,
+                m_result->vecVisiblePoint,
+                new Graphic3d_AspectLine3d(Quantity_NOC_BLACK, Aspect_TOL_SOLID, 1.5));
+}
+
+} // namespace Mayo
@@ -0,0 +1,61 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "../base/tkernel_utils.h"
+#include "graphics_hlr.h"
+
+#include <AIS_InteractiveObject.hxx>
+#include <Prs3d_Presentation.hxx>
+#include <PrsMgr_PresentationManager3d.hxx>
+#include <SelectMgr_Selection.hxx>
+#include <memory>
+
+#if OCC_VERSION_HEX < OCC_VERSION_CHECK(7, 5, 0)
+#  include <Prs3d_Projector.hxx>
+#endif
+
+namespace Mayo {
+
+class AIS_HlrLines;
+DEFINE_STANDARD_HANDLE(AIS_HlrLines, AIS_InteractiveObject)
+
+// Displays the lines computed by GraphicsHlr : visible lines solid, hidden lines dashed
+// Result is shared(eg with a cache), it's not copied. Not selectable
+class AIS_HlrLines : public AIS_InteractiveObject {
+public:
+    using ResultPtr = std::shared_ptr<const GraphicsHlr::Result>;
+
+    const ResultPtr& result() const { return m_result; }
+    void setResult(const ResultPtr& result) { m_result = result; }
+
+    bool AcceptDisplayMode(const int mode) const override { return mode == 0; }
+
+    void ComputeSelection(
+            const opencascade::handle<SelectMgr_Selection>& sel,
+            const int mode) override;
+
+    DEFINE_STANDARD_RTTI_INLINE(AIS_HlrLines, AIS_InteractiveObject)
+
+protected:
+    void Compute(
+            const opencascade::handle<PrsMgr_PresentationManager3d>& pm,
+            const opencascade::handle<Prs3d_Presentation>& pres,
+            const int mode) override;
+
+#if OCC_VERSION_HEX < OCC_VERSION_CHECK(7, 5, 0)
+    void Compute(
+            const opencascade::handle<Prs3d_Projector>&,
+            const opencascade::handle<Prs3d_Presentation>&) override
+    {}
+#endif
+
+private:
+    ResultPtr m_result;
+};
+
+} // namespace Mayo
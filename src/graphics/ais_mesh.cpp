@@ -0,0 +1,231 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "ais_mesh.h"
+
+#include "../base/mesh_normals.h"
+#include "../base/thread_budget.h"
+#include "../base/tracing.h"
+
+#include <Graphic3d_ArrayOfPoints.hxx>
+#include <Graphic3d_AspectFillArea3d.hxx>
+#include <Graphic3d_AspectMarker3d.hxx>
+#include <Graphic3d_Group.hxx>
+#include <Select3D_SensitiveTriangulation.hxx>
+#include <SelectMgr_EntityOwner.hxx>
+#include <TopLoc_Location.hxx>
+#include <algorithm>
+
+namespace Mayo {
+
+namespace Internal {
+
+static const int meshArrayChunkSize = 64 * 1024;
+
+static int meshArrayChunkCount(int count)
+{
+    return (count + meshArrayChunkSize - 1) / meshArrayChunkSize;
+}
+
+// Position of the vertex attribute 'iAttrib' of 0-based vertex 'i'
+static Graphic3d_Vec3* meshArrayVec3(Graphic3d_Buffer* attribs, int iAttrib, int i)
+{
+    Standard_Byte* data = attribs->ChangeData() + attribs->AttributeOffset(iAttrib);
+    return reinterpret_cast<Graphic3d_Vec3*>(data + size_t(attribs->Stride) * size_t(i));
+}
+
+#if OCC_VERSION_HEX < OCC_VERSION_CHECK(7, 4, 0)
+// Facet shading isn't available, nodes normals are averaged from adjacent triangles
+static void computeMeshArrayNormals(
+        const Handle_Poly_Triangulation& mesh, Graphic3d_Buffer* attribs)
+{
+    const TColgp_Array1OfPnt& nodes = mesh->Nodes();
+    for (int i = 1; i <= mesh->NbTriangles(); ++i) {
+        int n[3];
+        mesh->Triangle(i).Get(n[0], n[1], n[2]);
+        const gp_XYZ v1 = nodes(n[1]).XYZ() - nodes(n[0]).XYZ();
+        const gp_XYZ v2 = nodes(n[2]).XYZ() - nodes(n[0]).XYZ();
+        const gp_XYZ normal = v1 ^ v2; // Weighted by triangle area
+        const Graphic3d_Vec3 vecNormal(float(normal.X()), float(normal.Y()), float(normal.Z()));
+        for (int k = 0; k < 3; ++k)
+            *meshArrayVec3(attribs, 1, n[k] - 1) += vecNormal;
+    }
+
+    ThreadBudget::parallelFor(0, meshArrayChunkCount(mesh->NbNodes()), [=](int iChunk) {
+        const int iEnd = std::min(mesh->NbNodes(), (iChunk + 1) * meshArrayChunkSize);
+        for (int i = iChunk * meshArrayChunkSize; i < iEnd; ++i) {
+            Graphic3d_Vec3* normal = meshArrayVec3(attribs, 1, i);
+            const float length = normal->Modulus();
+            if (length > 0.f)
+                *normal /= length;
+        }
+    });
+}
+#endif
+
+} // namespace Internal
+
+AIS_Mesh::AIS_Mesh(const Handle_Poly_Triangulation& mesh)
+    : m_mesh(mesh)
+{
+}
+
+void AIS_Mesh::setCreaseAngle(double angle)
+{
+    m_creaseAngle = angle;
+    m_triangles.Nullify();
+}
+
+const Handle_Graphic3d_ArrayOfTriangles& AIS_Mesh::trianglesArray()
+{
+    if (!m_triangles.IsNull() || m_mesh.IsNull())
+        return m_triangles;
+
+    MAYO_TRACE_SCOPE("graphics", "AIS_Mesh::trianglesArray");
+    using namespace Internal;
+    // Selection and nodes keep the welded mesh
+    const Handle_Poly_Triangulation mesh =
+            m_creaseAngle >= 0. ? MeshNormals::computeSmooth(m_mesh, m_creaseAngle) : m_mesh;
+    const int nodeCount = mesh->NbNodes();
+    const int triangleCount = mesh->NbTriangles();
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 4, 0)
+    const bool hasNormals = mesh->HasNormals();
+#else
+    const bool hasNormals = true;
+#endif
+    Handle_Graphic3d_ArrayOfTriangles triangles =
+            new Graphic3d_ArrayOfTriangles(nodeCount, 3 * triangleCount, hasNormals);
+
+    // Element counts are set first, so vertices and indices can be written concurrently
+    Graphic3d_Buffer* attribs = triangles->Attributes().get();
+    Graphic3d_IndexBuffer* indices = triangles->Indices().get();
+    attribs->NbElements = nodeCount;
+    indices->NbElements = 3 * triangleCount;
+
+    ThreadBudget::parallelFor(0, meshArrayChunkCount(nodeCount), [=](int iChunk) {
+        const TColgp_Array1OfPnt& nodes = mesh->Nodes();
+        const int iEnd = std::min(nodeCount, (iChunk + 1) * meshArrayChunkSize);
+        for (int i = iChunk * meshArrayChunkSize; i < iEnd; ++i) {
+            const gp_Pnt& node = nodes(nodes.Lower() + i);
+            *meshArrayVec3(attribs, 0, i) =
+                    Graphic3d_Vec3(float(node.X()), float(node.Y()), float(node.Z()));
+        }
+
+        if (!mesh->HasNormals())
+            return;
+
+        const TShort_Array1OfShortReal& normals = mesh->Normals();
+        for (int i = iChunk * meshArrayChunkSize; i < iEnd; ++i) {
+            const int iCoord = normals.Lower() + 3 * i;
+            *meshArrayVec3(attribs, 1, i) =
+                    Graphic3d_Vec3(normals(iCoord), normals(iCoord + 1), normals(iCoord + 2));
+        }
+    });
+
+    ThreadBudget::parallelFor(0, meshArrayChunkCount(triangleCount), [=](int iChunk) {
+        const int iEnd = std::min(triangleCount, (iChunk + 1) * meshArrayChunkSize);
+        for (int i = iChunk * meshArrayChunkSize; i < iEnd; ++i) {
+            int n[3];
+            mesh->Triangle(i + 1).Get(n[0], n[1], n[2]);
+            for (int k = 0; k < 3; ++k)
+                indices->SetIndex(3 * i + k, n[k] - 1);
+        }
+    });
+
+#if OCC_VERSION_HEX < OCC_VERSION_CHECK(7, 4, 0)
+    if (!mesh->HasNormals())
+        computeMeshArrayNormals(mesh, attribs);
+#endif
+
+    m_triangles = triangles;
+    return m_triangles;
+}
+
+bool AIS_Mesh::AcceptDisplayMode(const int mode) const
+{
+    return mode == DisplayMode_Wireframe || mode == DisplayMode_Shaded || mode == DisplayMode_Nodes;
+}
+
+void AIS_Mesh::ComputeSelection(const opencascade::handle<SelectMgr_Selection>& sel, const int mode)
+{
+    if (mode != 0 || m_mesh.IsNull() || m_mesh->NbTriangles() == 0)
+        return;
+
+    // Sensitive triangulation refers to the mesh, nodes aren't copied
+    Handle_SelectMgr_EntityOwner owner = new SelectMgr_EntityOwner(this);
+    sel->Add(new Select3D_SensitiveTriangulation(owner, m_mesh, TopLoc_Location(), true));
+}
+
+void AIS_Mesh::Compute(
+        const opencascade::handle<PrsMgr_PresentationManager3d>&,
+        const opencascade::handle<Prs3d_Presentation>& pres,
+        const int mode)
+{
+    if (m_mesh.IsNull())
+        return;
+
+    MAYO_TRACE_SCOPE("graphics", "AIS_Mesh::Compute");
+    const bool hasTriangles = m_mesh->NbTriangles() > 0;
+    if (mode == DisplayMode_Shaded && hasTriangles) {
+        Graphic3d_MaterialAspect material = m_material;
+        material.SetColor(m_color);
+        Handle_Graphic3d_AspectFillArea3d aspect = new Graphic3d_AspectFillArea3d(
+                    Aspect_IS_SOLID, m_color, m_edgeColor, Aspect_TOL_SOLID, 1.,
+                    material, material);
+        if (m_showEdges)
+            aspect->SetEdgeOn();
+        else
+            aspect->SetEdgeOff();
+
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 4, 0)
+        if (!this->trianglesArray()->HasVertexNormals())
+            aspect->SetShadingModel(Graphic3d_TOSM_FACET);
+#endif
+
+        Handle_Graphic3d_Group group = pres->NewGroup();
+        group->SetGroupPrimitivesAspect(aspect);
+        group->AddPrimitiveArray(this->trianglesArray());
+    }
+    else if (mode == DisplayMode_Wireframe && hasTriangles) {
+        // Interior isn't drawn, only the edges of the triangles
+        Handle_Graphic3d_AspectFillArea3d aspect = new Graphic3d_AspectFillArea3d(
+                    Aspect_IS_EMPTY, m_color, m_edgeColor, Aspect_TOL_SOLID, 1.,
+                    m_material, m_material);
+        aspect->SetEdgeOn();
+        Handle_Graphic3d_Group group = pres->NewGroup();
+        group->SetGroupPrimitivesAspect(aspect);
+        group->AddPrimitiveArray(this->trianglesArray());
+    }
+
+    if (mode == DisplayMode_Nodes || m_showNodes)
+        this->addNodes(pres);
+}
+
+void AIS_Mesh::addNodes(const Handle_Prs3d_Presentation& pres) const
+{
+    using namespace Internal;
+    const int nodeCount = m_mesh->NbNodes();
+    Handle_Graphic3d_ArrayOfPoints points = new Graphic3d_ArrayOfPoints(nodeCount);
+    Graphic3d_Buffer* attribs = points->Attributes().get();
+    attribs->NbElements = nodeCount;
+    const Handle_Poly_Triangulation& mesh = m_mesh;
+    ThreadBudget::parallelFor(0, meshArrayChunkCount(nodeCount), [=](int iChunk) {
+        const TColgp_Array1OfPnt& nodes = mesh->Nodes();
+        const int iEnd = std::min(nodeCount, (iChunk + 1) * meshArrayChunkSize);
+        for (int i = iChunk * meshArrayChunkSize; i < iEnd; ++i) {
+            const gp_Pnt& node = nodes(nodes.Lower() + i);
+            *meshArrayVec3(attribs, 0, i) =
+                    Graphic3d_Vec3(float(node.X()), float(node.Y()), float(node.Z()));
+        }
+    });
+
+    Handle_Graphic3d_Group group = pres->NewGroup();
+    group->SetGroupPrimitivesAspect(
+                new Graphic3d_AspectMarker3d(Aspect_TOM_POINT, m_edgeColor, 2.));
+    group->AddPrimitiveArray(points);
+}
+
+} // namespace Mayo
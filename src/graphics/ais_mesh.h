@@ -0,0 +1,104 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "../base/tkernel_utils.h"
+
+#include <AIS_InteractiveObject.hxx>
+#include <Graphic3d_ArrayOfTriangles.hxx>
+#include <Graphic3d_MaterialAspect.hxx>
+#include <Poly_Triangulation.hxx>
+#include <Prs3d_Presentation.hxx>
+#include <PrsMgr_PresentationManager3d.hxx>
+#include <Quantity_Color.hxx>
+#include <SelectMgr_Selection.hxx>
+
+#if OCC_VERSION_HEX < OCC_VERSION_CHECK(7, 5, 0)
+#  include <Prs3d_Projector.hxx>
+#endif
+
+namespace Mayo {
+
+class AIS_Mesh;
+DEFINE_STANDARD_HANDLE(AIS_Mesh, AIS_InteractiveObject)
+
+// Displays a Poly_Triangulation with a single indexed Graphic3d_ArrayOfTriangles, filled in
+// parallel straight from the triangulation nodes(and normals if any)
+// The array is built once and shared by the display modes, edges are drawn from the triangles
+// with the edge aspect so no segment array is needed
+class AIS_Mesh : public AIS_InteractiveObject {
+public:
+    enum DisplayMode {
+        DisplayMode_Wireframe = 0,
+        DisplayMode_Shaded = 1,
+        DisplayMode_Nodes = 2
+    };
+
+    AIS_Mesh(const Handle_Poly_Triangulation& mesh);
+
+    const Handle_Poly_Triangulation& mesh() const { return m_mesh; }
+
+    const Quantity_Color& color() const { return m_color; }
+    void setColor(const Quantity_Color& color) { m_color = color; }
+
+    const Quantity_Color& edgeColor() const { return m_edgeColor; }
+    void setEdgeColor(const Quantity_Color& color) { m_edgeColor = color; }
+
+    const Graphic3d_MaterialAspect& material() const { return m_material; }
+    void setMaterial(const Graphic3d_MaterialAspect& material) { m_material = material; }
+
+    // Triangle edges drawn over shaded mode
+    bool showEdges() const { return m_showEdges; }
+    void setShowEdges(bool on) { m_showEdges = on; }
+
+    // Nodes drawn over wireframe and shaded modes
+    bool showNodes() const { return m_showNodes; }
+    void setShowNodes(bool on) { m_showNodes = on; }
+
+    // Angle used to compute normals at nodes with MeshNormals::computeSmooth(), the array then
+    // gets a split copy of the mesh. Negative to use the normals of the mesh, if any
+    double creaseAngle() const { return m_creaseAngle; }
+    void setCreaseAngle(double angle);
+
+    // Array of the mesh triangles, built on first call
+    const Handle_Graphic3d_ArrayOfTriangles& trianglesArray();
+
+    bool AcceptDisplayMode(const int mode) const override;
+
+    void ComputeSelection(
+            const opencascade::handle<SelectMgr_Selection>& sel,
+            const int mode) override;
+
+    DEFINE_STANDARD_RTTI_INLINE(AIS_Mesh, AIS_InteractiveObject)
+
+protected:
+    void Compute(
+            const opencascade::handle<PrsMgr_PresentationManager3d>& pm,
+            const opencascade::handle<Prs3d_Presentation>& pres,
+            const int mode) override;
+
+#if OCC_VERSION_HEX < OCC_VERSION_CHECK(7, 5, 0)
+    void Compute(
+            const opencascade::handle<Prs3d_Projector>&,
+            const opencascade::handle<Prs3d_Presentation>&) override
+    {}
+#endif
+
+private:
+    void addNodes(const Handle_Prs3d_Presentation& pres) const;
+
+    Handle_Poly_Triangulation m_mesh;
+    Handle_Graphic3d_ArrayOfTriangles m_triangles;
+    Quantity_Color m_color = Quantity_NOC_BISQUE;
+    Quantity_Color m_edgeColor = Quantity_NOC_BLACK;
+    Graphic3d_MaterialAspect m_material = Graphic3d_NOM_PLASTIC;
+    bool m_showEdges = false;
+    bool m_showNodes = false;
+    double m_creaseAngle = -1.;
+};
+
+} // namespace Mayo
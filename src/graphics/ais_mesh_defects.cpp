@@ -0,0 +1,125 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "ais_mesh_defects.h"
+
+#include <Graphic3d_ArrayOfPoints.hxx>
+#include <Graphic3d_ArrayOfSegments.hxx>
+#include <Graphic3d_AspectLine3d.hxx>
+#include <Graphic3d_AspectMarker3d.hxx>
+#include <Graphic3d_Group.hxx>
+#include <Graphic3d_ZLayerId.hxx>
+
+#include <vector>
+
+namespace Mayo {
+
+namespace Internal {
+
+static void addMeshDefectEdges(
+        const Handle_Prs3d_Presentation& pres,
+        const Handle_Poly_Triangulation& mesh,
+        const std::vector<MeshAnalysisResult::Edge>& vecEdge,
+        Quantity_NameOfColor color)
+{
+    if (vecEdge.empty())
+        return;
+
+    Handle_Graphic3d_ArrayOfSegments segments =
+            new Graphic3d_ArrayOfSegments(2 * int(vecEdge.size()));
+    for (const MeshAnalysisResult::Edge& edge : vecEdge) {
+        segments->AddVertex(mesh->Node(edge.node1));
+        segments->AddVertex(mesh->Node(edge.node2));
+    }
+
+    Handle_Graphic3d_Group group = pres->NewGroup();
+    group->SetGroupPrimitivesAspect(new Graphic3d_AspectLine3d(color, Aspect_TOL_SOLID, 3.));
+    group->AddPrimitiveArray(segments);
+}
+
+static void addMeshDefectTriangles(
+        const Handle_Prs3d_Presentation& pres,
+        const Handle_Poly_Triangulation& mesh,
+        const std::vector<int>& vecTriangle,
+        Quantity_NameOfColor color)
+{
+    if (vecTriangle.empty())
+        return;
+
+    Handle_Graphic3d_ArrayOfSegments segments =
+            new Graphic3d_ArrayOfSegments(6 * int(vecTriangle.size()));
+    for (int triangle : vecTriangle) {
+        int n[3];
+        mesh->Triangle(triangle).Get(n[0], n[1], n[2]);
+        for (int i = 0; i < 3; ++i) {
+            segments->AddVertex(mesh->Node(n[i]));
+            segments->AddVertex(mesh->Node(n[(i + 1) % 3]));
+        }
+    }
+
+    Handle_Graphic3d_Group group = pres->NewGroup();
+    group->SetGroupPrimitivesAspect(new Graphic3d_AspectLine3d(color, Aspect_TOL_SOLID, 2.));
+    group->AddPrimitiveArray(segments);
+}
+
+static void addMeshDefectMarkers(
+        const Handle_Prs3d_Presentation& pres,
+        const Handle_Poly_Triangulation& mesh,
+        const std::vector<int>& vecTriangle,
+        Quantity_NameOfColor color)
+{
+    if (vecTriangle.empty())
+        return;
+
+    // Triangles have no visible area, they are shown with a marker at their center
+    Handle_Graphic3d_ArrayOfPoints points = new Graphic3d_ArrayOfPoints(int(vecTriangle.size()));
+    for (int triangle : vecTriangle) {
+        int n[3];
+        mesh->Triangle(triangle).Get(n[0], n[1], n[2]);
+        const gp_XYZ center =
+                (mesh->Node(n[0]).XYZ() + mesh->Node(n[1]).XYZ() + mesh->Node(n[2]).XYZ()) / 3.;
+        points->AddVertex(gp_Pnt(center));
+    }
+
+    Handle_Graphic3d_Group group = pres->NewGroup();
+    group->SetGroupPrimitivesAspect(new Graphic3d_AspectMarker3d(Aspect_TOM_O_POINT, color, 2.));
+    group->AddPrimitiveArray(points);
+}
+
+} // namespace Internal
+
+AIS_MeshDefects::AIS_MeshDefects(
+        const Handle_Poly_Triangulation& mesh,
+        const std::shared_ptr<const MeshAnalysisResult>& analysis)
+    : m_mesh(mesh),
+      m_analysis(analysis)
+{
+    this->SetZLayer(Graphic3d_ZLayerId_Topmost);
+}
+
+void AIS_MeshDefects::ComputeSelection(const opencascade::handle<SelectMgr_Selection>&, const int)
+{
+}
+
+void AIS_MeshDefects::Compute(
+        const opencascade::handle<PrsMgr_PresentationManager3d>&,
+        const opencascade::handle<Prs3d_Presentation>& pres,
+        const int)
+{
+    if (m_mesh.IsNull() || !m_analysis)
+        return;
+
+    using namespace Internal;
+    const MeshAnalysisResult& res = *m_analysis;
+    addMeshDefectEdges(pres, m_mesh, res.vecBoundaryEdge, Quantity_NOC_YELLOW);
+    addMeshDefectEdges(pres, m_mesh, res.vecNonManifoldEdge, Quantity_NOC_RED);
+    addMeshDefectEdges(pres, m_mesh, res.vecMisorientedEdge, Quantity_NOC_MAGENTA1);
+    addMeshDefectTriangles(pres, m_mesh, res.vecSliverTriangle, Quantity_NOC_ORANGE);
+    addMeshDefectTriangles(pres, m_mesh, res.vecDuplicateTriangle, Quantity_NOC_CYAN1);
+    addMeshDefectMarkers(pres, m_mesh, res.vecDegenerateTriangle, Quantity_NOC_RED);
+}
+
+} // namespace Mayo
@@ -0,0 +1,59 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "../base/mesh_analysis.h"
+#include "../base/tkernel_utils.h"
+
+#include <AIS_InteractiveObject.hxx>
+#include <Poly_Triangulation.hxx>
+#include <Prs3d_Presentation.hxx>
+#include <PrsMgr_PresentationManager3d.hxx>
+#include <SelectMgr_Selection.hxx>
+#include <memory>
+
+#if OCC_VERSION_HEX < OCC_VERSION_CHECK(7, 5, 0)
+#  include <Prs3d_Projector.hxx>
+#endif
+
+namespace Mayo {
+
+// Highlights the defects found by MeshAnalysis on a mesh : boundary edges(yellow),
+// non-manifold edges(red), misoriented edges(magenta), degenerate triangles(red markers),
+// sliver triangles(orange) and duplicate triangles(cyan)
+// Displayed in the topmost layer so defects inside the mesh are visible, not selectable
+class AIS_MeshDefects : public AIS_InteractiveObject {
+public:
+    AIS_MeshDefects(
+            const Handle_Poly_Triangulation& mesh,
+            const std::shared_ptr<const MeshAnalysisResult>& analysis);
+
+    bool AcceptDisplayMode(const int mode) const override { return mode == 0; }
+
+    void ComputeSelection(
+            const opencascade::handle<SelectMgr_Selection>& sel,
+            const int mode) override;
+
+protected:
+    void Compute(
+            const opencascade::handle<PrsMgr_PresentationManager3d>& pm,
+            const opencascade::handle<Prs3d_Presentation>& pres,
+            const int mode) override;
+
+#if OCC_VERSION_HEX < OCC_VERSION_CHECK(7, 5, 0)
+    void Compute(
+            const opencascade::handle<Prs3d_Projector>&,
+            const opencascade::handle<Prs3d_Presentation>&) override
+    {}
+#endif
+
+private:
+    Handle_Poly_Triangulation m_mesh;
+    std::shared_ptr<const MeshAnalysisResult> m_analysis;
+};
+
+} // namespace Mayo
@@ -0,0 +1,130 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "ais_point_cloud_lod.h"
+
+#include "../base/tracing.h"
+
+#include <Graphic3d_ArrayOfPoints.hxx>
+#include <Graphic3d_AspectMarker3d.hxx>
+#include <Graphic3d_Group.hxx>
+#include <gp_Vec.hxx>
+#include <algorithm>
+#include <cmath>
+
+namespace Mayo {
+
+namespace Internal {
+
+// Nodes are cubes, their bounding sphere radius is halfSize * sqrt(3)
+static const double octreeNodeRadiusFactor = 1.7320508075688772;
+
+// Screen size assumed for the whole point cloud when no camera is known yet
+static const double pointCloudInitialScreenSize = 1000.;
+
+} // namespace Internal
+
+AIS_PointCloudLod::AIS_PointCloudLod(const Handle_PointCloud& cloud)
+    : m_cloud(cloud)
+{
+    if (m_cloud.IsNull() || m_cloud->octree().empty())
+        return;
+
+    // Initial level of detail, nodes screen size is relative to the whole point cloud
+    const double rootHalfSize = std::max(1e-9f, m_cloud->octree().front().halfSize);
+    auto fnScreenSize = [=](const PointCloud::OctreeNode& node) {
+        return Internal::pointCloudInitialScreenSize * node.halfSize / rootHalfSize;
+    };
+    m_vecLodNode = m_cloud->selectLevelOfDetail(m_pointBudget, fnScreenSize);
+}
+
+bool AIS_PointCloudLod::updateLevelOfDetail(
+        const Handle_Graphic3d_Camera& camera, int viewportHeight)
+{
+    if (m_cloud.IsNull() || camera.IsNull() || viewportHeight <= 0)
+        return false;
+
+    MAYO_TRACE_SCOPE("pointcloud", "updateLevelOfDetail");
+    const gp_Pnt eye = camera->Eye();
+    const gp_Dir viewDir = camera->Direction();
+    const gp_Dir upDir = camera->Up();
+    const bool isPerspective = !camera->IsOrthographic();
+    auto fnScreenSize = [&](const PointCloud::OctreeNode& node) {
+        const gp_Pnt center(node.center[0], node.center[1], node.center[2]);
+        const double radius = node.halfSize * Internal::octreeNodeRadiusFactor;
+        if (isPerspective && gp_Vec(eye, center).Dot(gp_Vec(viewDir)) < -radius)
+            return -1.; // Behind the eye
+
+        // Projected radius in normalized device coordinates, then in pixels
+        const gp_Pnt ndcCenter = camera->Project(center);
+        const gp_Pnt ndcTop = camera->Project(center.Translated(radius * gp_Vec(upDir)));
+        const double ndcRadius = ndcCenter.Distance(ndcTop);
+        if (std::abs(ndcCenter.X()) > 1 + ndcRadius || std::abs(ndcCenter.Y()) > 1 + ndcRadius)
+            return -1.; // Outside of the view frustum
+
+        return ndcRadius * viewportHeight; // Diameter in pixels
+    };
+
+    std::vector<PointCloud::LodNode> vecLodNode =
+            m_cloud->selectLevelOfDetail(m_pointBudget, fnScreenSize);
+    auto fnLodNodeEqual = [](const PointCloud::LodNode& lhs, const PointCloud::LodNode& rhs) {
+        return lhs.node == rhs.node && lhs.stride == rhs.stride;
+    };
+    if (std::equal(vecLodNode.cbegin(), vecLodNode.cend(),
+                   m_vecLodNode.cbegin(), m_vecLodNode.cend(),
+                   fnLodNodeEqual))
+    {
+        return false;
+    }
+
+    m_vecLodNode = std::move(vecLodNode);
+    return true;
+}
+
+int AIS_PointCloudLod::drawnPointCount() const
+{
+    return !m_cloud.IsNull() ? PointCloud::lodPointCount(m_vecLodNode, *m_cloud) : 0;
+}
+
+void AIS_PointCloudLod::ComputeSelection(const opencascade::handle<SelectMgr_Selection>&, const int)
+{
+}
+
+void AIS_PointCloudLod::Compute(
+        const opencascade::handle<PrsMgr_PresentationManager3d>&,
+        const opencascade::handle<Prs3d_Presentation>& pres,
+        const int)
+{
+    const int pointCount = this->drawnPointCount();
+    if (pointCount == 0)
+        return;
+
+    MAYO_TRACE_SCOPE("pointcloud", "AIS_PointCloudLod::Compute");
+    const PointCloud& cloud = *m_cloud;
+    const bool hasColors = cloud.hasColors();
+    Handle_Graphic3d_ArrayOfPoints points = new Graphic3d_ArrayOfPoints(pointCount, hasColors);
+    for (const PointCloud::LodNode& lodNode : m_vecLodNode) {
+        const PointCloud::OctreeNode& node = cloud.octree().at(lodNode.node);
+        for (int i = node.pointBegin; i < node.pointEnd; i += lodNode.stride) {
+            const float* coords = cloud.coords(i);
+            const gp_Pnt pnt(coords[0], coords[1], coords[2]);
+            if (hasColors) {
+                const uint8_t* color = cloud.color(i);
+                points->AddVertex(pnt, Graphic3d_Vec4ub(color[0], color[1], color[2], 255));
+            }
+            else {
+                points->AddVertex(pnt);
+            }
+        }
+    }
+
+    Handle_Graphic3d_Group group = pres->NewGroup();
+    group->SetGroupPrimitivesAspect(
+                new Graphic3d_AspectMarker3d(Aspect_TOM_POINT, m_defaultColor, 1.));
+    group->AddPrimitiveArray(points);
+}
+
+} // namespace Mayo
@@ -0,0 +1,81 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "../base/point_cloud.h"
+#include "../base/tkernel_utils.h"
+
+#include <AIS_InteractiveObject.hxx>
+#include <Graphic3d_Camera.hxx>
+#include <Prs3d_Presentation.hxx>
+#include <PrsMgr_PresentationManager3d.hxx>
+#include <Quantity_Color.hxx>
+#include <SelectMgr_Selection.hxx>
+#include <vector>
+
+#if OCC_VERSION_HEX < OCC_VERSION_CHECK(7, 5, 0)
+#  include <Prs3d_Projector.hxx>
+#endif
+
+namespace Mayo {
+
+class AIS_PointCloudLod;
+DEFINE_STANDARD_HANDLE(AIS_PointCloudLod, AIS_InteractiveObject)
+
+// Displays a PointCloud with screen-space level of detail : octree nodes are refined where they
+// appear the biggest in the view, so that no more than a budget of points is drawn
+// Points without colors are drawn with 'defaultColor()'. Not selectable
+class AIS_PointCloudLod : public AIS_InteractiveObject {
+public:
+    static constexpr int DefaultPointBudget = 2000000;
+
+    AIS_PointCloudLod(const Handle_PointCloud& cloud);
+
+    const Handle_PointCloud& pointCloud() const { return m_cloud; }
+
+    int pointBudget() const { return m_pointBudget; }
+    void setPointBudget(int budget) { m_pointBudget = budget; }
+
+    const Quantity_Color& defaultColor() const { return m_defaultColor; }
+    void setDefaultColor(const Quantity_Color& color) { m_defaultColor = color; }
+
+    // Selects the octree nodes to be drawn for 'camera' and a viewport 'viewportHeight' pixels
+    // high. Returns true if the selection changed, then the presentation has to be recomputed
+    bool updateLevelOfDetail(const Handle_Graphic3d_Camera& camera, int viewportHeight);
+
+    // Count of points drawn by the current level of detail
+    int drawnPointCount() const;
+
+    bool AcceptDisplayMode(const int mode) const override { return mode == 0; }
+
+    void ComputeSelection(
+            const opencascade::handle<SelectMgr_Selection>& sel,
+            const int mode) override;
+
+    DEFINE_STANDARD_RTTI_INLINE(AIS_PointCloudLod, AIS_InteractiveObject)
+
+protected:
+    void Compute(
+            const opencascade::handle<PrsMgr_PresentationManager3d>& pm,
+            const opencascade::handle<Prs3d_Presentation>& pres,
+            const int mode) override;
+
+#if OCC_VERSION_HEX < OCC_VERSION_CHECK(7, 5, 0)
+    void Compute(
+            const opencascade::handle<Prs3d_Projector>&,
+            const opencascade::handle<Prs3d_Presentation>&) override
+    {}
+#endif
+
+private:
+    Handle_PointCloud m_cloud;
+    int m_pointBudget = DefaultPointBudget;
+    Quantity_Color m_defaultColor = Quantity_NOC_GRAY70;
+    std::vector<PointCloud::LodNode> m_vecLodNode;
+};
+
+} // namespace Mayo
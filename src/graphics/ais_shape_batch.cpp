@@ -0,0 +1,396 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "ais_shape_batch.h"
+
+#include "../base/metrics.h"
+#include "../base/tracing.h"
+#include "../base/xcaf.h"
+
+#include <BRep_Tool.hxx>
+#include <Graphic3d_ArrayOfSegments.hxx>
+#include <Graphic3d_ArrayOfTriangles.hxx>
+#include <Graphic3d_AspectFillArea3d.hxx>
+#include <Graphic3d_AspectLine3d.hxx>
+#include <Poly_PolygonOnTriangulation.hxx>
+#include <StdPrs_ToolTriangulatedShape.hxx>
+#include <TopExp_Explorer.hxx>
+#include <TopoDS.hxx>
+#include <XCAFDoc_ColorTool.hxx>
+#include <XCAFDoc_DocumentTool.hxx>
+#include <map>
+#include <tuple>
+#include <utility>
+
+namespace Mayo {
+
+namespace Internal {
+
+// Same as the default surface color of XCAFPrs_AISObject
+static const Quantity_Color shapeBatchDefaultColor = Quantity_NOC_WHITE;
+
+using ShapeBatchColorKey = std::tuple<double, double, double>;
+
+static ShapeBatchColorKey shapeBatchColorKey(const Quantity_Color& color)
+{
+    return { color.Red(), color.Green(), color.Blue() };
+}
+
+static bool shapeBatchFindColor(
+        const Handle_XCAFDoc_ColorTool& colorTool, const TDF_Label& label, Quantity_Color* ptrColor)
+{
+    return !colorTool.IsNull()
+            && (colorTool->GetColor(label, XCAFDoc_ColorSurf, *ptrColor)
+                || colorTool->GetColor(label, XCAFDoc_ColorGen, *ptrColor));
+}
+
+static bool shapeBatchIsVisible(const Handle_XCAFDoc_ColorTool& colorTool, const TDF_Label& label)
+{
+    return colorTool.IsNull() || colorTool->IsVisible(label);
+}
+
+// Calls 'fnFace(face, color)' for each visible face of the XDE shape 'label', located as in the
+// assembly. Color precedence follows XCAFPrs : sub-shape colors prevail, then the instance color
+// over the color of its product, then the colors of the parent assemblies
+template<typename FUNCTION>
+static void shapeBatchForeachFace(
+        const Handle_XCAFDoc_ColorTool& colorTool,
+        const TDF_Label& label,
+        const TopLoc_Location& location,
+        const Quantity_Color& parentColor,
+        bool isInstanceColored,
+        FUNCTION& fnFace)
+{
+    if (!shapeBatchIsVisible(colorTool, label))
+        return;
+
+    Quantity_Color labelColor = parentColor;
+    if (!isInstanceColored)
+        shapeBatchFindColor(colorTool, label, &labelColor);
+
+    if (XCaf::isShapeAssembly(label)) {
+        for (const TDF_Label& component : XCaf::shapeComponents(label)) {
+            if (!shapeBatchIsVisible(colorTool, component))
+                continue;
+
+            Quantity_Color componentColor = labelColor;
+            const bool hasColor = shapeBatchFindColor(colorTool, component, &componentColor);
+            const TopLoc_Location componentLoc =
+                    location * XCaf::shapeReferenceLocation(component);
+            shapeBatchForeachFace(
+                        colorTool,
+                        XCaf::shapeReferred(component),
+                        componentLoc,
+                        componentColor,
+                        hasColor,
+                        fnFace);
+        }
+
+        return;
+    }
+
+    // Colors of sub-shapes, the coarse ones first so face colors prevail
+    NCollection_DataMap<TopoDS_Shape, Quantity_Color, TopTools_ShapeMapHasher> mapFaceColor;
+    const TDF_LabelSequence seqSub = XCaf::shapeSubs(label);
+    for (bool isFacePass : { false, true }) {
+        for (const TDF_Label& sub : seqSub) {
+            Quantity_Color subColor;
+            if (!shapeBatchFindColor(colorTool, sub, &subColor))
+                continue;
+
+            const TopoDS_Shape subShape = XCaf::shape(sub);
+            if (subShape.IsNull() || (subShape.ShapeType() == TopAbs_FACE) != isFacePass)
+                continue;
+
+            for (TopExp_Explorer expFace(subShape, TopAbs_FACE); expFace.More(); expFace.Next())
+                mapFaceColor.Bind(expFace.Current(), subColor);
+        }
+    }
+
+    const TopoDS_Shape shape = XCaf::shape(label);
+    for (TopExp_Explorer expFace(shape, TopAbs_FACE); expFace.More(); expFace.Next()) {
+        const TopoDS_Shape& face = expFace.Current();
+        const Quantity_Color* ptrSubColor = mapFaceColor.Seek(face);
+        fnFace(TopoDS::Face(face.Moved(location)), ptrSubColor ? *ptrSubColor : labelColor);
+    }
+}
+
+} // namespace Internal
+
+AIS_ShapeBatch::AIS_ShapeBatch(const TDF_Label& label)
+    : m_label(label)
+{
+}
+
+void AIS_ShapeBatch::setFaceBoundaryDraw(bool on)
+{
+    if (on == m_faceBoundaryDraw)
+        return;
+
+    m_faceBoundaryDraw = on;
+    for (Chunk& chunk : m_vecChunk) {
+        chunk.preparedTriangles.Nullify();
+        chunk.preparedBoundaries.Nullify();
+        chunk.isPrepared = false;
+    }
+}
+
+void AIS_ShapeBatch::prepare()
+{
+    MAYO_TRACE_SCOPE("graphics", "AIS_ShapeBatch::prepare");
+    this->collectFaces();
+    for (Chunk& chunk : m_vecChunk) {
+        this->buildChunkArrays(chunk, &chunk.preparedTriangles, &chunk.preparedBoundaries);
+        chunk.isPrepared = true;
+    }
+
+    m_isFaceCollectionPrepared = true;
+}
+
+bool AIS_ShapeBatch::setSplitShapes(const std::vector<TopoDS_Shape>& vecShape)
+{
+    TopTools_MapOfShape mapSplitFace;
+    for (const TopoDS_Shape& shape : vecShape) {
+        for (TopExp_Explorer expFace(shape, TopAbs_FACE); expFace.More(); expFace.Next())
+            mapSplitFace.Add(expFace.Current());
+    }
+
+    // Chunks having faces that enter or leave the split set
+    std::vector<bool> vecChunkDirty(m_vecChunk.size(), false);
+    auto fnMarkDirty = [&](const TopoDS_Shape& face) {
+        const int* ptrChunk = m_mapFaceChunk.Seek(face);
+        if (ptrChunk)
+            vecChunkDirty.at(*ptrChunk) = true;
+    };
+    for (TopTools_MapIteratorOfMapOfShape it(mapSplitFace); it.More(); it.Next()) {
+        if (!m_mapSplitFace.Contains(it.Key()))
+            fnMarkDirty(it.Key());
+    }
+
+    for (TopTools_MapIteratorOfMapOfShape it(m_mapSplitFace); it.More(); it.Next()) {
+        if (!mapSplitFace.Contains(it.Key()))
+            fnMarkDirty(it.Key());
+    }
+
+    m_mapSplitFace.Exchange(mapSplitFace);
+    for (unsigned i = 0; i < m_vecChunk.size(); ++i) {
+        if (vecChunkDirty.at(i))
+            m_vecChunk.at(i).isPrepared = false;
+    }
+
+    if (m_presentation.IsNull())
+        return false;
+
+    bool isPresentationChanged = false;
+    for (unsigned i = 0; i < m_vecChunk.size(); ++i) {
+        if (vecChunkDirty.at(i)) {
+            this->fillChunk(&m_vecChunk.at(i));
+            isPresentationChanged = true;
+        }
+    }
+
+    return isPresentationChanged;
+}
+
+void AIS_ShapeBatch::ComputeSelection(const opencascade::handle<SelectMgr_Selection>&, const int)
+{
+}
+
+void AIS_ShapeBatch::Compute(
+        const opencascade::handle<PrsMgr_PresentationManager3d>&,
+        const opencascade::handle<Prs3d_Presentation>& pres,
+        const int)
+{
+    MAYO_TRACE_SCOPE("graphics", "AIS_ShapeBatch::Compute");
+    // Faces collected by prepare() are used once, later computations collect them again
+    if (!m_isFaceCollectionPrepared)
+        this->collectFaces();
+
+    m_isFaceCollectionPrepared = false;
+    m_presentation = pres;
+    for (Chunk& chunk : m_vecChunk) {
+        chunk.groupTriangles = pres->NewGroup();
+        chunk.groupBoundaries = pres->NewGroup();
+        this->fillChunk(&chunk);
+    }
+
+    static Metrics::Counter& counterChunks = Metrics::counter("graphics.batchChunks");
+    counterChunks.add(int64_t(m_vecChunk.size()));
+}
+
+void AIS_ShapeBatch::collectFaces()
+{
+    m_vecChunk.clear();
+    m_mapFaceChunk.Clear();
+    std::map<Internal::ShapeBatchColorKey, int> mapColorChunk; // Color -> chunk being filled
+    auto fnAddFace = [&](const TopoDS_Face& face, const Quantity_Color& color) {
+        TopLoc_Location loc;
+        const Handle_Poly_Triangulation& triangulation = BRep_Tool::Triangulation(face, loc);
+        if (triangulation.IsNull())
+            return;
+
+        const int nodeCount = triangulation->NbNodes();
+        auto itChunk = mapColorChunk.find(Internal::shapeBatchColorKey(color));
+        if (itChunk == mapColorChunk.end()
+                || m_vecChunk.at(itChunk->second).nodeCount + nodeCount > ChunkMaxNodeCount)
+        {
+            Chunk chunk;
+            chunk.color = color;
+            m_vecChunk.push_back(std::move(chunk));
+            const int iChunk = int(m_vecChunk.size()) - 1;
+            const auto colorKey = Internal::shapeBatchColorKey(color);
+            itChunk = mapColorChunk.insert_or_assign(colorKey, iChunk).first;
+        }
+
+        Chunk& chunk = m_vecChunk.at(itChunk->second);
+        chunk.vecFace.push_back(face);
+        chunk.nodeCount += nodeCount;
+        m_mapFaceChunk.Bind(face, itChunk->second);
+    };
+
+    Internal::shapeBatchForeachFace(
+                XCAFDoc_DocumentTool::ColorTool(m_label),
+                m_label,
+                TopLoc_Location(),
+                Internal::shapeBatchDefaultColor,
+                false,
+                fnAddFace);
+}
+
+void AIS_ShapeBatch::buildChunkArrays(
+        const Chunk& chunk,
+        Handle_Graphic3d_ArrayOfTriangles* ptrTriangles,
+        Handle_Graphic3d_ArrayOfSegments* ptrBoundaries) const
+{
+    ptrTriangles->Nullify();
+    ptrBoundaries->Nullify();
+
+    // Count primitives of the faces not split
+    int nodeCount = 0;
+    int triangleCount = 0;
+    int boundaryVertexCount = 0;
+    for (const TopoDS_Face& face : chunk.vecFace) {
+        if (m_mapSplitFace.Contains(face))
+            continue;
+
+        TopLoc_Location loc;
+        const Handle_Poly_Triangulation& triangulation = BRep_Tool::Triangulation(face, loc);
+        nodeCount += triangulation->NbNodes();
+        triangleCount += triangulation->NbTriangles();
+        if (!m_faceBoundaryDraw)
+            continue;
+
+        for (TopExp_Explorer expEdge(face, TopAbs_EDGE); expEdge.More(); expEdge.Next()) {
+            const TopoDS_Edge& edge = TopoDS::Edge(expEdge.Current());
+            const Handle_Poly_PolygonOnTriangulation& polygon =
+                    BRep_Tool::PolygonOnTriangulation(edge, triangulation, loc);
+            if (!polygon.IsNull())
+                boundaryVertexCount += 2 * (polygon->NbNodes() - 1);
+        }
+    }
+
+    if (triangleCount == 0)
+        return;
+
+    Handle_Graphic3d_ArrayOfTriangles triangles =
+            new Graphic3d_ArrayOfTriangles(nodeCount, 3 * triangleCount, true);
+    Handle_Graphic3d_ArrayOfSegments boundaries;
+    if (boundaryVertexCount > 0)
+        boundaries = new Graphic3d_ArrayOfSegments(boundaryVertexCount);
+
+    for (const TopoDS_Face& face : chunk.vecFace) {
+        if (m_mapSplitFace.Contains(face))
+            continue;
+
+        TopLoc_Location loc;
+        const Handle_Poly_Triangulation& triangulation = BRep_Tool::Triangulation(face, loc);
+        if (!triangulation->HasNormals())
+            StdPrs_ToolTriangulatedShape::ComputeNormals(face, triangulation);
+
+        // Geometry is merged in world coordinates, reversed faces are flipped
+        const gp_Trsf trsf = loc.Transformation();
+        const bool isFaceReversed = face.Orientation() == TopAbs_REVERSED;
+        const TColgp_Array1OfPnt& nodes = triangulation->Nodes();
+        const TShort_Array1OfShortReal& normals = triangulation->Normals();
+        const int vertexOffset = triangles->VertexNumber() - nodes.Lower() + 1;
+        for (int i = nodes.Lower(); i <= nodes.Upper(); ++i) {
+            const gp_Pnt node = nodes(i).Transformed(trsf);
+            const int iCoord = normals.Lower() + 3 * (i - nodes.Lower());
+            gp_Vec normal(normals(iCoord), normals(iCoord + 1), normals(iCoord + 2));
+            normal.Transform(trsf);
+            if (isFaceReversed)
+                normal.Reverse();
+
+            triangles->AddVertex(
+                        node.X(), node.Y(), node.Z(), normal.X(), normal.Y(), normal.Z());
+        }
+
+        for (int i = 1; i <= triangulation->NbTriangles(); ++i) {
+            int n1, n2, n3;
+            triangulation->Triangle(i).Get(n1, n2, n3);
+            if (isFaceReversed)
+                std::swap(n2, n3);
+
+            triangles->AddEdge(vertexOffset + n1);
+            triangles->AddEdge(vertexOffset + n2);
+            triangles->AddEdge(vertexOffset + n3);
+        }
+
+        if (boundaries.IsNull())
+            continue;
+
+        for (TopExp_Explorer expEdge(face, TopAbs_EDGE); expEdge.More(); expEdge.Next()) {
+            const TopoDS_Edge& edge = TopoDS::Edge(expEdge.Current());
+            const Handle_Poly_PolygonOnTriangulation& polygon =
+                    BRep_Tool::PolygonOnTriangulation(edge, triangulation, loc);
+            if (polygon.IsNull())
+                continue;
+
+            const TColStd_Array1OfInteger& indices = polygon->Nodes();
+            for (int i = indices.Lower(); i < indices.Upper(); ++i) {
+                boundaries->AddVertex(nodes(indices(i)).Transformed(trsf));
+                boundaries->AddVertex(nodes(indices(i + 1)).Transformed(trsf));
+            }
+        }
+    }
+
+    *ptrTriangles = triangles;
+    *ptrBoundaries = boundaries;
+}
+
+void AIS_ShapeBatch::fillChunk(Chunk* chunk) const
+{
+    chunk->groupTriangles->Clear(false);
+    chunk->groupBoundaries->Clear(false);
+
+    Handle_Graphic3d_ArrayOfTriangles triangles = chunk->preparedTriangles;
+    Handle_Graphic3d_ArrayOfSegments boundaries = chunk->preparedBoundaries;
+    if (!chunk->isPrepared)
+        this->buildChunkArrays(*chunk, &triangles, &boundaries);
+
+    chunk->preparedTriangles.Nullify();
+    chunk->preparedBoundaries.Nullify();
+    chunk->isPrepared = false;
+    if (triangles.IsNull())
+        return;
+
+    // Pushed back in depth, so presentations of split faces(eg highlighting) are drawn over
+    Graphic3d_MaterialAspect material(Graphic3d_NOM_PLASTIC);
+    material.SetColor(chunk->color);
+    Handle_Graphic3d_AspectFillArea3d aspectFill = new Graphic3d_AspectFillArea3d(
+                Aspect_IS_SOLID, chunk->color, chunk->color, Aspect_TOL_SOLID, 1.,
+                material, material);
+    aspectFill->SetPolygonOffsets(Aspect_POM_Fill, 1.f, 4.f);
+    chunk->groupTriangles->SetGroupPrimitivesAspect(aspectFill);
+    chunk->groupTriangles->AddPrimitiveArray(triangles);
+    if (!boundaries.IsNull()) {
+        chunk->groupBoundaries->SetGroupPrimitivesAspect(
+                    new Graphic3d_AspectLine3d(Quantity_NOC_BLACK, Aspect_TOL_SOLID, 1.));
+        chunk->groupBoundaries->AddPrimitiveArray(boundaries);
+    }
+}
+
+} // namespace Mayo
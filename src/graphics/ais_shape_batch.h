@@ -0,0 +1,112 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "../base/tkernel_utils.h"
+
+#include <AIS_InteractiveObject.hxx>
+#include <Graphic3d_ArrayOfSegments.hxx>
+#include <Graphic3d_ArrayOfTriangles.hxx>
+#include <Graphic3d_Group.hxx>
+#include <NCollection_DataMap.hxx>
+#include <Prs3d_Presentation.hxx>
+#include <PrsMgr_PresentationManager3d.hxx>
+#include <Quantity_Color.hxx>
+#include <SelectMgr_Selection.hxx>
+#include <TDF_Label.hxx>
+#include <TopTools_MapOfShape.hxx>
+#include <TopTools_ShapeMapHasher.hxx>
+#include <TopoDS_Face.hxx>
+#include <vector>
+
+#if OCC_VERSION_HEX < OCC_VERSION_CHECK(7, 5, 0)
+#  include <Prs3d_Projector.hxx>
+#endif
+
+namespace Mayo {
+
+class AIS_ShapeBatch;
+DEFINE_STANDARD_HANDLE(AIS_ShapeBatch, AIS_InteractiveObject)
+
+// Draws the faces of an XDE shape(assembly or part) with a few large vertex buffers : faces are
+// grouped by color then merged into chunks of up to 'ChunkMaxNodeCount' nodes, so the count of
+// draw calls doesn't depend on the count of parts
+// Not selectable, meant to replace the presentation of the regular object while this one stays
+// selectable. "Split" faces are left out of the batch, they're drawn by some other presentation
+// (eg selection highlighting). Batch geometry is pushed back in depth so highlighting wins
+class AIS_ShapeBatch : public AIS_InteractiveObject {
+public:
+    static constexpr int ChunkMaxNodeCount = 256 * 1024;
+
+    AIS_ShapeBatch(const TDF_Label& label);
+
+    const TDF_Label& label() const { return m_label; }
+
+    bool faceBoundaryDraw() const { return m_faceBoundaryDraw; }
+    void setFaceBoundaryDraw(bool on);
+
+    // Collects the faces and builds the vertex buffers of the chunks ahead of Compute(), which then
+    // only has to attach them to the presentation. Meant to be called in a worker thread while the
+    // batch isn't displayed
+    void prepare();
+
+    // Faces of 'vecShape'(located as in the XDE assembly) are left out of the batch. Only the
+    // chunks affected are rebuilt. Returns true if the presentation changed
+    bool setSplitShapes(const std::vector<TopoDS_Shape>& vecShape);
+
+    int chunkCount() const { return int(m_vecChunk.size()); }
+
+    bool AcceptDisplayMode(const int mode) const override { return mode == 0; }
+
+    void ComputeSelection(
+            const opencascade::handle<SelectMgr_Selection>& sel,
+            const int mode) override;
+
+    DEFINE_STANDARD_RTTI_INLINE(AIS_ShapeBatch, AIS_InteractiveObject)
+
+protected:
+    void Compute(
+            const opencascade::handle<PrsMgr_PresentationManager3d>& pm,
+            const opencascade::handle<Prs3d_Presentation>& pres,
+            const int mode) override;
+
+#if OCC_VERSION_HEX < OCC_VERSION_CHECK(7, 5, 0)
+    void Compute(
+            const opencascade::handle<Prs3d_Projector>&,
+            const opencascade::handle<Prs3d_Presentation>&) override
+    {}
+#endif
+
+private:
+    struct Chunk {
+        Quantity_Color color;
+        std::vector<TopoDS_Face> vecFace;
+        int nodeCount = 0;
+        Handle_Graphic3d_Group groupTriangles;
+        Handle_Graphic3d_Group groupBoundaries;
+        Handle_Graphic3d_ArrayOfTriangles preparedTriangles; // Built by prepare()
+        Handle_Graphic3d_ArrayOfSegments preparedBoundaries;
+        bool isPrepared = false;
+    };
+
+    void collectFaces();
+    void buildChunkArrays(
+            const Chunk& chunk,
+            Handle_Graphic3d_ArrayOfTriangles* ptrTriangles,
+            Handle_Graphic3d_ArrayOfSegments* ptrBoundaries) const;
+    void fillChunk(Chunk* chunk) const;
+
+    TDF_Label m_label;
+    bool m_faceBoundaryDraw = true;
+    bool m_isFaceCollectionPrepared = false;
+    std::vector<Chunk> m_vecChunk;
+    NCollection_DataMap<TopoDS_Shape, int, TopTools_ShapeMapHasher> m_mapFaceChunk;
+    TopTools_MapOfShape m_mapSplitFace;
+    Handle_Prs3d_Presentation m_presentation;
+};
+
+} // namespace Mayo
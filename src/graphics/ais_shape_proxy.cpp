@@ -0,0 +1,420 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "ais_shape_proxy.h"
+
+#include "../base/bnd_utils.h"
+#include "../base/mesh_decimation.h"
+#include "../base/mesh_normals.h"
+#include "../base/mesh_utils.h"
+#include "../base/metrics.h"
+#include "../base/task_progress.h"
+#include "../base/tracing.h"
+#include "../base/xcaf.h"
+
+#include <BRep_Tool.hxx>
+#include <gp.hxx>
+#include <gp_Vec.hxx>
+#include <Graphic3d_ArrayOfTriangles.hxx>
+#include <Graphic3d_AspectFillArea3d.hxx>
+#include <Graphic3d_Group.hxx>
+#include <NCollection_DataMap.hxx>
+#include <Precision.hxx>
+#include <TDF_LabelMapHasher.hxx>
+#include <TopExp_Explorer.hxx>
+#include <TopoDS.hxx>
+#include <XCAFDoc_ColorTool.hxx>
+#include <XCAFDoc_DocumentTool.hxx>
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <utility>
+
+namespace Mayo {
+
+namespace Internal {
+
+// Triangle count below which parts aren't decimated
+static const int shapeProxyPartMinTriangleCount = 500;
+
+static bool shapeProxyFindColor(
+        const Handle_XCAFDoc_ColorTool& colorTool, const TDF_Label& label, Quantity_Color* ptrColor)
+{
+    return !colorTool.IsNull()
+            && (colorTool->GetColor(label, XCAFDoc_ColorSurf, *ptrColor)
+                || colorTool->GetColor(label, XCAFDoc_ColorGen, *ptrColor));
+}
+
+// Calls 'fnPart(product, location, color)' for each visible part instance of the XDE shape
+// 'label', 'location' being the one in the assembly. Instance color prevails over the color of
+// its product. Colors of sub-shapes are ignored, a part has a single color
+template<typename FUNCTION>
+static void shapeProxyForeachPart(
+        const Handle_XCAFDoc_ColorTool& colorTool,
+        const TDF_Label& label,
+        const TopLoc_Location& location,
+        const Quantity_Color& parentColor,
+        bool isInstanceColored,
+        FUNCTION& fnPart)
+{
+    if (!colorTool.IsNull() && !colorTool->IsVisible(label))
+        return;
+
+    Quantity_Color labelColor = parentColor;
+    if (!isInstanceColored)
+        shapeProxyFindColor(colorTool, label, &labelColor);
+
+    if (!XCaf::isShapeAssembly(label)) {
+        fnPart(label, location, labelColor);
+        return;
+    }
+
+    for (const TDF_Label& component : XCaf::shapeComponents(label)) {
+        if (!colorTool.IsNull() && !colorTool->IsVisible(component))
+            continue;
+
+        Quantity_Color componentColor = labelColor;
+        const bool hasColor = shapeProxyFindColor(colorTool, component, &componentColor);
+        shapeProxyForeachPart(
+                    colorTool,
+                    XCaf::shapeReferred(component),
+                    location * XCaf::shapeReferenceLocation(component),
+                    componentColor,
+                    hasColor,
+                    fnPart);
+    }
+}
+
+// Face triangulations of 'shape' merged in a single mesh, nodes shared by faces are duplicated
+static Handle_Poly_Triangulation shapeProxyMergeFaces(const TopoDS_Shape& shape)
+{
+    int nodeCount = 0;
+    int triangleCount = 0;
+    for (TopExp_Explorer expFace(shape, TopAbs_FACE); expFace.More(); expFace.Next()) {
+        TopLoc_Location loc;
+        const auto& triangulation = BRep_Tool::Triangulation(TopoDS::Face(expFace.Current()), loc);
+        if (!triangulation.IsNull()) {
+            nodeCount += triangulation->NbNodes();
+            triangleCount += triangulation->NbTriangles();
+        }
+    }
+
+    if (triangleCount == 0)
+        return {};
+
+    Handle_Poly_Triangulation mesh = new Poly_Triangulation(nodeCount, triangleCount, false);
+    TColgp_Array1OfPnt& meshNodes = mesh->ChangeNodes();
+    Poly_Array1OfTriangle& meshTriangles = mesh->ChangeTriangles();
+    int iNode = 0;
+    int iTriangle = 0;
+    for (TopExp_Explorer expFace(shape, TopAbs_FACE); expFace.More(); expFace.Next()) {
+        const TopoDS_Face& face = TopoDS::Face(expFace.Current());
+        TopLoc_Location loc;
+        const Handle_Poly_Triangulation& triangulation = BRep_Tool::Triangulation(face, loc);
+        if (triangulation.IsNull())
+            continue;
+
+        const gp_Trsf trsf = loc.Transformation();
+        const TColgp_Array1OfPnt& nodes = triangulation->Nodes();
+        const int nodeOffset = iNode - nodes.Lower() + 1;
+        for (int i = nodes.Lower(); i <= nodes.Upper(); ++i)
+            meshNodes.ChangeValue(++iNode) = nodes(i).Transformed(trsf);
+
+        const bool isFaceReversed = face.Orientation() == TopAbs_REVERSED;
+        for (int i = 1; i <= triangulation->NbTriangles(); ++i) {
+            int n1, n2, n3;
+            triangulation->Triangle(i).Get(n1, n2, n3);
+            if (isFaceReversed)
+                std::swap(n2, n3);
+
+            meshTriangles.ChangeValue(++iTriangle) =
+                    Poly_Triangle(nodeOffset + n1, nodeOffset + n2, nodeOffset + n3);
+        }
+    }
+
+    return mesh;
+}
+
+// Reduced mesh of a product : face triangulations are merged and welded, so decimation doesn't
+// open cracks along the face boundaries, then decimated and given smooth normals
+static Handle_Poly_Triangulation shapeProxyProductMesh(const TopoDS_Shape& shape)
+{
+    Handle_Poly_Triangulation mesh =
+            MeshUtils::weldedTriangulation(shapeProxyMergeFaces(shape), Precision::Confusion());
+    if (mesh.IsNull())
+        return {};
+
+    const int triangleCount = mesh->NbTriangles();
+    MeshDecimationParameters params;
+    params.targetMode = MeshDecimationParameters::TargetMode::TriangleCount;
+    params.targetTriangleCount = std::max(
+                shapeProxyPartMinTriangleCount,
+                std::min(triangleCount / 4, AIS_ShapeProxy::PartMaxTriangleCount));
+    if (triangleCount > params.targetTriangleCount) {
+        Handle_Poly_Triangulation meshReduced = MeshDecimation::decimate(mesh, params);
+        if (!meshReduced.IsNull())
+            mesh = meshReduced;
+    }
+
+    return MeshNormals::computeSmooth(mesh);
+}
+
+static void shapeProxyAddBox(
+        const Handle_Graphic3d_ArrayOfTriangles& triangles,
+        const Bnd_Box& bndBox,
+        const Quantity_Color& color)
+{
+    const BndBoxCoords bbc = BndBoxCoords::get(bndBox);
+    const double x[] = { bbc.xmin, bbc.xmax };
+    const double y[] = { bbc.ymin, bbc.ymax };
+    const double z[] = { bbc.zmin, bbc.zmax };
+    // For each axis, the two box sides orthogonal to it
+    for (int axis = 0; axis < 3; ++axis) {
+        for (int side = 0; side < 2; ++side) {
+            const double sign = side == 0 ? -1. : 1.;
+            const gp_Dir normal(
+                        axis == 0 ? sign : 0., axis == 1 ? sign : 0., axis == 2 ? sign : 0.);
+            gp_Pnt corners[4];
+            for (int c = 0; c < 4; ++c) {
+                // Corner (u, v) in the side plane, counter-clockwise seen from outside
+                const int u = (c == 1 || c == 2) ? 1 : 0;
+                const int v = (c >= 2) ? 1 : 0;
+                const int uu = side == 0 ? v : u;
+                const int vv = side == 0 ? u : v;
+                if (axis == 0)
+                    corners[c].SetCoord(x[side], y[uu], z[vv]);
+                else if (axis == 1)
+                    corners[c].SetCoord(x[vv], y[side], z[uu]);
+                else
+                    corners[c].SetCoord(x[uu], y[vv], z[side]);
+            }
+
+            const int first = triangles->VertexNumber() + 1;
+            for (const gp_Pnt& corner : corners) {
+                const int iVertex = triangles->AddVertex(corner, normal);
+                triangles->SetVertexColor(iVertex, color);
+            }
+
+            triangles->AddEdges(first, first + 1, first + 2);
+            triangles->AddEdges(first, first + 2, first + 3);
+        }
+    }
+}
+
+} // namespace Internal
+
+AIS_ShapeProxy::AIS_ShapeProxy(const TDF_Label& label)
+    : m_label(label)
+{
+}
+
+void AIS_ShapeProxy::prepare(TaskProgress* progress)
+{
+    MAYO_TRACE_SCOPE("graphics", "AIS_ShapeProxy::prepare");
+    static Metrics::Counter& counterTriangles = Metrics::counter("graphics.proxyTriangles");
+    m_vecProduct.clear();
+    m_vecPart.clear();
+    m_vecPartDraw.clear();
+    m_drawnTriangleCount = 0;
+    struct PartInput {
+        TDF_Label product;
+        TopLoc_Location location;
+        Quantity_Color color;
+    };
+    std::vector<PartInput> vecPartInput;
+    auto fnPart = [&](
+            const TDF_Label& product, const TopLoc_Location& location, const Quantity_Color& color)
+    {
+        vecPartInput.push_back({ product, location, color });
+    };
+    Internal::shapeProxyForeachPart(
+                XCAFDoc_DocumentTool::ColorTool(m_label),
+                m_label,
+                TopLoc_Location(),
+                Quantity_NOC_WHITE,
+                false,
+                fnPart);
+
+    // Index of the product in m_vecProduct, -1 if it has no mesh
+    NCollection_DataMap<TDF_Label, int, TDF_LabelMapHasher> mapProductIndex;
+    for (const PartInput& partInput : vecPartInput) {
+        if (TaskProgress::isAbortRequested(progress))
+            return;
+
+        int productIndex = -1;
+        if (!mapProductIndex.Find(partInput.product, productIndex)) {
+            Product product;
+            product.mesh = Internal::shapeProxyProductMesh(XCaf::shape(partInput.product));
+            if (!product.mesh.IsNull()) {
+                product.bndBox = BndUtils::geometryBoundingBox(product.mesh);
+                counterTriangles.add(product.mesh->NbTriangles());
+                productIndex = int(m_vecProduct.size());
+                m_vecProduct.push_back(std::move(product));
+            }
+
+            mapProductIndex.Bind(partInput.product, productIndex);
+        }
+
+        if (productIndex < 0)
+            continue;
+
+        Part part;
+        part.product = productIndex;
+        part.trsf = partInput.location.Transformation();
+        part.color = partInput.color;
+        part.bndBox = m_vecProduct.at(productIndex).bndBox.Transformed(part.trsf);
+        m_vecPart.push_back(std::move(part));
+    }
+
+    m_vecPartDraw.resize(m_vecPart.size(), PartDraw::None);
+}
+
+bool AIS_ShapeProxy::updateLevelOfDetail(const Handle_Graphic3d_Camera& camera, int viewportHeight)
+{
+    if (camera.IsNull() || viewportHeight <= 0)
+        return false;
+
+    MAYO_TRACE_SCOPE("graphics", "AIS_ShapeProxy::updateLevelOfDetail");
+    constexpr int boxTriangleCount = 12;
+    const gp_Pnt eye = camera->Eye();
+    const gp_Dir viewDir = camera->Direction();
+    const gp_Dir upDir = camera->Up();
+    const bool isPerspective = !camera->IsOrthographic();
+    auto fnScreenSize = [&](const Bnd_Box& bndBox) {
+        const BndBoxCoords bbc = BndBoxCoords::get(bndBox);
+        const gp_Pnt center = bbc.center();
+        const double radius = 0.5 * std::sqrt(bndBox.SquareExtent());
+        if (isPerspective && gp_Vec(eye, center).Dot(gp_Vec(viewDir)) < -radius)
+            return -1.; // Behind the eye
+
+        // Projected radius in normalized device coordinates, then in pixels
+        const gp_Pnt ndcCenter = camera->Project(center);
+        const gp_Pnt ndcTop = camera->Project(center.Translated(radius * gp_Vec(upDir)));
+        const double ndcRadius = ndcCenter.Distance(ndcTop);
+        if (std::abs(ndcCenter.X()) > 1 + ndcRadius || std::abs(ndcCenter.Y()) > 1 + ndcRadius)
+            return -1.; // Outside of the view frustum
+
+        return ndcRadius * viewportHeight; // Diameter in pixels
+    };
+
+    // Parts the biggest on screen are the first to get their mesh drawn
+    std::vector<double> vecScreenSize(m_vecPart.size());
+    for (unsigned i = 0; i < m_vecPart.size(); ++i)
+        vecScreenSize.at(i) = fnScreenSize(m_vecPart.at(i).bndBox);
+
+    std::vector<int> vecPartIndex(m_vecPart.size());
+    std::iota(vecPartIndex.begin(), vecPartIndex.end(), 0);
+    std::stable_sort(vecPartIndex.begin(), vecPartIndex.end(), [&](int lhs, int rhs) {
+        return vecScreenSize.at(lhs) > vecScreenSize.at(rhs);
+    });
+
+    // Boxes count in the budget too, so the triangle count drawn is bounded whatever the count
+    // of parts
+    std::vector<PartDraw> vecPartDraw(m_vecPart.size(), PartDraw::None);
+    int triangleBudget = m_triangleBudget;
+    for (int i : vecPartIndex) {
+        const double screenSize = vecScreenSize.at(i);
+        if (screenSize < AIS_ShapeProxy::MinPixelSize || triangleBudget < boxTriangleCount)
+            break;
+
+        const int triangleCount = m_vecProduct.at(m_vecPart.at(i).product).mesh->NbTriangles();
+        if (screenSize >= AIS_ShapeProxy::MinMeshPixelSize && triangleCount <= triangleBudget) {
+            vecPartDraw.at(i) = PartDraw::Mesh;
+            triangleBudget -= triangleCount;
+        }
+        else {
+            vecPartDraw.at(i) = PartDraw::Box;
+            triangleBudget -= boxTriangleCount;
+        }
+    }
+
+    m_drawnTriangleCount = m_triangleBudget - triangleBudget;
+    if (vecPartDraw == m_vecPartDraw)
+        return false;
+
+    m_vecPartDraw = std::move(vecPartDraw);
+    return true;
+}
+
+void AIS_ShapeProxy::ComputeSelection(const opencascade::handle<SelectMgr_Selection>&, const int)
+{
+}
+
+void AIS_ShapeProxy::Compute(
+        const opencascade::handle<PrsMgr_PresentationManager3d>&,
+        const opencascade::handle<Prs3d_Presentation>& pres,
+        const int)
+{
+    MAYO_TRACE_SCOPE("graphics", "AIS_ShapeProxy::Compute");
+    int vertexCount = 0;
+    int edgeCount = 0;
+    for (unsigned i = 0; i < m_vecPartDraw.size(); ++i) {
+        if (m_vecPartDraw.at(i) == PartDraw::Mesh) {
+            const Handle_Poly_Triangulation& mesh = m_vecProduct.at(m_vecPart.at(i).product).mesh;
+            vertexCount += mesh->NbNodes();
+            edgeCount += 3 * mesh->NbTriangles();
+        }
+        else if (m_vecPartDraw.at(i) == PartDraw::Box) {
+            vertexCount += 24;
+            edgeCount += 36;
+        }
+    }
+
+    if (edgeCount == 0)
+        return;
+
+    Handle_Graphic3d_ArrayOfTriangles triangles =
+            new Graphic3d_ArrayOfTriangles(vertexCount, edgeCount, true, true);
+    for (unsigned i = 0; i < m_vecPartDraw.size(); ++i) {
+        const Part& part = m_vecPart.at(i);
+        if (m_vecPartDraw.at(i) == PartDraw::Box) {
+            Internal::shapeProxyAddBox(triangles, part.bndBox, part.color);
+            continue;
+        }
+
+        if (m_vecPartDraw.at(i) != PartDraw::Mesh)
+            continue;
+
+        // Graphic3d groups have no transformation of their own, the product mesh is copied to
+        // the instance location
+        const Handle_Poly_Triangulation& mesh = m_vecProduct.at(part.product).mesh;
+        const TColgp_Array1OfPnt& nodes = mesh->Nodes();
+        const TShort_Array1OfShortReal& normals = mesh->Normals();
+        const int vertexOffset = triangles->VertexNumber() - nodes.Lower() + 1;
+        for (int n = nodes.Lower(); n <= nodes.Upper(); ++n) {
+            const int iCoord = normals.Lower() + 3 * (n - nodes.Lower());
+            gp_Vec normal(normals(iCoord), normals(iCoord + 1), normals(iCoord + 2));
+            normal.Transform(part.trsf);
+            if (normal.SquareMagnitude() <= gp::Resolution())
+                normal = gp_Vec(0., 0., 1.); // Node of degenerate triangles only
+
+            const gp_Pnt node = nodes(n).Transformed(part.trsf);
+            const int iVertex = triangles->AddVertex(node, gp_Dir(normal));
+            triangles->SetVertexColor(iVertex, part.color);
+        }
+
+        // Mirroring location reverses the triangles
+        const bool isTrsfNegative = part.trsf.IsNegative();
+        for (int t = 1; t <= mesh->NbTriangles(); ++t) {
+            int n1, n2, n3;
+            mesh->Triangle(t).Get(n1, n2, n3);
+            if (isTrsfNegative)
+                std::swap(n2, n3);
+
+            triangles->AddEdges(vertexOffset + n1, vertexOffset + n2, vertexOffset + n3);
+        }
+    }
+
+    Graphic3d_MaterialAspect material(Graphic3d_NOM_PLASTIC);
+    Handle_Graphic3d_AspectFillArea3d aspectFill = new Graphic3d_AspectFillArea3d(
+                Aspect_IS_SOLID, Quantity_NOC_WHITE, Quantity_NOC_WHITE, Aspect_TOL_SOLID, 1.,
+                material, material);
+    Handle_Graphic3d_Group group = pres->NewGroup();
+    group->SetGroupPrimitivesAspect(aspectFill);
+    group->AddPrimitiveArray(triangles);
+}
+
+} // namespace Mayo
@@ -0,0 +1,109 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "../base/tkernel_utils.h"
+
+#include <AIS_InteractiveObject.hxx>
+#include <Bnd_Box.hxx>
+#include <Graphic3d_Camera.hxx>
+#include <Poly_Triangulation.hxx>
+#include <Prs3d_Presentation.hxx>
+#include <PrsMgr_PresentationManager3d.hxx>
+#include <Quantity_Color.hxx>
+#include <SelectMgr_Selection.hxx>
+#include <TDF_Label.hxx>
+#include <gp_Trsf.hxx>
+#include <vector>
+
+#if OCC_VERSION_HEX < OCC_VERSION_CHECK(7, 5, 0)
+#  include <Prs3d_Projector.hxx>
+#endif
+
+namespace Mayo {
+
+class TaskProgress;
+
+class AIS_ShapeProxy;
+DEFINE_STANDARD_HANDLE(AIS_ShapeProxy, AIS_InteractiveObject)
+
+// Reduced representation of an XDE shape(assembly or part), drawn in place of the regular
+// presentations while the view is manipulated. Each part instance is drawn with a decimated mesh
+// if it's big enough on screen and the triangle budget allows it, otherwise with its bounding box
+// Parts a few pixels wide are skipped. Parts are drawn opaque with a single color, without edges
+// Meshes are decimated once per product, each instance is a copy moved to its location when all
+// the parts are merged in a single vertex buffer. Not selectable
+class AIS_ShapeProxy : public AIS_InteractiveObject {
+public:
+    static constexpr int DefaultTriangleBudget = 1000000;
+    static constexpr int PartMaxTriangleCount = 20000; // After decimation
+    static constexpr double MinMeshPixelSize = 24.; // Smaller parts are drawn as boxes
+    static constexpr double MinPixelSize = 2.; // Smaller parts aren't drawn
+
+    AIS_ShapeProxy(const TDF_Label& label);
+
+    const TDF_Label& label() const { return m_label; }
+
+    // Builds the reduced meshes of the parts, meant to be called in a worker thread while the
+    // proxy isn't displayed
+    void prepare(TaskProgress* progress = nullptr);
+
+    int triangleBudget() const { return m_triangleBudget; }
+    void setTriangleBudget(int budget) { m_triangleBudget = budget; }
+
+    // Selects how each part is drawn for 'camera' and a viewport 'viewportHeight' pixels high
+    // Returns true if the selection changed, then the presentation has to be recomputed
+    bool updateLevelOfDetail(const Handle_Graphic3d_Camera& camera, int viewportHeight);
+
+    // Count of triangles drawn with the current level of detail, never above the budget
+    int drawnTriangleCount() const { return m_drawnTriangleCount; }
+
+    bool AcceptDisplayMode(const int mode) const override { return mode == 0; }
+
+    void ComputeSelection(
+            const opencascade::handle<SelectMgr_Selection>& sel,
+            const int mode) override;
+
+    DEFINE_STANDARD_RTTI_INLINE(AIS_ShapeProxy, AIS_InteractiveObject)
+
+protected:
+    void Compute(
+            const opencascade::handle<PrsMgr_PresentationManager3d>& pm,
+            const opencascade::handle<Prs3d_Presentation>& pres,
+            const int mode) override;
+
+#if OCC_VERSION_HEX < OCC_VERSION_CHECK(7, 5, 0)
+    void Compute(
+            const opencascade::handle<Prs3d_Projector>&,
+            const opencascade::handle<Prs3d_Presentation>&) override
+    {}
+#endif
+
+private:
+    enum class PartDraw : char { None, Box, Mesh };
+
+    struct Product {
+        Handle_Poly_Triangulation mesh; // Product coordinates, with normals
+        Bnd_Box bndBox;
+    };
+
+    struct Part {
+        int product; // Index in m_vecProduct
+        gp_Trsf trsf; // Location of the instance
+        Quantity_Color color;
+        Bnd_Box bndBox; // World coordinates
+    };
+
+    TDF_Label m_label;
+    int m_triangleBudget = DefaultTriangleBudget;
+    int m_drawnTriangleCount = 0;
+    std::vector<Product> m_vecProduct;
+    std::vector<Part> m_vecPart;
+    std::vector<PartDraw> m_vecPartDraw;
+};
+
+} // namespace Mayo
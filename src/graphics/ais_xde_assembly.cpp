@@ -0,0 +1,133 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "ais_xde_assembly.h"
+
+#include "../base/metrics.h"
+#include "../base/tkernel_utils.h"
+#include "../base/tracing.h"
+#include "../base/xcaf.h"
+
+#include <NCollection_DataMap.hxx>
+#include <NCollection_Map.hxx>
+#include <TDF_AttributeSequence.hxx>
+#include <TDF_LabelMapHasher.hxx>
+#include <XCAFDoc_DocumentTool.hxx>
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 5, 0)
+#  include <XCAFDoc_VisMaterialTool.hxx>
+#endif
+
+namespace Mayo {
+
+namespace Internal {
+
+// Whether XCAFPrs has to collect style settings from 'label' : then the presentation of 'label'
+// can't be shared with other instances of the same product
+static bool xdeHasOwnStyle(const TDF_Label& label)
+{
+    Handle_XCAFDoc_ColorTool colorTool = XCAFDoc_DocumentTool::ColorTool(label);
+    if (!colorTool.IsNull()) {
+        if (colorTool->IsSet(label, XCAFDoc_ColorGen)
+                || colorTool->IsSet(label, XCAFDoc_ColorSurf)
+                || colorTool->IsSet(label, XCAFDoc_ColorCurv)
+                || !colorTool->IsVisible(label))
+        {
+            return true;
+        }
+    }
+
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 5, 0)
+    TDF_Label labelMaterial;
+    if (XCAFDoc_VisMaterialTool::GetShapeMaterial(label, labelMaterial))
+        return true;
+#endif
+
+    TDF_AttributeSequence seqShuo;
+    return XCaf::isShapeComponent(label)
+            && XCAFDoc_ShapeTool::GetAllComponentSHUO(label, seqShuo);
+}
+
+static void xdeFindInstances(
+        const TDF_Label& labelAssembly,
+        const TopLoc_Location& location,
+        std::vector<AIS_XdeAssembly::Instance>* ptrVecInstance)
+{
+    for (const TDF_Label& component : XCaf::shapeComponents(labelAssembly)) {
+        // Component shape is already located, don't apply its location twice
+        if (xdeHasOwnStyle(component)) {
+            ptrVecInstance->push_back({ component, location });
+            continue;
+        }
+
+        const TDF_Label referred = XCaf::shapeReferred(component);
+        const TopLoc_Location componentLoc = location * XCaf::shapeReferenceLocation(component);
+        if (XCaf::isShapeAssembly(referred) && !xdeHasOwnStyle(referred))
+            xdeFindInstances(referred, componentLoc, ptrVecInstance);
+        else
+            ptrVecInstance->push_back({ referred, componentLoc });
+    }
+}
+
+} // namespace Internal
+
+std::vector<AIS_XdeAssembly::Instance> AIS_XdeAssembly::findInstances(const TDF_Label& label)
+{
+    std::vector<Instance> vecInstance;
+    if (XCaf::isShapeAssembly(label) && !Internal::xdeHasOwnStyle(label))
+        Internal::xdeFindInstances(label, TopLoc_Location(), &vecInstance);
+
+    return vecInstance;
+}
+
+bool AIS_XdeAssembly::hasSharedPrototypes(const std::vector<Instance>& vecInstance)
+{
+    NCollection_Map<TDF_Label, TDF_LabelMapHasher> mapPrototypeLabel;
+    for (const Instance& instance : vecInstance) {
+        if (!mapPrototypeLabel.Add(instance.prototypeLabel))
+            return true;
+    }
+
+    return false;
+}
+
+AIS_XdeAssembly::AIS_XdeAssembly(const TDF_Label& label, const std::vector<Instance>& vecInstance)
+    : m_label(label)
+{
+    MAYO_TRACE_SCOPE("graphics", "AIS_XdeAssembly");
+    NCollection_DataMap<TDF_Label, Handle_XCAFPrs_AISObject, TDF_LabelMapHasher> mapPrototype;
+    for (const Instance& instance : vecInstance) {
+        Handle_XCAFPrs_AISObject prototype;
+        if (!mapPrototype.Find(instance.prototypeLabel, prototype)) {
+            prototype = new XCAFPrs_AISObject(instance.prototypeLabel);
+            mapPrototype.Bind(instance.prototypeLabel, prototype);
+            m_vecPrototype.push_back(prototype);
+        }
+
+        const Handle_AIS_InteractiveObject gfxInstance =
+                this->Connect(prototype, instance.location.Transformation());
+        m_mapInstanceLocation.emplace(gfxInstance.get(), instance.location);
+    }
+
+    static Metrics::Counter& counterPrototypes = Metrics::counter("graphics.xdePrototypes");
+    static Metrics::Counter& counterInstances = Metrics::counter("graphics.xdeInstances");
+    counterPrototypes.add(int64_t(m_vecPrototype.size()));
+    counterInstances.add(int64_t(m_mapInstanceLocation.size()));
+}
+
+TopLoc_Location AIS_XdeAssembly::instanceLocation(const SelectMgr_SelectableObject* object)
+{
+    auto gfxAssembly = object ? dynamic_cast<const AIS_XdeAssembly*>(object->Parent()) : nullptr;
+    if (!gfxAssembly)
+        return TopLoc_Location();
+
+    auto itFound = gfxAssembly->m_mapInstanceLocation.find(object);
+    if (itFound == gfxAssembly->m_mapInstanceLocation.cend())
+        return TopLoc_Location();
+
+    return itFound->second;
+}
+
+} // namespace Mayo
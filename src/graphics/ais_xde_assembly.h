@@ -0,0 +1,82 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include <AIS_MultipleConnectedInteractive.hxx>
+#include <TDF_Label.hxx>
+#include <TopLoc_Location.hxx>
+#include <XCAFPrs_AISObject.hxx>
+#include <unordered_map>
+#include <vector>
+
+namespace Mayo {
+
+class AIS_XdeAssembly;
+DEFINE_STANDARD_HANDLE(AIS_XdeAssembly, AIS_MultipleConnectedInteractive)
+
+// Displays an XDE assembly with presentations shared per unique product : each product is
+// displayed once by a XCAFPrs_AISObject "prototype", then each of its instances is an
+// AIS_ConnectedInteractive carrying only the instance transformation
+// Components having their own style(color, visibility, SHUO) get a prototype of their own, so the
+// instance style overrides are kept
+class AIS_XdeAssembly : public AIS_MultipleConnectedInteractive {
+public:
+    struct Instance {
+        TDF_Label prototypeLabel; // Product label, or component label if it has its own style
+        TopLoc_Location location; // Composed of the locations of the parent components
+    };
+
+    // Instances of the products found in the XDE assembly 'label', empty if 'label' is not an
+    // assembly or if it has its own style
+    static std::vector<Instance> findInstances(const TDF_Label& label);
+
+    // Whether at least one prototype is shared by several instances in 'vecInstance'
+    static bool hasSharedPrototypes(const std::vector<Instance>& vecInstance);
+
+    AIS_XdeAssembly(const TDF_Label& label, const std::vector<Instance>& vecInstance);
+
+    const TDF_Label& label() const { return m_label; }
+
+    const std::vector<Handle_XCAFPrs_AISObject>& prototypes() const { return m_vecPrototype; }
+    int instanceCount() const { return int(m_mapInstanceLocation.size()); }
+
+    // Location in the assembly of the instance 'object'(child of some AIS_XdeAssembly), identity
+    // if 'object' isn't an instance. Shapes of selection owners of an instance are relative to
+    // the prototype and have to be moved by this location
+    static TopLoc_Location instanceLocation(const SelectMgr_SelectableObject* object);
+
+    // Calls 'fn' on 'object' and, if it's an AIS_XdeAssembly, on each of its prototypes
+    // Drawer attributes affecting the shape presentations have to be changed this way
+    template<typename FUNCTION>
+    static void foreachShapeObject(const Handle_AIS_InteractiveObject& object, FUNCTION fn);
+
+    DEFINE_STANDARD_RTTI_INLINE(AIS_XdeAssembly, AIS_MultipleConnectedInteractive)
+
+private:
+    TDF_Label m_label;
+    std::vector<Handle_XCAFPrs_AISObject> m_vecPrototype;
+    std::unordered_map<const SelectMgr_SelectableObject*, TopLoc_Location> m_mapInstanceLocation;
+};
+
+
+
+// --
+// -- Implementation
+// --
+
+template<typename FUNCTION>
+void AIS_XdeAssembly::foreachShapeObject(const Handle_AIS_InteractiveObject& object, FUNCTION fn)
+{
+    fn(object);
+    auto gfxAssembly = Handle_AIS_XdeAssembly::DownCast(object);
+    if (!gfxAssembly.IsNull()) {
+        for (const Handle_XCAFPrs_AISObject& prototype : gfxAssembly->prototypes())
+            fn(prototype);
+    }
+}
+
+} // namespace Mayo
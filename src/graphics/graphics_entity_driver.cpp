@@ -8,23 +8,22 @@
 
 #include "../base/document.h"
 #include "../base/caf_utils.h"
+#include "../base/mesh_normals.h"
+#include "../base/point_cloud.h"
+#include "ais_mesh.h"
+#include "ais_point_cloud_lod.h"
+#include "ais_xde_assembly.h"
 #include "graphics_entity_base_property_group.h"
-#include "graphics_mesh_data_source.h"
 #include "graphics_scene.h"
 
 #include <AIS_DisplayMode.hxx>
 #include <BRep_TFace.hxx>
-#include <MeshVS_DisplayModeFlags.hxx>
-#include <MeshVS_DrawerAttribute.hxx>
-#include <MeshVS_Drawer.hxx>
-#include <MeshVS_Mesh.hxx>
-#include <MeshVS_MeshPrsBuilder.hxx>
 #include <Prs3d_LineAspect.hxx>
 #include <V3d_View.hxx>
 #include <V3d_Viewer.hxx>
 #include <TDataXtd_Triangulation.hxx>
 #include <XCAFPrs_AISObject.hxx>
-#include <XSDRAWSTLVRML_DataSource.hxx>
+#include <climits>
 #include <stdexcept>
 
 namespace Mayo {
@@ -87,12 +86,22 @@ GraphicsEntity GraphicsShapeEntityDriver::createEntity(const TDF_Label& label) c
     GraphicsEntity entity;
     this->initEntity(&entity, label);
     if (XCaf::isShape(label)) {
-        Handle_XCAFPrs_AISObject gpx = new XCAFPrs_AISObject(label);
-        gpx->SetDisplayMode(AIS_Shaded);
-        gpx->Attributes()->SetFaceBoundaryDraw(true);
-        gpx->Attributes()->SetFaceBoundaryAspect(
-                    new Prs3d_LineAspect(Quantity_NOC_BLACK, Aspect_TOL_SOLID, 1.));
-        gpx->Attributes()->SetIsoOnTriangulation(true);
+        // Repeated products of an assembly share their presentations
+        Handle_AIS_InteractiveObject gpx;
+        const std::vector<AIS_XdeAssembly::Instance> vecInstance =
+                AIS_XdeAssembly::findInstances(label);
+        if (AIS_XdeAssembly::hasSharedPrototypes(vecInstance))
+            gpx = new AIS_XdeAssembly(label, vecInstance);
+        else
+            gpx = new XCAFPrs_AISObject(label);
+
+        AIS_XdeAssembly::foreachShapeObject(gpx, [](const Handle_AIS_InteractiveObject& object) {
+            object->SetDisplayMode(AIS_Shaded);
+            object->Attributes()->SetFaceBoundaryDraw(true);
+            object->Attributes()->SetFaceBoundaryAspect(
+                        new Prs3d_LineAspect(Quantity_NOC_BLACK, Aspect_TOL_SOLID, 1.));
+            object->Attributes()->SetIsoOnTriangulation(true);
+        });
         GraphicsEntityDriver::setEntityAisObject(&entity, gpx);
     }
     else if (CafUtils::hasAttribute<TDataXtd_Triangulation>(label)) {
@@ -105,23 +114,13 @@ void GraphicsShapeEntityDriver::applyDisplayMode(GraphicsEntity* entity, Enumera
 {
     this->throwIf_differentDriver(*entity);
     this->throwIf_invalidDisplayMode(mode);
-    const GraphicsScene* gfxScene = entity->graphicsScene();
-    auto fnSetViewComputedMode = [=](bool on) {
-        V3d_ListOfViewIterator viewIter = gfxScene->v3dViewer()->DefinedViewIterator();
-        while (viewIter.More()) {
-            viewIter.Value()->SetComputedMode(on);
-            viewIter.Next();
-        }
-    };
+    GraphicsScene* gfxScene = entity->graphicsScene();
     if (mode == DisplayMode_HiddenLineRemoval) {
-        gfxScene->defaultPrs3dDrawer()->SetTypeOfHLR(Prs3d_TOH_PolyAlgo);
-        gfxScene->defaultPrs3dDrawer()->EnableDrawHiddenLine();
-        fnSetViewComputedMode(true);
+        // Lines are computed in background, see GuiHiddenLineDisplay
+        gfxScene->setHiddenLineDrawingOn(true);
     }
     else {
-        gfxScene->defaultPrs3dDrawer()->SetTypeOfHLR(Prs3d_TOH_NotSet);
-        gfxScene->defaultPrs3dDrawer()->DisableDrawHiddenLine();
-        fnSetViewComputedMode(false);
+        gfxScene->setHiddenLineDrawingOn(false);
         const AIS_DisplayMode aisDispMode = mode == DisplayMode_Wireframe ? AIS_WireFrame : AIS_Shaded;
         const bool showFaceBounds = mode == DisplayMode_ShadedWithFaceBoundary;
         const Handle_AIS_InteractiveObject& aisObject = entity->aisObject();
@@ -129,8 +128,11 @@ void GraphicsShapeEntityDriver::applyDisplayMode(GraphicsEntity* entity, Enumera
             entity->setDisplayMode(aisDispMode);
 
         if (aisObject->Attributes()->FaceBoundaryDraw() != showFaceBounds) {
-            aisObject->Attributes()->SetFaceBoundaryDraw(showFaceBounds);
-            aisObject->Redisplay(true);
+            auto fnSetFaceBoundaryDraw = [=](const Handle_AIS_InteractiveObject& object) {
+                object->Attributes()->SetFaceBoundaryDraw(showFaceBounds);
+            };
+            AIS_XdeAssembly::foreachShapeObject(aisObject, fnSetFaceBoundaryDraw);
+            gfxScene->recomputeObjectPresentationOnly(aisObject);
         }
     }
 
@@ -165,9 +167,9 @@ std::unique_ptr<PropertyGroupSignals> GraphicsShapeEntityDriver::properties(cons
 GraphicsMeshEntityDriver::GraphicsMeshEntityDriver()
 {
     this->setDisplayModes({
-        { MeshVS_DMF_WireFrame, GraphicsEntityDriverI18N::textId("WIREFRAME"), {} },
-        { MeshVS_DMF_Shading, GraphicsEntityDriverI18N::textId("SHADED"), {} },
-        { MeshVS_DMF_Shrink, GraphicsEntityDriverI18N::textId("SHRINK"), {} } // MeshVS_DA_ShrinkCoeff
+        { AIS_Mesh::DisplayMode_Wireframe, GraphicsEntityDriverI18N::textId("WIREFRAME"), {} },
+        { AIS_Mesh::DisplayMode_Shaded, GraphicsEntityDriverI18N::textId("SHADED"), {} },
+        { AIS_Mesh::DisplayMode_Nodes, GraphicsEntityDriverI18N::textId("NODES"), {} }
     });
 }
 
@@ -207,23 +209,14 @@ GraphicsEntity GraphicsMeshEntityDriver::createEntity(const TDF_Label& label) co
     }
 
     if (!polyTri.IsNull()) {
-        Handle_MeshVS_Mesh gpx = new MeshVS_Mesh;
-        gpx->SetDataSource(new GraphicsMeshDataSource(polyTri));
-        // meshVisu->AddBuilder(..., false); -> No selection
-        gpx->AddBuilder(new MeshVS_MeshPrsBuilder(gpx), true);
-
-        // -- MeshVS_DrawerAttribute
-        gpx->GetDrawer()->SetBoolean(MeshVS_DA_ShowEdges, defaultValues().showEdges);
-        gpx->GetDrawer()->SetBoolean(MeshVS_DA_DisplayNodes, defaultValues().showNodes);
-        gpx->GetDrawer()->SetMaterial(MeshVS_DA_FrontMaterial, Graphic3d_NOM_PLASTIC);
-        gpx->GetDrawer()->SetColor(MeshVS_DA_InteriorColor, defaultValues().color);
-        gpx->GetDrawer()->SetMaterial(
-                    MeshVS_DA_FrontMaterial, Graphic3d_MaterialAspect(defaultValues().material));
-        gpx->GetDrawer()->SetColor(MeshVS_DA_EdgeColor, defaultValues().edgeColor);
-        gpx->SetDisplayMode(MeshVS_DMF_Shading);
-
-        //gpx->SetHilightMode(MeshVS_DMF_WireFrame);
-        gpx->SetMeshSelMethod(MeshVS_MSM_PRECISE);
+        Handle_AIS_Mesh gpx = new AIS_Mesh(polyTri);
+        gpx->setShowEdges(defaultValues().showEdges);
+        gpx->setShowNodes(defaultValues().showNodes);
+        gpx->setColor(defaultValues().color);
+        gpx->setMaterial(Graphic3d_MaterialAspect(defaultValues().material));
+        gpx->setEdgeColor(defaultValues().edgeColor);
+        gpx->setCreaseAngle(MeshNormals::labelCreaseAngle(label));
+        gpx->SetDisplayMode(AIS_Mesh::DisplayMode_Shaded);
         GraphicsEntityDriver::setEntityAisObject(&entity, gpx);
     }
 
@@ -248,7 +241,7 @@ class GraphicsMeshEntityDriver::EntityProperties : public GraphicsEntityBaseProp
 public:
     EntityProperties(const GraphicsEntity& entity)
         : GraphicsEntityBasePropertyGroup(entity),
-          m_meshVisu(Handle_MeshVS_Mesh::DownCast(entity.aisObject())),
+          m_meshVisu(Handle_AIS_Mesh::DownCast(entity.aisObject())),
           m_propertyColor(this, textId("color")),
           m_propertyEdgeColor(this, textId("edgeColor")),
           m_propertyShowEdges(this, textId("showEdges")),
@@ -257,21 +250,10 @@ public:
         // Init properties
         Mayo_PropertyChangedBlocker(this);
 
-        // -- Color
-        Quantity_Color color;
-        m_meshVisu->GetDrawer()->GetColor(MeshVS_DA_InteriorColor, color);
-        m_propertyColor.setValue(color);
-        // -- Edge color
-        Quantity_Color edgeColor;
-        m_meshVisu->GetDrawer()->GetColor(MeshVS_DA_EdgeColor, edgeColor);
-        m_propertyEdgeColor.setValue(edgeColor);
-        // -- Show edges
-        bool boolVal;
-        m_meshVisu->GetDrawer()->GetBoolean(MeshVS_DA_ShowEdges, boolVal);
-        m_propertyShowEdges.setValue(boolVal);
-        // -- Show nodes
-        m_meshVisu->GetDrawer()->GetBoolean(MeshVS_DA_DisplayNodes, boolVal);
-        m_propertyShowNodes.setValue(boolVal);
+        m_propertyColor.setValue(m_meshVisu->color());
+        m_propertyEdgeColor.setValue(m_meshVisu->edgeColor());
+        m_propertyShowEdges.setValue(m_meshVisu->showEdges());
+        m_propertyShowNodes.setValue(m_meshVisu->showNodes());
     }
 
     void onPropertyChanged(Property* prop) override {
@@ -280,26 +262,26 @@ public:
         };
 
         if (prop == &m_propertyShowEdges) {
-            m_meshVisu->GetDrawer()->SetBoolean(MeshVS_DA_ShowEdges, m_propertyShowEdges.value());
+            m_meshVisu->setShowEdges(m_propertyShowEdges.value());
             fnRedisplay(m_meshVisu);
         }
         else if (prop == &m_propertyShowNodes) {
-            m_meshVisu->GetDrawer()->SetBoolean(MeshVS_DA_DisplayNodes, m_propertyShowNodes.value());
+            m_meshVisu->setShowNodes(m_propertyShowNodes.value());
             fnRedisplay(m_meshVisu);
         }
         else if (prop == &m_propertyColor) {
-            m_meshVisu->GetDrawer()->SetColor(MeshVS_DA_InteriorColor, m_propertyColor.value());
+            m_meshVisu->setColor(m_propertyColor.value());
             fnRedisplay(m_meshVisu);
         }
         else if (prop == &m_propertyEdgeColor) {
-            m_meshVisu->GetDrawer()->SetColor(MeshVS_DA_EdgeColor, m_propertyEdgeColor.value());
+            m_meshVisu->setEdgeColor(m_propertyEdgeColor.value());
             fnRedisplay(m_meshVisu);
         }
 
         GraphicsEntityBasePropertyGroup::onPropertyChanged(prop);
     }
 
-    Handle_MeshVS_Mesh m_meshVisu;
+    Handle_AIS_Mesh m_meshVisu;
     PropertyOccColor m_propertyColor;
     PropertyOccColor m_propertyEdgeColor;
     PropertyBool m_propertyShowEdges;
@@ -328,4 +310,97 @@ void GraphicsMeshEntityDriver::setDefaultValues(const DefaultValues& values)
     *Internal::graphicsMeshDefaultValues = values;
 }
 
+GraphicsPointCloudEntityDriver::GraphicsPointCloudEntityDriver()
+{
+    this->setDisplayModes({
+        { 0, GraphicsEntityDriverI18N::textId("POINTS"), {} }
+    });
+}
+
+GraphicsEntityDriver::Support GraphicsPointCloudEntityDriver::supportStatus(
+        const TDF_Label& label) const
+{
+    if (CafUtils::hasAttribute<PointCloudAttribute>(label))
+        return Support::Complete;
+
+    return Support::None;
+}
+
+GraphicsEntity GraphicsPointCloudEntityDriver::createEntity(const TDF_Label& label) const
+{
+    GraphicsEntity entity;
+    this->initEntity(&entity, label);
+    auto attrPointCloud = CafUtils::findAttribute<PointCloudAttribute>(label);
+    if (!attrPointCloud.IsNull() && !attrPointCloud->get().IsNull()) {
+        Handle_AIS_PointCloudLod gfx = new AIS_PointCloudLod(attrPointCloud->get());
+        gfx->SetDisplayMode(0);
+        GraphicsEntityDriver::setEntityAisObject(&entity, gfx);
+    }
+
+    return entity;
+}
+
+void GraphicsPointCloudEntityDriver::applyDisplayMode(
+        GraphicsEntity* entity, Enumeration::Value mode) const
+{
+    this->throwIf_differentDriver(*entity);
+    this->throwIf_invalidDisplayMode(mode);
+    entity->setDisplayMode(mode);
+}
+
+Enumeration::Value GraphicsPointCloudEntityDriver::currentDisplayMode(
+        const GraphicsEntity& entity) const
+{
+    this->throwIf_differentDriver(entity);
+    return entity.displayMode();
+}
+
+class GraphicsPointCloudEntityDriver::EntityProperties : public GraphicsEntityBasePropertyGroup {
+    MAYO_DECLARE_TEXT_ID_FUNCTIONS(Mayo::GraphicsPointCloudEntityDriver_EntityProperties)
+public:
+    EntityProperties(const GraphicsEntity& entity)
+        : GraphicsEntityBasePropertyGroup(entity),
+          m_gfx(Handle_AIS_PointCloudLod::DownCast(entity.aisObject())),
+          m_propertyPointBudget(this, textId("pointBudget")),
+          m_propertyColor(this, textId("color"))
+    {
+        m_propertyPointBudget.setDescription(
+                    textId("Maximum count of points drawn, "
+                           "the point cloud is refined where it appears the biggest").tr());
+        m_propertyPointBudget.setRange(1000, INT_MAX);
+        m_propertyPointBudget.setConstraintsEnabled(true);
+        m_propertyColor.setDescription(
+                    textId("Color of points, used when the point cloud has no colors").tr());
+
+        // Init properties
+        Mayo_PropertyChangedBlocker(this);
+        m_propertyPointBudget.setValue(m_gfx->pointBudget());
+        m_propertyColor.setValue(m_gfx->defaultColor());
+    }
+
+    void onPropertyChanged(Property* prop) override {
+        if (prop == &m_propertyPointBudget) {
+            // Level of detail is selected again on next view update
+            m_gfx->setPointBudget(m_propertyPointBudget.value());
+        }
+        else if (prop == &m_propertyColor) {
+            m_gfx->setDefaultColor(m_propertyColor.value());
+            m_gfx->Redisplay(true);
+        }
+
+        GraphicsEntityBasePropertyGroup::onPropertyChanged(prop);
+    }
+
+    Handle_AIS_PointCloudLod m_gfx;
+    PropertyInt m_propertyPointBudget;
+    PropertyOccColor m_propertyColor;
+};
+
+std::unique_ptr<PropertyGroupSignals> GraphicsPointCloudEntityDriver::properties(
+        const GraphicsEntity& entity) const
+{
+    this->throwIf_differentDriver(entity);
+    return std::make_unique<EntityProperties>(entity);
+}
+
 } // namespace Mayo
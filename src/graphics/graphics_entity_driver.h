@@ -88,4 +88,17 @@ private:
     class EntityProperties;
 };
 
+class GraphicsPointCloudEntityDriver : public GraphicsEntityDriver {
+public:
+    GraphicsPointCloudEntityDriver();
+    Support supportStatus(const TDF_Label& label) const override;
+    GraphicsEntity createEntity(const TDF_Label& label) const override;
+    void applyDisplayMode(GraphicsEntity* entity, Enumeration::Value mode) const override;
+    Enumeration::Value currentDisplayMode(const GraphicsEntity& entity) const override;
+    std::unique_ptr<PropertyGroupSignals> properties(const GraphicsEntity& entity) const override;
+
+private:
+    class EntityProperties;
+};
+
 } // namespace Mayo
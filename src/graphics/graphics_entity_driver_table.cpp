@@ -6,6 +6,7 @@
 
 #include "graphics_entity_driver_table.h"
 #include "graphics_entity_driver.h"
+#include "../base/metrics.h"
 
 namespace Mayo {
 
@@ -16,6 +17,8 @@ void GraphicsEntityDriverTable::addDriver(DriverPtr driver)
 
 GraphicsEntity GraphicsEntityDriverTable::createEntity(const TDF_Label& label) const
 {
+    static Metrics::Counter& counterPresentations = Metrics::counter("graphics.presentationsComputed");
+    counterPresentations.add();
     GraphicsEntityDriver* driverPartialSupport = nullptr;
     for (const DriverPtr& driver : m_vecDriver) {
         const GraphicsEntityDriver::Support support = driver->supportStatus(label);
@@ -0,0 +1,216 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "graphics_hlr.h"
+
+#include "../base/bnd_utils.h"
+#include "../base/task_progress.h"
+#include "../base/thread_budget.h"
+#include "../base/tracing.h"
+
+#include <BRepAdaptor_Curve.hxx>
+#include <BRepLib.hxx>
+#include <BRep_Tool.hxx>
+#include <GCPnts_TangentialDeflection.hxx>
+#include <HLRAlgo_Projector.hxx>
+#include <HLRBRep_Algo.hxx>
+#include <HLRBRep_HLRToShape.hxx>
+#include <HLRBRep_PolyAlgo.hxx>
+#include <HLRBRep_PolyHLRToShape.hxx>
+#include <TopExp_Explorer.hxx>
+#include <TopoDS.hxx>
+#include <TopoDS_Iterator.hxx>
+#include <algorithm>
+#include <cmath>
+
+namespace Mayo {
+
+namespace Internal {
+
+// Angular deflection used to discretize the curved lines
+static const double hlrAngularDeflection = 0.1; // rad
+
+// Extent of a part in the coordinate system of the view plane
+struct HlrPartExtent {
+    double xmin = RealLast();
+    double ymin = RealLast();
+    double zmin = RealLast();
+    double xmax = RealFirst();
+    double ymax = RealFirst();
+    double zmax = RealFirst();
+};
+
+static HlrPartExtent hlrPartExtent(const TopoDS_Shape& part, const gp_Ax2& viewPlane)
+{
+    HlrPartExtent extent;
+    const Bnd_Box bndBox = BndUtils::geometryBoundingBox(part);
+    if (bndBox.IsVoid())
+        return extent;
+
+    for (const gp_Pnt& pnt : BndBoxCoords::get(bndBox).vertices()) {
+        const gp_Vec vec(viewPlane.Location(), pnt);
+        const double x = vec.Dot(gp_Vec(viewPlane.XDirection()));
+        const double y = vec.Dot(gp_Vec(viewPlane.YDirection()));
+        const double z = vec.Dot(gp_Vec(viewPlane.Direction()));
+        extent.xmin = std::min(extent.xmin, x);
+        extent.ymin = std::min(extent.ymin, y);
+        extent.zmin = std::min(extent.zmin, z);
+        extent.xmax = std::max(extent.xmax, x);
+        extent.ymax = std::max(extent.ymax, y);
+        extent.zmax = std::max(extent.zmax, z);
+    }
+
+    return extent;
+}
+
+// Whether part of extent 'other' might hide some lines of part of extent 'extent'
+static bool hlrMightHide(const HlrPartExtent& other, const HlrPartExtent& extent)
+{
+    return other.xmin <= extent.xmax && other.xmax >= extent.xmin
+            && other.ymin <= extent.ymax && other.ymax >= extent.ymin
+            && other.zmax >= extent.zmin;
+}
+
+// Appends the edges of 'shape'(HLR output, lying in the XY plane of the projector) as segments
+// located in 'viewPlane'
+static void hlrAddEdges(
+        const TopoDS_Shape& shape,
+        const gp_Ax2& viewPlane,
+        double deflection,
+        std::vector<gp_Pnt>* ptrVecPoint)
+{
+    if (shape.IsNull())
+        return;
+
+    BRepLib::BuildCurves3d(shape);
+    const gp_Vec vecX(viewPlane.XDirection());
+    const gp_Vec vecY(viewPlane.YDirection());
+    auto fnToViewPlane = [&](const gp_Pnt& pnt) {
+        return viewPlane.Location().Translated(pnt.X() * vecX + pnt.Y() * vecY);
+    };
+    for (TopExp_Explorer expEdge(shape, TopAbs_EDGE); expEdge.More(); expEdge.Next()) {
+        const TopoDS_Edge& edge = TopoDS::Edge(expEdge.Current());
+        if (!BRep_Tool::IsGeometric(edge))
+            continue;
+
+        const BRepAdaptor_Curve curve(edge);
+        const GCPnts_TangentialDeflection discretizer(
+                    curve, Internal::hlrAngularDeflection, deflection);
+        for (int i = 2; i <= discretizer.NbPoints(); ++i) {
+            ptrVecPoint->push_back(fnToViewPlane(discretizer.Value(i - 1)));
+            ptrVecPoint->push_back(fnToViewPlane(discretizer.Value(i)));
+        }
+    }
+}
+
+} // namespace Internal
+
+GraphicsHlr::Result GraphicsHlr::compute(
+        Span<const TopoDS_Shape> spanPart,
+        const gp_Ax2& viewPlane,
+        Algorithm algo,
+        TaskProgress* progress)
+{
+    MAYO_TRACE_SCOPE("graphics", "GraphicsHlr::compute");
+    Result result;
+    if (spanPart.empty())
+        return result;
+
+    // Chordal deflection of the lines relative to the size of the parts
+    Bnd_Box bndBoxAll;
+    for (const TopoDS_Shape& part : spanPart)
+        BndUtils::add(&bndBoxAll, BndUtils::geometryBoundingBox(part));
+
+    const double deflection = !bndBoxAll.IsVoid() ?
+                1e-4 * std::sqrt(bndBoxAll.SquareExtent()) :
+                Precision::Confusion();
+    const HLRAlgo_Projector projector(viewPlane);
+    if (algo == Algorithm::Polygonal) {
+        Handle_HLRBRep_PolyAlgo polyAlgo = new HLRBRep_PolyAlgo;
+        for (const TopoDS_Shape& part : spanPart)
+            polyAlgo->Load(part);
+
+        polyAlgo->Projector(projector);
+        polyAlgo->Update();
+        if (TaskProgress::isAbortRequested(progress))
+            return result;
+
+        HLRBRep_PolyHLRToShape toShape;
+        toShape.Update(polyAlgo);
+        Internal::hlrAddEdges(toShape.VCompound(), viewPlane, deflection, &result.vecVisiblePoint);
+        Internal::hlrAddEdges(
+                    toShape.OutLineVCompound(), viewPlane, deflection, &result.vecVisiblePoint);
+        Internal::hlrAddEdges(toShape.HCompound(), viewPlane, deflection, &result.vecHiddenPoint);
+        Internal::hlrAddEdges(
+                    toShape.OutLineHCompound(), viewPlane, deflection, &result.vecHiddenPoint);
+        return result;
+    }
+
+    // Exact algorithm : each part is computed along with the parts that might hide it
+    const int partCount = int(spanPart.size());
+    std::vector<Internal::HlrPartExtent> vecExtent;
+    vecExtent.reserve(partCount);
+    for (const TopoDS_Shape& part : spanPart)
+        vecExtent.push_back(Internal::hlrPartExtent(part, viewPlane));
+
+    std::vector<Result> vecPartResult(partCount);
+    ThreadBudget::parallelFor(0, partCount, [&](int i) {
+        if (TaskProgress::isAbortRequested(progress))
+            return;
+
+        const TopoDS_Shape& part = spanPart[i];
+        Handle_HLRBRep_Algo exactAlgo = new HLRBRep_Algo;
+        exactAlgo->Add(part);
+        for (int j = 0; j < partCount; ++j) {
+            if (j != i && Internal::hlrMightHide(vecExtent.at(j), vecExtent.at(i)))
+                exactAlgo->Add(spanPart[j]);
+        }
+
+        exactAlgo->Projector(projector);
+        exactAlgo->Update();
+        exactAlgo->Hide();
+        HLRBRep_HLRToShape toShape(exactAlgo);
+        Result& partResult = vecPartResult.at(i);
+        std::vector<gp_Pnt>* ptrVecVisible = &partResult.vecVisiblePoint;
+        std::vector<gp_Pnt>* ptrVecHidden = &partResult.vecHiddenPoint;
+        Internal::hlrAddEdges(toShape.VCompound(part), viewPlane, deflection, ptrVecVisible);
+        Internal::hlrAddEdges(toShape.OutLineVCompound(part), viewPlane, deflection, ptrVecVisible);
+        Internal::hlrAddEdges(toShape.HCompound(part), viewPlane, deflection, ptrVecHidden);
+        Internal::hlrAddEdges(toShape.OutLineHCompound(part), viewPlane, deflection, ptrVecHidden);
+    });
+
+    if (TaskProgress::isAbortRequested(progress))
+        return result;
+
+    for (const Result& partResult : vecPartResult) {
+        result.vecVisiblePoint.insert(
+                    result.vecVisiblePoint.end(),
+                    partResult.vecVisiblePoint.cbegin(),
+                    partResult.vecVisiblePoint.cend());
+        result.vecHiddenPoint.insert(
+                    result.vecHiddenPoint.end(),
+                    partResult.vecHiddenPoint.cbegin(),
+                    partResult.vecHiddenPoint.cend());
+    }
+
+    return result;
+}
+
+void GraphicsHlr::explodeParts(const TopoDS_Shape& shape, std::vector<TopoDS_Shape>* ptrVecPart)
+{
+    if (shape.IsNull())
+        return;
+
+    if (shape.ShapeType() != TopAbs_COMPOUND) {
+        ptrVecPart->push_back(shape);
+        return;
+    }
+
+    for (TopoDS_Iterator it(shape); it.More(); it.Next())
+        GraphicsHlr::explodeParts(it.Value(), ptrVecPart);
+}
+
+} // namespace Mayo
@@ -0,0 +1,48 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "../base/span.h"
+
+#include <gp_Ax2.hxx>
+#include <gp_Pnt.hxx>
+#include <TopoDS_Shape.hxx>
+#include <vector>
+
+namespace Mayo {
+
+class TaskProgress;
+
+// Hidden-line removal(HLR) of shapes for an orthographic projection. Functions don't touch any
+// graphics object, they're meant to run in a worker thread
+struct GraphicsHlr {
+    enum class Algorithm {
+        Polygonal, // HLRBRep_PolyAlgo on face triangulations, fast
+        Exact // HLRBRep_Algo on exact geometry, slow but print quality
+    };
+
+    // Projected lines as segments, pairs of consecutive points are the segment ends
+    struct Result {
+        std::vector<gp_Pnt> vecVisiblePoint;
+        std::vector<gp_Pnt> vecHiddenPoint;
+    };
+
+    // Lines of the shapes 'spanPart' projected along the Z direction of 'viewPlane'(pointing
+    // towards the viewer). Lines lie in 'viewPlane', so they can be drawn as is in 3D
+    // Exact algorithm processes the parts in parallel, each one along with the parts that might
+    // hide it. Returns an empty result if aborted
+    static Result compute(
+            Span<const TopoDS_Shape> spanPart,
+            const gp_Ax2& viewPlane,
+            Algorithm algo,
+            TaskProgress* progress = nullptr);
+
+    // Leaf shapes of 'shape'(ie not compounds), located as in 'shape'
+    static void explodeParts(const TopoDS_Shape& shape, std::vector<TopoDS_Shape>* ptrVecPart);
+};
+
+} // namespace Mayo
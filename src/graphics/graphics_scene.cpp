@@ -6,12 +6,20 @@
 
 #include "graphics_scene.h"
 
+#include "../base/metrics.h"
 #include "../base/tkernel_utils.h"
+#include "ais_shape_batch.h"
+#include "ais_xde_assembly.h"
 #include "graphics_utils.h"
 
 #include <Graphic3d_GraphicDriver.hxx>
+#include <StdSelect_BRepOwner.hxx>
 #include <V3d_TypeOfOrientation.hxx>
+#include <QtCore/QElapsedTimer>
 #include <QtCore/QPoint>
+#include <QtCore/QTimer>
+#include <algorithm>
+#include <unordered_map>
 
 namespace Mayo {
 namespace Internal {
@@ -33,6 +41,19 @@ static Handle_V3d_Viewer createOccViewer()
     return viewer;
 }
 
+// Minimum interval between two hover picks
+static const qint64 highlightRequestFrameInterval = 16; // ms
+
+static void applyFrameStatsOverlay(const Handle_V3d_View& view, bool on)
+{
+    Graphic3d_RenderingParams& params = view->ChangeRenderingParams();
+    params.ToShowStats = on;
+    params.CollectedStats = Graphic3d_RenderingParams::PerfCounters(
+                Graphic3d_RenderingParams::PerfCounters_FrameRate
+                | Graphic3d_RenderingParams::PerfCounters_GroupArrays
+                | Graphic3d_RenderingParams::PerfCounters_Triangles);
+}
+
 } // namespace Internal
 
 namespace {
@@ -53,10 +74,37 @@ DEFINE_STANDARD_HANDLE(InteractiveContext, AIS_InteractiveContext)
 
 class GraphicsScene::Private {
 public:
+    struct StaticBatch {
+        GraphicsObjectPtr object;
+        Handle_AIS_ShapeBatch batch;
+    };
+
     Handle_V3d_Viewer m_v3dViewer;
     Handle_InteractiveContext m_aisContext;
     std::unordered_set<const AIS_InteractiveObject*> m_setClipPlaneSensitive;
+    std::unordered_map<const AIS_InteractiveObject*, StaticBatch> m_mapStaticBatch;
+    std::unordered_set<const AIS_InteractiveObject*> m_setPresentationHidden;
+    // Objects whose display is deferred, along with their requested visibility
+    std::unordered_map<const AIS_InteractiveObject*, bool> m_mapDeferredObjectVisible;
+    // Objects whose selection is computed by a worker thread, along with their requested
+    // visibility applied once computed
+    std::unordered_map<const AIS_InteractiveObject*, bool> m_mapSelectionComputingVisible;
+    bool m_isHiddenLineDrawingOn = false;
+    bool m_isStaticBatchingOn = false;
+    bool m_isStaticBatchSplitDirty = false;
     bool m_isRedrawBlocked = false;
+    bool m_isFrameStatsOverlayVisible = false;
+
+    QTimer* m_redrawTimer = nullptr;
+    QElapsedTimer m_lastFrameChrono; // Started at the beginning of the last rendered frame
+    qint64 m_frameRateActiveTimeNs = 0; // Sum of the intervals between consecutive frames
+    int m_frameRateIntervalCount = 0;
+
+    QTimer* m_highlightRequestTimer = nullptr;
+    QPoint m_highlightRequestPos;
+    Handle_V3d_View m_highlightRequestView; // Null if no pending request
+    QElapsedTimer m_highlightChrono; // Started at the end of the last pick
+    qint64 m_highlightLastDuration = 0; // ms
 };
 
 GraphicsScene::GraphicsScene(QObject* parent)
@@ -65,6 +113,15 @@ GraphicsScene::GraphicsScene(QObject* parent)
 {
     d->m_v3dViewer = Internal::createOccViewer();
     d->m_aisContext = new InteractiveContext(d->m_v3dViewer);
+    d->m_redrawTimer = new QTimer(this);
+    d->m_redrawTimer->setSingleShot(true);
+    d->m_redrawTimer->setInterval(0);
+    QObject::connect(d->m_redrawTimer, &QTimer::timeout, this, &GraphicsScene::renderFrame);
+    d->m_highlightRequestTimer = new QTimer(this);
+    d->m_highlightRequestTimer->setSingleShot(true);
+    QObject::connect(
+                d->m_highlightRequestTimer, &QTimer::timeout,
+                this, &GraphicsScene::flushHighlightRequest);
 }
 
 GraphicsScene::~GraphicsScene()
@@ -74,7 +131,11 @@ GraphicsScene::~GraphicsScene()
 
 opencascade::handle<V3d_View> GraphicsScene::createV3dView()
 {
-    return d->m_v3dViewer->CreateView();
+    Handle_V3d_View view = d->m_v3dViewer->CreateView();
+    if (d->m_isFrameStatsOverlayVisible)
+        Internal::applyFrameStatsOverlay(view, true);
+
+    return view;
 }
 
 const opencascade::handle<V3d_Viewer>& GraphicsScene::v3dViewer() const
@@ -94,24 +155,102 @@ const opencascade::handle<StdSelect_ViewerSelector3d>& GraphicsScene::mainSelect
 
 bool GraphicsScene::hiddenLineDrawingOn() const
 {
-    return d->m_aisContext->DrawHiddenLine();
+    return d->m_isHiddenLineDrawingOn;
+}
+
+void GraphicsScene::setHiddenLineDrawingOn(bool on)
+{
+    if (d->m_isHiddenLineDrawingOn == on)
+        return;
+
+    d->m_isHiddenLineDrawingOn = on;
+    emit hiddenLineDrawingChanged(on);
+}
+
+void GraphicsScene::addObject(const GraphicsObjectPtr& object, AddObjectFlag flags)
+{
+    if (flags & AddObjectDisableSelectionMode) {
+        const int displayMode =
+                GraphicsUtils::AisContext_objectDisplayMode(d->m_aisContext, object);
+        d->m_aisContext->Display(object, displayMode, -1, false);
+    }
+    else {
+        d->m_aisContext->Display(object, false);
+    }
+
+    auto itDeferred = d->m_mapDeferredObjectVisible.find(object.get());
+    if (itDeferred != d->m_mapDeferredObjectVisible.end()) {
+        // Object was hidden before it could be displayed
+        if (!itDeferred->second)
+            d->m_aisContext->Erase(object, false);
+
+        d->m_mapDeferredObjectVisible.erase(itDeferred);
+    }
+
+    this->updateStaticBatch(object);
 }
 
-void GraphicsScene::addObject(const GraphicsObjectPtr& object)
+void GraphicsScene::deferObjectDisplay(const GraphicsObjectPtr& object)
 {
-    d->m_aisContext->Display(object, false);
+    if (!object.IsNull() && !d->m_aisContext->IsDisplayed(object))
+        d->m_mapDeferredObjectVisible.insert({ object.get(), true });
 }
 
 void GraphicsScene::eraseObject(const GraphicsObjectPtr& object)
 {
     GraphicsUtils::AisContext_eraseObject(d->m_aisContext, object);
     d->m_setClipPlaneSensitive.erase(object.get());
+    d->m_setPresentationHidden.erase(object.get());
+    d->m_mapDeferredObjectVisible.erase(object.get());
+    d->m_mapSelectionComputingVisible.erase(object.get());
+    auto itBatch = d->m_mapStaticBatch.find(object.get());
+    if (itBatch != d->m_mapStaticBatch.end()) {
+        GraphicsUtils::AisContext_eraseObject(d->m_aisContext, itBatch->second.batch);
+        d->m_mapStaticBatch.erase(itBatch);
+    }
 }
 
 void GraphicsScene::redraw()
 {
-    if (!d->m_isRedrawBlocked)
-        d->m_aisContext->UpdateCurrentViewer();
+    if (d->m_isRedrawBlocked)
+        return;
+
+    static Metrics::Counter& counterRequests = Metrics::counter("graphics.redrawRequests");
+    counterRequests.add();
+    if (!d->m_redrawTimer->isActive())
+        d->m_redrawTimer->start();
+}
+
+void GraphicsScene::renderFrame()
+{
+    // Selection changes are applied to the batches once per frame
+    if (d->m_isStaticBatchSplitDirty)
+        this->updateStaticBatchSplitShapes();
+
+    static Metrics::Counter& counterRedraw = Metrics::counter("graphics.redrawCount");
+    static Metrics::Histogram& histoFrameTime = Metrics::histogram("graphics.frameTimeMs");
+    static Metrics::Gauge& gaugeFrameRate = Metrics::gauge("graphics.frameRate");
+    // Frames are rendered on demand, so frame rate is measured over intervals between
+    // consecutive frames only. An interval longer than the threshold is an idle period (no
+    // interaction) and is left out of the measure
+    constexpr qint64 frameIdleThresholdNs = 250 * 1000 * 1000;
+    if (d->m_lastFrameChrono.isValid()) {
+        const qint64 frameIntervalNs = d->m_lastFrameChrono.nsecsElapsed();
+        if (frameIntervalNs < frameIdleThresholdNs) {
+            d->m_frameRateActiveTimeNs += frameIntervalNs;
+            ++d->m_frameRateIntervalCount;
+        }
+    }
+
+    d->m_lastFrameChrono.start();
+    d->m_aisContext->UpdateCurrentViewer();
+    counterRedraw.add();
+    histoFrameTime.record(d->m_lastFrameChrono.nsecsElapsed() / 1e6);
+    if (d->m_frameRateActiveTimeNs >= 1000 * 1000 * 1000) {
+        gaugeFrameRate.set(d->m_frameRateIntervalCount * 1e9 / d->m_frameRateActiveTimeNs);
+        d->m_frameRateActiveTimeNs = 0;
+        d->m_frameRateIntervalCount = 0;
+    }
 }
 
 bool GraphicsScene::isRedrawBlocked() const
@@ -124,11 +263,58 @@ void GraphicsScene::blockRedraw(bool on)
     d->m_isRedrawBlocked = on;
 }
 
+bool GraphicsScene::isFrameStatsOverlayVisible() const
+{
+    return d->m_isFrameStatsOverlayVisible;
+}
+
+void GraphicsScene::setFrameStatsOverlayVisible(bool on)
+{
+    if (on == d->m_isFrameStatsOverlayVisible)
+        return;
+
+    d->m_isFrameStatsOverlayVisible = on;
+    for (V3d_ListOfViewIterator it = d->m_v3dViewer->DefinedViewIterator(); it.More(); it.Next())
+        Internal::applyFrameStatsOverlay(it.Value(), on);
+
+    this->redraw();
+}
+
 void GraphicsScene::recomputeObjectPresentation(const GraphicsObjectPtr& object)
 {
+    static Metrics::Counter& counterPresentations = Metrics::counter("graphics.presentationsComputed");
+    counterPresentations.add();
     d->m_aisContext->Redisplay(object, false);
 }
 
+void GraphicsScene::recomputeObjectPresentationOnly(const GraphicsObjectPtr& object)
+{
+    static Metrics::Counter& counterPresentations = Metrics::counter("graphics.presentationsComputed");
+    // Presentations of assembly instances are shared, they're computed by the prototypes
+    auto gfxAssembly = Handle_AIS_XdeAssembly::DownCast(object);
+    if (!gfxAssembly.IsNull()) {
+        for (const Handle_XCAFPrs_AISObject& prototype : gfxAssembly->prototypes()) {
+            counterPresentations.add();
+            d->m_aisContext->RecomputePrsOnly(prototype, false, true);
+        }
+    }
+
+    counterPresentations.add();
+    d->m_aisContext->RecomputePrsOnly(object, false, true);
+
+    auto itBatch = d->m_mapStaticBatch.find(object.get());
+    if (itBatch != d->m_mapStaticBatch.end()) {
+        const Handle_AIS_ShapeBatch& batch = itBatch->second.batch;
+        batch->setFaceBoundaryDraw(object->Attributes()->FaceBoundaryDraw());
+        if (d->m_aisContext->IsDisplayed(batch)) {
+            counterPresentations.add();
+            d->m_aisContext->RecomputePrsOnly(batch, false, true);
+        }
+
+        this->updateStaticBatch(object);
+    }
+}
+
 void GraphicsScene::activateObjectSelection(const GraphicsObjectPtr& object, int mode)
 {
     d->m_aisContext->Activate(object, mode);
@@ -139,6 +325,32 @@ void GraphicsScene::deactivateObjectSelection(const Mayo::GraphicsObjectPtr &obj
     d->m_aisContext->Deactivate(object, mode);
 }
 
+void GraphicsScene::setObjectSelectionComputing(const GraphicsObjectPtr& object, bool on)
+{
+    if (object.IsNull())
+        return;
+
+    if (on) {
+        const bool isVisible = this->isObjectVisible(object);
+        d->m_mapSelectionComputingVisible.insert({ object.get(), isVisible });
+        return;
+    }
+
+    auto itComputing = d->m_mapSelectionComputingVisible.find(object.get());
+    if (itComputing == d->m_mapSelectionComputingVisible.end())
+        return;
+
+    const bool isVisible = itComputing->second;
+    d->m_mapSelectionComputingVisible.erase(itComputing);
+    if (d->m_mapDeferredObjectVisible.find(object.get()) != d->m_mapDeferredObjectVisible.end())
+        return; // Visibility is applied by addObject()
+
+    if (d->m_aisContext->IsDisplayed(object) != isVisible) {
+        GraphicsUtils::AisContext_setObjectVisible(d->m_aisContext, object, isVisible);
+        this->updateStaticBatch(object);
+    }
+}
+
 void GraphicsScene::addSelectionFilter(const Handle_SelectMgr_Filter& filter)
 {
     d->m_aisContext->AddFilter(filter);
@@ -157,6 +369,7 @@ void GraphicsScene::clearSelectionFilters()
 void GraphicsScene::setObjectDisplayMode(const GraphicsObjectPtr& object, int displayMode)
 {
     d->m_aisContext->SetDisplayMode(object, displayMode, false);
+    this->updateStaticBatch(object);
 }
 
 bool GraphicsScene::isObjectClipPlaneSensitive(const GraphicsObjectPtr& object) const
@@ -180,12 +393,86 @@ void GraphicsScene::setObjectClipPlaneSensitive(const GraphicsObjectPtr& object,
 
 bool GraphicsScene::isObjectVisible(const GraphicsObjectPtr& object) const
 {
+    auto itComputing = d->m_mapSelectionComputingVisible.find(object.get());
+    if (itComputing != d->m_mapSelectionComputingVisible.cend())
+        return itComputing->second;
+
+    auto itDeferred = d->m_mapDeferredObjectVisible.find(object.get());
+    if (itDeferred != d->m_mapDeferredObjectVisible.cend())
+        return itDeferred->second;
+
     return d->m_aisContext->IsDisplayed(object);
 }
 
 void GraphicsScene::setObjectVisible(const GraphicsObjectPtr& object, bool on)
 {
-    GraphicsUtils::AisContext_setObjectVisible(d->m_aisContext, object, on);
+    if (object.IsNull() || this->isObjectVisible(object) == on)
+        return;
+
+    // Presentation data may be accessed by a worker thread, object can't be displayed yet
+    auto itDeferred = d->m_mapDeferredObjectVisible.find(object.get());
+    // Selection modes can't be (de)activated while a worker thread computes the selection
+    auto itComputing = d->m_mapSelectionComputingVisible.find(object.get());
+    if (itComputing != d->m_mapSelectionComputingVisible.end())
+        itComputing->second = on;
+
+    if (itDeferred != d->m_mapDeferredObjectVisible.end()) {
+        itDeferred->second = on;
+    }
+    else if (itComputing == d->m_mapSelectionComputingVisible.end()) {
+        GraphicsUtils::AisContext_setObjectVisible(d->m_aisContext, object, on);
+        this->updateStaticBatch(object);
+    }
+
+    emit objectVisibilityChanged(object, on);
+}
+
+bool GraphicsScene::isObjectPresentationVisible(const GraphicsObjectPtr& object) const
+{
+    return d->m_setPresentationHidden.find(object.get()) == d->m_setPresentationHidden.cend();
+}
+
+void GraphicsScene::setObjectPresentationVisible(const GraphicsObjectPtr& object, bool on)
+{
+    if (object.IsNull() || this->isObjectPresentationVisible(object) == on)
+        return;
+
+    if (on)
+        d->m_setPresentationHidden.erase(object.get());
+    else
+        d->m_setPresentationHidden.insert(object.get());
+
+    if (d->m_aisContext->IsDisplayed(object))
+        d->m_aisContext->MainPrsMgr()->SetVisibility(object, object->DisplayMode(), on);
+
+    this->updateStaticBatch(object);
+}
+
+bool GraphicsScene::isStaticBatchingEnabled() const
+{
+    return d->m_isStaticBatchingOn;
+}
+
+void GraphicsScene::setStaticBatchingEnabled(bool on)
+{
+    if (d->m_isStaticBatchingOn == on)
+        return;
+
+    d->m_isStaticBatchingOn = on;
+    for (const auto& mapPair : d->m_mapStaticBatch)
+        this->updateStaticBatch(mapPair.second.object);
+
+    d->m_isStaticBatchSplitDirty = true;
+}
+
+void GraphicsScene::addStaticBatch(
+        const GraphicsObjectPtr& object, const Handle_AIS_ShapeBatch& batch)
+{
+    if (object.IsNull() || batch.IsNull())
+        return;
+
+    d->m_mapStaticBatch[object.get()] = { object, batch };
+    this->updateStaticBatch(object);
 }
 
 GraphicsOwnerPtr GraphicsScene::firstSelectedOwner() const
@@ -201,6 +488,7 @@ void GraphicsScene::clearSelection()
 {
     d->m_aisContext->ClearDetected(false);
     d->m_aisContext->ClearSelected(false);
+    d->m_isStaticBatchSplitDirty = !d->m_mapStaticBatch.empty();
 }
 
 AIS_InteractiveContext* GraphicsScene::aisContextPtr() const
@@ -211,6 +499,7 @@ AIS_InteractiveContext* GraphicsScene::aisContextPtr() const
 void GraphicsScene::toggleOwnerSelection(const GraphicsOwnerPtr& gfxOwner)
 {
     d->m_aisContext->AddOrRemoveSelected(gfxOwner, false);
+    d->m_isStaticBatchSplitDirty = !d->m_mapStaticBatch.empty();
 }
 
 void GraphicsScene::highlightAt(const QPoint& pos, const Handle_V3d_View& view)
@@ -218,9 +507,55 @@ void GraphicsScene::highlightAt(const QPoint& pos, const Handle_V3d_View& view)
     d->m_aisContext->MoveTo(pos.x(), pos.y(), view, true);
 }
 
+void GraphicsScene::requestHighlightAt(const QPoint& pos, const Handle_V3d_View& view)
+{
+    static Metrics::Counter& counterRequests = Metrics::counter("graphics.highlightRequests");
+    counterRequests.add();
+    d->m_highlightRequestPos = pos;
+    d->m_highlightRequestView = view;
+    if (d->m_highlightRequestTimer->isActive())
+        return; // Pending request was superseded
+
+    const qint64 interval =
+            std::max(Internal::highlightRequestFrameInterval, d->m_highlightLastDuration);
+    const qint64 elapsed =
+            d->m_highlightChrono.isValid() ? d->m_highlightChrono.elapsed() : interval;
+    d->m_highlightRequestTimer->start(int(std::max<qint64>(interval - elapsed, 0)));
+}
+
+void GraphicsScene::cancelHighlightRequest()
+{
+    d->m_highlightRequestTimer->stop();
+    d->m_highlightRequestView.Nullify();
+}
+
+void GraphicsScene::flushHighlightRequest()
+{
+    d->m_highlightRequestTimer->stop();
+    if (d->m_highlightRequestView.IsNull())
+        return;
+
+    static Metrics::Counter& counterPicks = Metrics::counter("graphics.highlightPicks");
+    static Metrics::Histogram& histoPickTime = Metrics::histogram("graphics.highlightPickMs");
+    const QPoint pos = d->m_highlightRequestPos;
+    const Handle_V3d_View view = d->m_highlightRequestView;
+    d->m_highlightRequestView.Nullify();
+    QElapsedTimer chrono;
+    chrono.start();
+    this->highlightAt(pos, view);
+    d->m_highlightLastDuration = chrono.elapsed();
+    d->m_highlightChrono.start();
+    counterPicks.add();
+    histoPickTime.record(chrono.nsecsElapsed() / 1e6);
+    emit highlightedAt(pos);
+}
+
 void GraphicsScene::selectCurrentHighlighted()
 {
-    const AIS_StatusOfPick pick = d->m_aisContext->Select(true);
+    this->flushHighlightRequest();
+    const AIS_StatusOfPick pick = d->m_aisContext->Select(false);
+    d->m_isStaticBatchSplitDirty = !d->m_mapStaticBatch.empty();
+    this->redraw();
     if (pick == AIS_SOP_NothingSelected)
         emit this->selectionCleared();
     else if (pick == AIS_SOP_OneSelected)
@@ -236,6 +571,75 @@ const GraphicsOwnerPtr& GraphicsScene::currentHighlightedOwner() const
 #endif
 }
 
+void GraphicsScene::updateStaticBatch(const GraphicsObjectPtr& object)
+{
+    // Hidden presentation stays hidden when the object is displayed again(or display mode changed)
+    const bool isPresentationVisible = this->isObjectPresentationVisible(object);
+    if (!isPresentationVisible && d->m_aisContext->IsDisplayed(object))
+        d->m_aisContext->MainPrsMgr()->SetVisibility(object, object->DisplayMode(), false);
+
+    auto itBatch = d->m_mapStaticBatch.find(object.get());
+    if (itBatch == d->m_mapStaticBatch.end())
+        return;
+
+    const Handle_AIS_ShapeBatch& batch = itBatch->second.batch;
+    const bool isBatched =
+            d->m_isStaticBatchingOn
+            && isPresentationVisible
+            && d->m_aisContext->IsDisplayed(object)
+            && object->DisplayMode() == AIS_Shaded;
+    if (isBatched) {
+        if (batch->faceBoundaryDraw() != object->Attributes()->FaceBoundaryDraw()) {
+            batch->setFaceBoundaryDraw(object->Attributes()->FaceBoundaryDraw());
+            if (d->m_aisContext->IsDisplayed(batch))
+                d->m_aisContext->RecomputePrsOnly(batch, false, true);
+        }
+
+        // Batch isn't selectable, selection and highlighting remain handled by 'object' whose
+        // sub-shape owners have presentations of their own
+        d->m_aisContext->Display(batch, 0, -1, false);
+        d->m_aisContext->MainPrsMgr()->SetVisibility(object, object->DisplayMode(), false);
+    }
+    else {
+        GraphicsUtils::AisContext_eraseObject(d->m_aisContext, batch);
+        if (d->m_aisContext->IsDisplayed(object)) {
+            d->m_aisContext->MainPrsMgr()->SetVisibility(
+                        object, object->DisplayMode(), isPresentationVisible);
+        }
+    }
+}
+
+void GraphicsScene::updateStaticBatchSplitShapes()
+{
+    d->m_isStaticBatchSplitDirty = false;
+
+    // Selected shapes located as in the assembly, grouped by top-level object
+    std::unordered_map<const AIS_InteractiveObject*, std::vector<TopoDS_Shape>> mapObjectShapes;
+    if (d->m_isStaticBatchingOn) {
+        this->foreachSelectedOwner([&](const GraphicsOwnerPtr& owner) {
+            auto brepOwner = Handle_StdSelect_BRepOwner::DownCast(owner);
+            if (brepOwner.IsNull() || !brepOwner->HasShape())
+                return;
+
+            auto selectable = brepOwner->Selectable();
+            const PrsMgr_PresentableObject* object = selectable.get();
+            while (object && object->Parent())
+                object = object->Parent();
+
+            auto gfxObject = static_cast<const AIS_InteractiveObject*>(object);
+            const TopLoc_Location loc = AIS_XdeAssembly::instanceLocation(selectable.get());
+            mapObjectShapes[gfxObject].push_back(brepOwner->Shape().Moved(loc));
+        });
+    }
+
+    const std::vector<TopoDS_Shape> vecShapeEmpty;
+    for (const auto& mapPair : d->m_mapStaticBatch) {
+        auto itShapes = mapObjectShapes.find(mapPair.first);
+        const bool hasShapes = itShapes != mapObjectShapes.end();
+        mapPair.second.batch->setSplitShapes(hasShapes ? itShapes->second : vecShapeEmpty);
+    }
+}
+
 GraphicsSceneRedrawBlocker::GraphicsSceneRedrawBlocker(GraphicsScene* scene)
     : m_scene(scene),
       m_isRedrawBlockedOnEntry(scene->isRedrawBlocked())
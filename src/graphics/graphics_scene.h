@@ -10,6 +10,7 @@
 #include "graphics_owner_ptr.h"
 
 #include <AIS_InteractiveContext.hxx>
+#include <PrsMgr_ListOfPresentableObjects.hxx>
 #include <V3d_Viewer.hxx>
 #include <V3d_View.hxx>
 #include <QtCore/QObject>
@@ -18,6 +19,8 @@ class QPoint;
 
 namespace Mayo {
 
+class AIS_ShapeBatch;
+
 // Provides a container for GraphicsObject items(actually AIS_InteractiveObject)
 // It's a wrapper(incomplete though) around AIS_InteractiveContext to provide a more consistent API
 class GraphicsScene : public QObject {
@@ -31,19 +34,46 @@ public:
     const opencascade::handle<V3d_Viewer>& v3dViewer() const;
     const opencascade::handle<Prs3d_Drawer>& defaultPrs3dDrawer() const;
     const opencascade::handle<StdSelect_ViewerSelector3d>& mainSelector() const;
-    bool hiddenLineDrawingOn() const;
 
-    void addObject(const GraphicsObjectPtr& object);
+    // Scene-wide hidden-line removal(HLR) drawing mode, only a state : lines are computed and
+    // drawn by the client(see GuiHiddenLineDisplay)
+    bool hiddenLineDrawingOn() const;
+    void setHiddenLineDrawingOn(bool on);
+
+    enum AddObjectFlag {
+        AddObjectDefault = 0,
+        // No selection mode is activated, see activateObjectSelection()
+        AddObjectDisableSelectionMode = 0x01
+    };
+    void addObject(const GraphicsObjectPtr& object, AddObjectFlag flags = AddObjectDefault);
     void eraseObject(const GraphicsObjectPtr& object);
 
+    // Marks 'object' as to be added once its presentation data is prepared(eg in a worker thread)
+    // Until addObject() is called, setObjectVisible() only records the requested visibility, which
+    // is then applied by addObject()
+    void deferObjectDisplay(const GraphicsObjectPtr& object);
+
+    // Schedules a redraw of the views : the scene is marked dirty and rendered once on next event
+    // loop pass, so redraws requested by a single user action are coalesced into one frame.
+    // This is the only path rendering scene frames, view changes (eg camera) must go through it
+    // to be accounted in the "graphics.*" frame metrics
     void redraw();
     bool isRedrawBlocked() const;
     void blockRedraw(bool on);
 
+    // On-screen overlay of the views showing frame rate, count of draw calls and of triangles
+    bool isFrameStatsOverlayVisible() const;
+    void setFrameStatsOverlayVisible(bool on);
+
     void recomputeObjectPresentation(const GraphicsObjectPtr& object);
+    // Same as recomputeObjectPresentation() but selection primitives(and owners) are kept as is
+    void recomputeObjectPresentationOnly(const GraphicsObjectPtr& object);
 
     void activateObjectSelection(const GraphicsObjectPtr& object, int mode);
     void deactivateObjectSelection(const GraphicsObjectPtr& object, int mode);
+    // Selection of 'object' is computed by a worker thread, meanwhile visibility changes are only
+    // recorded so selection modes are left untouched. They're applied when 'on' is reset
+    void setObjectSelectionComputing(const GraphicsObjectPtr& object, bool on);
 
     void addSelectionFilter(const Handle_SelectMgr_Filter& filter);
     void removeSelectionFilter(const Handle_SelectMgr_Filter& filter);
@@ -57,7 +87,30 @@ public:
     bool isObjectVisible(const GraphicsObjectPtr& object) const;
     void setObjectVisible(const GraphicsObjectPtr& object, bool on);
 
+    // Presentation of an object(and of its static batch) can be hidden while the object is kept
+    // displayed and selectable, eg when it's drawn by some other object
+    bool isObjectPresentationVisible(const GraphicsObjectPtr& object) const;
+    void setObjectPresentationVisible(const GraphicsObjectPtr& object, bool on);
+
+    // Static batching : when enabled, the shaded presentation of an object having a batch is
+    // hidden and drawn by the batch instead. The object itself stays selectable, faces of the
+    // selected owners are split out of the batch on next redraw()
+    bool isStaticBatchingEnabled() const;
+    void setStaticBatchingEnabled(bool on);
+    // Batches are accessed by the GUI thread on each redraw, so 'batch' must be added once no
+    // other thread prepares it
+    void addStaticBatch(
+            const GraphicsObjectPtr& object, const opencascade::handle<AIS_ShapeBatch>& batch);
+
     void highlightAt(const QPoint& pos, const Handle_V3d_View& view);
+    // Deferred highlightAt() meant for mouse moves : a request supersedes the pending one and
+    // picking is done at most once per frame. Interval between picks is stretched to the duration
+    // of the last pick, so hover detection can't take more than half of the GUI thread time
+    // Signal highlightedAt() is emitted once picking is done
+    void requestHighlightAt(const QPoint& pos, const Handle_V3d_View& view);
+    void cancelHighlightRequest();
+    // Picks at once the pending request if any, eg before a mouse click is handled
+    void flushHighlightRequest();
     void selectCurrentHighlighted();
 
     const GraphicsOwnerPtr& currentHighlightedOwner() const;
@@ -79,11 +132,18 @@ public:
     GraphicsOwnerPtr findSelectedOwner(PREDICATE fn) const;
 
 signals:
+    void hiddenLineDrawingChanged(bool on);
+    // Emitted by setObjectVisible() when visibility of 'object' actually changes
+    void objectVisibilityChanged(const GraphicsObjectPtr& object, bool visible);
+    void highlightedAt(const QPoint& pos);
     void selectionCleared();
     void singleItemSelected();
 
 private:
     AIS_InteractiveContext* aisContextPtr() const;
+    void renderFrame();
+    void updateStaticBatch(const GraphicsObjectPtr& object);
+    void updateStaticBatchSplitShapes();
 
     class Private;
     Private* const d;
@@ -127,6 +187,16 @@ void GraphicsScene::foreachOwner(const GraphicsObjectPtr& object, int selectionM
     this->aisContextPtr()->EntityOwners(mapEntityOwner, object, selectionMode);
     for (auto it = mapEntityOwner->cbegin(); it != mapEntityOwner->cend(); ++it)
         fn(*it);
+
+    if (!mapEntityOwner->IsEmpty())
+        return;
+
+    // Owners of connected objects(eg assembly instances) are held by the children
+    for (PrsMgr_ListOfPresentableObjectsIter it(object->Children()); it.More(); it.Next()) {
+        auto child = Handle_AIS_InteractiveObject::DownCast(it.Value());
+        if (!child.IsNull())
+            this->foreachOwner(child, selectionMode, fn);
+    }
 }
 
 template<typename FUNCTION>
@@ -9,6 +9,7 @@
 #include "../base/brep_utils.h"
 #include "../base/document.h"
 #include "../base/document_tree_node.h"
+#include "ais_xde_assembly.h"
 
 #include <AIS_Shape.hxx>
 #include <StdSelect_BRepOwner.hxx>
@@ -60,7 +61,11 @@ bool GraphicsShapeTreeNodeMapping::mapGraphicsOwner(const GraphicsOwnerPtr& gfxO
     if (brepOwner->Shape().ShapeType() != m_shapeType)
         return false;
 
-    auto result = m_mapGfxOwner.emplace(BRepUtils::hashCode(brepOwner->Shape()), brepOwner);
+    // Shape of an assembly instance owner is relative to the shared prototype
+    const Handle_SelectMgr_SelectableObject selectable = brepOwner->Selectable();
+    const TopLoc_Location instanceLoc = AIS_XdeAssembly::instanceLocation(selectable.get());
+    const TopoDS_Shape shape = brepOwner->Shape().Moved(instanceLoc);
+    auto result = m_mapGfxOwner.emplace(BRepUtils::hashCode(shape), brepOwner);
     return result.second;
 }
 
@@ -14,6 +14,8 @@
 #include <ProjLib.hxx>
 #include <SelectMgr_SelectionManager.hxx>
 #include <Standard_Version.hxx>
+#include <TColStd_ListIteratorOfListOfInteger.hxx>
+#include <TColStd_ListOfInteger.hxx>
 
 namespace Mayo {
 
@@ -23,6 +25,17 @@ void GraphicsUtils::V3dView_fitAll(const Handle_V3d_View& view)
     view->FitAll(0.01, false);
 }
 
+void GraphicsUtils::V3dView_fitAll(const Handle_V3d_View& view, const Bnd_Box& box)
+{
+    if (box.IsVoid()) {
+        GraphicsUtils::V3dView_fitAll(view);
+        return;
+    }
+
+    view->ZFitAll();
+    view->FitAll(box, 0.01, false);
+}
+
 bool GraphicsUtils::V3dView_hasClipPlane(
         const Handle_V3d_View& view, const Handle_Graphic3d_ClipPlane& plane)
 {
@@ -77,17 +90,37 @@ void GraphicsUtils::AisContext_eraseObject(
     }
 }
 
+int GraphicsUtils::AisContext_objectDisplayMode(
+        const Handle_AIS_InteractiveContext& context,
+        const Handle_AIS_InteractiveObject& object)
+{
+    if (object->HasDisplayMode())
+        return object->DisplayMode();
+
+    const int defaultDisplayMode = context->DefaultDrawer()->DisplayMode();
+    return object->AcceptDisplayMode(defaultDisplayMode) ? defaultDisplayMode : 0;
+}
+
 void GraphicsUtils::AisContext_setObjectVisible(
         const Handle_AIS_InteractiveContext& context,
         const Handle_AIS_InteractiveObject& object,
         bool on)
 {
-    if (!context.IsNull() && !object.IsNull()) {
-        if (on)
-            context->Display(object, false);
-        else
-            context->Erase(object, false);
+    if (context.IsNull() || object.IsNull())
+        return;
+
+    if (!on) {
+        context->Erase(object, false);
+        return;
     }
+
+    // Erase() keeps the selection modes in the object status but deactivates them
+    const int displayMode = GraphicsUtils::AisContext_objectDisplayMode(context, object);
+    context->Display(object, displayMode, -1, false);
+    TColStd_ListOfInteger listMode;
+    context->ActivatedModes(object, listMode);
+    for (TColStd_ListIteratorOfListOfInteger it(listMode); it.More(); it.Next())
+        context->Activate(object, it.Value());
 }
 
 Bnd_Box GraphicsUtils::AisObject_boundingBox(const Handle_AIS_InteractiveObject& object)
@@ -15,6 +15,9 @@ namespace Mayo {
 
 struct GraphicsUtils {
     static void V3dView_fitAll(const Handle_V3d_View& view);
+    // Fits 'box' instead of the bounding box of all graphics presentations, which might not be
+    // computed yet
+    static void V3dView_fitAll(const Handle_V3d_View& view, const Bnd_Box& box);
     static bool V3dView_hasClipPlane(
             const Handle_V3d_View& view,
             const Handle_Graphic3d_ClipPlane& plane);
@@ -24,6 +27,12 @@ struct GraphicsUtils {
     static void AisContext_eraseObject(
             const Handle_AIS_InteractiveContext& context,
             const Handle_AIS_InteractiveObject& object);
+    // Display mode of 'object', the one of the context drawer if not set and accepted
+    static int AisContext_objectDisplayMode(
+            const Handle_AIS_InteractiveContext& context,
+            const Handle_AIS_InteractiveObject& object);
+    // Object is displayed again without any default selection mode, only the selection modes
+    // active before it was erased are activated again
     static void AisContext_setObjectVisible(
             const Handle_AIS_InteractiveContext& context,
             const Handle_AIS_InteractiveObject& object,
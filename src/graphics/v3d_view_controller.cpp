@@ -25,13 +25,17 @@ V3dViewController::~V3dViewController()
 
 void V3dViewController::zoomIn()
 {
-    m_view->SetScale(m_view->Scale() * 1.1); // +10%
+    this->changeView([](const Handle_V3d_View& view) {
+        view->SetScale(view->Scale() * 1.1); // +10%
+    });
     emit viewScaled();
 }
 
 void V3dViewController::zoomOut()
 {
-    m_view->SetScale(m_view->Scale() / 1.1); // -10%
+    this->changeView([](const Handle_V3d_View& view) {
+        view->SetScale(view->Scale() / 1.1); // -10%
+    });
     emit viewScaled();
 }
 
@@ -92,8 +96,19 @@ void V3dViewController::hideRubberBand()
 
 void V3dViewController::windowFitAll(const QPoint& posMin, const QPoint& posMax)
 {
-    if (std::abs(posMin.x() - posMax.x()) > 1 || std::abs(posMin.y() - posMax.y()) > 1)
-        m_view->WindowFitAll(posMin.x(), posMin.y(), posMax.x(), posMax.y());
+    if (std::abs(posMin.x() - posMax.x()) > 1 || std::abs(posMin.y() - posMax.y()) > 1) {
+        this->changeView([=](const Handle_V3d_View& view) {
+            view->WindowFitAll(posMin.x(), posMin.y(), posMax.x(), posMax.y());
+        });
+    }
+}
+
+void V3dViewController::changeView(const std::function<void(const Handle_V3d_View&)>& fnChange)
+{
+    const bool wasImmediateUpdate = m_view->SetImmediateUpdate(false);
+    fnChange(m_view);
+    m_view->SetImmediateUpdate(wasImmediateUpdate);
+    emit redrawRequested();
 }
 
 V3dViewController::DynamicAction V3dViewController::currentDynamicAction() const
@@ -9,6 +9,7 @@
 #include <V3d_View.hxx>
 #include <QtCore/QObject>
 #include <QtCore/QPoint>
+#include <functional>
 
 namespace Mayo {
 
@@ -42,6 +43,8 @@ signals:
     void dynamicActionStarted(DynamicAction dynAction);
     void dynamicActionEnded(DynamicAction dynAction);
     void viewScaled();
+    // View was changed without being rendered, connect to GraphicsScene::redraw()
+    void redrawRequested();
 
     void mouseMoved(const QPoint& posMouseInView);
     void mouseClicked(Qt::MouseButton btn);
@@ -56,6 +59,10 @@ protected:
 
     void windowFitAll(const QPoint& posMin, const QPoint& posMax);
 
+    // Applies 'fnChange' to the view with V3d immediate update turned off, the frame is then
+    // requested with signal redrawRequested()
+    void changeView(const std::function<void(const Handle_V3d_View&)>& fnChange);
+
     virtual AbstractRubberBand* createRubberBand() = 0;
     void drawRubberBand(const QPoint& posMin, const QPoint& posMax);
     void hideRubberBand();
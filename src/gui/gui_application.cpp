@@ -68,6 +68,11 @@ GraphicsTreeNodeMappingDriverTable* GuiApplication::graphicsTreeNodeMappingDrive
     return m_gfxTreeNodeMappingDriverTable.get();
 }
 
+void GuiApplication::setTessellationParameters(const TessellationParameters& params)
+{
+    m_tessellationParams = params;
+}
+
 void GuiApplication::onDocumentAdded(const DocumentPtr& doc)
 {
     m_vecGuiDocument.push_back(new GuiDocument(doc, this));
@@ -9,6 +9,7 @@
 #include "../base/application_ptr.h"
 #include "../base/application_item_selection_model.h"
 #include "../base/span.h"
+#include "../base/tessellation.h"
 #include "../graphics/graphics_entity_driver_table.h"
 #include "../graphics/graphics_tree_node_mapping_driver_table.h"
 #include "gui_document.h"
@@ -37,6 +38,10 @@ public:
     GraphicsEntityDriverTable* graphicsEntityDriverTable() const;
     GraphicsTreeNodeMappingDriverTable* graphicsTreeNodeMappingDriverTable() const;
 
+    // Parameters of the tessellation computed at import, used for display of new entities
+    const TessellationParameters& tessellationParameters() const { return m_tessellationParams; }
+    void setTessellationParameters(const TessellationParameters& params);
+
 signals:
     void guiDocumentAdded(GuiDocument* guiDoc);
     void guiDocumentErased(const GuiDocument* guiDoc);
@@ -55,6 +60,7 @@ private:
     ApplicationItemSelectionModel* m_selectionModel = nullptr;
     std::unique_ptr<GraphicsEntityDriverTable> m_gfxEntityDriverTable;
     std::unique_ptr<GraphicsTreeNodeMappingDriverTable> m_gfxTreeNodeMappingDriverTable;
+    TessellationParameters m_tessellationParams;
 };
 
 } // namespace Mayo
@@ -9,23 +9,48 @@
 #include "../app/theme.h" // TODO Remove this dependency
 #include "../base/application_item.h"
 #include "../base/bnd_utils.h"
+#include "../base/caf_utils.h"
 #include "../base/document.h"
+#include "../base/point_cloud.h"
+#include "../base/metrics.h"
+#include "../base/task_manager.h"
+#include "../base/thread_budget.h"
 #include "../base/tkernel_utils.h"
+#include "../base/tracing.h"
+#include "../base/xcaf.h"
 #include "../gui/gui_application.h"
+#include "../gui/gui_hidden_line_display.h"
+#include "../gui/gui_tessellation_refiner.h"
+#include "../graphics/ais_mesh.h"
+#include "../graphics/ais_point_cloud_lod.h"
+#include "../graphics/ais_shape_batch.h"
+#include "../graphics/ais_xde_assembly.h"
 #include "../graphics/graphics_entity_driver_table.h"
 #include "../graphics/graphics_utils.h"
 #include "../graphics/v3d_view_camera_animation.h"
 
 #include <fougtools/occtools/qt_utils.h>
 
-#include <QtCore/QtDebug>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QPoint>
 #if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 4, 0)
 #  include <AIS_ViewCube.hxx>
 #endif
 #include <AIS_Trihedron.hxx>
+#include <BRep_Tool.hxx>
 #include <Geom_Axis2Placement.hxx>
 #include <Graphic3d_GraphicDriver.hxx>
+#include <PrsMgr_ListOfPresentableObjects.hxx>
+#include <SelectMgr_Selection.hxx>
+#include <StdPrs_ToolTriangulatedShape.hxx>
+#include <TDataXtd_Triangulation.hxx>
+#include <TopExp_Explorer.hxx>
+#include <TopTools_IndexedMapOfShape.hxx>
+#include <TopoDS.hxx>
 #include <V3d_TypeOfOrientation.hxx>
+#include <gp_Lin.hxx>
+#include <algorithm>
+#include <unordered_set>
 
 namespace Mayo {
 
@@ -34,6 +59,124 @@ namespace Internal {
 // Defined in gui_create_gfx_driver.cpp
 Handle_Graphic3d_GraphicDriver createGfxDriver();
 
+// Bounding box of the entity geometry, so graphics presentation bounds don't need to be computed
+static Bnd_Box entityBoundingBox(const TDF_Label& label, const GraphicsEntity& gfxEntity)
+{
+    if (XCaf::isShape(label))
+        return BndUtils::geometryBoundingBox(XCaf::shape(label));
+
+    auto attrTriangulation = CafUtils::findAttribute<TDataXtd_Triangulation>(label);
+    if (!attrTriangulation.IsNull())
+        return BndUtils::geometryBoundingBox(attrTriangulation->Get());
+
+    auto attrPointCloud = CafUtils::findAttribute<PointCloudAttribute>(label);
+    if (!attrPointCloud.IsNull() && !attrPointCloud->get().IsNull())
+        return attrPointCloud->get()->boundingBox();
+
+    return GraphicsUtils::AisObject_boundingBox(gfxEntity.aisObject());
+}
+
+// Computes the sensitive primitives of 'object' and of its children(eg assembly instances) for
+// selection 'mode', without loading them in the selector. It's safe in a worker thread as long
+// as 'object' isn't activated in the meantime
+static void computeObjectSelection(const Handle_SelectMgr_SelectableObject& object, int mode)
+{
+    for (PrsMgr_ListOfPresentableObjectsIter it(object->Children()); it.More(); it.Next()) {
+        auto child = Handle_SelectMgr_SelectableObject::DownCast(it.Value());
+        if (!child.IsNull())
+            computeObjectSelection(child, mode);
+    }
+
+    if (object->HasSelection(mode))
+        return;
+
+    object->RecomputePrimitives(mode);
+    if (!object->HasSelection(mode))
+        return;
+
+    // BVH trees of the primitives(eg triangles of Select3D_SensitiveTriangulation) are built
+    // here too, otherwise they would be built by the first hover picking in the GUI thread
+    const Handle_SelectMgr_Selection& selection = object->Selection(mode);
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 4, 0)
+    for (const Handle_SelectMgr_SensitiveEntity& entity : selection->Entities())
+        entity->BaseSensitive()->BVH();
+#else
+    for (selection->Init(); selection->More(); selection->Next())
+        selection->Sensitive()->BaseSensitive()->BVH();
+#endif
+}
+
+// Calls 'fn' once for each owner of the selection 'mode' computed for 'object' and its children
+template<typename FUNCTION>
+static void foreachSelectionOwner(
+        const Handle_SelectMgr_SelectableObject& object,
+        int mode,
+        std::unordered_set<const SelectMgr_EntityOwner*>* ptrSetVisited,
+        FUNCTION fn)
+{
+    if (object->HasSelection(mode)) {
+        auto fnOwner = [&](const Handle_SelectMgr_SensitiveEntity& entity) {
+            auto owner = Handle_SelectMgr_EntityOwner::DownCast(entity->BaseSensitive()->OwnerId());
+            if (!owner.IsNull() && ptrSetVisited->insert(owner.get()).second)
+                fn(owner);
+        };
+        const Handle_SelectMgr_Selection& selection = object->Selection(mode);
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 4, 0)
+        for (const Handle_SelectMgr_SensitiveEntity& entity : selection->Entities())
+            fnOwner(entity);
+#else
+        for (selection->Init(); selection->More(); selection->Next())
+            fnOwner(selection->Sensitive());
+#endif
+    }
+
+    for (PrsMgr_ListOfPresentableObjectsIter it(object->Children()); it.More(); it.Next()) {
+        auto child = Handle_SelectMgr_SelectableObject::DownCast(it.Value());
+        if (!child.IsNull())
+            foreachSelectionOwner(child, mode, ptrSetVisited, fn);
+    }
+}
+
+// Whether the presentations of the entity are worth preparing in a worker thread
+static bool hasPresentationToPrepare(const TDF_Label& label, const GraphicsObjectPtr& object)
+{
+    return XCaf::isShape(label) || !Handle_AIS_Mesh::DownCast(object).IsNull();
+}
+
+// Computes the data the presentations of an entity are built from : normals of the face
+// triangulations, mesh triangles array, vertex buffers of the static batch(if not null)
+// Display in the GUI thread attaches the mesh array and the batch buffers as is. Limitation :
+// XCAFPrs_AISObject::Compute() still fills its per-style triangle arrays in the GUI thread, only
+// normals are computed ahead for it, so shapes fully benefit only with static batching on
+// It's safe in a worker thread as long as the objects aren't displayed and the geometry isn't
+// modified in the meantime
+static void prepareEntityPresentation(
+        const TDF_Label& label, const GraphicsObjectPtr& object, const Handle_AIS_ShapeBatch& batch)
+{
+    if (XCaf::isShape(label)) {
+        // Instances of a part share the triangulations, so faces are visited regardless location
+        TopTools_IndexedMapOfShape mapFace;
+        const TopoDS_Shape shape = XCaf::shape(label);
+        for (TopExp_Explorer expFace(shape, TopAbs_FACE); expFace.More(); expFace.Next())
+            mapFace.Add(expFace.Current().Located(TopLoc_Location()));
+
+        ThreadBudget::parallelFor(1, mapFace.Extent() + 1, [&](int i) {
+            const TopoDS_Face& face = TopoDS::Face(mapFace.FindKey(i));
+            TopLoc_Location loc;
+            const Handle_Poly_Triangulation& triangulation = BRep_Tool::Triangulation(face, loc);
+            if (!triangulation.IsNull() && !triangulation->HasNormals())
+                StdPrs_ToolTriangulatedShape::ComputeNormals(face, triangulation);
+        });
+    }
+
+    auto gfxMesh = Handle_AIS_Mesh::DownCast(object);
+    if (!gfxMesh.IsNull())
+        gfxMesh->trianglesArray();
+
+    if (!batch.IsNull())
+        batch->prepare();
+}
+
 static Handle_AIS_Trihedron createOriginTrihedron()
 {
     Handle_Geom_Axis2Placement axis = new Geom_Axis2Placement(gp::XOY());
@@ -67,10 +210,66 @@ GuiDocument::GuiDocument(const DocumentPtr& doc, GuiApplication* guiApp)
       m_gfxScene(this),
       m_v3dView(m_gfxScene.createV3dView()),
       m_aisOriginTrihedron(Internal::createOriginTrihedron()),
-      m_cameraAnimation(new V3dViewCameraAnimation(m_v3dView, this))
+      m_cameraAnimation(new V3dViewCameraAnimation(m_v3dView, this)),
+      m_tessellationRefiner(new GuiTessellationRefiner(this)),
+      m_hiddenLineDisplay(new GuiHiddenLineDisplay(this)),
+      m_mapGraphicsTimer(new QTimer(this)),
+      m_selectionTaskMgr(new TaskManager(this)),
+      m_presentationTaskMgr(new TaskManager(this)),
+      m_levelOfDetailTimer(new QTimer(this))
 {
     Expects(!doc.IsNull());
 
+    // Entities added in a row(eg import of many files) are mapped by a single batch
+    m_mapGraphicsTimer->setSingleShot(true);
+    m_mapGraphicsTimer->setInterval(0);
+    QObject::connect(
+                m_mapGraphicsTimer, &QTimer::timeout,
+                this, &GuiDocument::mapPendingGraphics);
+    QObject::connect(
+                m_selectionTaskMgr, &TaskManager::ended,
+                this, &GuiDocument::onSelectionTaskEnded);
+    QObject::connect(
+                m_presentationTaskMgr, &TaskManager::ended,
+                this, &GuiDocument::onPresentationTaskEnded);
+    QObject::connect(
+                &m_gfxScene, &GraphicsScene::hiddenLineDrawingChanged,
+                m_hiddenLineDisplay, &GuiHiddenLineDisplay::setEnabled);
+    QObject::connect(
+                m_tessellationRefiner, &GuiTessellationRefiner::entityRefined,
+                m_hiddenLineDisplay, &GuiHiddenLineDisplay::invalidate);
+    QObject::connect(
+                m_tessellationRefiner, &GuiTessellationRefiner::entityRefined,
+                this, [=](TreeNodeId entityTreeNodeId) {
+        // Proxy is built from the face triangulations, it has to be prepared again
+        auto gfxItem = const_cast<GraphicsItem*>(this->findGraphicsItem(entityTreeNodeId));
+        if (!gfxItem || !gfxItem->isProxyReady)
+            return;
+
+        if (m_gfxScene.isObjectVisible(gfxItem->gfxProxy)) {
+            m_gfxScene.setObjectVisible(gfxItem->gfxProxy, false);
+            m_gfxScene.setObjectPresentationVisible(gfxItem->graphicsEntity.aisObject(), true);
+        }
+
+        gfxItem->isProxyReady = false;
+        if (m_isInteractionLodEnabled) {
+            m_vecPresentationRequest.push_back(entityTreeNodeId);
+            this->startNextPresentationTask();
+        }
+    });
+
+    m_levelOfDetailTimer->setSingleShot(true);
+    m_levelOfDetailTimer->setInterval(100);
+    QObject::connect(
+                m_levelOfDetailTimer, &QTimer::timeout,
+                this, &GuiDocument::applyViewLevelOfDetail);
+    QObject::connect(
+                m_cameraAnimation, &QAbstractAnimation::finished,
+                this, &GuiDocument::updateViewLevelOfDetail);
+    QObject::connect(
+                m_cameraAnimation, &QAbstractAnimation::finished,
+                m_hiddenLineDisplay, &GuiHiddenLineDisplay::onViewChanged);
+
 #if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 4, 0)
     this->setViewTrihedronMode(ViewTrihedronMode::AisViewCube);
     this->setViewTrihedronCorner(Qt::TopLeftCorner);
@@ -93,8 +292,11 @@ GuiDocument::GuiDocument(const DocumentPtr& doc, GuiApplication* guiApp)
 
     m_cameraAnimation->setEasingCurve(QEasingCurve::OutExpo);
 
+    std::vector<TreeNodeId> vecEntity;
     for (int i = 0; i < doc->entityCount(); ++i)
-        this->mapGraphics(doc->entityTreeNodeId(i));
+        vecEntity.push_back(doc->entityTreeNodeId(i));
+
+    this->mapGraphics(vecEntity);
 
     QObject::connect(doc.get(), &Document::entityAdded, this, &GuiDocument::onDocumentEntityAdded);
     QObject::connect(
@@ -102,12 +304,55 @@ GuiDocument::GuiDocument(const DocumentPtr& doc, GuiApplication* guiApp)
                 this, &GuiDocument::onDocumentEntityAboutToBeDestroyed);
 }
 
+GuiDocument::~GuiDocument()
+{
+    if (m_isSelectionTaskRunning) {
+        m_selectionTaskMgr->requestAbort(m_selectionTaskId);
+        m_selectionTaskMgr->waitForDone(m_selectionTaskId);
+    }
+
+    if (m_isPresentationTaskRunning) {
+        m_presentationTaskMgr->requestAbort(m_presentationTaskId);
+        m_presentationTaskMgr->waitForDone(m_presentationTaskId);
+    }
+}
+
 GraphicsEntity GuiDocument::findGraphicsEntity(TreeNodeId entityTreeNodeId) const
 {
     const GraphicsItem* gfxItem = this->findGraphicsItem(entityTreeNodeId);
     return gfxItem ? gfxItem->graphicsEntity : GraphicsEntity();
 }
 
+void GuiDocument::addEntityOverlay(TreeNodeId entityTreeNodeId, const GraphicsObjectPtr& object)
+{
+    auto gfxItem = const_cast<GraphicsItem*>(this->findGraphicsItem(entityTreeNodeId));
+    if (!gfxItem || object.IsNull())
+        return;
+
+    gfxItem->vecOverlay.push_back(object);
+    m_gfxScene.addObject(object);
+    m_gfxScene.redraw();
+}
+
+void GuiDocument::removeEntityOverlays(TreeNodeId entityTreeNodeId)
+{
+    auto gfxItem = const_cast<GraphicsItem*>(this->findGraphicsItem(entityTreeNodeId));
+    if (!gfxItem || gfxItem->vecOverlay.empty())
+        return;
+
+    for (const GraphicsObjectPtr& object : gfxItem->vecOverlay)
+        m_gfxScene.eraseObject(object);
+
+    gfxItem->vecOverlay.clear();
+    m_gfxScene.redraw();
+}
+
+bool GuiDocument::hasEntityOverlays(TreeNodeId entityTreeNodeId) const
+{
+    const GraphicsItem* gfxItem = this->findGraphicsItem(entityTreeNodeId);
+    return gfxItem ? !gfxItem->vecOverlay.empty() : false;
+}
+
 void GuiDocument::toggleItemSelected(const ApplicationItem& appItem)
 {
     const DocumentPtr doc = appItem.document();
@@ -118,9 +363,25 @@ void GuiDocument::toggleItemSelected(const ApplicationItem& appItem)
         const DocumentTreeNode& docTreeNode = appItem.documentTreeNode();
         const TreeNodeId entityNodeId = doc->modelTree().nodeRoot(docTreeNode.id());
 
+        auto gfxItem = const_cast<GraphicsItem*>(this->findGraphicsItem(entityNodeId));
+        if (!gfxItem)
+            return;
+
+        if (gfxItem->selectionStatus != SelectionStatus::Active) {
+            // Applied once selection is activated, toggling twice cancels out
+            std::vector<TreeNodeId>& vecToggle = gfxItem->vecPendingToggle;
+            auto itToggle = std::find(vecToggle.begin(), vecToggle.end(), docTreeNode.id());
+            if (itToggle != vecToggle.end())
+                vecToggle.erase(itToggle);
+            else
+                vecToggle.push_back(docTreeNode.id());
+
+            this->activateEntitySelection(entityNodeId);
+            return;
+        }
+
         // Add/remove graphics owner
-        const GraphicsItem* gfxItem = this->findGraphicsItem(entityNodeId);
-        if (gfxItem && gfxItem->gpxTreeNodeMapping) {
+        if (gfxItem->gpxTreeNodeMapping) {
             auto vecGfxOwner = gfxItem->gpxTreeNodeMapping->findGraphicsOwners(docTreeNode);
             for (const GraphicsOwnerPtr& gfxOwner : vecGfxOwner)
                 m_gfxScene.toggleOwnerSelection(gfxOwner);
@@ -128,6 +389,43 @@ void GuiDocument::toggleItemSelected(const ApplicationItem& appItem)
     }
 }
 
+void GuiDocument::activateEntitySelection(TreeNodeId entityTreeNodeId)
+{
+    auto gfxItem = const_cast<GraphicsItem*>(this->findGraphicsItem(entityTreeNodeId));
+    if (!gfxItem || gfxItem->selectionStatus != SelectionStatus::Inactive)
+        return;
+
+    gfxItem->selectionStatus = SelectionStatus::Pending;
+    m_vecSelectionRequest.push_back(entityTreeNodeId);
+    if (!m_isSelectionTaskRunning)
+        this->startNextSelectionTask();
+}
+
+void GuiDocument::activateSelectionAt(const QPoint& pos)
+{
+    if (m_v3dView->Window().IsNull())
+        return;
+
+    double x, y, z, dx, dy, dz;
+    m_v3dView->ConvertWithProj(pos.x(), pos.y(), x, y, z, dx, dy, dz);
+    const gp_Vec vecDir(dx, dy, dz);
+    if (vecDir.SquareMagnitude() <= gp::Resolution())
+        return;
+
+    const gp_Lin ray(gp_Pnt(x, y, z), gp_Dir(vecDir));
+    for (const GraphicsItem& item : m_vecGraphicsItem) {
+        if (item.selectionStatus == SelectionStatus::Inactive && !item.bndBox.IsOut(ray))
+            this->activateEntitySelection(item.entityTreeNodeId);
+    }
+}
+
+bool GuiDocument::isWorkerReadingGeometry() const
+{
+    return m_isSelectionTaskRunning
+            || m_isPresentationTaskRunning
+            || m_hiddenLineDisplay->isRunning();
+}
+
 bool GuiDocument::isOriginTrihedronVisible() const
 {
     return m_gfxScene.isObjectVisible(m_aisOriginTrihedron);
@@ -155,12 +453,13 @@ void GuiDocument::setViewCameraOrientation(V3d_TypeOfOrientation projection)
 {
     this->runViewCameraAnimation([=](Handle_V3d_View view) {
         view->SetProj(projection);
-        GraphicsUtils::V3dView_fitAll(view);
+        GraphicsUtils::V3dView_fitAll(view, m_gpxBoundingBox);
     });
 }
 
 void GuiDocument::runViewCameraAnimation(const std::function<void (Handle_V3d_View)>& fnViewChange)
 {
+    m_hiddenLineDisplay->onViewChangeStarted();
     m_cameraAnimation->configure(fnViewChange);
     m_cameraAnimation->start(QAbstractAnimation::KeepWhenStopped);
 }
@@ -283,71 +582,467 @@ int GuiDocument::aisViewCubeBoundingSize() const
 
 void GuiDocument::onDocumentEntityAdded(TreeNodeId entityTreeNodeId)
 {
-    this->mapGraphics(entityTreeNodeId);
-    emit graphicsBoundingBoxChanged(m_gpxBoundingBox);
+    m_vecPendingEntity.push_back(entityTreeNodeId);
+    m_mapGraphicsTimer->start();
 }
 
 void GuiDocument::onDocumentEntityAboutToBeDestroyed(TreeNodeId entityTreeNodeId)
 {
-    const GraphicsItem* gfxItem = this->findGraphicsItem(entityTreeNodeId);
-    if (gfxItem) {
-        const GraphicsEntity& gfxEntity = gfxItem->graphicsEntity;
-        m_gfxScene.eraseObject(gfxEntity.aisObject());
-        m_vecGraphicsItem.erase(m_vecGraphicsItem.begin() + (gfxItem - &m_vecGraphicsItem.front()));
-        m_gfxScene.redraw();
+    m_tessellationRefiner->removeEntity(entityTreeNodeId);
+    m_hiddenLineDisplay->removeEntity(entityTreeNodeId);
+    m_vecPendingEntity.erase(
+                std::remove(m_vecPendingEntity.begin(), m_vecPendingEntity.end(), entityTreeNodeId),
+                m_vecPendingEntity.end());
+    for (auto ptrVecRequest : { &m_vecSelectionRequest, &m_vecPresentationRequest }) {
+        std::vector<TreeNodeId>& vecRequest = *ptrVecRequest;
+        vecRequest.erase(
+                    std::remove(vecRequest.begin(), vecRequest.end(), entityTreeNodeId),
+                    vecRequest.end());
+    }
+
+    this->waitForEntityTasks(entityTreeNodeId);
 
-        // Recompute bounding box
+    auto itIndex = m_mapEntityItemIndex.find(entityTreeNodeId);
+    if (itIndex == m_mapEntityItemIndex.end())
+        return;
+
+    const size_t index = itIndex->second;
+    m_mapEntityItemIndex.erase(itIndex);
+    GraphicsItem& gfxItem = m_vecGraphicsItem.at(index);
+    m_gfxScene.eraseObject(gfxItem.graphicsEntity.aisObject());
+    if (!gfxItem.gfxProxy.IsNull())
+        m_gfxScene.eraseObject(gfxItem.gfxProxy);
+
+    for (const GraphicsObjectPtr& object : gfxItem.vecOverlay)
+        m_gfxScene.eraseObject(object);
+
+    // Bounding box has to be recomputed only if the entity was touching its sides
+    const bool isBoundingBoxChanged =
+            !BndUtils::isStrictlyInside(gfxItem.bndBox, m_gpxBoundingBox);
+
+    // Last item takes the place of the erased one, so other indexes are kept
+    if (index + 1 != m_vecGraphicsItem.size()) {
+        gfxItem = std::move(m_vecGraphicsItem.back());
+        m_mapEntityItemIndex[gfxItem.entityTreeNodeId] = index;
+    }
+
+    m_vecGraphicsItem.pop_back();
+    m_gfxScene.redraw();
+    if (isBoundingBoxChanged) {
         m_gpxBoundingBox.SetVoid();
-        for (const GraphicsItem& item : m_vecGraphicsItem) {
-            const Bnd_Box entityBndBox = GraphicsUtils::AisObject_boundingBox(item.graphicsEntity.aisObject());
-            BndUtils::add(&m_gpxBoundingBox, entityBndBox);
-        }
+        for (const GraphicsItem& item : m_vecGraphicsItem)
+            BndUtils::add(&m_gpxBoundingBox, item.bndBox);
 
         emit graphicsBoundingBoxChanged(m_gpxBoundingBox);
     }
 }
 
-void GuiDocument::mapGraphics(TreeNodeId entityTreeNodeId)
+void GuiDocument::mapGraphics(Span<const TreeNodeId> spanEntityTreeNodeId)
+{
+    if (spanEntityTreeNodeId.empty())
+        return;
+
+    MAYO_TRACE_SCOPE("graphics", "mapGraphics");
+    static Metrics::Counter& counterBatches = Metrics::counter("graphics.mapGraphicsBatches");
+    counterBatches.add();
+    const TessellationParameters& tessellationParams = m_guiApp->tessellationParameters();
+    std::vector<TreeNodeId> vecMappedEntity;
+    bool hasPointCloud = false;
+    {
+        GraphicsSceneRedrawBlocker redrawBlocker(&m_gfxScene);
+        for (TreeNodeId entityTreeNodeId : spanEntityTreeNodeId) {
+            if (m_mapEntityItemIndex.find(entityTreeNodeId) != m_mapEntityItemIndex.cend())
+                continue;
+
+            GraphicsItem item;
+            if (!this->mapEntityGraphics(entityTreeNodeId, &item))
+                continue;
+
+            BndUtils::add(&m_gpxBoundingBox, item.bndBox);
+            if (!Handle_AIS_PointCloudLod::DownCast(item.graphicsEntity.aisObject()).IsNull())
+                hasPointCloud = true;
+
+            m_mapEntityItemIndex.insert({ entityTreeNodeId, m_vecGraphicsItem.size() });
+            m_vecGraphicsItem.emplace_back(std::move(item));
+            vecMappedEntity.push_back(entityTreeNodeId);
+        }
+    }
+
+    // Entities mapped together come from the same import, they share the deflection reference
+    if (tessellationParams.enabled && tessellationParams.progressive)
+        m_tessellationRefiner->addEntities(vecMappedEntity, tessellationParams);
+
+    this->startNextPresentationTask();
+    {
+        MAYO_TRACE_SCOPE("graphics", "fitAll");
+        GraphicsUtils::V3dView_fitAll(m_v3dView, m_gpxBoundingBox);
+    }
+
+    m_gfxScene.redraw();
+    if (hasPointCloud)
+        this->updateViewLevelOfDetail();
+
+    emit graphicsBoundingBoxChanged(m_gpxBoundingBox);
+}
+
+void GuiDocument::mapPendingGraphics()
+{
+    const std::vector<TreeNodeId> vecEntity = std::move(m_vecPendingEntity);
+    m_vecPendingEntity.clear();
+    this->mapGraphics(vecEntity);
+}
+
+bool GuiDocument::mapEntityGraphics(TreeNodeId entityTreeNodeId, GraphicsItem* item)
 {
-    GraphicsItem item;
     const DocumentTreeNode entityTreeNode(m_document, entityTreeNodeId);
-    GraphicsEntity& gfxEntity = item.graphicsEntity;
+    GraphicsEntity& gfxEntity = item->graphicsEntity;
     gfxEntity = m_guiApp->graphicsEntityDriverTable()->createEntity(entityTreeNode.label());
     if (gfxEntity.aisObject().IsNull())
-        return;
+        return false;
+
+    if (m_guiApp->tessellationParameters().enabled) {
+        // Display the mesh computed at import as is, don't let AIS re-mesh in the GUI thread
+        AIS_XdeAssembly::foreachShapeObject(
+                    gfxEntity.aisObject(), [](const Handle_AIS_InteractiveObject& object) {
+            object->Attributes()->SetAutoTriangulation(false);
+        });
+    }
 
     gfxEntity.setScene(&m_gfxScene);
-    gfxEntity.setVisible(true);
-    item.entityTreeNodeId = entityTreeNodeId;
-    m_gfxScene.redraw();
+    const TDF_Label entityLabel = entityTreeNode.label();
+    if (XCaf::isShape(entityLabel)) {
+        item->gfxBatch = new AIS_ShapeBatch(entityLabel);
+        item->gfxProxy = new AIS_ShapeProxy(entityLabel);
+    }
+
+    if (Internal::hasPresentationToPrepare(entityLabel, gfxEntity.aisObject())) {
+        // Displayed once presentation data is computed, see startNextPresentationTask()
+        // Static batch is prepared along, so it's added to the scene only then
+        m_gfxScene.deferObjectDisplay(gfxEntity.aisObject());
+        m_vecPresentationRequest.push_back(entityTreeNodeId);
+    }
+    else {
+        // Selection is activated later on demand, see activateEntitySelection()
+        m_gfxScene.addObject(gfxEntity.aisObject(), GraphicsScene::AddObjectDisableSelectionMode);
+        m_gfxScene.addStaticBatch(gfxEntity.aisObject(), item->gfxBatch);
+        item->isPresentationReady = true;
+    }
+
+    item->entityTreeNodeId = entityTreeNodeId;
+    item->bndBox = Internal::entityBoundingBox(entityTreeNode.label(), gfxEntity);
+    return true;
+}
+
+void GuiDocument::startNextSelectionTask()
+{
+    while (!m_isSelectionTaskRunning) {
+        // Selection of an entity is computed once its presentation data is prepared
+        auto itRequest = std::find_if(
+                    m_vecSelectionRequest.begin(),
+                    m_vecSelectionRequest.end(),
+                    [=](TreeNodeId entityTreeNodeId) {
+            const GraphicsItem* item = this->findGraphicsItem(entityTreeNodeId);
+            return !item || item->isPresentationReady;
+        });
+        if (itRequest == m_vecSelectionRequest.end())
+            return;
+
+        const TreeNodeId entityTreeNodeId = *itRequest;
+        m_vecSelectionRequest.erase(itRequest);
+        auto gfxItem = const_cast<GraphicsItem*>(this->findGraphicsItem(entityTreeNodeId));
+        if (!gfxItem)
+            continue;
 
-    item.gpxTreeNodeMapping = m_guiApp->graphicsTreeNodeMappingDriverTable()->createMapping(entityTreeNode);
-    if (item.gpxTreeNodeMapping) {
-        const int selectMode = item.gpxTreeNodeMapping->selectionMode();
-        if (selectMode != -1) {
-            m_gfxScene.activateObjectSelection(gfxEntity.aisObject(), selectMode);
-            m_gfxScene.foreachOwner(gfxEntity.aisObject(), selectMode, [&](const GraphicsOwnerPtr& ptr) {
-                if (!item.gpxTreeNodeMapping->mapGraphicsOwner(ptr))
-                    qDebug() << "Insertion failed";
+        const DocumentTreeNode entityTreeNode(m_document, entityTreeNodeId);
+        auto mappingDriverTable = m_guiApp->graphicsTreeNodeMappingDriverTable();
+        m_selectionTaskMapping = mappingDriverTable->createMapping(entityTreeNode);
+        const int selectMode =
+                m_selectionTaskMapping ? m_selectionTaskMapping->selectionMode() : -1;
+        if (selectMode == -1) {
+            gfxItem->selectionStatus = SelectionStatus::Active;
+            gfxItem->vecPendingToggle.clear();
+            continue;
+        }
+
+        // Worker thread has exclusive access to the object selections and to the mapping
+        const GraphicsObjectPtr object = gfxItem->graphicsEntity.aisObject();
+        GraphicsTreeNodeMapping* mapping = m_selectionTaskMapping.get();
+        m_selectionTaskEntity = entityTreeNodeId;
+        m_selectionTaskId = m_selectionTaskMgr->newTask([=](TaskProgress*) {
+            MAYO_TRACE_SCOPE("graphics", "computeSelection");
+            static Metrics::Counter& counterOwners =
+                    Metrics::counter("graphics.selectionOwnersMapped");
+            static Metrics::Histogram& histoTime =
+                    Metrics::histogram("graphics.selectionComputeMs");
+            QElapsedTimer chrono;
+            chrono.start();
+            Internal::computeObjectSelection(object, selectMode);
+            std::unordered_set<const SelectMgr_EntityOwner*> setVisited;
+            Internal::foreachSelectionOwner(
+                        object, selectMode, &setVisited, [&](const GraphicsOwnerPtr& owner) {
+                if (mapping->mapGraphicsOwner(owner))
+                    counterOwners.add();
             });
+            histoTime.record(chrono.nsecsElapsed() / 1e6);
+        });
+        m_selectionTaskMgr->setTitle(m_selectionTaskId, tr("Computing selection"));
+        m_gfxScene.setObjectSelectionComputing(object, true);
+        m_isSelectionTaskRunning = true;
+        m_selectionTaskMgr->run(m_selectionTaskId);
+    }
+}
+
+void GuiDocument::onSelectionTaskEnded(TaskId taskId)
+{
+    if (!m_isSelectionTaskRunning || taskId != m_selectionTaskId)
+        return;
+
+    m_isSelectionTaskRunning = false;
+    auto gfxItem = const_cast<GraphicsItem*>(this->findGraphicsItem(m_selectionTaskEntity));
+    if (gfxItem) {
+        // Primitives are already computed, activation only loads them in the selector
+        // Visibility changes requested meanwhile are applied once selection is activated
+        const GraphicsObjectPtr object = gfxItem->graphicsEntity.aisObject();
+        const int selectMode = m_selectionTaskMapping->selectionMode();
+        m_gfxScene.activateObjectSelection(object, selectMode);
+        m_gfxScene.setObjectSelectionComputing(object, false);
+        gfxItem->gpxTreeNodeMapping = std::move(m_selectionTaskMapping);
+        gfxItem->selectionStatus = SelectionStatus::Active;
+        static Metrics::Counter& counterActivated =
+                Metrics::counter("graphics.selectionsActivated");
+        counterActivated.add();
+
+        const std::vector<TreeNodeId> vecToggle = std::move(gfxItem->vecPendingToggle);
+        gfxItem->vecPendingToggle.clear();
+        for (TreeNodeId nodeId : vecToggle) {
+            const DocumentTreeNode docTreeNode(m_document, nodeId);
+            auto vecGfxOwner = gfxItem->gpxTreeNodeMapping->findGraphicsOwners(docTreeNode);
+            for (const GraphicsOwnerPtr& gfxOwner : vecGfxOwner)
+                m_gfxScene.toggleOwnerSelection(gfxOwner);
+        }
+
+        if (!vecToggle.empty())
+            m_gfxScene.redraw();
+
+        emit entitySelectionActivated(m_selectionTaskEntity);
+    }
+
+    m_selectionTaskMapping.reset();
+    this->startNextSelectionTask();
+}
+
+void GuiDocument::startNextPresentationTask()
+{
+    while (!m_vecPresentationRequest.empty() && !m_isPresentationTaskRunning) {
+        const TreeNodeId entityTreeNodeId = m_vecPresentationRequest.front();
+        m_vecPresentationRequest.erase(m_vecPresentationRequest.begin());
+        const GraphicsItem* gfxItem = this->findGraphicsItem(entityTreeNodeId);
+        if (!gfxItem)
+            continue;
+
+        // Entity already displayed may only need its interaction proxy
+        const bool isObjectPrepared = !gfxItem->isPresentationReady;
+        Handle_AIS_ShapeProxy proxy;
+        if (m_isInteractionLodEnabled && !gfxItem->isProxyReady)
+            proxy = gfxItem->gfxProxy;
+
+        if (!isObjectPrepared && proxy.IsNull())
+            continue;
+
+        // Vertex buffers of the static batch are needed only if batching is on
+        const GraphicsObjectPtr object = gfxItem->graphicsEntity.aisObject();
+        Handle_AIS_ShapeBatch batch;
+        const bool isBatchNeeded = isObjectPrepared && m_gfxScene.isStaticBatchingEnabled();
+        if (isBatchNeeded && !gfxItem->gfxBatch.IsNull()) {
+            batch = gfxItem->gfxBatch;
+            batch->setFaceBoundaryDraw(object->Attributes()->FaceBoundaryDraw());
+        }
+
+        // Worker thread has exclusive access to the objects until they're displayed
+        const TDF_Label entityLabel = DocumentTreeNode(m_document, entityTreeNodeId).label();
+        m_presentationTaskEntity = entityTreeNodeId;
+        m_presentationTaskId = m_presentationTaskMgr->newTask([=](TaskProgress* progress) {
+            MAYO_TRACE_SCOPE("graphics", "preparePresentation");
+            static Metrics::Histogram& histoTime =
+                    Metrics::histogram("graphics.presentationPrepareMs");
+            QElapsedTimer chrono;
+            chrono.start();
+            if (isObjectPrepared)
+                Internal::prepareEntityPresentation(entityLabel, object, batch);
+
+            if (!proxy.IsNull())
+                proxy->prepare(progress);
+
+            histoTime.record(chrono.nsecsElapsed() / 1e6);
+        });
+        m_presentationTaskMgr->setTitle(m_presentationTaskId, tr("Computing presentation"));
+        m_isPresentationTaskRunning = true;
+        m_isPresentationTaskPreparingProxy = !proxy.IsNull();
+        m_presentationTaskMgr->run(m_presentationTaskId);
+    }
+}
+
+void GuiDocument::onPresentationTaskEnded(TaskId taskId)
+{
+    if (!m_isPresentationTaskRunning || taskId != m_presentationTaskId)
+        return;
+
+    m_isPresentationTaskRunning = false;
+    auto gfxItem = const_cast<GraphicsItem*>(this->findGraphicsItem(m_presentationTaskEntity));
+    if (gfxItem && m_isPresentationTaskPreparingProxy)
+        gfxItem->isProxyReady = true;
+
+    if (gfxItem && !gfxItem->isPresentationReady) {
+        MAYO_TRACE_SCOPE("graphics", "displayPreparedPresentation");
+        // Entity "pops in", display only attaches the data computed in the worker thread
+        // Visibility requested meanwhile is applied by GraphicsScene::addObject()
+        m_gfxScene.addObject(
+                    gfxItem->graphicsEntity.aisObject(),
+                    GraphicsScene::AddObjectDisableSelectionMode);
+        m_gfxScene.addStaticBatch(gfxItem->graphicsEntity.aisObject(), gfxItem->gfxBatch);
+        gfxItem->isPresentationReady = true;
+        m_hiddenLineDisplay->addEntity(
+                    m_presentationTaskEntity, gfxItem->graphicsEntity.aisObject());
+        static Metrics::Counter& counterDisplayed =
+                Metrics::counter("graphics.presentationsPrepared");
+        counterDisplayed.add();
+        m_gfxScene.redraw();
+    }
+
+    this->startNextPresentationTask();
+    this->startNextSelectionTask();
+}
+
+void GuiDocument::waitForEntityTasks(TreeNodeId entityTreeNodeId)
+{
+    // Entity objects can't be erased while they're accessed by a worker thread
+    if (m_isSelectionTaskRunning && m_selectionTaskEntity == entityTreeNodeId) {
+        m_selectionTaskMgr->requestAbort(m_selectionTaskId);
+        m_selectionTaskMgr->waitForDone(m_selectionTaskId);
+    }
+
+    if (m_isPresentationTaskRunning && m_presentationTaskEntity == entityTreeNodeId) {
+        m_presentationTaskMgr->requestAbort(m_presentationTaskId);
+        m_presentationTaskMgr->waitForDone(m_presentationTaskId);
+    }
+}
+
+void GuiDocument::updateViewLevelOfDetail()
+{
+    m_levelOfDetailTimer->start();
+}
+
+void GuiDocument::applyViewLevelOfDetail()
+{
+    int viewWidth = 0;
+    int viewHeight = 0;
+    if (!m_v3dView->Window().IsNull())
+        m_v3dView->Window()->Size(viewWidth, viewHeight);
+
+    bool isRedrawNeeded = false;
+    for (const GraphicsItem& item : m_vecGraphicsItem) {
+        auto gfxPointCloud = Handle_AIS_PointCloudLod::DownCast(item.graphicsEntity.aisObject());
+        if (!gfxPointCloud.IsNull()
+                && gfxPointCloud->updateLevelOfDetail(m_v3dView->Camera(), viewHeight))
+        {
+            m_gfxScene.recomputeObjectPresentationOnly(gfxPointCloud);
+            isRedrawNeeded = true;
+        }
+    }
+
+    if (isRedrawNeeded)
+        m_gfxScene.redraw();
+}
+
+void GuiDocument::setInteractionLodEnabled(bool on)
+{
+    if (on == m_isInteractionLodEnabled)
+        return;
 
-            //m_aisContext->Deactivate(gfxEntity.aisObject(), selectMode);
+    m_isInteractionLodEnabled = on;
+    if (on) {
+        // Proxies of the entities not displayed yet are prepared along with their presentation
+        for (const GraphicsItem& item : m_vecGraphicsItem) {
+            if (item.isPresentationReady && !item.gfxProxy.IsNull() && !item.isProxyReady)
+                m_vecPresentationRequest.push_back(item.entityTreeNodeId);
         }
+
+        this->startNextPresentationTask();
+    }
+    else if (m_isViewProxyShown) {
+        this->hideViewProxies();
+        m_gfxScene.redraw();
     }
+}
 
-    GraphicsUtils::V3dView_fitAll(m_v3dView);
-    const Bnd_Box itemBndBox = GraphicsUtils::AisObject_boundingBox(item.graphicsEntity.aisObject());
-    BndUtils::add(&m_gpxBoundingBox, itemBndBox);
-    m_vecGraphicsItem.emplace_back(std::move(item));
+void GuiDocument::beginViewInteraction()
+{
+    m_hiddenLineDisplay->onViewChangeStarted();
+    if (!m_isInteractionLodEnabled || m_isViewProxyShown)
+        return;
+
+    MAYO_TRACE_SCOPE("graphics", "beginViewInteraction");
+    int viewWidth = 0;
+    int viewHeight = 0;
+    if (!m_v3dView->Window().IsNull())
+        m_v3dView->Window()->Size(viewWidth, viewHeight);
+
+    // Triangle budget is shared by the proxies, in the order entities were added
+    int triangleBudget = AIS_ShapeProxy::DefaultTriangleBudget;
+    for (const GraphicsItem& item : m_vecGraphicsItem) {
+        const GraphicsObjectPtr object = item.graphicsEntity.aisObject();
+        if (!item.isProxyReady || !m_gfxScene.isObjectVisible(object))
+            continue;
+
+        const Handle_AIS_ShapeProxy& proxy = item.gfxProxy;
+        proxy->setTriangleBudget(triangleBudget);
+        // Presentation kept while erased is recomputed on display only if the LOD changed
+        if (proxy->updateLevelOfDetail(m_v3dView->Camera(), viewHeight))
+            proxy->SetToUpdate();
+
+        triangleBudget -= proxy->drawnTriangleCount();
+        m_gfxScene.addObject(proxy, GraphicsScene::AddObjectDisableSelectionMode);
+        m_gfxScene.setObjectPresentationVisible(object, false);
+        m_isViewProxyShown = true;
+    }
+
+    if (m_isViewProxyShown) {
+        static Metrics::Counter& counterShown = Metrics::counter("graphics.interactionLodShown");
+        counterShown.add();
+        m_gfxScene.redraw();
+    }
+}
+
+void GuiDocument::endViewInteraction()
+{
+    if (m_isViewProxyShown) {
+        this->hideViewProxies();
+        m_gfxScene.redraw();
+    }
+
+    m_hiddenLineDisplay->onViewChanged();
+    this->updateViewLevelOfDetail();
+}
+
+void GuiDocument::hideViewProxies()
+{
+    for (const GraphicsItem& item : m_vecGraphicsItem) {
+        if (!item.gfxProxy.IsNull() && m_gfxScene.isObjectVisible(item.gfxProxy)) {
+            m_gfxScene.setObjectVisible(item.gfxProxy, false);
+            m_gfxScene.setObjectPresentationVisible(item.graphicsEntity.aisObject(), true);
+        }
+    }
+
+    m_isViewProxyShown = false;
 }
 
 const GuiDocument::GraphicsItem* GuiDocument::findGraphicsItem(TreeNodeId entityTreeNodeId) const
 {
-    auto itFound = std::find_if(
-                m_vecGraphicsItem.cbegin(),
-                m_vecGraphicsItem.cend(),
-                [=](const GraphicsItem& item) { return item.entityTreeNodeId == entityTreeNodeId; });
-    return itFound != m_vecGraphicsItem.end() ? &(*itFound) : nullptr;
+    auto itFound = m_mapEntityItemIndex.find(entityTreeNodeId);
+    if (itFound == m_mapEntityItemIndex.cend())
+        return nullptr;
+
+    return &m_vecGraphicsItem.at(itFound->second);
 }
 
 void GuiDocument::v3dViewTrihedronDisplay(Qt::Corner corner)
@@ -7,11 +7,16 @@
 #pragma once
 
 #include "../base/document.h"
+#include "../base/span.h"
+#include "../base/task_common.h"
+#include "../graphics/ais_shape_batch.h"
+#include "../graphics/ais_shape_proxy.h"
 #include "../graphics/graphics_entity.h"
 #include "../graphics/graphics_scene.h"
 #include "../graphics/graphics_tree_node_mapping.h"
 
 #include <QtCore/QObject>
+#include <QtCore/QTimer>
 #include <AIS_InteractiveContext.hxx>
 #include <Bnd_Box.hxx>
 #include <V3d_Viewer.hxx>
@@ -25,12 +30,16 @@ namespace Mayo {
 
 class ApplicationItem;
 class GuiApplication;
+class GuiHiddenLineDisplay;
+class GuiTessellationRefiner;
+class TaskManager;
 class V3dViewCameraAnimation;
 
 class GuiDocument : public QObject {
     Q_OBJECT
 public:
     GuiDocument(const DocumentPtr& doc, GuiApplication* guiApp);
+    ~GuiDocument();
 
     GuiApplication* guiApplication() const { return m_guiApp; }
 
@@ -40,8 +49,26 @@ public:
     const Bnd_Box& graphicsBoundingBox() const { return m_gpxBoundingBox; }
     GraphicsEntity findGraphicsEntity(TreeNodeId entityTreeNodeId) const;
 
+    // Additional objects displayed along with the graphics of an entity(eg analysis results)
+    // They are erased when the entity is destroyed
+    void addEntityOverlay(TreeNodeId entityTreeNodeId, const GraphicsObjectPtr& object);
+    void removeEntityOverlays(TreeNodeId entityTreeNodeId);
+    bool hasEntityOverlays(TreeNodeId entityTreeNodeId) const;
+
     void toggleItemSelected(const ApplicationItem& appItem);
 
+    // Selection of entities is activated on demand : sensitive primitives and the mapping of
+    // graphics owners to tree nodes are computed in a worker thread the first time an entity is
+    // selected from the model tree or hovered in the 3D view
+    void activateEntitySelection(TreeNodeId entityTreeNodeId);
+    // Activates the selection of the entities whose bounding box is crossed by the view ray at
+    // 'pos'(3D view coordinates)
+    void activateSelectionAt(const QPoint& pos);
+
+    // Whether entity geometry is being read by a worker thread(selection, presentation or hidden
+    // lines computation)
+    bool isWorkerReadingGeometry() const;
+
     bool isOriginTrihedronVisible() const;
     void toggleOriginTrihedronVisibility();
 
@@ -65,8 +92,26 @@ public:
 
     int aisViewCubeBoundingSize() const;
 
+    GuiTessellationRefiner* tessellationRefiner() const { return m_tessellationRefiner; }
+    GuiHiddenLineDisplay* hiddenLineDisplay() const { return m_hiddenLineDisplay; }
+
+    // Selects again the points drawn by point cloud entities for the current view camera
+    // Update is deferred a little so that a sequence of view changes(eg zoom steps) is coalesced
+    void updateViewLevelOfDetail();
+
+    // Interaction level of detail : while the view is manipulated(eg rotation, panning), shape
+    // entities are drawn with reduced proxies(decimated meshes or bounding boxes of the parts)
+    // within a triangle budget. Proxies are prepared in a worker thread along with presentations
+    bool isInteractionLodEnabled() const { return m_isInteractionLodEnabled; }
+    void setInteractionLodEnabled(bool on);
+
+    // View manipulation starts/ends : entities are switched to their proxies and back
+    void beginViewInteraction();
+    void endViewInteraction();
+
 signals:
     void graphicsBoundingBoxChanged(const Bnd_Box& bndBox);
+    void entitySelectionActivated(TreeNodeId entityTreeNodeId);
     void viewTrihedronModeChanged(ViewTrihedronMode mode);
     void viewTrihedronCornerChanged(Qt::Corner corner);
 
@@ -74,14 +119,34 @@ private:
     void onDocumentEntityAdded(TreeNodeId entityTreeNodeId);
     void onDocumentEntityAboutToBeDestroyed(TreeNodeId entityTreeNodeId);
 
-    void mapGraphics(TreeNodeId entityTreeNodeId);
+    // Maps the graphics of all the entities, view fit and redraw are done once at the end
+    void mapGraphics(Span<const TreeNodeId> spanEntityTreeNodeId);
+    void mapPendingGraphics();
+    void applyViewLevelOfDetail();
+    void hideViewProxies();
+    void startNextSelectionTask();
+    void onSelectionTaskEnded(TaskId taskId);
+    void startNextPresentationTask();
+    void onPresentationTaskEnded(TaskId taskId);
+    void waitForEntityTasks(TreeNodeId entityTreeNodeId);
+
+    enum class SelectionStatus { Inactive, Pending, Active };
 
     struct GraphicsItem {
         GraphicsEntity graphicsEntity;
         TreeNodeId entityTreeNodeId;
-        std::unique_ptr<GraphicsTreeNodeMapping> gpxTreeNodeMapping;
+        Handle_AIS_ShapeBatch gfxBatch; // Null if entity isn't an XDE shape
+        bool isPresentationReady = false; // Object displayed once its data is prepared
+        Handle_AIS_ShapeProxy gfxProxy; // Null if entity isn't an XDE shape
+        bool isProxyReady = false;
+        std::unique_ptr<GraphicsTreeNodeMapping> gpxTreeNodeMapping; // Null until activated
+        SelectionStatus selectionStatus = SelectionStatus::Inactive;
+        std::vector<TreeNodeId> vecPendingToggle; // Selection toggled while pending
+        std::vector<GraphicsObjectPtr> vecOverlay;
+        Bnd_Box bndBox; // Computed from entity geometry
     };
 
+    bool mapEntityGraphics(TreeNodeId entityTreeNodeId, GraphicsItem* item);
     const GraphicsItem* findGraphicsItem(TreeNodeId entityTreeNodeId) const;
 
     void v3dViewTrihedronDisplay(Qt::Corner corner);
@@ -96,9 +161,29 @@ private:
     ViewTrihedronMode m_viewTrihedronMode = ViewTrihedronMode::None;
     Qt::Corner m_viewTrihedronCorner = Qt::BottomLeftCorner;
     Handle_AIS_InteractiveObject m_aisViewCube;
+    GuiTessellationRefiner* m_tessellationRefiner = nullptr;
+    GuiHiddenLineDisplay* m_hiddenLineDisplay = nullptr;
 
     std::vector<GraphicsItem> m_vecGraphicsItem;
+    std::unordered_map<TreeNodeId, size_t> m_mapEntityItemIndex; // -> Index in m_vecGraphicsItem
+    std::vector<TreeNodeId> m_vecPendingEntity; // Added entities not mapped yet
+    QTimer* m_mapGraphicsTimer = nullptr;
+    TaskManager* m_selectionTaskMgr = nullptr;
+    TaskId m_selectionTaskId = 0;
+    bool m_isSelectionTaskRunning = false;
+    TreeNodeId m_selectionTaskEntity = 0;
+    std::unique_ptr<GraphicsTreeNodeMapping> m_selectionTaskMapping;
+    std::vector<TreeNodeId> m_vecSelectionRequest; // Entities waiting for selection activation
+    TaskManager* m_presentationTaskMgr = nullptr;
+    TaskId m_presentationTaskId = 0;
+    bool m_isPresentationTaskRunning = false;
+    TreeNodeId m_presentationTaskEntity = 0;
+    bool m_isPresentationTaskPreparingProxy = false;
+    std::vector<TreeNodeId> m_vecPresentationRequest; // Entities waiting to be displayed
     Bnd_Box m_gpxBoundingBox;
+    QTimer* m_levelOfDetailTimer = nullptr;
+    bool m_isInteractionLodEnabled = false;
+    bool m_isViewProxyShown = false;
 };
 
 } // namespace Mayo
@@ -0,0 +1,281 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "gui_hidden_line_display.h"
+
+#include "../base/bnd_utils.h"
+#include "../base/document.h"
+#include "../base/metrics.h"
+#include "../base/task_manager.h"
+#include "../base/tracing.h"
+#include "../base/xcaf.h"
+#include "gui_document.h"
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QTimer>
+#include <algorithm>
+
+namespace Mayo {
+
+namespace Internal {
+
+// Delay after the last view change before lines are computed
+static const int hiddenLineDisplayDelay = 300; // ms
+static const size_t hiddenLineDisplayCacheMaxSize = 8;
+static const double hiddenLineDisplayAngularTolerance = 1e-6; // rad
+
+} // namespace Internal
+
+GuiHiddenLineDisplay::GuiHiddenLineDisplay(GuiDocument* guiDoc)
+    : QObject(guiDoc),
+      m_guiDoc(guiDoc),
+      m_taskMgr(new TaskManager(this)),
+      m_delayTimer(new QTimer(this)),
+      m_gfxLines(new AIS_HlrLines)
+{
+    m_delayTimer->setSingleShot(true);
+    m_delayTimer->setInterval(Internal::hiddenLineDisplayDelay);
+    QObject::connect(m_delayTimer, &QTimer::timeout, this, &GuiHiddenLineDisplay::startTask);
+    QObject::connect(m_taskMgr, &TaskManager::ended, this, &GuiHiddenLineDisplay::onTaskEnded);
+    // Only visible entities are drawn, cached results are obsolete once an entity is shown/hidden
+    QObject::connect(
+                guiDoc->graphicsScene(), &GraphicsScene::objectVisibilityChanged,
+                this, [=](const GraphicsObjectPtr& object) {
+        auto itEntity = std::find_if(
+                    m_vecEntity.cbegin(), m_vecEntity.cend(),
+                    [&](const Entity& entity) { return entity.object == object; });
+        if (itEntity != m_vecEntity.cend())
+            this->invalidate();
+    });
+}
+
+GuiHiddenLineDisplay::~GuiHiddenLineDisplay()
+{
+    if (m_isTaskRunning) {
+        m_taskMgr->requestAbort(m_taskId);
+        m_taskMgr->waitForDone(m_taskId);
+    }
+}
+
+void GuiHiddenLineDisplay::setEnabled(bool on)
+{
+    if (on == m_isEnabled)
+        return;
+
+    m_isEnabled = on;
+    if (on) {
+        this->onViewChanged();
+    }
+    else {
+        m_delayTimer->stop();
+        if (m_isTaskRunning)
+            m_taskMgr->requestAbort(m_taskId);
+
+        this->showPresentations();
+    }
+}
+
+void GuiHiddenLineDisplay::setAlgorithm(GraphicsHlr::Algorithm algo)
+{
+    if (algo == m_algorithm)
+        return;
+
+    m_algorithm = algo;
+    this->onViewChanged();
+}
+
+void GuiHiddenLineDisplay::addEntity(TreeNodeId entityTreeNodeId, const GraphicsObjectPtr& object)
+{
+    const TDF_Label entityLabel = m_guiDoc->document()->modelTree().nodeData(entityTreeNodeId);
+    if (!XCaf::isShape(entityLabel))
+        return;
+
+    m_vecEntity.push_back({ entityTreeNodeId, object });
+    this->invalidate();
+}
+
+void GuiHiddenLineDisplay::removeEntity(TreeNodeId entityTreeNodeId)
+{
+    auto itRemoveBegin = std::remove_if(
+                m_vecEntity.begin(), m_vecEntity.end(),
+                [=](const Entity& entity) { return entity.treeNodeId == entityTreeNodeId; });
+    if (itRemoveBegin == m_vecEntity.end())
+        return;
+
+    m_vecEntity.erase(itRemoveBegin, m_vecEntity.end());
+    this->invalidate();
+}
+
+void GuiHiddenLineDisplay::invalidate()
+{
+    ++m_generation;
+    m_vecCacheItem.clear();
+    this->onViewChanged();
+}
+
+void GuiHiddenLineDisplay::onViewChangeStarted()
+{
+    if (!m_isEnabled)
+        return;
+
+    m_delayTimer->stop();
+    this->showPresentations();
+}
+
+void GuiHiddenLineDisplay::onViewChanged()
+{
+    if (!m_isEnabled)
+        return;
+
+    const gp_Dir viewDir = this->currentViewDirection();
+    const ResultPtr cachedResult = this->findCachedResult(viewDir);
+    if (cachedResult) {
+        m_delayTimer->stop();
+        this->showLines(cachedResult);
+        return;
+    }
+
+    // Lines currently shown are kept if still valid for the view direction, until they're updated
+    const GraphicsScene* gfxScene = m_guiDoc->graphicsScene();
+    const bool areLinesUsable =
+            gfxScene->isObjectVisible(m_gfxLines)
+            && m_linesViewDir.IsEqual(viewDir, Internal::hiddenLineDisplayAngularTolerance);
+    if (!areLinesUsable)
+        this->showPresentations();
+
+    m_delayTimer->start();
+}
+
+gp_Dir GuiHiddenLineDisplay::currentViewDirection() const
+{
+    // HLR projection direction points towards the viewer
+    return m_guiDoc->v3dView()->Camera()->Direction().Reversed();
+}
+
+GuiHiddenLineDisplay::ResultPtr GuiHiddenLineDisplay::findCachedResult(const gp_Dir& viewDir) const
+{
+    for (const CacheItem& item : m_vecCacheItem) {
+        if (item.algo == m_algorithm
+                && item.viewDir.IsEqual(viewDir, Internal::hiddenLineDisplayAngularTolerance))
+        {
+            return item.result;
+        }
+    }
+
+    return {};
+}
+
+void GuiHiddenLineDisplay::startTask()
+{
+    if (!m_isEnabled)
+        return;
+
+    // Only one computation at a time, the running one is cancelled and started again once done
+    if (m_isTaskRunning) {
+        m_taskMgr->requestAbort(m_taskId);
+        m_isTaskRestartNeeded = true;
+        return;
+    }
+
+    std::vector<TopoDS_Shape> vecPart;
+    const DocumentPtr& doc = m_guiDoc->document();
+    for (const Entity& entity : m_vecEntity) {
+        if (m_guiDoc->graphicsScene()->isObjectVisible(entity.object)) {
+            const TDF_Label entityLabel = doc->modelTree().nodeData(entity.treeNodeId);
+            GraphicsHlr::explodeParts(XCaf::shape(entityLabel), &vecPart);
+        }
+    }
+
+    // Lines lie in the plane facing the camera through the center of the scene
+    const Bnd_Box& bndBox = m_guiDoc->graphicsBoundingBox();
+    const gp_Pnt center = !bndBox.IsVoid() ? BndBoxCoords::get(bndBox).center() : gp::Origin();
+    const gp_Dir viewDir = this->currentViewDirection();
+    const gp_Ax2 viewPlane(center, viewDir);
+    const GraphicsHlr::Algorithm algo = m_algorithm;
+    auto result = std::make_shared<GraphicsHlr::Result>();
+    m_taskId = m_taskMgr->newTask([=](TaskProgress* progress) {
+        MAYO_TRACE_SCOPE("graphics", "computeHiddenLines");
+        static Metrics::Histogram& histoTime = Metrics::histogram("graphics.hlrComputeMs");
+        QElapsedTimer chrono;
+        chrono.start();
+        *result = GraphicsHlr::compute(vecPart, viewPlane, algo, progress);
+        histoTime.record(chrono.nsecsElapsed() / 1e6);
+    });
+    m_taskMgr->setTitle(m_taskId, tr("Computing hidden lines"));
+    m_taskResult = result;
+    m_taskViewDir = viewDir;
+    m_taskAlgo = algo;
+    m_taskGeneration = m_generation;
+    m_isTaskRunning = true;
+    m_taskMgr->run(m_taskId);
+}
+
+void GuiHiddenLineDisplay::onTaskEnded(TaskId taskId)
+{
+    if (!m_isTaskRunning || taskId != m_taskId)
+        return;
+
+    m_isTaskRunning = false;
+    const bool isAborted = m_isTaskRestartNeeded || !m_isEnabled;
+    const bool isObsolete = m_taskGeneration != m_generation;
+    if (!isAborted && !isObsolete) {
+        ResultPtr result = std::move(m_taskResult);
+        m_vecCacheItem.push_back({ m_taskViewDir, m_taskAlgo, result });
+        if (m_vecCacheItem.size() > Internal::hiddenLineDisplayCacheMaxSize)
+            m_vecCacheItem.erase(m_vecCacheItem.begin());
+
+        const bool isCurrentView =
+                m_taskAlgo == m_algorithm
+                && m_taskViewDir.IsEqual(
+                    this->currentViewDirection(), Internal::hiddenLineDisplayAngularTolerance);
+        if (isCurrentView && !m_delayTimer->isActive())
+            this->showLines(result);
+    }
+
+    m_taskResult.reset();
+    const bool isRestartNeeded = m_isTaskRestartNeeded || (isObsolete && m_isEnabled);
+    m_isTaskRestartNeeded = false;
+    if (isRestartNeeded && !m_delayTimer->isActive())
+        this->startTask();
+}
+
+void GuiHiddenLineDisplay::showLines(const ResultPtr& result)
+{
+    GraphicsScene* gfxScene = m_guiDoc->graphicsScene();
+    const bool isLinesVisible = gfxScene->isObjectVisible(m_gfxLines);
+    if (!isLinesVisible || m_gfxLines->result() != result) {
+        m_gfxLines->setResult(result);
+        if (isLinesVisible)
+            gfxScene->recomputeObjectPresentationOnly(m_gfxLines);
+        else
+            gfxScene->addObject(m_gfxLines, GraphicsScene::AddObjectDisableSelectionMode);
+
+        static Metrics::Counter& counterShown = Metrics::counter("graphics.hlrResultsShown");
+        counterShown.add();
+    }
+
+    // Entities are still selectable, only their presentation is hidden
+    for (const Entity& entity : m_vecEntity)
+        gfxScene->setObjectPresentationVisible(entity.object, false);
+
+    m_linesViewDir = this->currentViewDirection();
+    gfxScene->redraw();
+}
+
+void GuiHiddenLineDisplay::showPresentations()
+{
+    GraphicsScene* gfxScene = m_guiDoc->graphicsScene();
+    if (!gfxScene->isObjectVisible(m_gfxLines))
+        return;
+
+    gfxScene->eraseObject(m_gfxLines);
+    for (const Entity& entity : m_vecEntity)
+        gfxScene->setObjectPresentationVisible(entity.object, true);
+
+    gfxScene->redraw();
+}
+
+} // namespace Mayo
@@ -0,0 +1,98 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "../base/libtree.h"
+#include "../base/task_common.h"
+#include "../graphics/ais_hlr_lines.h"
+#include "../graphics/graphics_hlr.h"
+#include "../graphics/graphics_object_ptr.h"
+
+#include <QtCore/QObject>
+#include <gp_Dir.hxx>
+#include <memory>
+#include <vector>
+
+class QTimer;
+
+namespace Mayo {
+
+class GuiDocument;
+class TaskManager;
+
+// Draws the shape entities of a GuiDocument with hidden-line removal(HLR), when the scene
+// hidden-line drawing mode is on. Lines are computed in a worker thread once the view camera
+// stopped changing for a short delay, meanwhile entities are drawn with their regular(shaded)
+// presentation. Results are cached per view direction, so panning and zooming don't require any
+// computation. Meant for orthographic projection : lines are drawn in a plane facing the camera
+class GuiHiddenLineDisplay : public QObject {
+    Q_OBJECT
+public:
+    GuiHiddenLineDisplay(GuiDocument* guiDoc);
+    ~GuiHiddenLineDisplay();
+
+    bool isEnabled() const { return m_isEnabled; }
+    void setEnabled(bool on);
+
+    GraphicsHlr::Algorithm algorithm() const { return m_algorithm; }
+    void setAlgorithm(GraphicsHlr::Algorithm algo);
+
+    void addEntity(TreeNodeId entityTreeNodeId, const GraphicsObjectPtr& object);
+    void removeEntity(TreeNodeId entityTreeNodeId);
+
+    // Discards the cached results, eg geometry of the entities changed
+    void invalidate();
+
+    // View camera starts changing : HLR lines are replaced by the regular presentations
+    void onViewChangeStarted();
+    // View camera changed : HLR lines are taken from cache or computed after a short delay
+    void onViewChanged();
+
+    bool isRunning() const { return m_isTaskRunning; }
+
+private:
+    using ResultPtr = AIS_HlrLines::ResultPtr;
+
+    struct Entity {
+        TreeNodeId treeNodeId;
+        GraphicsObjectPtr object;
+    };
+
+    struct CacheItem {
+        gp_Dir viewDir;
+        GraphicsHlr::Algorithm algo;
+        ResultPtr result;
+    };
+
+    gp_Dir currentViewDirection() const;
+    ResultPtr findCachedResult(const gp_Dir& viewDir) const;
+    void startTask();
+    void onTaskEnded(TaskId taskId);
+    void showLines(const ResultPtr& result);
+    void showPresentations();
+
+    GuiDocument* m_guiDoc = nullptr;
+    TaskManager* m_taskMgr = nullptr;
+    QTimer* m_delayTimer = nullptr;
+    bool m_isEnabled = false;
+    GraphicsHlr::Algorithm m_algorithm = GraphicsHlr::Algorithm::Polygonal;
+    std::vector<Entity> m_vecEntity;
+    Handle_AIS_HlrLines m_gfxLines;
+    std::vector<CacheItem> m_vecCacheItem; // Oldest first
+    gp_Dir m_linesViewDir; // View direction of the lines shown
+
+    TaskId m_taskId = 0;
+    bool m_isTaskRunning = false;
+    bool m_isTaskRestartNeeded = false;
+    gp_Dir m_taskViewDir;
+    GraphicsHlr::Algorithm m_taskAlgo = GraphicsHlr::Algorithm::Polygonal;
+    std::shared_ptr<GraphicsHlr::Result> m_taskResult;
+    unsigned m_generation = 0; // Incremented on invalidation, results of older tasks are dropped
+    unsigned m_taskGeneration = 0;
+};
+
+} // namespace Mayo
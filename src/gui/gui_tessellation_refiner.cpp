@@ -0,0 +1,406 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "gui_tessellation_refiner.h"
+
+#include "../base/bnd_utils.h"
+#include "../base/document.h"
+#include "../base/mass_properties.h"
+#include "../base/metrics.h"
+#include "../base/task_manager.h"
+#include "../base/thread_budget.h"
+#include "../base/tracing.h"
+#include "gui_document.h"
+
+#include <BRep_Builder.hxx>
+#include <BRep_Tool.hxx>
+#include <BRepBndLib.hxx>
+#include <BRepBuilderAPI_Copy.hxx>
+#include <BRepMesh_IncrementalMesh.hxx>
+#include <BRepTools.hxx>
+#include <Poly_PolygonOnTriangulation.hxx>
+#include <Poly_Triangulation.hxx>
+#include <TopExp_Explorer.hxx>
+#include <TopoDS.hxx>
+#include <TopoDS_Iterator.hxx>
+#include <TopTools_DataMapOfShapeInteger.hxx>
+
+#include <QtCore/QTimer>
+#include <algorithm>
+#include <climits>
+#include <mutex>
+#include <shared_mutex>
+#include <utility>
+
+namespace Mayo {
+
+namespace Internal {
+
+// Limits of a batch, small enough to get frequent visual updates
+static const int tessellationRefinerBatchMaxUnitCount = 64;
+static const int tessellationRefinerBatchMaxFaceCount = 2000;
+// Minimum delay between two updates of the entity presentations
+static const int tessellationRefinerPresentationDelay = 400; // ms
+// Delay before applying again a batch postponed by a selection or presentation computation
+static const int tessellationRefinerWorkerWaitDelay = 50; // ms
+
+static int faceCount(const TopoDS_Shape& shape)
+{
+    int count = 0;
+    for (TopExp_Explorer expl(shape, TopAbs_FACE); expl.More(); expl.Next())
+        ++count;
+
+    return count;
+}
+
+// Transfers the triangulation of 'faceSrc' to 'faceDst' along with the polygons of the edges on
+// that triangulation. Both faces must have the same topological structure
+static void transferTriangulation(
+        BRep_Builder* builder, const TopoDS_Face& faceSrc, const TopoDS_Face& faceDst)
+{
+    TopLoc_Location locSrc;
+    const Handle_Poly_Triangulation& triangulation = BRep_Tool::Triangulation(faceSrc, locSrc);
+    if (triangulation.IsNull())
+        return;
+
+    // Edge polygons on the previous triangulation are removed, as BRepMesh does
+    TopLoc_Location locDst;
+    const Handle_Poly_Triangulation triangulationPrev = BRep_Tool::Triangulation(faceDst, locDst);
+    TopExp_Explorer explSrc(faceSrc, TopAbs_EDGE);
+    TopExp_Explorer explDst(faceDst, TopAbs_EDGE);
+    for (; explSrc.More() && explDst.More(); explSrc.Next(), explDst.Next()) {
+        const TopoDS_Edge edgeSrc = TopoDS::Edge(explSrc.Current().Oriented(TopAbs_FORWARD));
+        const TopoDS_Edge edgeDst = TopoDS::Edge(explDst.Current().Oriented(TopAbs_FORWARD));
+        if (!triangulationPrev.IsNull()) {
+            builder->UpdateEdge(
+                        edgeDst, Handle_Poly_PolygonOnTriangulation(), triangulationPrev, locDst);
+        }
+
+        const Handle_Poly_PolygonOnTriangulation& polygon =
+                BRep_Tool::PolygonOnTriangulation(edgeSrc, triangulation, locSrc);
+        if (polygon.IsNull())
+            continue;
+
+        if (BRep_Tool::IsClosed(edgeSrc, faceSrc)) {
+            const Handle_Poly_PolygonOnTriangulation& polygonReversed =
+                    BRep_Tool::PolygonOnTriangulation(
+                        TopoDS::Edge(edgeSrc.Reversed()), triangulation, locSrc);
+            builder->UpdateEdge(edgeDst, polygon, polygonReversed, triangulation, locSrc);
+        }
+        else {
+            builder->UpdateEdge(edgeDst, polygon, triangulation, locSrc);
+        }
+    }
+
+    builder->UpdateFace(faceDst, triangulation);
+}
+
+} // namespace Internal
+
+GuiTessellationRefiner::GuiTessellationRefiner(GuiDocument* guiDoc)
+    : QObject(guiDoc),
+      m_guiDoc(guiDoc),
+      m_taskMgr(new TaskManager(this))
+{
+    QObject::connect(m_taskMgr, &TaskManager::ended, this, &GuiTessellationRefiner::onTaskEnded);
+}
+
+GuiTessellationRefiner::~GuiTessellationRefiner()
+{
+    if (m_isBatchRunning) {
+        m_taskMgr->requestAbort(m_batchTaskId);
+        m_taskMgr->waitForDone(m_batchTaskId);
+    }
+}
+
+void GuiTessellationRefiner::addEntities(
+        Span<const TreeNodeId> spanEntityTreeNodeId, const TessellationParameters& params)
+{
+    const DocumentPtr& doc = m_guiDoc->document();
+    std::vector<TreeNodeId> vecEntityTreeNodeId;
+    std::vector<TopoDS_Shape> vecEntityShape;
+    for (TreeNodeId entityTreeNodeId : spanEntityTreeNodeId) {
+        const TDF_Label entityLabel = doc->modelTree().nodeData(entityTreeNodeId);
+        if (XCaf::isShape(entityLabel)) {
+            vecEntityTreeNodeId.push_back(entityTreeNodeId);
+            vecEntityShape.push_back(XCaf::shape(entityLabel));
+        }
+    }
+
+    if (vecEntityShape.empty())
+        return;
+
+    const double linDeflection = Tessellation::chordalDeflection(params, vecEntityShape);
+    const size_t jobCountStart = m_vecPendingJob.size();
+    for (size_t i = 0; i < vecEntityShape.size(); ++i) {
+        this->addEntity(
+                    vecEntityTreeNodeId.at(i),
+                    vecEntityShape.at(i),
+                    linDeflection,
+                    params.angularDeflection);
+    }
+
+    if (m_vecPendingJob.size() != jobCountStart && !m_isBatchRunning)
+        this->startNextBatch();
+}
+
+void GuiTessellationRefiner::addEntity(
+        TreeNodeId entityTreeNodeId,
+        const TopoDS_Shape& entityShape,
+        double linDeflection,
+        double angDeflection)
+{
+    // Same units as Tessellation::meshingUnits(), so batch jobs never share edges
+    // A unit groups candidate sub-shapes sharing edges, map each candidate to its unit
+    const std::vector<TopoDS_Shape> vecUnit =
+            Tessellation::meshingUnits(Span<const TopoDS_Shape>(&entityShape, 1));
+    TopTools_DataMapOfShapeInteger mapCandidateUnitIndex;
+    for (int i = 0; i < int(vecUnit.size()); ++i) {
+        const TopoDS_Shape& unit = vecUnit.at(i);
+        if (unit.ShapeType() == TopAbs_COMPOUND) {
+            for (TopoDS_Iterator it(unit); it.More(); it.Next())
+                mapCandidateUnitIndex.Bind(it.Value(), i);
+        }
+        else {
+            mapCandidateUnitIndex.Bind(unit, i);
+        }
+    }
+
+    // Group located instances by meshing unit
+    std::vector<int> vecUnitJobIndex(vecUnit.size(), -1);
+    const size_t jobIndexStart = m_vecPendingJob.size();
+    auto fnAddInstance = [&](const TopoDS_Shape& instance) {
+        const int* ptrUnitIndex = mapCandidateUnitIndex.Seek(instance.Located(TopLoc_Location()));
+        if (!ptrUnitIndex)
+            return;
+
+        const TopoDS_Shape& unit = vecUnit.at(*ptrUnitIndex);
+        if (BRepTools::Triangulation(unit, linDeflection))
+            return; // Already fine enough
+
+        Bnd_Box instanceBndBox;
+        BRepBndLib::Add(instance, instanceBndBox);
+        int& jobIndex = vecUnitJobIndex.at(*ptrUnitIndex);
+        if (jobIndex >= 0) {
+            Job& job = m_vecPendingJob.at(jobIndex);
+            BndUtils::add(&job.bndBox, instanceBndBox);
+        }
+        else {
+            Job job = {};
+            job.entityTreeNodeId = entityTreeNodeId;
+            job.unit = unit;
+            job.bndBox = instanceBndBox;
+            job.linDeflection = linDeflection;
+            job.angDeflection = angDeflection;
+            job.faceCount = Internal::faceCount(unit);
+            jobIndex = int(m_vecPendingJob.size());
+            m_vecPendingJob.push_back(std::move(job));
+        }
+    };
+
+    // Located instances of the candidates, see Tessellation::meshingUnits()
+    // Pairs of (candidate type, type to avoid), TopAbs_SHAPE meaning nothing to avoid
+    const std::pair<TopAbs_ShapeEnum, TopAbs_ShapeEnum> arrayCandidateType[] = {
+        { TopAbs_COMPSOLID, TopAbs_SHAPE },
+        { TopAbs_SOLID, TopAbs_COMPSOLID },
+        { TopAbs_SHELL, TopAbs_SOLID },
+        { TopAbs_FACE, TopAbs_SHELL }
+    };
+    for (const auto& candidateType : arrayCandidateType) {
+        TopExp_Explorer expl(entityShape, candidateType.first, candidateType.second);
+        for (; expl.More(); expl.Next())
+            fnAddInstance(expl.Current());
+    }
+
+    if (m_vecPendingJob.size() != jobIndexStart)
+        m_setRemovedEntity.erase(entityTreeNodeId);
+}
+
+void GuiTessellationRefiner::removeEntity(TreeNodeId entityTreeNodeId)
+{
+    auto itRemoveBegin = std::remove_if(
+                m_vecPendingJob.begin(), m_vecPendingJob.end(),
+                [=](const Job& job) { return job.entityTreeNodeId == entityTreeNodeId; });
+    m_vecPendingJob.erase(itRemoveBegin, m_vecPendingJob.end());
+    m_setDirtyEntity.erase(entityTreeNodeId);
+    // Jobs of the running batch can't be touched, they're discarded once the batch is done
+    if (m_isBatchRunning)
+        m_setRemovedEntity.insert(entityTreeNodeId);
+}
+
+void GuiTessellationRefiner::startNextBatch()
+{
+    if (m_vecPendingJob.empty()) {
+        this->updatePresentations();
+        return;
+    }
+
+    // Biggest parts on screen first, with the current camera
+    for (Job& job : m_vecPendingJob)
+        job.screenArea = this->screenArea(job.bndBox);
+
+    std::stable_sort(
+                m_vecPendingJob.begin(), m_vecPendingJob.end(),
+                [](const Job& lhs, const Job& rhs) { return lhs.screenArea > rhs.screenArea; });
+
+    int batchFaceCount = 0;
+    auto itJob = m_vecPendingJob.begin();
+    while (itJob != m_vecPendingJob.end()) {
+        const bool isBatchFull =
+                int(m_vecBatchJob.size()) >= Internal::tessellationRefinerBatchMaxUnitCount
+                || batchFaceCount >= Internal::tessellationRefinerBatchMaxFaceCount;
+        if (isBatchFull)
+            break;
+
+        batchFaceCount += itJob->faceCount;
+        // Topology is copied but geometry is shared
+        itJob->unitCopy = BRepBuilderAPI_Copy(itJob->unit, false, false).Shape();
+        m_vecBatchJob.push_back(std::move(*itJob));
+        ++itJob;
+    }
+
+    m_vecPendingJob.erase(m_vecPendingJob.begin(), itJob);
+
+    std::vector<Job>* ptrVecBatchJob = &m_vecBatchJob;
+    m_batchTaskId = m_taskMgr->newTask([=](TaskProgress* progress) {
+        MAYO_TRACE_SCOPE("mesh", "refineBatch");
+        const std::vector<Job>& vecJob = *ptrVecBatchJob;
+        ThreadBudget::parallelFor(0, int(vecJob.size()), [&](int i) {
+            if (TaskProgress::isAbortRequested(progress))
+                return;
+
+            const Job& job = vecJob.at(i);
+            BRepMesh_IncrementalMesh mesher(
+                        job.unitCopy, job.linDeflection, false, job.angDeflection, false);
+        });
+    });
+    m_taskMgr->setTitle(m_batchTaskId, tr("Refining meshes"));
+    m_isBatchRunning = true;
+    m_taskMgr->run(m_batchTaskId);
+}
+
+void GuiTessellationRefiner::onTaskEnded(TaskId taskId)
+{
+    if (!m_isBatchRunning || taskId != m_batchTaskId)
+        return;
+
+    // Faces can't be updated while a selection, presentation or properties(see
+    // Tessellation::triangulationMutex()) are computed from them in a worker thread, so try again
+    // a little later
+    std::unique_lock<std::shared_mutex> lockTriangulation(
+                Tessellation::triangulationMutex(), std::try_to_lock);
+    if (m_guiDoc->isWorkerReadingGeometry() || !lockTriangulation.owns_lock()) {
+        QTimer::singleShot(Internal::tessellationRefinerWorkerWaitDelay, this, [=]{
+            this->onTaskEnded(taskId);
+        });
+        return;
+    }
+
+    static Metrics::Counter& counterRefined = Metrics::counter("mesh.unitsRefined");
+    m_isBatchRunning = false;
+    BRep_Builder builder;
+    for (const Job& job : m_vecBatchJob) {
+        if (m_setRemovedEntity.find(job.entityTreeNodeId) != m_setRemovedEntity.cend())
+            continue;
+
+        // BRepBuilderAPI_Copy preserves the topological structure, so faces and edges come in
+        // same order
+        TopExp_Explorer explUnit(job.unit, TopAbs_FACE);
+        TopExp_Explorer explCopy(job.unitCopy, TopAbs_FACE);
+        for (; explUnit.More() && explCopy.More(); explUnit.Next(), explCopy.Next()) {
+            Internal::transferTriangulation(
+                        &builder,
+                        TopoDS::Face(explCopy.Current()),
+                        TopoDS::Face(explUnit.Current()));
+        }
+
+        m_setDirtyEntity.insert(job.entityTreeNodeId);
+        counterRefined.add();
+    }
+
+    // Cached properties computed from the previous triangulations are now stale
+    const DocumentPtr& doc = m_guiDoc->document();
+    for (TreeNodeId entityTreeNodeId : m_setDirtyEntity) {
+        const TDF_Label entityLabel = doc->modelTree().nodeData(entityTreeNodeId);
+        const TopoDS_Shape entityShape = XCaf::shape(entityLabel);
+        OrientedBoundingBoxCache::erase(entityShape);
+        MassPropertiesCache::erase(entityShape);
+    }
+
+    lockTriangulation.unlock();
+
+    m_vecBatchJob.clear();
+    m_setRemovedEntity.clear();
+    if (!m_presentationTimer.isValid()
+            || m_presentationTimer.elapsed() >= Internal::tessellationRefinerPresentationDelay)
+    {
+        this->updatePresentations();
+    }
+
+    this->startNextBatch();
+}
+
+void GuiTessellationRefiner::updatePresentations()
+{
+    if (m_setDirtyEntity.empty())
+        return;
+
+    MAYO_TRACE_SCOPE("graphics", "refinePresentations");
+    GraphicsScene* gfxScene = m_guiDoc->graphicsScene();
+    for (TreeNodeId entityTreeNodeId : m_setDirtyEntity) {
+        const GraphicsEntity gfxEntity = m_guiDoc->findGraphicsEntity(entityTreeNodeId);
+        if (!gfxEntity.aisObject().IsNull())
+            gfxScene->recomputeObjectPresentationOnly(gfxEntity.aisObject());
+
+        if (this->pendingJobCount(entityTreeNodeId) == 0)
+            emit entityRefined(entityTreeNodeId);
+    }
+
+    m_setDirtyEntity.clear();
+    gfxScene->redraw();
+    m_presentationTimer.start();
+}
+
+double GuiTessellationRefiner::screenArea(const Bnd_Box& bndBox) const
+{
+    const Handle_V3d_View& view = m_guiDoc->v3dView();
+    if (bndBox.IsVoid() || view.IsNull() || view->Window().IsNull())
+        return 0.;
+
+    int xMin = INT_MAX;
+    int yMin = INT_MAX;
+    int xMax = INT_MIN;
+    int yMax = INT_MIN;
+    for (const gp_Pnt& pnt : BndBoxCoords::get(bndBox).vertices()) {
+        int x, y;
+        view->Convert(pnt.X(), pnt.Y(), pnt.Z(), x, y);
+        xMin = std::min(x, xMin);
+        yMin = std::min(y, yMin);
+        xMax = std::max(x, xMax);
+        yMax = std::max(y, yMax);
+    }
+
+    // Only the visible part counts
+    int width, height;
+    view->Window()->Size(width, height);
+    xMin = std::max(xMin, 0);
+    yMin = std::max(yMin, 0);
+    xMax = std::min(xMax, width);
+    yMax = std::min(yMax, height);
+    if (xMax <= xMin || yMax <= yMin)
+        return 0.;
+
+    return double(xMax - xMin) * double(yMax - yMin);
+}
+
+int GuiTessellationRefiner::pendingJobCount(TreeNodeId entityTreeNodeId) const
+{
+    const auto fnMatch = [=](const Job& job) { return job.entityTreeNodeId == entityTreeNodeId; };
+    return int(std::count_if(m_vecPendingJob.cbegin(), m_vecPendingJob.cend(), fnMatch)
+               + std::count_if(m_vecBatchJob.cbegin(), m_vecBatchJob.cend(), fnMatch));
+}
+
+} // namespace Mayo
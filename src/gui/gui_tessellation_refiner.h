@@ -0,0 +1,86 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "../base/libtree.h"
+#include "../base/span.h"
+#include "../base/task_common.h"
+#include "../base/tessellation.h"
+
+#include <Bnd_Box.hxx>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QObject>
+#include <TopoDS_Shape.hxx>
+#include <unordered_set>
+#include <vector>
+
+namespace Mayo {
+
+class GuiDocument;
+class TaskManager;
+
+// Refines in background the tessellation of the entities displayed in a GuiDocument, from the
+// coarse mesh computed at import up to the final deflection(see TessellationParameters::progressive)
+// Meshing units are processed by batches, biggest on screen first. Each batch is meshed in a
+// worker thread on copies of the units, so displayed shapes are never modified concurrently.
+// Refined triangulations are then transferred to the displayed shapes in the GUI thread and the
+// entity presentations are recomputed(at most every few hundred milliseconds)
+// Transfer waits for the worker threads reading geometry(see Tessellation::triangulationMutex())
+// and erases the cached properties computed from the previous triangulations
+class GuiTessellationRefiner : public QObject {
+    Q_OBJECT
+public:
+    GuiTessellationRefiner(GuiDocument* guiDoc);
+    ~GuiTessellationRefiner();
+
+    // Entities are refined with the chordal deflection of their shapes taken all together, as
+    // done at import by Tessellation::tessellate()
+    void addEntities(
+            Span<const TreeNodeId> spanEntityTreeNodeId, const TessellationParameters& params);
+    void removeEntity(TreeNodeId entityTreeNodeId);
+
+    bool isRunning() const { return m_isBatchRunning; }
+    int pendingUnitCount() const { return int(m_vecPendingJob.size()); }
+
+signals:
+    void entityRefined(TreeNodeId entityTreeNodeId);
+
+private:
+    struct Job {
+        TreeNodeId entityTreeNodeId;
+        TopoDS_Shape unit; // Displayed shape, location-less
+        TopoDS_Shape unitCopy; // Meshed in worker thread
+        Bnd_Box bndBox; // Union of the located instances of 'unit'
+        double linDeflection;
+        double angDeflection;
+        int faceCount;
+        double screenArea;
+    };
+
+    void addEntity(
+            TreeNodeId entityTreeNodeId,
+            const TopoDS_Shape& entityShape,
+            double linDeflection,
+            double angDeflection);
+    void startNextBatch();
+    void onTaskEnded(TaskId taskId);
+    void updatePresentations();
+    double screenArea(const Bnd_Box& bndBox) const;
+    int pendingJobCount(TreeNodeId entityTreeNodeId) const;
+
+    GuiDocument* m_guiDoc = nullptr;
+    TaskManager* m_taskMgr = nullptr;
+    std::vector<Job> m_vecPendingJob;
+    std::vector<Job> m_vecBatchJob;
+    TaskId m_batchTaskId = 0;
+    bool m_isBatchRunning = false;
+    std::unordered_set<TreeNodeId> m_setRemovedEntity;
+    std::unordered_set<TreeNodeId> m_setDirtyEntity;
+    QElapsedTimer m_presentationTimer;
+};
+
+} // namespace Mayo
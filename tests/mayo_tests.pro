@@ -50,3 +50,5 @@ minOpenCascadeVersion(7, 4, 0) {
 }
 # -- VRML support
 LIBS += -lTKVRML
+
+win*:LIBS += -lpsapi
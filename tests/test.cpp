@@ -9,34 +9,66 @@
 
 #include "test.h"
 #include "../src/base/application.h"
+#include "../src/base/bnd_utils.h"
 #include "../src/base/brep_utils.h"
 #include "../src/base/caf_utils.h"
 #include "../src/base/geom_utils.h"
 #include "../src/base/io_occ.h"
+#include "../src/base/io_point_cloud.h"
 #include "../src/base/io_system.h"
 #include "../src/base/libtree.h"
+#include "../src/base/mass_properties.h"
+#include "../src/base/memory_utils.h"
+#include "../src/base/mesh_analysis.h"
+#include "../src/base/mesh_decimation.h"
+#include "../src/base/mesh_normals.h"
 #include "../src/base/mesh_utils.h"
 #include "../src/base/meta_enum.h"
+#include "../src/base/metrics.h"
+#include "../src/base/point_cloud.h"
 #include "../src/base/result.h"
 #include "../src/base/string_utils.h"
 #include "../src/base/task_manager.h"
+#include "../src/base/tessellation.h"
+#include "../src/base/tessellation_cache.h"
+#include "../src/base/thread_budget.h"
+#include "../src/base/tracing.h"
 #include "../src/base/unit.h"
 #include "../src/base/unit_system.h"
 
+#include <Bnd_Box.hxx>
+#include <BRep_Builder.hxx>
 #include <BRep_Tool.hxx>
 #include <BRepAdaptor_Curve.hxx>
 #include <BRepMesh_IncrementalMesh.hxx>
+#include <BRepTools.hxx>
 #include <GCPnts_TangentialDeflection.hxx>
+#include <gp_Trsf.hxx>
+#include <Poly_PolygonOnTriangulation.hxx>
+#include <TDF_Data.hxx>
 #include <TopAbs_ShapeEnum.hxx>
+#include <TopExp_Explorer.hxx>
+#include <TopoDS.hxx>
+#include <TopoDS_Compound.hxx>
 #include <QtCore/QFile>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QSysInfo>
+#include <QtCore/QTemporaryDir>
 #include <QtCore/QtDebug>
 #include <QtTest/QSignalSpy>
 #include <gsl/gsl_util>
+#include <algorithm>
 #include <cmath>
 #include <cstring>
 #include <utility>
 #include <iostream>
+#include <mutex>
+#include <random>
+#include <set>
 #include <sstream>
+#include <thread>
 
 Q_DECLARE_METATYPE(Mayo::UnitSystem::TranslateResult)
 // For Application_test()
@@ -85,6 +117,17 @@ void Test::Application_test()
         QCOMPARE(app->documentCount(), 0);
     }
 
+    {   // Closed document is released asynchronously
+        Metrics::Counter& counterReleased = Metrics::counter("document.releasedCount");
+        const int64_t releasedCountOnEntry = counterReleased.value();
+        DocumentPtr doc = app->newDocument();
+        app->closeDocument(doc);
+        QCOMPARE(app->documentCount(), 0);
+        doc.Nullify();
+        app->waitForReleasedDocuments();
+        QVERIFY(counterReleased.value() > releasedCountOnEntry);
+    }
+
     {   // Add & remove an entity
         DocumentPtr doc = app->newDocument();
         auto _ = gsl::finally([=]{ app->closeDocument(doc); });
@@ -155,6 +198,101 @@ void Test::IO_test_data()
     QTest::newRow("cube.stla") << "inputs/cube.stla" << IO::Format_STL;
     QTest::newRow("cube.stlb") << "inputs/cube.stlb" << IO::Format_STL;
     QTest::newRow("cube.obj") << "inputs/cube.obj" << IO::Format_OBJ;
+    QTest::newRow("cube_points.ply") << "inputs/cube_points.ply" << IO::Format_PLY;
+    QTest::newRow("cube_points.pts") << "inputs/cube_points.pts" << IO::Format_PTS;
+    QTest::newRow("cube_points.xyz") << "inputs/cube_points.xyz" << IO::Format_XYZ;
+}
+
+void Test::BndUtils_test()
+{
+    QVERIFY(BndUtils::geometryBoundingBox(TopoDS_Shape()).IsVoid());
+    QVERIFY(BndUtils::geometryBoundingBox(Handle_Poly_Triangulation()).IsVoid());
+    QVERIFY(BndUtils::orientedBoundingBox(TopoDS_Shape()).IsVoid());
+    QVERIFY(BndUtils::orientedBoundingBox(Handle_Poly_Triangulation()).IsVoid());
+
+    // Box 10x4x2 rotated by 30° around Z axis then translated
+    gp_Trsf trsfRotation;
+    trsfRotation.SetRotation(gp::OZ(), 0.5235987755982988); // 30°
+    gp_Trsf trsfTranslation;
+    trsfTranslation.SetTranslation(gp_Vec(5, -3, 1));
+    const TopLoc_Location loc(trsfTranslation * trsfRotation);
+    const TopoDS_Shape shapeBox = BRepPrimAPI_MakeBox(10, 4, 2).Shape().Moved(loc);
+    BRepMesh_IncrementalMesh mesher(shapeBox, 0.1);
+    QVERIFY(mesher.IsDone());
+
+    auto fnCheckBoxObb = [=](const Bnd_OBB& obb) {
+        QVERIFY(!obb.IsVoid());
+        std::vector<double> vecHalfSize = { obb.XHSize(), obb.YHSize(), obb.ZHSize() };
+        std::sort(vecHalfSize.begin(), vecHalfSize.end());
+        QVERIFY(std::abs(vecHalfSize.at(0) - 1.) < 1e-6);
+        QVERIFY(std::abs(vecHalfSize.at(1) - 2.) < 1e-6);
+        QVERIFY(std::abs(vecHalfSize.at(2) - 5.) < 1e-6);
+        const gp_Pnt expectedCenter = gp_Pnt(5, 2, 1).Transformed(loc.Transformation());
+        QVERIFY(gp_Pnt(obb.Center()).Distance(expectedCenter) < 1e-6);
+    };
+
+    // Nodes of the face triangulations are located
+    fnCheckBoxObb(BndUtils::orientedBoundingBox(shapeBox));
+    const Bnd_Box bndBox = BndUtils::geometryBoundingBox(shapeBox);
+    QVERIFY(!bndBox.IsVoid());
+    const gp_Pnt expectedCornerMin = gp_Pnt(0, 0, 0).Transformed(loc.Transformation());
+    QVERIFY(bndBox.CornerMin().X() <= expectedCornerMin.X() + 1e-6);
+    QVERIFY(bndBox.CornerMin().Z() <= expectedCornerMin.Z() + 1e-6);
+
+    // Triangulation of all the box nodes
+    std::vector<gp_Pnt> vecNode;
+    for (TopExp_Explorer expl(shapeBox, TopAbs_FACE); expl.More(); expl.Next()) {
+        TopLoc_Location locFace;
+        const TopoDS_Face& face = TopoDS::Face(expl.Current());
+        const Handle_Poly_Triangulation& polyTri = BRep_Tool::Triangulation(face, locFace);
+        for (const gp_Pnt& pnt : polyTri->Nodes())
+            vecNode.push_back(pnt.Transformed(locFace.Transformation()));
+    }
+
+    Handle_Poly_Triangulation mesh = new Poly_Triangulation(int(vecNode.size()), 1, false);
+    for (unsigned i = 0; i < vecNode.size(); ++i)
+        mesh->ChangeNode(i + 1) = vecNode.at(i);
+
+    mesh->ChangeTriangle(1).Set(1, 2, 3);
+
+    fnCheckBoxObb(BndUtils::orientedBoundingBox(mesh));
+    const Bnd_Box meshBndBox = BndUtils::geometryBoundingBox(mesh);
+    QVERIFY(meshBndBox.CornerMin().Distance(bndBox.CornerMin()) < 1e-3);
+    QVERIFY(meshBndBox.CornerMax().Distance(bndBox.CornerMax()) < 1e-3);
+
+    // Cached box of a located shape is the location-less one transformed
+    OrientedBoundingBoxCache::clear();
+    Bnd_OBB obbCached;
+    QVERIFY(!OrientedBoundingBoxCache::find(shapeBox, &obbCached));
+    fnCheckBoxObb(OrientedBoundingBoxCache::compute(shapeBox));
+    QVERIFY(OrientedBoundingBoxCache::find(shapeBox, &obbCached));
+    fnCheckBoxObb(obbCached);
+    QVERIFY(!OrientedBoundingBoxCache::find(mesh, &obbCached));
+    fnCheckBoxObb(OrientedBoundingBoxCache::compute(mesh));
+    QVERIFY(OrientedBoundingBoxCache::find(mesh, &obbCached));
+
+    // Erasing a shape erases its sub-shapes too, boxes of meshes are kept
+    const TopoDS_Shape shapeBoxFace = TopExp_Explorer(shapeBox, TopAbs_FACE).Current();
+    OrientedBoundingBoxCache::compute(shapeBoxFace);
+    QVERIFY(OrientedBoundingBoxCache::find(shapeBoxFace, &obbCached));
+    OrientedBoundingBoxCache::erase(shapeBox);
+    QVERIFY(!OrientedBoundingBoxCache::find(shapeBox, &obbCached));
+    QVERIFY(!OrientedBoundingBoxCache::find(shapeBoxFace, &obbCached));
+    QVERIFY(OrientedBoundingBoxCache::find(mesh, &obbCached));
+    OrientedBoundingBoxCache::clear();
+
+    // Strict inclusion
+    Bnd_Box boxOuter;
+    boxOuter.Update(0, 0, 0, 10, 10, 10);
+    Bnd_Box boxInner;
+    boxInner.Update(1, 1, 1, 9, 9, 9);
+    Bnd_Box boxTouching;
+    boxTouching.Update(0, 1, 1, 9, 9, 9);
+    QVERIFY(BndUtils::isStrictlyInside(Bnd_Box(), boxOuter));
+    QVERIFY(BndUtils::isStrictlyInside(boxInner, boxOuter));
+    QVERIFY(!BndUtils::isStrictlyInside(boxTouching, boxOuter));
+    QVERIFY(!BndUtils::isStrictlyInside(boxOuter, boxOuter));
+    QVERIFY(!BndUtils::isStrictlyInside(boxInner, Bnd_Box()));
 }
 
 void Test::BRepUtils_test()
@@ -180,6 +318,63 @@ void Test::CafUtils_test()
     // TODO Add CafUtils::labelTag() test for multi-threaded safety
 }
 
+void Test::MassProperties_test()
+{
+    MassPropertiesCache::clear();
+    const TopoDS_Shape shapeBox = BRepPrimAPI_MakeBox(10, 20, 30);
+    MassProperties props;
+    QVERIFY(!MassPropertiesCache::find(shapeBox, &props));
+    props = MassPropertiesCache::compute(shapeBox);
+    QVERIFY(props.hasVolume);
+    QVERIFY(std::abs(props.area - 2 * (10 * 20 + 10 * 30 + 20 * 30)) < 1e-6);
+    QVERIFY(std::abs(props.volume - 10 * 20 * 30) < 1e-6);
+    QVERIFY(props.centroid.Distance(gp_Pnt(5, 10, 15)) < 1e-6);
+
+    // Located instances share the cached properties of the box
+    gp_Trsf trsf;
+    trsf.SetTranslation(gp_Vec(100, 0, 0));
+    const TopoDS_Shape shapeBoxMoved = shapeBox.Moved(trsf);
+    QVERIFY(MassPropertiesCache::find(shapeBoxMoved, &props));
+    QVERIFY(props.centroid.Distance(gp_Pnt(105, 10, 15)) < 1e-6);
+
+    TopoDS_Compound compound;
+    BRep_Builder builder;
+    builder.MakeCompound(compound);
+    builder.Add(compound, shapeBox);
+    builder.Add(compound, shapeBoxMoved);
+    props = MassPropertiesCache::compute(compound);
+    QVERIFY(std::abs(props.volume - 2 * 10 * 20 * 30) < 1e-6);
+    QVERIFY(props.centroid.Distance(gp_Pnt(55, 10, 15)) < 1e-6);
+    QVERIFY(MassPropertiesCache::find(compound, &props));
+
+    // Erasing a shape erases its sub-shapes too
+    MassPropertiesCache::erase(compound);
+    QVERIFY(!MassPropertiesCache::find(compound, &props));
+    QVERIFY(!MassPropertiesCache::find(shapeBox, &props));
+
+    // Free face has no volume
+    const TopoDS_Shape shapeFace = TopExp_Explorer(shapeBox, TopAbs_FACE).Current();
+    MassPropertiesCache::clear();
+    props = MassPropertiesCache::compute(shapeFace);
+    QVERIFY(!props.hasVolume);
+    QVERIFY(props.area > 0.);
+}
+
+void Test::MemoryUtils_test()
+{
+#if defined(_WIN32) || defined(__APPLE__) || defined(__linux__)
+    const uint64_t residentMemory = MemoryUtils::processResidentMemory();
+    QVERIFY(residentMemory > 0);
+
+    {
+        std::vector<char> vecData(64 * 1024 * 1024, 1);
+        QVERIFY(MemoryUtils::processResidentMemory() > residentMemory);
+    }
+#endif
+
+    MemoryUtils::releaseFreedMemory();
+}
+
 void Test::MeshUtils_orientation_test()
 {
     struct BasicPolyline2d : public Mayo::MeshUtils::AdaptorPolyline2d {
@@ -257,6 +452,136 @@ void Test::MeshUtils_orientation_test_data()
     }
 }
 
+void Test::MeshUtils_triangulationProperties_test()
+{
+    // Cube [1,3]x[2,4]x[5,7] with outward oriented triangles
+    const double a = 2.;
+    const gp_XYZ origin(1, 2, 5);
+    Handle_Poly_Triangulation polyTriCube = new Poly_Triangulation(8, 12, false);
+    for (int i = 0; i < 8; ++i) {
+        const gp_XYZ offset(a * (i & 1), a * ((i >> 1) & 1), a * ((i >> 2) & 1));
+        polyTriCube->ChangeNode(i + 1) = gp_Pnt(origin + offset);
+    }
+
+    const int cubeTriangles[12][3] = {
+        {0, 2, 1}, {1, 2, 3}, {4, 5, 6}, {5, 7, 6}, {0, 1, 4}, {1, 5, 4},
+        {2, 6, 3}, {3, 6, 7}, {0, 4, 2}, {2, 4, 6}, {1, 3, 5}, {3, 7, 5}
+    };
+    for (int i = 0; i < 12; ++i) {
+        const int* tri = cubeTriangles[i];
+        polyTriCube->ChangeTriangle(i + 1).Set(tri[0] + 1, tri[1] + 1, tri[2] + 1);
+    }
+
+    const MeshUtils::TriangulationProperties props =
+            MeshUtils::triangulationProperties(polyTriCube);
+    QCOMPARE(props.area, 6 * a * a);
+    QCOMPARE(props.signedVolume, a * a * a);
+    QVERIFY(props.centroid.Distance(gp_Pnt(2, 3, 6)) < 1e-9);
+    const double inertiaExpected = a * a * a * a * a / 6.;
+    for (int i = 1; i <= 3; ++i) {
+        for (int j = 1; j <= 3; ++j) {
+            const double expected = i == j ? inertiaExpected : 0.;
+            QVERIFY(std::abs(props.inertia.Value(i, j) - expected) < 1e-9);
+        }
+    }
+
+    QVERIFY(props.bndBox.CornerMin().Distance(gp_Pnt(1, 2, 5)) < 1e-9);
+    QVERIFY(props.bndBox.CornerMax().Distance(gp_Pnt(3, 4, 7)) < 1e-9);
+
+    // Inward oriented triangles give a negative volume, but the same inertia
+    for (int i = 1; i <= polyTriCube->NbTriangles(); ++i) {
+        int n1, n2, n3;
+        polyTriCube->Triangle(i).Get(n1, n2, n3);
+        polyTriCube->ChangeTriangle(i).Set(n1, n3, n2);
+    }
+
+    const MeshUtils::TriangulationProperties propsInward =
+            MeshUtils::triangulationProperties(polyTriCube);
+    QCOMPARE(propsInward.signedVolume, -a * a * a);
+    QVERIFY(std::abs(propsInward.inertia.Value(1, 1) - inertiaExpected) < 1e-9);
+
+    // Open mesh(single triangle) : surface centroid
+    Handle_Poly_Triangulation polyTriOpen = new Poly_Triangulation(3, 1, false);
+    polyTriOpen->ChangeNode(1) = gp_Pnt(0, 0, 0);
+    polyTriOpen->ChangeNode(2) = gp_Pnt(3, 0, 0);
+    polyTriOpen->ChangeNode(3) = gp_Pnt(0, 3, 0);
+    polyTriOpen->ChangeTriangle(1).Set(1, 2, 3);
+    const MeshUtils::TriangulationProperties propsOpen =
+            MeshUtils::triangulationProperties(polyTriOpen);
+    QCOMPARE(propsOpen.area, 4.5);
+    QCOMPARE(propsOpen.signedVolume, 0.);
+    QVERIFY(propsOpen.centroid.Distance(gp_Pnt(1, 1, 0)) < 1e-9);
+}
+
+void Test::MeshUtils_triangulationProperties_bench()
+{
+    // 10M triangles mesh takes a few hundred MB, so the benchmark is opt-in
+    if (qEnvironmentVariableIsEmpty("MAYO_BENCHMARK"))
+        QSKIP("Set MAYO_BENCHMARK environment variable to run this benchmark");
+
+    // Wavy grid of 2x2237x2237 triangles
+    const int cellCount = 2237;
+    const int nodeRowCount = cellCount + 1;
+    Handle_Poly_Triangulation mesh =
+            new Poly_Triangulation(nodeRowCount * nodeRowCount, 2 * cellCount * cellCount, false);
+    for (int i = 0; i < nodeRowCount; ++i) {
+        for (int j = 0; j < nodeRowCount; ++j) {
+            const double z = std::sin(i * 0.01) * std::cos(j * 0.01);
+            mesh->ChangeNode(i * nodeRowCount + j + 1) = gp_Pnt(i, j, z);
+        }
+    }
+
+    int triIndex = 0;
+    for (int i = 0; i < cellCount; ++i) {
+        for (int j = 0; j < cellCount; ++j) {
+            const int n00 = i * nodeRowCount + j + 1;
+            const int n10 = n00 + nodeRowCount;
+            mesh->ChangeTriangle(++triIndex).Set(n00, n10, n10 + 1);
+            mesh->ChangeTriangle(++triIndex).Set(n00, n10 + 1, n00 + 1);
+        }
+    }
+
+    qInfo() << "Triangle count:" << mesh->NbTriangles();
+    MeshUtils::TriangulationProperties props;
+    QBENCHMARK {
+        props = MeshUtils::triangulationProperties(mesh);
+    }
+
+    QVERIFY(props.area > cellCount * cellCount);
+}
+
+void Test::MeshUtils_weldedTriangulation_test()
+{
+    // Two triangles of a square, each with its own nodes, plus one collapsed by welding
+    Handle_Poly_Triangulation mesh = new Poly_Triangulation(7, 3, false);
+    mesh->ChangeNode(1) = gp_Pnt(0, 0, 0);
+    mesh->ChangeNode(2) = gp_Pnt(1, 0, 0);
+    mesh->ChangeNode(3) = gp_Pnt(1, 1, 0);
+    mesh->ChangeNode(4) = gp_Pnt(0, 0, 0);
+    mesh->ChangeNode(5) = gp_Pnt(1, 1, 1e-9);
+    mesh->ChangeNode(6) = gp_Pnt(0, 1, 0);
+    mesh->ChangeNode(7) = gp_Pnt(1, 0, 1e-9);
+    mesh->ChangeTriangle(1).Set(1, 2, 3);
+    mesh->ChangeTriangle(2).Set(4, 5, 6);
+    mesh->ChangeTriangle(3).Set(2, 7, 6);
+
+    const std::vector<int> vecWeld = MeshUtils::weldNodeMap(mesh->Nodes(), 1e-7);
+    QCOMPARE(vecWeld, std::vector<int>({ 0, 1, 2, 0, 2, 5, 1 }));
+    QCOMPARE(MeshUtils::weldNodeMap(mesh->Nodes(), 0.).at(3), 3);
+
+    const Handle_Poly_Triangulation meshWelded = MeshUtils::weldedTriangulation(mesh, 1e-7);
+    QVERIFY(!meshWelded.IsNull());
+    QCOMPARE(meshWelded->NbNodes(), 4);
+    QCOMPARE(meshWelded->NbTriangles(), 2);
+    int n[3];
+    meshWelded->Triangle(2).Get(n[0], n[1], n[2]);
+    QCOMPARE(n[0], 1);
+    QCOMPARE(n[1], 3);
+    QCOMPARE(n[2], 4);
+
+    QVERIFY(MeshUtils::weldedTriangulation(Handle_Poly_Triangulation(), 1e-7).IsNull());
+}
+
 void Test::MetaEnum_test()
 {
     QCOMPARE(MetaEnum::name(TopAbs_VERTEX), "TopAbs_VERTEX");
@@ -271,6 +596,300 @@ void Test::MetaEnum_test()
     QCOMPARE(MetaEnum::nameWithoutPrefix(TopAbs_VERTEX, ""), "TopAbs_VERTEX");
 }
 
+void Test::Metrics_test()
+{
+    Metrics::Counter& counter = Metrics::counter("test.counter");
+    QCOMPARE(&counter, &Metrics::counter("test.counter"));
+    counter.reset();
+    counter.add();
+    counter.add(41);
+    QCOMPARE(counter.value(), int64_t(42));
+
+    Metrics::Gauge& gauge = Metrics::gauge("test.gauge");
+    gauge.set(5.);
+    gauge.add(-1.5);
+    QCOMPARE(gauge.value(), 3.5);
+
+    Metrics::Histogram& histo = Metrics::histogram("test.histogram");
+    histo.reset();
+    QCOMPARE(histo.count(), int64_t(0));
+    QCOMPARE(histo.min(), 0.);
+    for (int i = 1; i <= 100; ++i)
+        histo.record(i);
+
+    QCOMPARE(histo.count(), int64_t(100));
+    QCOMPARE(histo.min(), 1.);
+    QCOMPARE(histo.max(), 100.);
+    QCOMPARE(histo.mean(), 50.5);
+    QVERIFY(histo.percentile(0.5) >= 50. && histo.percentile(0.5) <= 64.);
+    QCOMPARE(histo.percentile(1.), 100.);
+
+    const std::vector<Metrics::Sample> vecSample = Metrics::snapshot();
+    auto itSample = std::find_if(vecSample.cbegin(), vecSample.cend(), [](const Metrics::Sample& sample) {
+        return sample.name == "test.histogram";
+    });
+    QVERIFY(itSample != vecSample.cend());
+    QCOMPARE(itSample->kind, Metrics::Kind::Histogram);
+    QCOMPARE(itSample->count, int64_t(100));
+
+    const QJsonDocument jsonDoc = QJsonDocument::fromJson(Metrics::toJson(vecSample));
+    QVERIFY(jsonDoc.isObject());
+    QCOMPARE(jsonDoc.object().value("metrics").toArray().size(), int(vecSample.size()));
+}
+
+void Test::MeshDecimation_test()
+{
+    // Planar square made of a regular grid of 2x20x20 triangles
+    const int cellCount = 20;
+    const int nodeRowCount = cellCount + 1;
+    Handle_Poly_Triangulation mesh =
+            new Poly_Triangulation(nodeRowCount * nodeRowCount, 2 * cellCount * cellCount, false);
+    for (int i = 0; i < nodeRowCount; ++i) {
+        for (int j = 0; j < nodeRowCount; ++j)
+            mesh->ChangeNodes().ChangeValue(i * nodeRowCount + j + 1) = gp_Pnt(i, j, 0);
+    }
+
+    int triIndex = 0;
+    for (int i = 0; i < cellCount; ++i) {
+        for (int j = 0; j < cellCount; ++j) {
+            const int n00 = i * nodeRowCount + j + 1;
+            const int n10 = n00 + nodeRowCount;
+            mesh->ChangeTriangles().ChangeValue(++triIndex) = Poly_Triangle(n00, n10, n10 + 1);
+            mesh->ChangeTriangles().ChangeValue(++triIndex) = Poly_Triangle(n00, n10 + 1, n00 + 1);
+        }
+    }
+
+    const int triangleCount = mesh->NbTriangles();
+    const double area = MeshUtils::triangulationArea(mesh);
+    QCOMPARE(area, double(cellCount * cellCount));
+
+    MeshDecimationParameters params;
+    params.targetMode = MeshDecimationParameters::TargetMode::Ratio;
+    params.targetRatio = 0.1;
+    QCOMPARE(MeshDecimation::targetTriangleCount(params, triangleCount), 80);
+    params.targetMode = MeshDecimationParameters::TargetMode::TriangleCount;
+    params.targetTriangleCount = 100000;
+    QCOMPARE(MeshDecimation::targetTriangleCount(params, triangleCount), triangleCount);
+    params.targetMode = MeshDecimationParameters::TargetMode::MaxError;
+    QCOMPARE(MeshDecimation::targetTriangleCount(params, triangleCount), 0);
+
+    QVERIFY(MeshDecimation::decimate(Handle_Poly_Triangulation(), params).IsNull());
+
+    // Boundary and planarity are preserved whatever the target
+    auto fnCheckDecimated = [=](const Handle_Poly_Triangulation& meshDecimated) {
+        QVERIFY(!meshDecimated.IsNull());
+        QVERIFY(meshDecimated->NbTriangles() < triangleCount);
+        QVERIFY(meshDecimated->NbNodes() < mesh->NbNodes());
+        QVERIFY(std::abs(MeshUtils::triangulationArea(meshDecimated) - area) < 1e-6 * area);
+        for (const gp_Pnt& pnt : meshDecimated->Nodes())
+            QVERIFY(std::abs(pnt.Z()) < 1e-9);
+    };
+
+    params.targetMode = MeshDecimationParameters::TargetMode::Ratio;
+    const Handle_Poly_Triangulation meshRatio = MeshDecimation::decimate(mesh, params);
+    fnCheckDecimated(meshRatio);
+    QVERIFY(meshRatio->NbTriangles() <= 80);
+
+    params.targetMode = MeshDecimationParameters::TargetMode::MaxError;
+    params.maxError = 1e-6;
+    fnCheckDecimated(MeshDecimation::decimate(mesh, params));
+}
+
+void Test::MeshAnalysis_test()
+{
+    // Cube with outward oriented triangles, extra room for defective triangles
+    const int cubeTriangles[12][3] = {
+        {0, 2, 1}, {1, 2, 3}, {4, 5, 6}, {5, 7, 6}, {0, 1, 4}, {1, 5, 4},
+        {2, 6, 3}, {3, 6, 7}, {0, 4, 2}, {2, 4, 6}, {1, 3, 5}, {3, 7, 5}
+    };
+    auto fnCreateCube = [&](int extraNodeCount, int extraTriangleCount) {
+        Handle_Poly_Triangulation mesh =
+                new Poly_Triangulation(8 + extraNodeCount, 12 + extraTriangleCount, false);
+        for (int i = 0; i < 8; ++i)
+            mesh->ChangeNode(i + 1) = gp_Pnt(i & 1, (i >> 1) & 1, (i >> 2) & 1);
+
+        for (int i = 0; i < 12; ++i) {
+            const int* tri = cubeTriangles[i];
+            mesh->ChangeTriangle(i + 1).Set(tri[0] + 1, tri[1] + 1, tri[2] + 1);
+        }
+
+        return mesh;
+    };
+
+    {   // Closed and consistent
+        const MeshAnalysisResult res = MeshAnalysis::analyze(fnCreateCube(0, 0));
+        QCOMPARE(res.triangleCount, 12);
+        QCOMPARE(res.componentCount, 1);
+        QVERIFY(res.isClosed());
+        QVERIFY(res.isManifold());
+        QVERIFY(res.isOrientationConsistent());
+        QVERIFY(res.vecDegenerateTriangle.empty());
+        QVERIFY(res.vecSliverTriangle.empty());
+        QVERIFY(res.vecDuplicateTriangle.empty());
+    }
+
+    {   // Flipped triangle : its three edges are misoriented
+        const Handle_Poly_Triangulation mesh = fnCreateCube(0, 0);
+        mesh->ChangeTriangle(1).Set(1, 2, 3);
+        const MeshAnalysisResult res = MeshAnalysis::analyze(mesh);
+        QVERIFY(res.isClosed());
+        QVERIFY(res.isManifold());
+        QCOMPARE(int(res.vecMisorientedEdge.size()), 3);
+    }
+
+    {   // Duplicate triangle : its three edges are non-manifold
+        const Handle_Poly_Triangulation mesh = fnCreateCube(0, 1);
+        mesh->ChangeTriangle(13).Set(3, 2, 1);
+        const MeshAnalysisResult res = MeshAnalysis::analyze(mesh);
+        QCOMPARE(int(res.vecDuplicateTriangle.size()), 1);
+        QCOMPARE(res.vecDuplicateTriangle.front(), 13);
+        QCOMPARE(int(res.vecNonManifoldEdge.size()), 3);
+        QCOMPARE(res.componentCount, 1);
+    }
+
+    {   // Separate sliver triangle : second component with three boundary edges
+        const Handle_Poly_Triangulation mesh = fnCreateCube(3, 1);
+        mesh->ChangeNode(9) = gp_Pnt(5, 0, 0);
+        mesh->ChangeNode(10) = gp_Pnt(15, 0, 0);
+        mesh->ChangeNode(11) = gp_Pnt(10, 0.1, 0);
+        mesh->ChangeTriangle(13).Set(9, 10, 11);
+        const MeshAnalysisResult res = MeshAnalysis::analyze(mesh);
+        QCOMPARE(res.componentCount, 2);
+        QCOMPARE(int(res.vecBoundaryEdge.size()), 3);
+        QCOMPARE(int(res.vecSliverTriangle.size()), 1);
+        QCOMPARE(res.vecSliverTriangle.front(), 13);
+        QVERIFY(res.vecDegenerateTriangle.empty());
+    }
+
+    {   // Degenerate triangles : repeated node and colinear nodes
+        const Handle_Poly_Triangulation mesh = fnCreateCube(1, 2);
+        mesh->ChangeNode(9) = gp_Pnt(2, 0, 0);
+        mesh->ChangeTriangle(13).Set(1, 1, 2);
+        mesh->ChangeTriangle(14).Set(1, 2, 9);
+        const MeshAnalysisResult res = MeshAnalysis::analyze(mesh);
+        QCOMPARE(int(res.vecDegenerateTriangle.size()), 2);
+        QCOMPARE(res.vecDegenerateTriangle.at(0), 13);
+        QCOMPARE(res.vecDegenerateTriangle.at(1), 14);
+        QVERIFY(res.vecSliverTriangle.empty());
+    }
+
+    {   // Nodes split along creases are welded : same topology as the original cube
+        const Handle_Poly_Triangulation mesh = MeshNormals::computeSmooth(fnCreateCube(0, 0));
+        QCOMPARE(mesh->NbNodes(), 24);
+        const MeshAnalysisResult res = MeshAnalysis::analyze(mesh);
+        QCOMPARE(res.componentCount, 1);
+        QVERIFY(res.isClosed());
+        QVERIFY(res.isManifold());
+        QVERIFY(res.isOrientationConsistent());
+        QVERIFY(res.vecDegenerateTriangle.empty());
+
+        MeshAnalysisParameters params;
+        params.weldTolerance = 0.;
+        const MeshAnalysisResult resNoWeld = MeshAnalysis::analyze(mesh, params);
+        QCOMPARE(resNoWeld.componentCount, 6);
+        QVERIFY(!resNoWeld.isClosed());
+    }
+
+    QCOMPARE(MeshAnalysis::analyze(Handle_Poly_Triangulation()).triangleCount, 0);
+}
+
+void Test::MeshNormals_test()
+{
+    // Cube with outward oriented triangles, 8 nodes shared by 3 faces
+    Handle_Poly_Triangulation polyTriCube = new Poly_Triangulation(8, 12, false);
+    for (int i = 0; i < 8; ++i)
+        polyTriCube->ChangeNode(i + 1) = gp_Pnt(i & 1, (i >> 1) & 1, (i >> 2) & 1);
+
+    const int cubeTriangles[12][3] = {
+        {0, 2, 1}, {1, 2, 3}, {4, 5, 6}, {5, 7, 6}, {0, 1, 4}, {1, 5, 4},
+        {2, 6, 3}, {3, 6, 7}, {0, 4, 2}, {2, 4, 6}, {1, 3, 5}, {3, 7, 5}
+    };
+    for (int i = 0; i < 12; ++i) {
+        const int* tri = cubeTriangles[i];
+        polyTriCube->ChangeTriangle(i + 1).Set(tri[0] + 1, tri[1] + 1, tri[2] + 1);
+    }
+
+    auto fnNormal = [](const Handle_Poly_Triangulation& mesh, int node) {
+        const TShort_Array1OfShortReal& normals = mesh->Normals();
+        const int i = normals.Lower() + 3 * (node - 1);
+        return gp_XYZ(normals.Value(i), normals.Value(i + 1), normals.Value(i + 2));
+    };
+
+    // Edges of the cube are creases : each node is split in 3, with normals of the faces
+    const Handle_Poly_Triangulation meshCreased = MeshNormals::computeSmooth(polyTriCube);
+    QVERIFY(!meshCreased.IsNull());
+    QVERIFY(meshCreased->HasNormals());
+    QCOMPARE(meshCreased->NbNodes(), 24);
+    QCOMPARE(meshCreased->NbTriangles(), 12);
+    for (int t = 1; t <= meshCreased->NbTriangles(); ++t) {
+        int n[3];
+        meshCreased->Triangle(t).Get(n[0], n[1], n[2]);
+        const gp_XYZ& p1 = meshCreased->Node(n[0]).XYZ();
+        const gp_XYZ& p2 = meshCreased->Node(n[1]).XYZ();
+        const gp_XYZ& p3 = meshCreased->Node(n[2]).XYZ();
+        const gp_XYZ triNormal = (p2 - p1).Crossed(p3 - p1).Normalized();
+        for (int node : n)
+            QVERIFY((fnNormal(meshCreased, node) - triNormal).Modulus() < 1e-6);
+    }
+
+    // Crease angle above 90° : nodes are kept, normals point outwards
+    const Handle_Poly_Triangulation meshSmooth = MeshNormals::computeSmooth(polyTriCube, 2.);
+    QCOMPARE(meshSmooth->NbNodes(), 8);
+    const gp_XYZ cubeCenter(0.5, 0.5, 0.5);
+    for (int i = 1; i <= meshSmooth->NbNodes(); ++i) {
+        const gp_XYZ normal = fnNormal(meshSmooth, i);
+        QVERIFY(std::abs(normal.Modulus() - 1.) < 1e-6);
+        QVERIFY(normal.Dot(meshSmooth->Node(i).XYZ() - cubeCenter) > 0.);
+    }
+
+    QVERIFY(MeshNormals::computeSmooth(Handle_Poly_Triangulation()).IsNull());
+
+    // Crease angle stored at a document label
+    Handle_TDF_Data data = new TDF_Data;
+    const TDF_Label label = data->Root();
+    QVERIFY(MeshNormals::labelCreaseAngle(label) < 0.);
+    MeshNormals::setLabelCreaseAngle(label, 0.5);
+    QCOMPARE(MeshNormals::labelCreaseAngle(label), 0.5);
+}
+
+void Test::MeshNormals_bench()
+{
+    // Multi-million triangles mesh takes a few hundred MB, so the benchmark is opt-in
+    if (qEnvironmentVariableIsEmpty("MAYO_BENCHMARK"))
+        QSKIP("Set MAYO_BENCHMARK environment variable to run this benchmark");
+
+    // Wavy grid of 2x1415x1415 triangles, ridges every 100 cells
+    const int cellCount = 1415;
+    const int nodeRowCount = cellCount + 1;
+    Handle_Poly_Triangulation mesh =
+            new Poly_Triangulation(nodeRowCount * nodeRowCount, 2 * cellCount * cellCount, false);
+    for (int i = 0; i < nodeRowCount; ++i) {
+        for (int j = 0; j < nodeRowCount; ++j) {
+            const double z = std::sin(i * 0.01) * std::cos(j * 0.01) + std::abs((i % 100) - 50);
+            mesh->ChangeNode(i * nodeRowCount + j + 1) = gp_Pnt(i, j, z);
+        }
+    }
+
+    int triIndex = 0;
+    for (int i = 0; i < cellCount; ++i) {
+        for (int j = 0; j < cellCount; ++j) {
+            const int n00 = i * nodeRowCount + j + 1;
+            const int n10 = n00 + nodeRowCount;
+            mesh->ChangeTriangle(++triIndex).Set(n00, n10, n10 + 1);
+            mesh->ChangeTriangle(++triIndex).Set(n00, n10 + 1, n00 + 1);
+        }
+    }
+
+    qInfo() << "Triangle count:" << mesh->NbTriangles();
+    Handle_Poly_Triangulation meshSmooth;
+    QBENCHMARK {
+        meshSmooth = MeshNormals::computeSmooth(mesh, MeshNormals::DefaultCreaseAngle);
+    }
+
+    QVERIFY(meshSmooth->HasNormals());
+    QVERIFY(meshSmooth->NbNodes() > mesh->NbNodes());
+}
+
 void Test::MeshUtils_test()
 {
     // Create box
@@ -343,6 +962,126 @@ void Test::MeshUtils_test_data()
     QTest::newRow("case4") << 40. << 50. << 70.;
 }
 
+void Test::PointCloud_test()
+{
+    // Corners of a 10mm cube, colors are the normalized coordinates
+    for (const IO::Format& format : { IO::Format_PLY, IO::Format_PTS, IO::Format_XYZ }) {
+        IO::PointCloudReader reader(format);
+        TaskProgress progress;
+        QVERIFY(reader.readFile("inputs/cube_points." + format.fileSuffixes.front(), &progress));
+    }
+
+    {
+        QFile file("inputs/cube_points.pts");
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        const QByteArray contents = file.readAll();
+        const Handle_PointCloud cloud = IO::PointCloudReader::parse(
+                    IO::Format_PTS, contents.constData(), contents.size());
+        QVERIFY(!cloud.IsNull());
+        QCOMPARE(cloud->pointCount(), 8);
+        QVERIFY(cloud->hasColors());
+        for (int i = 0; i < cloud->pointCount(); ++i) {
+            const float* coords = cloud->coords(i);
+            const uint8_t* color = cloud->color(i);
+            for (int k = 0; k < 3; ++k)
+                QCOMPARE(int(color[k]), coords[k] > 5 ? 255 : 0);
+        }
+    }
+
+    // Binary PLY, big endian with double coordinates and a preceding element
+    {
+        QByteArray contents =
+                "ply\n"
+                "format binary_big_endian 1.0\n"
+                "element camera 1\n"
+                "property float focal\n"
+                "element vertex 2\n"
+                "property double x\n"
+                "property double y\n"
+                "property double z\n"
+                "end_header\n";
+        auto fnAppendBigEndian = [&](auto value) {
+            char bytes[sizeof(value)];
+            std::memcpy(bytes, &value, sizeof(value));
+            if (QSysInfo::ByteOrder == QSysInfo::LittleEndian)
+                std::reverse(bytes, bytes + sizeof(value));
+
+            contents.append(bytes, int(sizeof(value)));
+        };
+        fnAppendBigEndian(35.f);
+        for (double value : { 1., -2.5, 3e3, 4., 5., 6. })
+            fnAppendBigEndian(value);
+
+        const Handle_PointCloud cloud = IO::PointCloudReader::parse(
+                    IO::Format_PLY, contents.constData(), contents.size());
+        QVERIFY(!cloud.IsNull());
+        QCOMPARE(cloud->pointCount(), 2);
+        QVERIFY(!cloud->hasColors());
+        QVERIFY(cloud->point(0).Distance(gp_Pnt(1, -2.5, 3e3)) < 1e-6);
+        QVERIFY(cloud->point(1).Distance(gp_Pnt(4, 5, 6)) < 1e-6);
+
+        // Truncated data
+        contents.chop(1);
+        QVERIFY(IO::PointCloudReader::parse(
+                    IO::Format_PLY, contents.constData(), contents.size()).IsNull());
+    }
+
+    // Octree of random points
+    Handle_PointCloud cloud = new PointCloud;
+    const int pointCount = 100000;
+    std::mt19937 randomGenerator(0);
+    std::uniform_real_distribution<float> randomCoord(-50.f, 50.f);
+    for (int i = 0; i < 3 * pointCount; ++i)
+        cloud->changeCoords().push_back(randomCoord(randomGenerator));
+
+    const int maxNodePointCount = 500;
+    QVERIFY(cloud->buildOctree(maxNodePointCount));
+    QCOMPARE(cloud->pointCount(), pointCount);
+    QVERIFY(!cloud->boundingBox().IsVoid());
+    const std::vector<PointCloud::OctreeNode>& octree = cloud->octree();
+    QVERIFY(!octree.empty());
+    QCOMPARE(octree.front().pointBegin, 0);
+    QCOMPARE(octree.front().pointEnd, pointCount);
+    int leafPointCount = 0;
+    for (const PointCloud::OctreeNode& node : octree) {
+        if (node.isLeaf()) {
+            QVERIFY(node.pointCount() <= maxNodePointCount);
+            leafPointCount += node.pointCount();
+        }
+        else {
+            // Children cover the point range of their parent
+            int pointBegin = node.pointBegin;
+            for (int i = node.firstChild; i < node.firstChild + node.childCount; ++i) {
+                QCOMPARE(octree.at(i).pointBegin, pointBegin);
+                pointBegin = octree.at(i).pointEnd;
+            }
+
+            QCOMPARE(pointBegin, node.pointEnd);
+        }
+
+        for (int i = node.pointBegin; i < node.pointEnd; ++i) {
+            const float* coords = cloud->coords(i);
+            for (int k = 0; k < 3; ++k)
+                QVERIFY(std::abs(coords[k] - node.center[k]) <= node.halfSize * 1.0001f);
+        }
+    }
+
+    QCOMPARE(leafPointCount, pointCount);
+
+    // Level of detail is within budget, and complete when budget and screen size allow it
+    auto fnScreenSize = [](const PointCloud::OctreeNode& node) { return 100. * node.halfSize; };
+    const std::vector<PointCloud::LodNode> vecLodNode =
+            cloud->selectLevelOfDetail(10000, fnScreenSize);
+    QVERIFY(!vecLodNode.empty());
+    QVERIFY(PointCloud::lodPointCount(vecLodNode, *cloud) <= 10000);
+    auto fnHugeScreenSize = [](const PointCloud::OctreeNode& node) { return 1e6 * node.halfSize; };
+    const std::vector<PointCloud::LodNode> vecLodNodeFull =
+            cloud->selectLevelOfDetail(10 * pointCount, fnHugeScreenSize);
+    QCOMPARE(PointCloud::lodPointCount(vecLodNodeFull, *cloud), pointCount);
+    auto fnInvisible = [](const PointCloud::OctreeNode&) { return -1.; };
+    QVERIFY(cloud->selectLevelOfDetail(10000, fnInvisible).empty());
+}
+
 void Test::Quantity_test()
 {
     const QuantityArea area = (10 * Quantity_Millimeter) * (5 * Quantity_Centimeter);
@@ -477,6 +1216,237 @@ void Test::StringUtils_text_test_data()
             << QStringLiteral("(0.55mm 4.9mm 15.14mm)");
 }
 
+void Test::Tessellation_test()
+{
+    TessellationParameters params;
+    params.enabled = true;
+    {
+        Bnd_Box bndBox;
+        bndBox.Update(0, 0, 0, 100, 100, 100);
+        params.deflectionMode = TessellationParameters::DeflectionMode::Absolute;
+        QCOMPARE(Tessellation::chordalDeflection(params, bndBox), params.chordalDeflection);
+        params.deflectionMode = TessellationParameters::DeflectionMode::Relative;
+        const double expected = std::sqrt(3 * 100. * 100.) * params.relativeChordalDeflection;
+        QVERIFY(std::abs(Tessellation::chordalDeflection(params, bndBox) - expected) < 1e-9);
+    }
+
+    {
+        const TessellationParameters coarseParams = Tessellation::coarseParameters(params);
+        QVERIFY(coarseParams.chordalDeflection > params.chordalDeflection);
+        QVERIFY(coarseParams.relativeChordalDeflection > params.relativeChordalDeflection);
+        QVERIFY(coarseParams.angularDeflection > params.angularDeflection);
+        QVERIFY(!coarseParams.progressive);
+    }
+
+    // Located instances of the same shape are meshed once
+    const TopoDS_Shape shapeBox = BRepPrimAPI_MakeBox(25, 25, 25);
+    gp_Trsf trsf;
+    trsf.SetTranslation(gp_Vec(50, 0, 0));
+    const TopoDS_Shape shapeBoxInstance = shapeBox.Moved(TopLoc_Location(trsf));
+    const std::vector<TopoDS_Shape> vecShape = { shapeBox, shapeBoxInstance };
+    QCOMPARE(int(Tessellation::meshingUnits(vecShape).size()), 1);
+
+    // Faces of a free shell share edges, so they belong to the same unit
+    {
+        const std::vector<TopoDS_Shape> vecShell = { BRepPrimAPI_MakeBox(5, 5, 5).Shell() };
+        QCOMPARE(int(Tessellation::meshingUnits(vecShell).size()), 1);
+    }
+
+    // Free faces sharing edges are grouped into a single unit, other faces stay apart
+    {
+        BRep_Builder builder;
+        TopoDS_Compound compound;
+        builder.MakeCompound(compound);
+        const TopoDS_Shape shapeBoxFaces = BRepPrimAPI_MakeBox(5, 5, 5).Shape();
+        for (TopExp_Explorer expl(shapeBoxFaces, TopAbs_FACE); expl.More(); expl.Next())
+            builder.Add(compound, expl.Current());
+
+        const TopoDS_Shape shapeOtherBox = BRepPrimAPI_MakeBox(5, 5, 5).Shape();
+        builder.Add(compound, TopExp_Explorer(shapeOtherBox, TopAbs_FACE).Current());
+        const std::vector<TopoDS_Shape> vecCompound = { compound };
+        const std::vector<TopoDS_Shape> vecUnit = Tessellation::meshingUnits(vecCompound);
+        QCOMPARE(int(vecUnit.size()), 2);
+        QCOMPARE(vecUnit.front().ShapeType(), TopAbs_COMPOUND);
+        QCOMPARE(vecUnit.back().ShapeType(), TopAbs_FACE);
+    }
+
+    params.deflectionMode = TessellationParameters::DeflectionMode::Absolute;
+    params.chordalDeflection = 0.1;
+    const int64_t triangleCount = Tessellation::tessellate(vecShape, params);
+    QCOMPARE(triangleCount, int64_t(12));
+    QVERIFY(BRepTools::Triangulation(shapeBoxInstance, params.chordalDeflection));
+
+    // Already meshed shapes are left untouched
+    QCOMPARE(Tessellation::tessellate(vecShape, params), int64_t(0));
+}
+
+void Test::TessellationCache_test()
+{
+    QTemporaryDir cacheDir;
+    QVERIFY(cacheDir.isValid());
+    QVERIFY(!TessellationCache::isEnabled());
+    TessellationCache::setDirectory(cacheDir.path());
+    auto _ = gsl::finally([]{ TessellationCache::setDirectory(QString()); });
+    QVERIFY(TessellationCache::isEnabled());
+
+    TessellationParameters params;
+    params.enabled = true;
+    params.deflectionMode = TessellationParameters::DeflectionMode::Absolute;
+    params.chordalDeflection = 0.1;
+    const TessellationCache::Statistics statsBegin = TessellationCache::statistics();
+
+    // Miss: shape is meshed then stored
+    const std::vector<TopoDS_Shape> vecShape = { BRepPrimAPI_MakeBox(10, 20, 30).Shape() };
+    const TopoDS_Shape& shapeBox = vecShape.front();
+    QCOMPARE(Tessellation::tessellate(vecShape, params), int64_t(12));
+    const TessellationCache::Statistics statsStore = TessellationCache::statistics();
+    QCOMPARE(statsStore.missCount - statsBegin.missCount, int64_t(1));
+    QCOMPARE(statsStore.storeCount - statsBegin.storeCount, int64_t(1));
+    QCOMPARE(statsStore.entryCount, int64_t(1));
+    QVERIFY(statsStore.size > 0);
+
+    // Hit: same geometry in a different shape, triangulations are attached without meshing
+    const std::vector<TopoDS_Shape> vecShapeCopy = { BRepPrimAPI_MakeBox(10, 20, 30).Shape() };
+    const TopoDS_Shape& shapeBoxCopy = vecShapeCopy.front();
+    QCOMPARE(Tessellation::tessellate(vecShapeCopy, params), int64_t(0));
+    QVERIFY(BRepTools::Triangulation(shapeBoxCopy, params.chordalDeflection));
+    for (TopExp_Explorer explFace(shapeBoxCopy, TopAbs_FACE); explFace.More(); explFace.Next()) {
+        const TopoDS_Face& face = TopoDS::Face(explFace.Current());
+        TopLoc_Location loc;
+        const Handle_Poly_Triangulation& triangulation = BRep_Tool::Triangulation(face, loc);
+        for (TopExp_Explorer explEdge(face, TopAbs_EDGE); explEdge.More(); explEdge.Next()) {
+            const TopoDS_Edge& edge = TopoDS::Edge(explEdge.Current());
+            QVERIFY(!BRep_Tool::PolygonOnTriangulation(edge, triangulation, loc).IsNull());
+        }
+    }
+
+    const TessellationCache::Statistics statsHit = TessellationCache::statistics();
+    QCOMPARE(statsHit.hitCount - statsStore.hitCount, int64_t(1));
+
+    // Deflection is part of the key
+    const uint64_t key = TessellationCache::shapeKey(shapeBox, 0.1, params.angularDeflection);
+    QCOMPARE(TessellationCache::shapeKey(shapeBoxCopy, 0.1, params.angularDeflection), key);
+    QVERIFY(TessellationCache::shapeKey(shapeBox, 0.2, params.angularDeflection) != key);
+
+    // Size limit
+    TessellationCache::setMaxSize(1);
+    QCOMPARE(TessellationCache::statistics().entryCount, int64_t(0));
+    QCOMPARE(TessellationCache::statistics().size, uint64_t(0));
+    QVERIFY(!TessellationCache::load(key, BRepPrimAPI_MakeBox(10, 20, 30).Shape()));
+    TessellationCache::setMaxSize(512 * 1024 * 1024);
+}
+
+void Test::ThreadBudget_test()
+{
+    ThreadBudget::setThreadCount(0);
+    QCOMPARE(ThreadBudget::threadCount(), ThreadBudget::hardwareThreadCount());
+    ThreadBudget::setThreadCount(2);
+    QCOMPARE(ThreadBudget::threadCount(), 2);
+    auto _ = gsl::finally([]{ ThreadBudget::setThreadCount(0); });
+
+    // Check TaskManager instances never run more tasks concurrently than the budget, all together
+    TaskManager taskMgr;
+    TaskManager otherTaskMgr;
+    std::atomic<int> runningCount = {};
+    std::atomic<int> maxRunningCount = {};
+    std::vector<std::pair<TaskManager*, TaskId>> vecTask;
+    for (int i = 0; i < 6; ++i) {
+        TaskManager* mgr = i % 2 == 0 ? &taskMgr : &otherTaskMgr;
+        const TaskId taskId = mgr->newTask([&](TaskProgress*) {
+            const int count = ++runningCount;
+            int maxCount = maxRunningCount.load();
+            while (count > maxCount && !maxRunningCount.compare_exchange_weak(maxCount, count)) {}
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            --runningCount;
+        });
+        vecTask.push_back({ mgr, taskId });
+        mgr->run(taskId, TaskAutoDestroy::Off);
+    }
+
+    for (const auto& task : vecTask)
+        task.first->waitForDone(task.second);
+
+    QVERIFY(maxRunningCount.load() >= 1);
+    QVERIFY(maxRunningCount.load() <= 2);
+    QCOMPARE(taskMgr.runningTaskCount(), 0);
+    QCOMPARE(otherTaskMgr.runningTaskCount(), 0);
+    QCOMPARE(ThreadBudget::acquiredRunSlotCount(), 0);
+
+    // Check a task waiting for child tasks doesn't deadlock when it holds the last run slot
+    ThreadBudget::setThreadCount(1);
+    bool isChildDone = false;
+    const TaskId parentTaskId = taskMgr.newTask([&](TaskProgress*) {
+        const ThreadBudget::RunSlotYield runSlotYield;
+        TaskManager childTaskMgr;
+        const TaskId childTaskId = childTaskMgr.newTask([&](TaskProgress*) { isChildDone = true; });
+        childTaskMgr.run(childTaskId, TaskAutoDestroy::Off);
+        childTaskMgr.waitForDone(childTaskId);
+    });
+    taskMgr.run(parentTaskId, TaskAutoDestroy::Off);
+    QVERIFY(taskMgr.waitForDone(parentTaskId, 5000));
+    QVERIFY(isChildDone);
+    QCOMPARE(ThreadBudget::acquiredRunSlotCount(), 0);
+
+    // Check parallelFor() borrows free run slots only, and runs on the calling thread otherwise
+    ThreadBudget::setThreadCount(2);
+    std::vector<int> vecIndexCount(100, 0);
+    ThreadBudget::parallelFor(0, 100, [&](int i) { ++vecIndexCount.at(i); });
+    QCOMPARE(int(std::count(vecIndexCount.cbegin(), vecIndexCount.cend(), 1)), 100);
+    QCOMPARE(ThreadBudget::acquiredRunSlotCount(), 0);
+    {
+        const ThreadBudget::FreeRunSlots slots(2);
+        QCOMPARE(slots.count(), 2);
+        QCOMPARE(ThreadBudget::FreeRunSlots(1).count(), 0);
+        std::mutex mutexThreadId;
+        std::set<std::thread::id> setThreadId;
+        ThreadBudget::parallelFor(0, 100, [&](int) {
+            std::lock_guard<std::mutex> lock(mutexThreadId);
+            setThreadId.insert(std::this_thread::get_id());
+        });
+        QCOMPARE(int(setThreadId.size()), 1);
+        QVERIFY(setThreadId.count(std::this_thread::get_id()) == 1);
+    }
+
+    QCOMPARE(ThreadBudget::acquiredRunSlotCount(), 0);
+}
+
+void Test::Tracing_test()
+{
+    Tracing::clear();
+    Tracing::setEnabled(false);
+    {
+        MAYO_TRACE_SCOPE("test", "disabled");
+    }
+    QVERIFY(Tracing::events().empty());
+
+    Tracing::setEnabled(true);
+    auto _ = gsl::finally([]{
+        Tracing::setEnabled(false);
+        Tracing::clear();
+    });
+    {
+        MAYO_TRACE_SCOPE("test", "outer");
+        MAYO_TRACE_SCOPE("test", QStringLiteral("inner \"quoted\""));
+    }
+
+    const std::vector<Tracing::Event> vecEvent = Tracing::events();
+    QCOMPARE(vecEvent.size(), size_t(4));
+    QCOMPARE(vecEvent.at(0).phase, Tracing::Phase::Begin);
+    QCOMPARE(vecEvent.at(0).name, QByteArray("outer"));
+    QCOMPARE(vecEvent.at(1).phase, Tracing::Phase::Begin);
+    QCOMPARE(vecEvent.at(2).phase, Tracing::Phase::End);
+    QCOMPARE(vecEvent.at(3).phase, Tracing::Phase::End);
+    for (size_t i = 1; i < vecEvent.size(); ++i)
+        QVERIFY(vecEvent.at(i - 1).timestampUs <= vecEvent.at(i).timestampUs);
+
+    const QJsonDocument jsonDoc = QJsonDocument::fromJson(Tracing::toChromeTraceJson(vecEvent));
+    QVERIFY(jsonDoc.isObject());
+    const QJsonArray jsonEvents = jsonDoc.object().value("traceEvents").toArray();
+    QCOMPARE(jsonEvents.size(), 4);
+    QCOMPARE(jsonEvents.at(1).toObject().value("name").toString(), QStringLiteral("inner \"quoted\""));
+    QCOMPARE(jsonEvents.at(3).toObject().value("ph").toString(), QStringLiteral("E"));
+}
+
 void Test::UnitSystem_test()
 {
     QFETCH(UnitSystem::TranslateResult, trResultActual);
@@ -578,6 +1548,7 @@ void Test::initTestCase()
 {
     IO::System* ioSystem = Application::instance()->ioSystem();
     ioSystem->addFactoryReader(std::make_unique<IO::OccFactoryReader>());
+    ioSystem->addFactoryReader(std::make_unique<IO::PointCloudFactoryReader>());
     ioSystem->addFactoryWriter(std::make_unique<IO::OccFactoryWriter>());
     IO::addPredefinedFormatProbes(ioSystem);
 }
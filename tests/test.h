@@ -18,19 +18,35 @@ private slots:
     void TextId_test();
     void IO_test();
     void IO_test_data();
+    void BndUtils_test();
     void BRepUtils_test();
     void CafUtils_test();
+    void MassProperties_test();
+    void MemoryUtils_test();
+    void MeshDecimation_test();
+    void MeshAnalysis_test();
+    void MeshNormals_test();
+    void MeshNormals_bench();
     void MeshUtils_test();
     void MeshUtils_test_data();
     void MeshUtils_orientation_test();
     void MeshUtils_orientation_test_data();
+    void MeshUtils_triangulationProperties_test();
+    void MeshUtils_triangulationProperties_bench();
+    void MeshUtils_weldedTriangulation_test();
     void MetaEnum_test();
+    void Metrics_test();
+    void PointCloud_test();
     void Quantity_test();
     void Result_test();
     void StringUtils_append_test();
     void StringUtils_append_test_data();
     void StringUtils_text_test();
     void StringUtils_text_test_data();
+    void Tessellation_test();
+    void TessellationCache_test();
+    void ThreadBudget_test();
+    void Tracing_test();
     void UnitSystem_test();
     void UnitSystem_test_data();
 